@@ -0,0 +1,445 @@
+"""
+Análisis por flujo para logs grandes (modo --flujo de termo.py)
+================================================================
+Calcula la misma tabla que estadisticas_resumidas.csv (Count, Mean, Std,
+Min, 25%, 50%, 75%, Max) sin cargar el log entero en memoria:
+
+- CSV (fecha_hora,temperatura,humedad) leído por bloques con pandas.
+- Almacenes columnares de ingesta.c (directorio con filas.u8, temp.i2,
+  hum.i2) leídos con np.memmap; un directorio con varios nodos se expande.
+
+Sin numpy (un servidor de ingesta que no lo tiene) los almacenes se leen
+con array y el CSV, sin numpy o sin pandas, con el módulo csv. Los valores
+se cuentan con Counter y el resumen sale del conteo: mismas tablas, más
+lento.
+
+Cada bloque se reduce a un resumen combinable: media y varianza con la
+fórmula de Chan (Welford por bloques), mínimo, máximo y un histograma en
+centésimas. Los sensores entregan décimas, así que el histograma es exacto
+y los cuartiles salen iguales a np.percentile (interpolación lineal); un
+CSV con más decimales difiere en menos de 0.005. Los nodos, archivos y
+tramos de un mismo almacén se procesan en paralelo en varios procesos.
+
+Cada nodo se nombra con su ruta relativa a la base común de todas las
+fuentes (a/datos.csv y b/datos.csv son dos tablas); la misma fuente dos
+veces es un error.
+
+Uso:
+    python termo.py --flujo datos.csv ingesta/ [-o salida] [-j procesos]
+    python analisis_flujo.py --banco 100000000      # datos sintéticos
+
+Las cifras medidas y lo que no se pudo medir están en "Análisis de logs
+grandes" en el README; test_analisis_flujo.py compara las tablas con
+calcular_estadisticas() de termo.py.
+"""
+
+import os
+import sys
+import csv
+import time
+import array
+import bisect
+import random
+import struct
+import argparse
+import resource
+import tempfile
+import itertools
+import multiprocessing
+from collections import Counter
+from concurrent.futures import ProcessPoolExecutor
+
+try:
+    import numpy as np
+except ImportError:
+    np = None
+
+ESTADISTICAS = ['Count', 'Mean', 'Std', 'Min', '25%', '50%', '75%', 'Max']
+TABLA_TOTAL = 'estadisticas_resumidas.csv'
+
+ESCALA = 100                  # Centésimas
+VALOR_MIN, VALOR_MAX = -100, 200
+BINS = (VALOR_MAX - VALOR_MIN) * ESCALA + 1
+SIN_DATO = -32768             # Lectura fallida en el almacén de ingesta.c
+BLOQUE = 4_000_000            # Filas por bloque (~100 MB de temporales)
+DISTINTOS_CSV = 200_000       # Textos distintos contados antes de vaciar (sin pandas)
+
+
+class Resumen:
+    """Resumen combinable de una serie (unidades: centésimas)"""
+
+    def __init__(self):
+        self.n = 0
+        self.media = 0.0
+        self.m2 = 0.0
+        self.min = None
+        self.max = None
+        self.fuera = 0  # Valores fuera de [VALOR_MIN, VALOR_MAX]
+        self.hist = np.zeros(BINS, dtype=np.int64) if np else [0] * BINS
+
+    def agregar(self, v):
+        """Agrega un bloque de valores enteros en centésimas"""
+        ok = (v >= VALOR_MIN * ESCALA) & (v <= VALOR_MAX * ESCALA)
+        if not ok.all():
+            self.fuera += int(v.size - ok.sum())
+            v = v[ok]
+        if v.size == 0:
+            return
+        media = float(v.mean())
+        m2 = float(((v - media) ** 2).sum())
+        self._combinar(int(v.size), media, m2, int(v.min()), int(v.max()))
+        self.hist += np.bincount(v - VALOR_MIN * ESCALA, minlength=BINS)
+
+    def agregar_conteo(self, conteo):
+        """Agrega un bloque ya contado {centésimas: veces} (sin numpy)"""
+        ok = {x: c for x, c in conteo.items() if VALOR_MIN * ESCALA <= x <= VALOR_MAX * ESCALA}
+        self.fuera += sum(conteo.values()) - sum(ok.values())
+        n = sum(ok.values())
+        if n == 0:
+            return
+        media = sum(x * c for x, c in ok.items()) / n
+        m2 = sum((x - media) ** 2 * c for x, c in ok.items())
+        self._combinar(n, media, m2, min(ok), max(ok))
+        for x, c in ok.items():
+            self.hist[x - VALOR_MIN * ESCALA] += c
+
+    def unir(self, otro):
+        """Combina otro resumen (de otro bloque, proceso o nodo)"""
+        if otro.n:
+            self._combinar(otro.n, otro.media, otro.m2, otro.min, otro.max)
+            if np:
+                self.hist += otro.hist
+            else:
+                self.hist = [a + b for a, b in zip(self.hist, otro.hist)]
+        self.fuera += otro.fuera
+        return self
+
+    def _combinar(self, n, media, m2, vmin, vmax):
+        # Chan et al.: une dos (n, media, M2) sin volver a recorrer los datos
+        total = self.n + n
+        d = media - self.media
+        self.media += d * n / total
+        self.m2 += m2 + d * d * self.n * n / total
+        self.n = total
+        self.min = vmin if self.min is None else min(self.min, vmin)
+        self.max = vmax if self.max is None else max(self.max, vmax)
+
+    def percentil(self, p):
+        """Igual a np.percentile(serie, p) con interpolación lineal"""
+        pos = p / 100 * (self.n - 1)
+        k = int(pos)
+        acum = np.cumsum(self.hist) if np else list(itertools.accumulate(self.hist))
+        a = bisect.bisect_right(acum, k)
+        b = bisect.bisect_right(acum, k + 1) if k + 1 < self.n else a
+        return (a + (pos - k) * (b - a) + VALOR_MIN * ESCALA) / ESCALA
+
+    def tabla(self):
+        """Diccionario con las claves de calcular_estadisticas()"""
+        if self.n == 0:
+            return {e: float('nan') for e in ESTADISTICAS}
+        return {
+            'Count': self.n,
+            'Mean': self.media / ESCALA,
+            'Std': (self.m2 / (self.n - 1)) ** 0.5 / ESCALA if self.n > 1 else float('nan'),
+            'Min': self.min / ESCALA,
+            '25%': self.percentil(25),
+            '50%': self.percentil(50),
+            '75%': self.percentil(75),
+            'Max': self.max / ESCALA,
+        }
+
+
+# ============================================================================
+# LECTORES (cada tarea devuelve los resúmenes de temperatura y humedad)
+# ============================================================================
+
+def _es_almacen(ruta):
+    return os.path.isfile(os.path.join(ruta, 'filas.u8'))
+
+def _filas(ruta):
+    with open(os.path.join(ruta, 'filas.u8'), 'rb') as f:
+        return struct.unpack('<Q', f.read(8))[0]
+
+def _leer_i2(f, n):
+    """n int16 little-endian de f, como array"""
+    a = array.array('h')
+    a.fromfile(f, n)
+    if sys.byteorder == 'big':
+        a.byteswap()
+    return a
+
+def _tarea_almacen(ruta, inicio, fin):
+    """Tramo [inicio, fin) de un almacén de ingesta.c (décimas, int16)"""
+    rt, rh = Resumen(), Resumen()
+    if np is None:
+        with open(os.path.join(ruta, 'temp.i2'), 'rb') as ft, \
+             open(os.path.join(ruta, 'hum.i2'), 'rb') as fh:
+            ft.seek(2 * inicio)
+            fh.seek(2 * inicio)
+            for i in range(inicio, fin, BLOQUE):
+                j = min(i + BLOQUE, fin)
+                for f, res in ((ft, rt), (fh, rh)):
+                    conteo = Counter(_leer_i2(f, j - i))
+                    conteo.pop(SIN_DATO, None)
+                    res.agregar_conteo({x * (ESCALA // 10): c for x, c in conteo.items()})
+        return rt, rh
+    temp = np.memmap(os.path.join(ruta, 'temp.i2'), dtype='<i2', mode='r')
+    hum = np.memmap(os.path.join(ruta, 'hum.i2'), dtype='<i2', mode='r')
+    for i in range(inicio, fin, BLOQUE):
+        j = min(i + BLOQUE, fin)
+        for col, res in ((temp, rt), (hum, rh)):
+            v = col[i:j].astype(np.int32)
+            res.agregar(v[v != SIN_DATO] * (ESCALA // 10))
+    return rt, rh
+
+def _valor_csv(campo):
+    """Centésimas de un campo del CSV; None si está vacío o es NaN"""
+    try:
+        v = float(campo)
+    except ValueError:
+        return None
+    return None if v != v else round(v * ESCALA)   # round() redondea como np.rint
+
+def _tarea_csv(ruta):
+    """CSV completo por bloques (pandas solo se importa acá)"""
+    rt, rh = Resumen(), Resumen()
+    try:
+        import pandas as pd
+    except ImportError:
+        pd = None
+    if np is None or pd is None:
+        # Se cuentan los textos de cada campo (pocos distintos: décimas de
+        # un sensor) y se pasan a centésimas al vaciar el conteo
+        def vaciar(textos, res):
+            conteo = Counter()
+            for x, c in textos.items():
+                v = _valor_csv(x)
+                if v is not None:
+                    conteo[v] += c
+            res.agregar_conteo(conteo)
+            textos.clear()
+
+        ct, ch = Counter(), Counter()
+        with open(ruta, newline='') as f:
+            filas = csv.reader(f)
+            cab = next(filas, [])
+            it, ih = cab.index('temperatura'), cab.index('humedad')
+            for fila in filas:
+                ct[fila[it]] += 1
+                ch[fila[ih]] += 1
+                if len(ct) + len(ch) > DISTINTOS_CSV:
+                    vaciar(ct, rt)
+                    vaciar(ch, rh)
+        vaciar(ct, rt)
+        vaciar(ch, rh)
+        return rt, rh
+    for df in pd.read_csv(ruta, usecols=['temperatura', 'humedad'], chunksize=BLOQUE):
+        for col, res in (('temperatura', rt), ('humedad', rh)):
+            v = df[col].to_numpy(dtype=np.float64)
+            v = v[~np.isnan(v)]
+            res.agregar(np.rint(v * ESCALA).astype(np.int64))
+    return rt, rh
+
+def _ejecutar(tarea):
+    fn, args = tarea
+    return fn(*args)
+
+def nombres(nodos):
+    """
+    Nombre de cada nodo: la ruta relativa a la base común de todos, así
+    a/datos.csv y b/datos.csv no se pisan. ValueError si una fuente aparece
+    dos veces (también ingesta/ e ingesta/nodo1) o si dos nombres dan el
+    mismo archivo de salida.
+    """
+    reales = [os.path.realpath(n) for n in nodos]
+    for r, veces in Counter(reales).items():
+        if veces > 1:
+            raise ValueError(f"la fuente {r} aparece {veces} veces")
+    if not reales:
+        return []
+    base = os.path.commonpath([os.path.dirname(r) for r in reales])
+    lista = [os.path.relpath(r, base) for r in reales]
+    for a, veces in Counter([archivo_tabla(n) for n in lista] + [TABLA_TOTAL]).items():
+        if veces > 1:
+            raise ValueError(f"{veces} tablas irían a {a}")
+    return lista
+
+def archivo_tabla(nombre):
+    """Archivo de la tabla de un nodo (los separadores de ruta pasan a _)"""
+    return 'estadisticas_' + nombre.replace(os.sep, '_') + '.csv'
+
+def planificar(fuentes, procesos):
+    """Lista de (nodo, función, argumentos): un almacén grande se parte en tramos"""
+    nodos = []
+    for f in fuentes:
+        if os.path.isdir(f) and not _es_almacen(f):
+            nodos += [os.path.join(f, d) for d in sorted(os.listdir(f))
+                      if _es_almacen(os.path.join(f, d))]
+        else:
+            nodos.append(f)
+
+    total = sum(_filas(n) for n in nodos if os.path.isdir(n)) or 1
+    tareas = []
+    for n, nombre in zip(nodos, nombres(nodos)):
+        if os.path.isdir(n):
+            filas = _filas(n)
+            partes = max(1, min(procesos * filas // total, filas // BLOQUE + 1))
+            cortes = [filas * i // partes for i in range(partes + 1)]
+            tareas += [(nombre, _tarea_almacen, (n, a, b)) for a, b in zip(cortes, cortes[1:])]
+        else:
+            tareas.append((nombre, _tarea_csv, (n,)))
+    return tareas
+
+def analizar(fuentes, procesos=None):
+    """
+    Devuelve ({nodo: (tabla temp, tabla hum)}, (Resumen temp, Resumen hum)).
+    Los resultados se combinan a medida que llegan: en memoria solo hay un
+    resumen por nodo en curso, no uno por tarea.
+    """
+    procesos = procesos or os.cpu_count() or 1
+    tareas = planificar(fuentes, procesos)
+    trabajos = [(fn, args) for _, fn, args in tareas]
+    tablas = {}
+    total = (Resumen(), Resumen())
+    actual, parcial = None, None
+
+    def cerrar_nodo():
+        if actual is not None:
+            tablas[actual] = (parcial[0].tabla(), parcial[1].tabla())
+            total[0].unir(parcial[0])
+            total[1].unir(parcial[1])
+
+    if procesos == 1:
+        pool = None
+        resultados = map(_ejecutar, trabajos)
+    else:
+        # fork: los hijos no vuelven a ejecutar termo.py como script
+        metodos = multiprocessing.get_all_start_methods()
+        pool = ProcessPoolExecutor(max_workers=procesos,
+                                   mp_context=multiprocessing.get_context(
+                                       'fork' if 'fork' in metodos else None))
+        resultados = pool.map(_ejecutar, trabajos)
+
+    # pool.map respeta el orden: los tramos de un nodo llegan seguidos
+    for (nombre, _, _), (rt, rh) in zip(tareas, resultados):
+        if nombre == actual:
+            parcial[0].unir(rt)
+            parcial[1].unir(rh)
+        else:
+            cerrar_nodo()
+            actual, parcial = nombre, (rt, rh)
+    cerrar_nodo()
+    if pool:
+        pool.shutdown()
+    return tablas, total
+
+
+# ============================================================================
+# SALIDA (mismo formato que df_stats.to_csv en termo.py)
+# ============================================================================
+
+def escribir_tabla(archivo, t, h):
+    with open(archivo, 'w') as f:
+        f.write(',Temperatura,Humedad\n')
+        for e in ESTADISTICAS:
+            f.write(f'{e},{float(t[e])!r},{float(h[e])!r}\n')
+
+def main(argv=None):
+    ap = argparse.ArgumentParser(description='Análisis por flujo de logs grandes')
+    ap.add_argument('fuentes', nargs='*', help='CSV, almacén de ingesta o directorio de almacenes')
+    ap.add_argument('-o', '--salida', default='.', help='Directorio de las tablas')
+    ap.add_argument('-j', '--procesos', type=int, default=None)
+    ap.add_argument('--banco', type=int, metavar='FILAS',
+                    help='Genera FILAS lecturas sintéticas y mide el análisis')
+    ap.add_argument('--nodos', type=int, default=16, help='Nodos del banco de prueba')
+    a = ap.parse_args(argv)
+
+    if a.banco:
+        return banco(a.banco, a.nodos, a.procesos)
+    if not a.fuentes:
+        ap.error('faltan fuentes')
+
+    os.makedirs(a.salida, exist_ok=True)
+    inicio = time.perf_counter()
+    try:
+        tablas, total = analizar(a.fuentes, a.procesos)
+    except ValueError as e:
+        ap.error(str(e))
+    seg = time.perf_counter() - inicio
+
+    for nombre, (t, h) in tablas.items():
+        escribir_tabla(os.path.join(a.salida, archivo_tabla(nombre)), t, h)
+    escribir_tabla(os.path.join(a.salida, TABLA_TOTAL),
+                   total[0].tabla(), total[1].tabla())
+
+    propio, hijos = _rss_mb()
+    print(f"✅ {len(tablas)} fuentes, {total[0].n:,} lecturas en {seg:.2f} s "
+          f"({total[0].n / seg / 1e6:.1f} M/s, {a.procesos or os.cpu_count()} procesos, "
+          f"{'numpy' if np else 'sin numpy'})")
+    print(f"   Pico de RSS: {propio:.0f} MB principal, {hijos:.0f} MB el mayor de los procesos hijos")
+    print(f"   Tablas en '{a.salida}' (estadisticas_resumidas.csv = todas juntas)")
+    if total[0].fuera or total[1].fuera:
+        print(f"⚠️  Fuera de rango: {total[0].fuera} temp., {total[1].fuera} hum.")
+    return 0
+
+
+# ============================================================================
+# BANCO DE PRUEBA
+# ============================================================================
+
+def _rss_mb():
+    """Pico de memoria residente (este proceso y los hijos), en MB"""
+    propio = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+    hijos = resource.getrusage(resource.RUSAGE_CHILDREN).ru_maxrss
+    return propio / 1024, hijos / 1024
+
+def generar_almacenes(directorio, filas, nodos, semilla=1):
+    """Almacenes con el formato de ingesta.c (solo las columnas que se leen)"""
+    rng = np.random.default_rng(semilla) if np else None
+    azar = random.Random(semilla)
+    for n in range(nodos):
+        ruta = os.path.join(directorio, f'nodo{n:04d}')
+        os.makedirs(ruta, exist_ok=True)
+        cant = filas // nodos + (1 if n < filas % nodos else 0)
+        with open(os.path.join(ruta, 'filas.u8'), 'wb') as f:
+            f.write(struct.pack('<Q', cant))
+        for col, media, desv in (('temp.i2', 240, 40), ('hum.i2', 600, 100)):
+            if np is None:
+                # Sin numpy: con random, un bloque a la vez
+                with open(os.path.join(ruta, col), 'wb') as f:
+                    for i in range(0, cant, BLOQUE):
+                        a = array.array('h', (SIN_DATO if azar.random() < 0.01 else
+                                              max(-32767, min(32767, round(azar.gauss(media, desv))))
+                                              for _ in range(min(BLOQUE, cant - i))))
+                        if sys.byteorder == 'big':
+                            a.byteswap()
+                        a.tofile(f)
+                continue
+            m = np.memmap(os.path.join(ruta, col), dtype='<i2', mode='w+', shape=(max(cant, 1),))
+            for i in range(0, cant, BLOQUE):
+                j = min(i + BLOQUE, cant)
+                v = rng.normal(media, desv, j - i).round().astype(np.int16)
+                v[rng.random(j - i) < 0.01] = SIN_DATO  # 1% de lecturas fallidas
+                m[i:j] = v
+            m.flush()
+            del m
+
+def banco(filas, nodos, procesos):
+    """Genera los almacenes y los analiza en un proceso aparte (RSS limpio)"""
+    import subprocess
+    with tempfile.TemporaryDirectory(prefix='banco_termo_') as d:
+        print(f"Generando {filas:,} filas en {nodos} nodos en {d} ...")
+        t0 = time.perf_counter()
+        generar_almacenes(d, filas, nodos)
+        print(f"  generado en {time.perf_counter() - t0:.1f} s")
+
+        orden = [sys.executable, os.path.abspath(__file__), d, '-o', d]
+        if procesos:
+            orden += ['-j', str(procesos)]
+        subprocess.run(orden, check=True)
+        print(open(os.path.join(d, TABLA_TOTAL)).read())
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
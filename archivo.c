@@ -0,0 +1,156 @@
+/*
+ * File: archivo.c
+ * Archivo del historial en la EEPROM externa (ver archivo.h)
+ */
+#include "archivo.h"
+#include "eeprom.h"
+#include "crc8.h"
+#include "prof.h"
+
+#define ARCHIVO_IND_LEN   4      // Bytes del indice antes del CRC
+#define ARCHIVO_COPIA     8      // Distancia entre las dos copias
+#define ARCHIVO_ESPERA_MS 100    // Sin nada que copiar
+#define ARCHIVO_SONDEO_MS 1
+
+#define ARCHIVO_LIBRE   0
+#define ARCHIVO_PAGINA  1        // Pagina encolada
+#define ARCHIVO_SONDEO  2        // Esperando el ACK del fin de la escritura
+
+static uint8_t archivo_ok = 0;
+static uint8_t archivo_estado = ARCHIVO_LIBRE;
+static uint8_t archivo_seq;        // Ultimo bloque copiado
+static uint16_t archivo_pag;       // Proxima pagina, con ARCHIVO_LLENO
+static uint8_t archivo_cont;       // Contador de la copia vigente del indice
+static volatile uint8_t archivo_done;
+
+static uint8_t archivo_leer_indice(uint8_t copia, uint8_t *ind)
+{
+    uint8_t addr = EELOG_INDICE + copia * ARCHIVO_COPIA;
+
+    for(uint8_t i = 0; i <= ARCHIVO_IND_LEN; i++) {
+        ind[i] = EEPROM_Read(addr + i);
+    }
+    return crc8(ind, ARCHIVO_IND_LEN) == ind[ARCHIVO_IND_LEN];
+}
+
+static void archivo_guardar_indice(void)
+{
+    uint8_t ind[ARCHIVO_IND_LEN + 1];
+    uint8_t addr;
+
+    archivo_cont++;
+    ind[0] = archivo_cont;
+    ind[1] = archivo_seq;
+    ind[2] = archivo_pag & 0xFF;
+    ind[3] = archivo_pag >> 8;
+    ind[ARCHIVO_IND_LEN] = crc8(ind, ARCHIVO_IND_LEN);
+
+    // Copias alternadas: la otra queda como respaldo
+    addr = EELOG_INDICE + (archivo_cont & 1) * ARCHIVO_COPIA;
+    for(uint8_t i = 0; i <= ARCHIVO_IND_LEN; i++) {
+        EEPROM_Write(addr + i, ind[i]);
+    }
+}
+
+void archivo_init(void)
+{
+    uint8_t a[ARCHIVO_IND_LEN + 1], b[ARCHIVO_IND_LEN + 1];
+    uint8_t ok_a, ok_b;
+    uint8_t *ind;
+
+    archivo_ok = EEXT_Wait();
+    archivo_estado = ARCHIVO_LIBRE;
+
+    ok_a = archivo_leer_indice(0, a);
+    ok_b = archivo_leer_indice(1, b);
+    if(ok_a && ok_b) {
+        ind = ((int8_t)(b[0] - a[0]) > 0) ? b : a;
+    } else if(ok_a || ok_b) {
+        ind = ok_a ? a : b;
+    } else {
+        // Archivo nuevo: empieza por el bloque mas viejo del anillo
+        archivo_cont = 0;
+        archivo_pag = 0;
+        archivo_seq = eelog_seq_abierto() - EELOG_SLOTS;
+        return;
+    }
+    archivo_cont = ind[0];
+    archivo_seq = ind[1];
+    archivo_pag = ind[2] | (uint16_t)ind[3] << 8;
+}
+
+// Encola la pagina con los ARCHIVO_BLOQUES bloques que siguen al ultimo
+// copiado, si ya estan todos cerrados
+static uint8_t archivo_copiar(void)
+{
+    uint8_t k, i, addr;
+
+    // Bloques que el anillo piso sin copiar (o indice nuevo): seguir
+    // desde el mas viejo que quede
+    while((uint8_t)(archivo_seq + 1) != eelog_seq_abierto() &&
+          eelog_bloque(archivo_seq + 1) == EELOG_NINGUNO) {
+        archivo_seq++;
+    }
+    for(k = 1; k <= ARCHIVO_BLOQUES; k++) {
+        if(eelog_bloque(archivo_seq + k) == EELOG_NINGUNO) return 0;
+    }
+
+    PROF_INICIO(PROF_EEXT);
+    EEXT_Begin((archivo_pag & ~ARCHIVO_LLENO) * EEXT_PAGINA);
+    for(k = 1; k <= ARCHIVO_BLOQUES; k++) {
+        addr = eelog_bloque(archivo_seq + k) * EELOG_SLOT_LEN;
+        for(i = 0; i < EELOG_SLOT_LEN; i++) {
+            EEXT_Put(EEPROM_Read(addr + i));
+        }
+    }
+    return EEXT_Commit(&archivo_done);
+}
+
+uint16_t archivo_tarea(void)
+{
+    if(!archivo_ok || !eelog_total()) return ARCHIVO_ESPERA_MS;
+
+    switch(archivo_estado) {
+        case ARCHIVO_PAGINA:
+            if(archivo_done == I2C_PENDIENTE) return ARCHIVO_SONDEO_MS;
+            if(archivo_done != I2C_OK) {
+                archivo_estado = ARCHIVO_LIBRE;   // Se reintenta la pagina
+                return ARCHIVO_ESPERA_MS;
+            }
+            archivo_estado = ARCHIVO_SONDEO;
+            EEXT_Poll(&archivo_done);
+            return ARCHIVO_SONDEO_MS;
+
+        case ARCHIVO_SONDEO:
+            if(archivo_done == I2C_PENDIENTE) return ARCHIVO_SONDEO_MS;
+            if(archivo_done != I2C_OK) {
+                EEXT_Poll(&archivo_done);         // Todavia grabando
+                return ARCHIVO_SONDEO_MS;
+            }
+            PROF_FIN(PROF_EEXT);
+            archivo_seq += ARCHIVO_BLOQUES;
+            archivo_pag++;
+            if((archivo_pag & ~ARCHIVO_LLENO) == EEXT_PAGINAS) archivo_pag = ARCHIVO_LLENO;
+            archivo_guardar_indice();
+            archivo_estado = ARCHIVO_LIBRE;
+            return ARCHIVO_ESPERA_MS;
+
+        default:
+            if(archivo_copiar()) {
+                archivo_estado = ARCHIVO_PAGINA;
+                return ARCHIVO_SONDEO_MS;
+            }
+            return ARCHIVO_ESPERA_MS;
+    }
+}
+
+uint8_t archivo_presente(void)
+{
+    return archivo_ok;
+}
+
+uint16_t archivo_bloques(void)
+{
+    if(archivo_pag & ARCHIVO_LLENO) return EEXT_PAGINAS * ARCHIVO_BLOQUES;
+    return archivo_pag * ARCHIVO_BLOQUES;
+}
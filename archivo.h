@@ -0,0 +1,38 @@
+/*
+ * File: archivo.h
+ * Archivo del historial en la EEPROM externa (24LC256)
+ *
+ * El anillo de eelog.c guarda ~300 lecturas; el archivo copia sus bloques
+ * cerrados a la 24LC256, que tiene lugar para 2048 (de una semana a meses,
+ * segun cuanto ahorre el registro por cambio). Los bloques van tal cual,
+ * con su seq, keyframe, marca y CRC, de a ARCHIVO_BLOQUES: 4 x 16 bytes
+ * son una pagina alineada de 64 bytes y una sola escritura. Los bytes van
+ * de la EEPROM interna directo a la cola de I2C, sin otro buffer en RAM.
+ *
+ * Despues de cada pagina se sondea el ACK del chip cada 1 ms en lugar de
+ * esperar el tWC de 5 ms, y recien con el ACK se guarda el indice en los
+ * 16 bytes del final de la EEPROM interna (EELOG_INDICE):
+ *
+ *   [contador][seq del ultimo bloque copiado][pagina L][pagina H][crc8]
+ *
+ * en dos copias alternadas; vale la de contador mas nuevo con CRC
+ * correcto, asi un corte a mitad de la escritura deja la anterior. Un corte
+ * antes del indice solo hace que la pagina se vuelva a escribir. El bit 15
+ * de la pagina indica que el anillo externo ya dio la vuelta.
+ */
+#ifndef ARCHIVO_H
+#define ARCHIVO_H
+
+#include <stdint.h>
+#include "eelog.h"
+#include "eeprom_ext.h"
+
+#define ARCHIVO_BLOQUES  (EEXT_PAGINA / EELOG_SLOT_LEN)   // Bloques por pagina
+#define ARCHIVO_LLENO    0x8000
+
+void archivo_init(void);          // Despues de eelog_init()
+uint16_t archivo_tarea(void);     // Retorna los ms hasta la proxima llamada
+uint8_t archivo_presente(void);
+uint16_t archivo_bloques(void);   // Bloques archivados (hasta 2048)
+
+#endif /* ARCHIVO_H */
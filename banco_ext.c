@@ -0,0 +1,162 @@
+/*
+ * File: banco_ext.c
+ * Banco de la 24LC256 sobre el simulador (Linux, make banco_ext)
+ *
+ * Corre eeprom_ext.c, i2c.c y sched.c sobre hal_host.c y mide en tiempo
+ * virtual (tick de 1 ms), a 100 y 400 kHz:
+ * - Escritura del chip entero por paginas de 64 bytes, esperando el fin de
+ *   cada una con sondeo de ACK o con los 5 ms fijos de la hoja de datos.
+ * - Lectura del chip entero en una sola rafaga con direccion.
+ * Da paginas/s, bytes/s y registros/s, con registro = un bloque de
+ * eelog.c (EELOG_SLOT_LEN bytes, el que copia archivo.c). Verifica lo
+ * escrito, y que una rafaga que cruza el borde de pagina da la vuelta
+ * dentro de la misma pagina.
+ *
+ * Uso:
+ *   banco_ext
+ */
+#include <stdio.h>
+#include <string.h>
+#include "hal.h"
+#include "sched.h"
+#include "archivo.h"
+
+#define ESPERA_FIJA_MS  5   // tWC maximo de la hoja de datos
+
+static uint8_t leido[EEXT_TAMANO];
+
+void __interrupt() isr(void)
+{
+    if(SCHED_TICK_PENDIENTE()) {
+        sched_tick_isr();
+    }
+    if(PIE1bits.SSPIE && PIR1bits.SSPIF) {
+        I2C_Isr();
+    }
+}
+
+static uint8_t patron(uint16_t addr, uint8_t semilla)
+{
+    return (uint8_t)(addr * 7 + (addr >> 8) + semilla);
+}
+
+// Escribe el chip entero; retorna los ms o 0 si alguna pagina fallo
+static uint16_t escribir(uint8_t sondeo, uint8_t semilla)
+{
+    volatile uint8_t done;
+    uint16_t t0 = sched_ticks();
+
+    for(uint16_t p = 0; p < EEXT_PAGINAS; p++) {
+        uint16_t base = p * EEXT_PAGINA;
+
+        EEXT_Begin(base);
+        for(uint8_t i = 0; i < EEXT_PAGINA; i++) {
+            EEXT_Put(patron(base + i, semilla));
+        }
+        EEXT_Commit(&done);
+        while(done == I2C_PENDIENTE) HAL_ESPERA();
+        if(done != I2C_OK) return 0;
+
+        if(sondeo) {
+            do {
+                EEXT_Poll(&done);
+                while(done == I2C_PENDIENTE) HAL_ESPERA();
+            } while(done != I2C_OK);
+        } else {
+            __delay_ms(ESPERA_FIJA_MS);
+        }
+    }
+    return (uint16_t)(sched_ticks() - t0);
+}
+
+static uint16_t verificar(uint8_t semilla, uint16_t *ms)
+{
+    uint16_t t0 = sched_ticks();
+    uint16_t errores = 0;
+
+    if(!EEXT_Read(0, leido, EEXT_TAMANO)) return EEXT_TAMANO;
+    *ms = (uint16_t)(sched_ticks() - t0);
+    for(uint16_t a = 0; a < EEXT_TAMANO; a++) {
+        if(leido[a] != patron(a, semilla)) errores++;
+    }
+    return errores;
+}
+
+static void imprimir(const char *nombre, uint16_t ms, unsigned long bytes)
+{
+    double s = ms / 1000.0;
+
+    printf("  %-16s %6u ms %8.1f pag/s %8.0f B/s %7.1f reg/s\n", nombre, ms,
+           bytes / EEXT_PAGINA / s, bytes / s, bytes / EELOG_SLOT_LEN / s);
+}
+
+// 8 bytes desde el byte 60 de una pagina: 60..63 y despues 0..3 de la misma
+static int probar_vuelta(void)
+{
+    uint16_t base = 5 * EEXT_PAGINA;
+    uint8_t p[EEXT_PAGINA];
+    volatile uint8_t done;
+    int ok = 1;
+
+    EEXT_Begin(base + EEXT_PAGINA - 4);
+    for(uint8_t i = 0; i < 8; i++) EEXT_Put(0xC0 + i);
+    EEXT_Commit(&done);
+    I2C_Flush();
+    if(!EEXT_Wait() || !EEXT_Read(base, p, EEXT_PAGINA)) return 0;
+
+    for(uint8_t i = 0; i < EEXT_PAGINA; i++) {
+        uint8_t esperado = patron(base + i, 2);
+
+        if(i >= EEXT_PAGINA - 4) esperado = 0xC0 + (i - (EEXT_PAGINA - 4));
+        if(i < 4) esperado = 0xC4 + i;
+        if(p[i] != esperado) ok = 0;
+    }
+    // La pagina siguiente no se toca
+    if(!EEXT_Read(base + EEXT_PAGINA, p, 1) || p[0] != patron(base + EEXT_PAGINA, 2)) ok = 0;
+    return ok;
+}
+
+int main(void)
+{
+    static const struct {
+        const char *nombre;
+        unsigned char velocidad;
+    } buses[] = { { "100 kHz", I2C_100KHZ }, { "400 kHz", I2C_400KHZ } };
+    uint16_t ms, lectura = 0, errores;
+    int falla = 0;
+
+    HAL_INIT();
+    sched_init(NULL, 0);
+    INTCONbits.GIE = 1;
+
+    printf("24LC256: %u paginas de %d bytes, registro de %d bytes (%d por pagina)\n",
+           EEXT_PAGINAS, EEXT_PAGINA, EELOG_SLOT_LEN, ARCHIVO_BLOQUES);
+
+    for(size_t b = 0; b < sizeof(buses) / sizeof(buses[0]); b++) {
+        I2C_Init_Master(buses[b].velocidad);
+        printf("\nbus a %s\n", buses[b].nombre);
+
+        for(uint8_t sondeo = 0; sondeo < 2; sondeo++) {
+            ms = escribir(sondeo, sondeo + 1);
+            if(!ms) {
+                printf("  sin ACK del chip\n");
+                return 1;
+            }
+            imprimir(sondeo ? "sondeo de ACK" : "espera de 5 ms", ms, EEXT_TAMANO);
+            errores = verificar(sondeo + 1, &lectura);
+            if(errores) {
+                printf("  %u bytes distintos al releer\n", errores);
+                falla = 1;
+            }
+        }
+        imprimir("lectura", lectura, EEXT_TAMANO);
+    }
+
+    if(probar_vuelta()) {
+        printf("\nvuelta dentro de la pagina: ok\n");
+    } else {
+        printf("\nvuelta dentro de la pagina: FALLA\n");
+        falla = 1;
+    }
+    return falla;
+}
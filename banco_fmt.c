@@ -0,0 +1,122 @@
+/*
+ * File: banco_fmt.c
+ * Tiempo de fmt.c contra sprintf en una fila del LCD (Linux, make banco_fmt)
+ *
+ * Arma muchas veces la fila de la lectura ("T: 21C  H: 67%" con el DHT11,
+ * "T: 23.5C H:65.2%" con el DHT22) con valores que cambian en cada vuelta:
+ * con fmt.c como main.c, con el sprintf que usaba main.c antes y con un
+ * sprintf de ancho fijo que da la misma fila que fmt.c. Imprime ns por
+ * fila de cada uno. Es el tiempo en x86-64; en el PIC la diferencia es
+ * mayor (doprnt y las divisiones son rutinas de software), pero eso solo
+ * se mide con XC8 y el simulador de MPLAB.
+ *
+ * Uso:
+ *   banco_fmt [filas]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "fmt.h"
+
+#if MUESTRA_ESCALA == 10
+#define ANCHO_T  5
+#define ANCHO_H  4
+#define SEP_TH   "C H:"
+#else
+#define ANCHO_T  3
+#define ANCHO_H  3
+#define SEP_TH   "C  H:"
+#endif
+
+#define FILA  16
+
+static volatile char sumidero;
+
+static double ahora_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Valores de la vuelta i, dentro del rango del sensor
+static void valores(long i, int16_t *t, int16_t *h)
+{
+    *t = (int16_t)((i * 7) % (60 * MUESTRA_ESCALA)) - 10 * MUESTRA_ESCALA;
+    *h = (int16_t)((i * 13) % (100 * MUESTRA_ESCALA));
+}
+
+static void fila_fmt(char *fila, int16_t t, int16_t h)
+{
+    char *p = fmt_txt(fila, "T:");
+
+    p = fmt_muestra(p, t, ANCHO_T);
+    p = fmt_txt(p, SEP_TH);
+    p = fmt_muestra(p, h, ANCHO_H);
+    fmt_txt(p, "%");
+}
+
+// El formato de main.c antes de fmt.c (sin ancho fijo)
+static void fila_antes(char *fila, int16_t t, int16_t h)
+{
+#if MUESTRA_ESCALA == 10
+    sprintf(fila, "T:%s%d.%dC H:%d.%d%%", t < 0 ? "-" : "", abs(t) / 10, abs(t) % 10, h / 10, h % 10);
+#else
+    sprintf(fila, "T:%dC  H:%d%%", t, h);
+#endif
+}
+
+// La misma fila que fmt.c, con sprintf
+static void fila_igual(char *fila, int16_t t, int16_t h)
+{
+#if MUESTRA_ESCALA == 10
+    char tt[12], hh[12];
+
+    sprintf(tt, "%s%d.%d", t < 0 ? "-" : "", abs(t) / 10, abs(t) % 10);
+    sprintf(hh, "%d.%d", h / 10, h % 10);
+    sprintf(fila, "T:%*s" SEP_TH "%*s%%", ANCHO_T, tt, ANCHO_H, hh);
+#else
+    sprintf(fila, "T:%*d" SEP_TH "%*d%%", ANCHO_T, t, ANCHO_H, h);
+#endif
+}
+
+static double medir(void (*f)(char *, int16_t, int16_t), long n)
+{
+    char fila[2 * FILA];
+    int16_t t, h;
+    double t0 = ahora_ns();
+
+    for(long i = 0; i < n; i++) {
+        valores(i, &t, &h);
+        f(fila, t, h);
+        sumidero ^= fila[4] ^ fila[11];
+    }
+    return (ahora_ns() - t0) / n;
+}
+
+int main(int argc, char **argv)
+{
+    long n = argc > 1 ? atol(argv[1]) : 10000000;
+    char a[2 * FILA], b[2 * FILA];
+    int16_t t, h;
+
+    // Antes de medir: fmt.c y el sprintf de ancho fijo dan la misma fila
+    for(long i = 0; i < 100000; i++) {
+        valores(i, &t, &h);
+        memset(a, 0, sizeof(a));
+        fila_fmt(a, t, h);
+        fila_igual(b, t, h);
+        if(strcmp(a, b) != 0) {
+            printf("distintas con t=%d h=%d: \"%s\" \"%s\"\n", t, h, a, b);
+            return 1;
+        }
+    }
+
+    printf("%s, %ld filas\n", MUESTRA_ESCALA == 10 ? "DHT22" : "DHT11", n);
+    printf("fmt.c            %6.1f ns/fila\n", medir(fila_fmt, n));
+    printf("sprintf antes    %6.1f ns/fila\n", medir(fila_antes, n));
+    printf("sprintf igual    %6.1f ns/fila\n", medir(fila_igual, n));
+    return 0;
+}
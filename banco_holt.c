@@ -0,0 +1,31 @@
+/*
+ * File: banco_holt.c
+ * holt.c sobre una serie de texto (Linux, make banco_holt)
+ *
+ * Lee de la entrada una muestra por linea, "temperatura humedad" en
+ * unidades de muestra_t (enteros con el DHT11, decimas con el DHT22: las
+ * del sensor elegido al compilar), y escribe por cada una el pronostico
+ * de holt_pronostico() despues de agregarla. La primera linea de la
+ * salida da la escala y los parametros de holt.h, para que
+ * pronostico_holt.py --banco compare con su implementacion y con
+ * statsmodels usando los mismos.
+ *
+ * Uso:
+ *   banco_holt < serie.txt
+ */
+#include <stdio.h>
+#include "holt.h"
+
+int main(void)
+{
+    long t, h;
+
+    printf("# escala %d bytes %d pasos %d alfa_sh %d beta_sh %d frac %d\n", MUESTRA_ESCALA,
+           MUESTRA_BYTES, HOLT_PASOS, HOLT_ALFA_SH, HOLT_BETA_SH, HOLT_FRAC);
+    holt_init();
+    while(scanf("%ld %ld", &t, &h) == 2) {
+        holt_push((muestra_t)t, (muestra_t)h);
+        printf("%d %d\n", (int)holt_pronostico(STATS_TEMP), (int)holt_pronostico(STATS_HUM));
+    }
+    return 0;
+}
@@ -0,0 +1,282 @@
+/*
+ * File: banco_muestreo.c
+ * Banco de muestreo.c sobre trazas grabadas (Linux)
+ *
+ * Reproduce una traza de telemetria (tramas COBS de uart.c: un puerto
+ * serie grabado, o SIM_UART del simulador) por el mismo camino que el
+ * firmware: una muestra cada 20 s (la lectura del paso que mas se sale de
+ * la banda, muestreo_desvio()), muestreo.c elige los puntos y eelog.c +
+ * logpack.c los graban en una EEPROM en RAM que cuenta las escrituras.
+ * Despues de cada punto guardado se releen con eelog_replay() las muestras
+ * que ese punto cierra y se comparan con las muestras: el error es el de
+ * la reconstruccion real, no el de un modelo. La marca de cada muestra es
+ * su indice en la serie, y tambien se compara.
+ *
+ * Se compara contra el registro fijo (cada muestra) con varias bandas; la
+ * banda por defecto del firmware va marcada con '*'. Las unidades son las
+ * del sensor elegido al compilar (make -B banco SENSOR=dht22).
+ *
+ * Uso:
+ *   banco_muestreo [-z zona] traza...
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include "eeprom.h"
+#include "eelog.h"
+#include "muestreo.h"
+#include "crc8.h"
+#include "cobs.h"
+
+#define TELEM_LEN    11
+#define TELEM_DHT22  0x08
+#define PASO_MS      20000   // Muestra del historial (PASOS_REGISTRO en main.c)
+
+// ========== EEPROM EN RAM ==========
+static uint8_t ee[EEPROM_TAMANO];
+static unsigned long ee_escrituras, ee_celda[EEPROM_TAMANO];
+
+uint8_t EEPROM_Read(uint8_t addr)
+{
+    return ee[addr];
+}
+
+void EEPROM_Write(uint8_t addr, uint8_t data)
+{
+    ee[addr] = data;
+    ee_escrituras++;
+    ee_celda[addr]++;
+}
+
+// ========== TRAZA ==========
+// Lecturas validas con el paso al que pertenecen; la serie de muestras
+// depende de la banda (la eleccion usa la recta) y se arma en correr()
+static muestra_t *lect_t, *lect_h, *serie_t, *serie_h;
+static size_t *lect_paso;
+static size_t n_lect, cap_lect, n_serie;
+static unsigned long n_lecturas, n_fallos;
+
+static void lectura_agregar(muestra_t t, muestra_t h, size_t paso)
+{
+    if(n_lect == cap_lect) {
+        cap_lect = cap_lect ? 2 * cap_lect : 4096;
+        lect_t = realloc(lect_t, cap_lect * sizeof(muestra_t));
+        lect_h = realloc(lect_h, cap_lect * sizeof(muestra_t));
+        lect_paso = realloc(lect_paso, cap_lect * sizeof(size_t));
+        if(!lect_t || !lect_h || !lect_paso) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    lect_t[n_lect] = t;
+    lect_h[n_lect] = h;
+    lect_paso[n_lect] = paso;
+    n_lect++;
+}
+
+// Lecturas de una zona, repartidas en pasos de PASO_MS como en el PIC
+static void traza_leer(const char *ruta, int zona)
+{
+    FILE *f = fopen(ruta, "rb");
+    uint8_t trama[64], *r = trama + 1, *d = &r[3];
+    size_t n = 0;
+    int c, hay = 0, previo = 0;
+    uint16_t tick_prev = 0;
+    uint64_t ms = 0, proximo = PASO_MS;
+    muestra_t t = 0, h = 0;
+
+    if(!f) {
+        perror(ruta);
+        exit(1);
+    }
+    while((c = getc(f)) != EOF) {
+        if(c != 0) {
+            if(n < sizeof(trama)) trama[n++] = c;
+            continue;
+        }
+        // El registro queda decodificado en la misma trama, desde trama + 1
+        if(n == COBS_LEN(TELEM_LEN) - 1 && cobs_decodificar(trama, n) &&
+           crc8(r, TELEM_LEN - 1) == r[TELEM_LEN - 1] &&
+           (r[8] >> 4) == zona) {
+            uint16_t tick = r[1] | r[2] << 8;
+
+            if(previo) ms += (uint16_t)(tick - tick_prev);
+            previo = 1;
+            tick_prev = tick;
+            while(ms >= proximo) {
+                if(hay) n_serie++;
+                proximo += PASO_MS;
+            }
+
+            n_lecturas++;
+            if((r[8] & 0x07) != 0) {
+                n_fallos++;
+            } else if(!!(r[8] & TELEM_DHT22) != (MUESTRA_ESCALA == 10)) {
+                fprintf(stderr, "%s: la traza es de otro sensor (make -B banco SENSOR=...)\n", ruta);
+                exit(1);
+            } else {
+#if MUESTRA_ESCALA == 10
+                t = (muestra_t)((d[2] & 0x7F) << 8 | d[3]);
+                if(d[2] & 0x80) t = -t;
+                h = (muestra_t)(d[0] << 8 | d[1]);
+#else
+                t = d[2] + (d[3] >= 5);
+                h = d[0] + (d[1] >= 5);
+#endif
+                lectura_agregar(t, h, n_serie);
+                hay = 1;
+            }
+        }
+        n = 0;
+    }
+    fclose(f);
+}
+
+// ========== CORRIDA ==========
+typedef struct {
+    unsigned long puntos, escrituras, max_celda;
+    double err_max[2], err_cuad[2];
+    size_t comparadas;
+} Resultado;
+
+static const muestra_t *replay_t, *replay_h;
+static size_t replay_i;
+static Resultado *replay_r;
+
+static void replay_comparar(uint16_t marca, muestra_t t, muestra_t h)
+{
+    double e[2] = { fabs((double)t - replay_t[replay_i]), fabs((double)h - replay_h[replay_i]) };
+
+    if(marca != (uint16_t)replay_i) {
+        fprintf(stderr, "muestra %zu: marca %u\n", replay_i, marca);
+        exit(1);
+    }
+
+    for(int c = 0; c < 2; c++) {
+        if(e[c] > replay_r->err_max[c]) replay_r->err_max[c] = e[c];
+        replay_r->err_cuad[c] += e[c] * e[c];
+    }
+    replay_r->comparadas++;
+    replay_i++;
+}
+
+// bandas < 0: registro fijo, cada muestra
+static void correr(int banda_t, int banda_h, Resultado *res)
+{
+    Punto p;
+    size_t fin, j = 0;
+    muestra_t t = 0, h = 0;
+    uint16_t d, d_max;
+
+    memset(res, 0, sizeof(*res));
+    memset(ee, 0xFF, sizeof(ee));
+    memset(ee_celda, 0, sizeof(ee_celda));
+    ee_escrituras = 0;
+    eelog_init();
+    muestreo_init(banda_t, banda_h);
+    replay_t = serie_t;
+    replay_h = serie_h;
+    replay_r = res;
+
+    for(size_t i = 0; i < n_serie; i++) {
+        // La muestra del paso, como lectura_valida() en main.c (un paso sin
+        // lecturas repite la anterior); el registro fijo toma la ultima
+        for(d_max = 0; j < n_lect && lect_paso[j] == i; j++) {
+            d = banda_t < 0 ? 0 : muestreo_desvio(lect_t[j], lect_h[j]);
+            if(d >= d_max) {
+                t = lect_t[j];
+                h = lect_h[j];
+                d_max = d;
+            }
+        }
+        serie_t[i] = t;
+        serie_h[i] = h;
+
+        if(banda_t < 0) {
+            p.t = serie_t[i];
+            p.h = serie_h[i];
+            p.hueco = 0;
+        } else if(!muestreo_paso(serie_t[i], serie_h[i], &p)) {
+            continue;
+        }
+        fin = i - (banda_t < 0 ? 0 : muestreo_pendientes());
+        eelog_append_hueco(p.hueco, (uint16_t)fin, p.t, p.h);
+        res->puntos++;
+
+        // Lo que cierra este punto, tal como lo lee el firmware
+        replay_i = fin - p.hueco;
+        eelog_replay(p.hueco + 1, replay_comparar);
+    }
+
+    res->escrituras = ee_escrituras;
+    for(int a = 0; a < EEPROM_TAMANO; a++) {
+        if(ee_celda[a] > res->max_celda) res->max_celda = ee_celda[a];
+    }
+}
+
+static void imprimir(const char *nombre, const Resultado *r, const Resultado *fijo)
+{
+    double n = r->comparadas ? r->comparadas : 1;
+
+    printf("%-12s %8lu %10lu %6.1f%% %6lu   %5.2f %5.2f   %5.2f %5.2f\n", nombre,
+           r->puntos, r->escrituras, 100.0 * (1.0 - (double)r->escrituras / fijo->escrituras),
+           r->max_celda,
+           r->err_max[0] / MUESTRA_ESCALA, sqrt(r->err_cuad[0] / n) / MUESTRA_ESCALA,
+           r->err_max[1] / MUESTRA_ESCALA, sqrt(r->err_cuad[1] / n) / MUESTRA_ESCALA);
+}
+
+int main(int argc, char **argv)
+{
+    static const int bandas[][2] = {
+#if MUESTRA_ESCALA == 10
+        { 0, 0 }, { 1, 5 }, { MUESTREO_BANDA_T, MUESTREO_BANDA_H }, { 5, 20 }, { 10, 30 },
+#else
+        { 0, 0 }, { MUESTREO_BANDA_T, MUESTREO_BANDA_H }, { 2, 2 }, { 3, 3 },
+#endif
+    };
+    Resultado fijo, r;
+    char nombre[32];
+    int opt, zona = 0;
+
+    while((opt = getopt(argc, argv, "z:")) != -1) {
+        switch(opt) {
+            case 'z': zona = atoi(optarg); break;
+            default:
+                fprintf(stderr, "uso: %s [-z zona] traza...\n", argv[0]);
+                return 1;
+        }
+    }
+    if(optind >= argc) {
+        fprintf(stderr, "uso: %s [-z zona] traza...\n", argv[0]);
+        return 1;
+    }
+    for(int i = optind; i < argc; i++) traza_leer(argv[i], zona);
+    if(n_serie == 0) {
+        fprintf(stderr, "sin lecturas validas de la zona %d\n", zona);
+        return 1;
+    }
+    serie_t = malloc(n_serie * sizeof(muestra_t));
+    serie_h = malloc(n_serie * sizeof(muestra_t));
+    if(!serie_t || !serie_h) {
+        perror("malloc");
+        return 1;
+    }
+
+    printf("traza: %lu lecturas (%lu fallidas), %zu muestras de %d s (%.1f h)\n",
+           n_lecturas, n_fallos, n_serie, PASO_MS / 1000, n_serie * (PASO_MS / 1000.0) / 3600);
+    printf("latido cada %d muestras; error en unidades del sensor (max, rms)\n\n",
+           MUESTREO_MAX_PASOS);
+    printf("politica       puntos escrituras ahorro  celda    err T max/rms   err H max/rms\n");
+
+    correr(-1, -1, &fijo);
+    imprimir("fijo", &fijo, &fijo);
+    for(size_t b = 0; b < sizeof(bandas) / sizeof(bandas[0]); b++) {
+        correr(bandas[b][0], bandas[b][1], &r);
+        snprintf(nombre, sizeof(nombre), "banda %d/%d%s", bandas[b][0], bandas[b][1],
+                 (bandas[b][0] == MUESTREO_BANDA_T && bandas[b][1] == MUESTREO_BANDA_H) ? "*" : "");
+        imprimir(nombre, &r, &fijo);
+    }
+    return 0;
+}
@@ -0,0 +1,41 @@
+/*
+ * File: cobs.c
+ * COBS de las tramas de telemetria (ver cobs.h)
+ */
+#include "cobs.h"
+
+void cobs_codificar(const uint8_t *d, uint8_t n, uint8_t *buf, uint8_t pos, uint8_t len)
+{
+    uint8_t cod = 1, cod_pos = pos, w;
+
+    w = (pos + 1 >= len) ? 0 : pos + 1;
+    while(n--) {
+        if(*d == 0) {
+            buf[cod_pos] = cod;
+            cod_pos = w;
+            cod = 1;
+        } else {
+            buf[w] = *d;
+            cod++;
+        }
+        w = (w + 1 >= len) ? 0 : w + 1;
+        d++;
+    }
+    buf[cod_pos] = cod;
+    buf[w] = 0x00;
+}
+
+uint8_t cobs_decodificar(uint8_t *t, uint8_t len)
+{
+    uint8_t i = 0, cod;
+
+    if(len == 0) return 0;
+    for(;;) {
+        cod = t[i];
+        if(cod == 0 || cod > len - i) return 0;
+        // Los codigos despues del primero son los ceros de los datos
+        if(i) t[i] = 0;
+        if(cod == len - i) return 1;
+        i += cod;
+    }
+}
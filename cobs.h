@@ -0,0 +1,27 @@
+/*
+ * File: cobs.h
+ * COBS (Consistent Overhead Byte Stuffing) de las tramas de telemetria
+ *
+ * Cada 0x00 de los datos se reemplaza por la distancia al siguiente; el
+ * primer byte es la distancia al primer cero y la trama termina en 0x00.
+ * Con n < 254 hay un solo grupo: n bytes de datos ocupan siempre n + 2.
+ *
+ * cobs_codificar() escribe en un anillo (uart.c) o en un buffer lineal
+ * (pos = 0 y len >= n + 2). cobs_decodificar() deshace la trama en el
+ * mismo buffer, sin copiar los datos: pone en 0 los bytes de codigo y los
+ * datos quedan desde t + 1.
+ */
+#ifndef COBS_H
+#define COBS_H
+
+#include <stdint.h>
+
+#define COBS_LEN(n)  ((n) + 2)   // Trama de n bytes con el 0x00 final
+
+// Codifica n bytes (n < 254) desde buf[pos], dando la vuelta en len
+void cobs_codificar(const uint8_t *d, uint8_t n, uint8_t *buf, uint8_t pos, uint8_t len);
+// Trama sin el 0x00 final; los datos (len - 1 bytes) quedan desde t + 1.
+// 0 si la trama esta mal
+uint8_t cobs_decodificar(uint8_t *t, uint8_t len);
+
+#endif /* COBS_H */
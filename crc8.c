@@ -0,0 +1,18 @@
+/*
+ * File: crc8.c
+ * CRC-8 (polinomio 0x07, valor inicial 0) bit a bit: sin tabla en flash
+ */
+#include "crc8.h"
+
+uint8_t crc8(const uint8_t *d, uint8_t len)
+{
+    uint8_t crc = 0;
+
+    while(len--) {
+        crc ^= *d++;
+        for(uint8_t b = 0; b < 8; b++) {
+            crc = (crc & 0x80) ? (uint8_t)(crc << 1) ^ 0x07 : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
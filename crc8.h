@@ -0,0 +1,12 @@
+/*
+ * File: crc8.h
+ * CRC-8 (polinomio 0x07, valor inicial 0) para el historial y la telemetria
+ */
+#ifndef CRC8_H
+#define CRC8_H
+
+#include <stdint.h>
+
+uint8_t crc8(const uint8_t *d, uint8_t len);
+
+#endif /* CRC8_H */
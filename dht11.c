@@ -12,13 +12,10 @@
  */
 
 /*==================[inclusiones]============================================*/
-#include <xc.h>
+#include "hal.h"
 #include "dht11.h"
 
 /*==================[definiciones y macros]==================================*/
-// Timer0: Fosc/4 = 5MHz, sin prescaler = 0.2us por tick
-// Timeout de 255 ticks = 51us (suficiente para detectar errores)
-#define DHT11_TIMEOUT        (255)    
 #define DHT11_DATA_SIZE      (5)
 
 #define TRUE  1
@@ -31,57 +28,60 @@
 #define dht11_GPIO_Read()    PIN_DHT11
 
 // Timer0: prescaler 1:4 para mejor resolucin
-// Con prescaler 1:4: tick = 0.8us
-#define dht11_TMR_Reset()    TMR0 = 0
+// Con prescaler 1:4: tick = 0.8us (Timer0 corre libre como base de tiempo)
 #define dht11_TMR_Read()     TMR0
 #define dht11_TMR_Config()   OPTION_REGbits.T0CS = 0; OPTION_REGbits.PSA = 0; OPTION_REGbits.PS = 0b001;
 
+// Captura por interrupcion externa (RB0/INT) en flanco descendente. Un
+// bit '0' deja ~23us de margen al umbral: mientras dura la trama (~5ms)
+// PEIE queda apagado para que I2C, UART, EEPROM y Timer2 no demoren la
+// marca de un flanco. El tick lo atiende la ISR de main.c igual (mira
+// TMR2IF en cada entrada); el desborde de Timer0 (T0IE, cada ~205us) la
+// hace entrar aunque el sensor no responda, y a los DHT11_MAX_DESBORDES
+// dht11_desborde() corta la captura: PEIE nunca queda apagado mas de ~6ms
+#define dht11_INT_Armar()    OPTION_REGbits.INTEDG = 0; INTCONbits.INTF = 0; \
+                             dht11_peie = INTCONbits.PEIE; INTCONbits.PEIE = 0; \
+                             INTCONbits.T0IF = 0; INTCONbits.T0IE = 1; INTCONbits.INTE = 1;
+#define dht11_INT_Parar()    if(INTCONbits.INTE) { INTCONbits.INTE = 0; INTCONbits.T0IE = 0; \
+                             INTCONbits.PEIE = dht11_peie; }
+
 /*==================[definiciones de datos internos]=========================*/
 static uint8_t dht11_byte[DHT11_DATA_SIZE];
-static uint8_t dht11_aux;
+static uint8_t dht11_periodo[DHT11_FLANCOS];
+static volatile uint8_t dht11_n = DHT11_ESPERA;
+static volatile uint8_t dht11_t_prev;
+static volatile uint8_t dht11_desbordes;
+static uint8_t dht11_peie;   // PEIE antes de armar la captura
 
 /*==================[definiciones de funciones internas]=====================*/
 /**
- * @brief       Lee un byte enviado por el mdulo DHT11
- * @return      1 si la recepcin fue correcta
- *              0 si hubo timeout
- * @note        Guarda el resultado en una variable global auxiliar (dht11_aux)
+ * @brief       Captura una trama completa esperando activamente
+ * @return      Nada
+ * @note        Usado por las lecturas bloqueantes
  */
-static uint8_t dht11_read_byte() {
-    uint8_t i;
-    uint8_t timer_val;
-    dht11_aux = 0;
-    
-    // Recibo 8 bits (MSB primero)
-    for(i = 0; i < 8; i++) {
-        // Espero flanco ascendente (el pulso en bajo siempre es ~50us)
-        dht11_TMR_Reset();
-        while(!dht11_GPIO_Read()) {
-            if(dht11_TMR_Read() > DHT11_TIMEOUT) return FALSE;
-        }
-        
-        // Mido la duracin del pulso en alto
-        // Si el pulso dura ~26-28us es un '0'
-        // Si el pulso dura ~70us es un '1'
-        dht11_TMR_Reset();
-        while(dht11_GPIO_Read()) {
-            if(dht11_TMR_Read() > DHT11_TIMEOUT) return FALSE;
+static void dht11_read_frame(void) {
+    uint8_t desbordes = 0;
+
+    // Seal de inicio: mnimo 18ms en bajo segn datasheet
+    dht11_start();
+    __delay_ms(20);  // 20ms para asegurar
+
+    // Liberar el bus y capturar la trama; los desbordes de Timer0 se
+    // cuentan aca, sin su interrupcion
+    dht11_capture();
+    INTCONbits.T0IE = 0;
+    INTCONbits.T0IF = 0;
+    while(!dht11_done() && desbordes < DHT11_MAX_DESBORDES) {
+        // Sin interrupciones globales se atiende el flanco a mano
+        if(!INTCONbits.GIE && INTCONbits.INTF) {
+            dht11_isr();
         }
-        
-        timer_val = dht11_TMR_Read();
-        
-        // Desplazo el bit
-        dht11_aux <<= 1;
-        
-        // Con prescaler 1:4: 0.8us por tick
-        // Pulso '0' = ~28us = 35 ticks
-        // Pulso '1' = ~70us = 87 ticks
-        // Umbral: 50 ticks = 40us (punto medio)
-        if(timer_val > 50) {
-            dht11_aux |= 0x01;
+        if(INTCONbits.T0IF) {
+            INTCONbits.T0IF = 0;
+            desbordes++;
         }
+        HAL_ESPERA();
     }
-    return TRUE;
 }
 
 /*==================[definiciones de funciones externas]=====================*/
@@ -92,70 +92,251 @@ static uint8_t dht11_read_byte() {
 void dht11_config(void) {
     dht11_GPIO_High();
     dht11_TMR_Config();
+    dht11_INT_Parar();
 }
 
 /**
- * @brief       Lee los datos del mdulo DHT11
- * @param[in]   *phum: Direccin de la variable donde guardar la humedad
- * @param[in]   *ptemp: Direccin de la variable donde guardar la temperatura
- * @return      1 si la recepcin fue correcta
- *              0 si hubo timeout o error de checksum
+ * @brief       Inicia la senal de arranque (linea en bajo)
+ * @return      Nada
+ * @note        La linea debe quedar en bajo al menos 18ms antes de
+ *              llamar a dht11_capture()
  */
-uint8_t dht11_read(float *phum, float *ptemp) {
-    uint8_t i;
-    uint8_t checksum;
-    
-    // Seal de inicio: mnimo 18ms en bajo segn datasheet
+void dht11_start(void) {
+    dht11_INT_Parar();
     dht11_GPIO_Low();
-    __delay_ms(20);  // 20ms para asegurar
-    
-    // Liberar el bus y esperar respuesta del sensor
+}
+
+/**
+ * @brief       Libera la linea y arma la captura de flancos
+ * @return      Nada
+ * @note        A partir de aqui la trama se recibe en dht11_isr() sin
+ *              ocupar la CPU (~4ms)
+ */
+void dht11_capture(void) {
+    dht11_n = DHT11_ESPERA;
+    dht11_desbordes = 0;
     dht11_GPIO_High();
-    __delay_us(30);  // Esperar 20-40us
-    
-    // Esperar respuesta del DHT11: flanco descendente (~80us en alto)
-    dht11_TMR_Reset();
-    while(dht11_GPIO_Read()) {
-        if(dht11_TMR_Read() > DHT11_TIMEOUT) {
-            return FALSE;  // Timeout esperando respuesta
+    dht11_INT_Armar();
+}
+
+/**
+ * @brief       Guarda el periodo entre flancos descendentes
+ * @return      Nada
+ * @note        Llamar desde la ISR cuando INTF e INTE
+ */
+void dht11_isr(void) {
+    uint8_t t = dht11_TMR_Read();
+
+    INTCONbits.INTF = 0;
+    if(dht11_n == DHT11_ESPERA) {
+        dht11_n = 0;  // Primer flanco: inicio de la respuesta
+    } else {
+        dht11_periodo[dht11_n] = t - dht11_t_prev;
+        dht11_n++;
+        if(dht11_n >= DHT11_FLANCOS) {
+            dht11_INT_Parar();
         }
     }
-    
-    // Esperar flanco ascendente: DHT11 mantiene bajo por ~80us
-    dht11_TMR_Reset();
-    while(!dht11_GPIO_Read()) {
-        if(dht11_TMR_Read() > DHT11_TIMEOUT) {
-            return FALSE;  // Timeout en seal de respuesta
-        }
+    dht11_t_prev = t;
+}
+
+/**
+ * @brief       Cuenta un desborde de Timer0 durante la captura
+ * @return      Nada
+ * @note        Llamar desde la ISR cuando T0IE y T0IF. Si la trama no
+ *              termino en DHT11_MAX_DESBORDES (~6ms) corta la captura y
+ *              vuelve PEIE: sin respuesta del sensor, la cola I2C y la
+ *              EEPROM no quedan paradas hasta dht11_finish_raw()
+ */
+void dht11_desborde(void) {
+    INTCONbits.T0IF = 0;
+    dht11_desbordes++;
+    if(dht11_desbordes >= DHT11_MAX_DESBORDES) {
+        dht11_INT_Parar();
     }
-    
-    // Esperar flanco descendente: DHT11 mantiene alto por ~80us
-    dht11_TMR_Reset();
-    while(dht11_GPIO_Read()) {
-        if(dht11_TMR_Read() > DHT11_TIMEOUT) {
-            return FALSE;  // Timeout en seal de respuesta
-        }
+}
+
+/**
+ * @brief       Indica si ya se capturo la trama completa
+ * @return      1 si llegaron los 41 periodos
+ */
+uint8_t dht11_done(void) {
+    return dht11_n != DHT11_ESPERA && dht11_n >= DHT11_FLANCOS;
+}
+
+/**
+ * @brief       Indica si la captura de flancos esta armada
+ * @return      1 entre dht11_capture() y el ultimo flanco, el corte por
+ *              desbordes o dht11_finish_raw()
+ * @note        Timer0 se detiene en SLEEP: mientras tanto no se puede dormir
+ */
+uint8_t dht11_capturando(void) {
+    return INTCONbits.INTE;
+}
+
+/**
+ * @brief       Copia los 5 bytes de la ultima trama decodificada
+ * @param[out]  *datos: 5 bytes tal como llegaron del sensor
+ * @return      Nada
+ * @note        Solo corresponden a la ultima lectura si dio DHT11_OK o
+ *              DHT11_ERR_CHECKSUM
+ */
+void dht11_raw(uint8_t *datos) {
+    uint8_t i;
+
+    for(i = 0; i < DHT11_DATA_SIZE; i++) {
+        datos[i] = dht11_byte[i];
     }
-    
-    // Ahora el DHT11 enviar 40 bits de datos (5 bytes)
+}
+
+/**
+ * @brief       Convierte los periodos capturados en los 5 bytes del sensor
+ * @param[in]   *periodo: Periodos entre flancos descendentes (ticks de 0.8us)
+ * @param[in]   n: Cantidad de periodos validos
+ * @param[out]  *datos: 5 bytes (hum. entera, hum. decimal, temp. entera,
+ *              temp. decimal, checksum)
+ * @return      DHT11_OK o el codigo de error correspondiente
+ * @note        No toca el hardware: sirve igual para una traza grabada
+ */
+uint8_t dht11_decode(const uint8_t *periodo, uint8_t n, uint8_t *datos) {
+    uint8_t i;
+    uint8_t p;
+    uint8_t checksum;
+
+    if(n == 0 || n == DHT11_ESPERA) {
+        return DHT11_ERR_RESPUESTA;  // El sensor no respondio
+    }
+    if(periodo[0] < DHT11_RESP_MIN) {
+        return DHT11_ERR_TIEMPO;     // Respuesta demasiado corta
+    }
+    if(n < DHT11_FLANCOS) {
+        return DHT11_ERR_TIMEOUT;    // Trama incompleta
+    }
+
     for(i = 0; i < DHT11_DATA_SIZE; i++) {
-        if(!dht11_read_byte()) {
-            return FALSE;  // Error leyendo byte
+        datos[i] = 0;
+    }
+
+    // Recibo 40 bits (MSB primero)
+    for(i = 0; i < DHT11_FLANCOS - 1; i++) {
+        p = periodo[i + 1];
+        if(p < DHT11_BIT_MIN || p > DHT11_BIT_MAX) {
+            return DHT11_ERR_TIEMPO;
+        }
+        datos[i >> 3] <<= 1;
+        if(p > DHT11_BIT_UMBRAL) {
+            datos[i >> 3] |= 0x01;
         }
-        dht11_byte[i] = dht11_aux;
     }
-    
+
     // Verificar checksum
-    checksum = dht11_byte[0] + dht11_byte[1] + dht11_byte[2] + dht11_byte[3];
-    if(checksum != dht11_byte[4]) {
-        return FALSE;  // Error de checksum
+    checksum = datos[0] + datos[1] + datos[2] + datos[3];
+    if(checksum != datos[4]) {
+        return DHT11_ERR_CHECKSUM;
+    }
+    return DHT11_OK;
+}
+
+// Fuera de rango no entra en Q8.8 (255 daria negativo) o es un DHT22
+static uint8_t dht11_en_rango(const uint8_t *datos) {
+    return datos[0] <= DHT11_HUM_MAX && datos[2] <= DHT11_TEMP_MAX &&
+           datos[1] <= DHT11_DECIMAS_MAX && datos[3] <= DHT11_DECIMAS_MAX;
+}
+
+/**
+ * @brief       Convierte los 5 bytes de una trama del DHT11 a punto fijo
+ * @param[in]   *datos: Trama con el checksum ya verificado
+ * @param[out]  *phum: Humedad (Q8.8)
+ * @param[out]  *ptemp: Temperatura (Q8.8)
+ * @return      DHT11_OK, o DHT11_ERR_RANGO si un valor sale de dht11.h
+ * @note        No toca el hardware; dht11m.c la usa para cada zona
+ */
+uint8_t dht11_convertir(const uint8_t *datos, q8_t *phum, q8_t *ptemp) {
+    if(!dht11_en_rango(datos)) {
+        return DHT11_ERR_RANGO;
     }
-    
+    // Parte entera en el byte alto, decimas convertidas a 1/256
+    *phum  = Q8_DE_ENTERO(datos[0]) + Q8_DECIMAS(datos[1]);
+    *ptemp = Q8_DE_ENTERO(datos[2]) + Q8_DECIMAS(datos[3]);
+    return DHT11_OK;
+}
+
+/**
+ * @brief       Termina la captura y decodifica los 5 bytes, sin convertir
+ * @return      DHT11_OK o el codigo de error correspondiente
+ * @note        Los bytes quedan para dht11_raw(); dht22.c convierte con
+ *              su propio formato
+ */
+uint8_t dht11_finish_raw(void) {
+    dht11_INT_Parar();
+    return dht11_decode(dht11_periodo, dht11_n, dht11_byte);
+}
+
+/**
+ * @brief       Termina la captura y decodifica la trama en punto fijo
+ * @param[in]   *phum: Direccion de la variable donde guardar la humedad (Q8.8)
+ * @param[in]   *ptemp: Direccion de la variable donde guardar la temperatura (Q8.8)
+ * @return      DHT11_OK o el codigo de error correspondiente
+ */
+uint8_t dht11_finish_fixed(q8_t *phum, q8_t *ptemp) {
+    uint8_t res;
+
+    res = dht11_finish_raw();
+    if(res != DHT11_OK) {
+        return res;
+    }
+    return dht11_convertir(dht11_byte, phum, ptemp);
+}
+
+/**
+ * @brief       Lee los datos del mdulo DHT11 en punto fijo (bloqueante)
+ * @param[in]   *phum: Direccion de la variable donde guardar la humedad (Q8.8)
+ * @param[in]   *ptemp: Direccion de la variable donde guardar la temperatura (Q8.8)
+ * @return      1 si la recepcin fue correcta
+ *              0 si hubo timeout o error de checksum
+ */
+uint8_t dht11_read_fixed(q8_t *phum, q8_t *ptemp) {
+    dht11_read_frame();
+    return dht11_finish_fixed(phum, ptemp) == DHT11_OK ? TRUE : FALSE;
+}
+
+#ifdef USE_FLOAT
+/**
+ * @brief       Termina la captura y decodifica la trama
+ * @param[in]   *phum: Direccion de la variable donde guardar la humedad
+ * @param[in]   *ptemp: Direccion de la variable donde guardar la temperatura
+ * @return      DHT11_OK o el codigo de error correspondiente
+ */
+uint8_t dht11_finish(float *phum, float *ptemp) {
+    uint8_t res;
+
+    dht11_INT_Parar();
+    res = dht11_decode(dht11_periodo, dht11_n, dht11_byte);
+    if(res != DHT11_OK) {
+        return res;
+    }
+    if(!dht11_en_rango(dht11_byte)) {
+        return DHT11_ERR_RANGO;
+    }
+
     // Formatear los datos
     *phum  = ((float)dht11_byte[0]) + ((float)dht11_byte[1]) / 10.0;
     *ptemp = ((float)dht11_byte[2]) + ((float)dht11_byte[3]) / 10.0;
-    
-    return TRUE;
+
+    return DHT11_OK;
+}
+
+/**
+ * @brief       Lee los datos del mdulo DHT11
+ * @param[in]   *phum: Direccin de la variable donde guardar la humedad
+ * @param[in]   *ptemp: Direccin de la variable donde guardar la temperatura
+ * @return      1 si la recepcin fue correcta
+ *              0 si hubo timeout o error de checksum
+ */
+uint8_t dht11_read(float *phum, float *ptemp) {
+    dht11_read_frame();
+    return dht11_finish(phum, ptemp) == DHT11_OK ? TRUE : FALSE;
 }
+#endif
 
 /*==================[fin del archivo]========================================*/
\ No newline at end of file
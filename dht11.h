@@ -13,14 +13,66 @@
 
 /*==================[inclusiones]============================================*/
 #include <stdint.h>
+#include "fixpt.h"
 
 /*==================[macros]=================================================*/
-#define PIN_DHT11   PORTAbits.RA0
-#define TRIS_DHT11  TRISAbits.TRISA0
+// RB0/INT: cada flanco descendente de la trama genera una interrupcion
+#define PIN_DHT11   PORTBbits.RB0
+#define TRIS_DHT11  TRISBbits.TRISB0
+
+#define DHT11_FLANCOS   (41)    // Periodos capturados: respuesta + 40 bits
+
+// Periodos entre flancos descendentes, en ticks de Timer0 (0.8us), para
+// dht11.c y dht11m.c.
+// Timer0 es de 8 bits: la resta modulo 256 vale para periodos < 204us.
+// Respuesta: 80us bajo + 80us alto = ~200 ticks
+// Bit '0':   50us bajo + 26-28us alto = ~96 ticks
+// Bit '1':   50us bajo + 70us alto    = ~150 ticks
+#define DHT11_RESP_MIN       (150)    // 120us
+#define DHT11_BIT_MIN        (75)     // 60us
+#define DHT11_BIT_UMBRAL     (125)    // 100us: por encima es un '1'
+#define DHT11_BIT_MAX        (212)    // 170us
+#define DHT11_ESPERA         (0xFF)   // Aun no llego el primer flanco
+#define DHT11_MAX_DESBORDES  (30)     // ~6ms de Timer0 para la trama
+
+// Resultado de la decodificacion
+#define DHT11_OK             0
+#define DHT11_ERR_RESPUESTA  1  // El sensor no respondio
+#define DHT11_ERR_TIMEOUT    2  // Trama incompleta
+#define DHT11_ERR_TIEMPO     3  // Periodo fuera de rango (ruido o jitter)
+#define DHT11_ERR_CHECKSUM   4
+#define DHT11_ERR_RANGO      5  // Valor imposible con checksum correcto
+
+// Valores posibles de una trama del DHT11 (la hoja dice 20-90 % y 0-50 C;
+// algunas versiones llegan a 60 C). Las decimas van de 0 a 9: con el bit 7
+// esas versiones marcan una temperatura negativa, que la muestra del
+// DHT11 (entera, sin signo) no guarda
+#define DHT11_HUM_MAX        100
+#define DHT11_TEMP_MAX       60
+#define DHT11_DECIMAS_MAX    9
 
 /*==================[declaraciones de funciones externas]====================*/
 void dht11_config (void);
+uint8_t dht11_read_fixed (q8_t *phum, q8_t *ptemp);
+#ifdef USE_FLOAT
 uint8_t dht11_read (float *phum, float *ptemp);
+#endif
+
+// Lectura no bloqueante: start, >=18ms, capture, ~5ms, finish
+void dht11_start (void);
+void dht11_capture (void);
+void dht11_isr (void);
+uint8_t dht11_done (void);
+void dht11_desborde (void);      // Desde la ISR con T0IE y T0IF
+uint8_t dht11_capturando (void);
+uint8_t dht11_finish_fixed (q8_t *phum, q8_t *ptemp);
+#ifdef USE_FLOAT
+uint8_t dht11_finish (float *phum, float *ptemp);
+#endif
+uint8_t dht11_decode (const uint8_t *periodo, uint8_t n, uint8_t *datos);
+uint8_t dht11_convertir (const uint8_t *datos, q8_t *phum, q8_t *ptemp);
+uint8_t dht11_finish_raw (void);
+void dht11_raw (uint8_t *datos);  // Ultima trama (telemetria)
 
 /*==================[fin del archivo]========================================*/
 #endif /* _DHT11_H_ */
\ No newline at end of file
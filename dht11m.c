@@ -0,0 +1,147 @@
+/*
+ * File: dht11m.c
+ * Varios DHT11 en el mismo puerto, leidos en paralelo (ver dht11m.h)
+ */
+#include "hal.h"
+#include "dht11m.h"
+#include "sensor.h"
+#include "sched.h"
+
+#define DHT11M_BYTES  5
+
+static uint8_t zona_byte[DHT_ZONAS][DHT11M_BYTES];
+static uint8_t zona_n[DHT_ZONAS];       // Periodos recibidos o DHT11_ESPERA
+static uint8_t zona_t[DHT_ZONAS];       // Timer0 en el ultimo flanco
+static uint8_t zona_estado[DHT_ZONAS];
+
+// Flanco descendente de una zona: el periodo desde el anterior es un bit
+// (o la respuesta, el primero). Retorna 1 si la zona ya no espera mas
+static uint8_t dht11m_flanco(uint8_t z, uint8_t t)
+{
+    uint8_t p = t - zona_t[z];
+    uint8_t n = zona_n[z];
+    uint8_t *b;
+
+    zona_t[z] = t;
+    if(n == DHT11_ESPERA) {
+        zona_n[z] = 0;  // Inicio de la respuesta
+        return 0;
+    }
+    if(n == 0) {
+        if(p < DHT11_RESP_MIN) {
+            zona_estado[z] = DHT11_ERR_TIEMPO;
+            return 1;
+        }
+    } else {
+        if(p < DHT11_BIT_MIN || p > DHT11_BIT_MAX) {
+            zona_estado[z] = DHT11_ERR_TIEMPO;
+            return 1;
+        }
+        // MSB primero; cada byte recibe 8 bits, no hace falta borrarlo
+        b = &zona_byte[z][(n - 1) >> 3];
+        *b <<= 1;
+        if(p > DHT11_BIT_UMBRAL) *b |= 0x01;
+    }
+    zona_n[z] = ++n;
+    return n >= DHT11_FLANCOS;
+}
+
+void dht11m_config(void)
+{
+    DHT11M_TRIS |= DHT11M_MASCARA;
+    INTCONbits.INTE = 0;
+
+    // Timer0 libre con prescaler 1:4 (0.8 us), igual que dht11.c
+    OPTION_REGbits.T0CS = 0;
+    OPTION_REGbits.PSA = 0;
+    OPTION_REGbits.PS = 0b001;
+}
+
+void dht11m_start(void)
+{
+    DHT11M_PUERTO &= (uint8_t)~DHT11M_MASCARA;
+    DHT11M_TRIS &= (uint8_t)~DHT11M_MASCARA;
+}
+
+uint8_t dht11m_capture(void)
+{
+    uint8_t z, bit, t, p, ant, caidas;
+    uint8_t pendientes = DHT11M_MASCARA;
+    uint8_t desbordes = 0;
+    uint8_t ok = 0;
+    uint8_t gie = INTCONbits.GIE;
+    uint8_t *d;
+
+    for(z = 0; z < DHT_ZONAS; z++) {
+        zona_n[z] = DHT11_ESPERA;
+        zona_estado[z] = DHT11_OK;
+    }
+
+    INTCONbits.GIE = 0;
+    DHT11M_TRIS |= DHT11M_MASCARA;  // Soltar todas las lineas
+    ant = DHT11M_PUERTO;
+    INTCONbits.T0IF = 0;
+
+    while(pendientes && desbordes < DHT11_MAX_DESBORDES) {
+        // Una muestra del puerto: los flancos de bajada de todas las zonas
+        p = DHT11M_PUERTO;
+        caidas = ant & ~p & pendientes;
+        ant = p;
+        if(caidas) {
+            t = TMR0;
+            for(z = 0, bit = 1; z < DHT_ZONAS; z++, bit <<= 1) {
+                if((caidas & bit) && dht11m_flanco(z, t)) {
+                    pendientes &= ~bit;
+                }
+            }
+        }
+        if(INTCONbits.T0IF) {
+            INTCONbits.T0IF = 0;
+            desbordes++;
+        }
+        // Sin interrupciones globales el tick se atiende a mano
+        if(SCHED_TICK_PENDIENTE()) {
+            sched_tick_isr();
+        }
+        HAL_ESPERA();
+    }
+    INTCONbits.GIE = gie;
+
+    for(z = 0; z < DHT_ZONAS; z++) {
+        d = zona_byte[z];
+        if(zona_estado[z] != DHT11_OK) continue;
+        if(zona_n[z] == DHT11_ESPERA) {
+            zona_estado[z] = DHT11_ERR_RESPUESTA;
+        } else if(zona_n[z] < DHT11_FLANCOS) {
+            zona_estado[z] = DHT11_ERR_TIMEOUT;
+        } else if((uint8_t)(d[0] + d[1] + d[2] + d[3]) != d[4]) {
+            zona_estado[z] = DHT11_ERR_CHECKSUM;
+        } else {
+            ok |= 1 << z;
+        }
+    }
+    return ok;
+}
+
+uint8_t dht11m_estado(uint8_t zona)
+{
+    return zona_estado[zona];
+}
+
+uint8_t dht11m_finish_fixed(uint8_t zona, q8_t *phum, q8_t *ptemp)
+{
+    if(zona_estado[zona] == DHT11_OK) {
+        // Formato del sensor elegido (la trama es la misma en los dos)
+        zona_estado[zona] = sensor_convertir(zona_byte[zona], phum, ptemp);
+    }
+    return zona_estado[zona];
+}
+
+void dht11m_raw(uint8_t zona, uint8_t *datos)
+{
+    uint8_t i;
+
+    for(i = 0; i < DHT11M_BYTES; i++) {
+        datos[i] = zona_byte[zona][i];
+    }
+}
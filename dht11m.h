@@ -0,0 +1,51 @@
+/*
+ * File: dht11m.h
+ * Varios DHT11 en el mismo puerto, leidos en paralelo (una zona por sensor)
+ *
+ * Hasta 4 sensores en RB0..RB3, cada uno con su pull-up. dht11m_start()
+ * baja todas las lineas juntas y dht11m_capture() las suelta y muestrea el
+ * puerto entero: cada lectura de PORTB trae un bit de cada zona. Los
+ * flancos descendentes de todas las lineas salen de una sola operacion por
+ * muestra y se reparten por zona en el momento, con la marca de Timer0 de
+ * esa muestra. Por zona solo se guarda el ultimo flanco, la cuenta de
+ * periodos y los 5 bytes: la traza no cabe en la RAM del PIC16F887.
+ *
+ * Cada zona tiene su checksum y su codigo de error (DHT11_OK,
+ * DHT11_ERR_*): un sensor que no responde no afecta a los demas. Sirve
+ * igual para DHT22 (sensor.h): la trama es la misma.
+ *
+ * La captura es bloqueante (~5 ms) y con GIE apagado, porque la latencia
+ * de las otras interrupciones corre los flancos mas que el margen entre un
+ * '0' y un '1'; el tick del planificador se atiende a mano en el bucle.
+ * Procesar un flanco lleva unos pocos us por zona: con muchas zonas que
+ * caen en la misma muestra los flancos que llegan mientras tanto se marcan
+ * tarde. Con 4 zonas el peor caso queda dentro del margen de +-20 us;
+ * con mas ya no, y por eso el limite.
+ */
+#ifndef DHT11M_H
+#define DHT11M_H
+
+#include <stdint.h>
+#include "fixpt.h"
+#include "dht11.h"
+
+#ifndef DHT_ZONAS
+#define DHT_ZONAS  1   // Sensores en RB0..RB(DHT_ZONAS-1)
+#endif
+
+#if DHT_ZONAS < 1 || DHT_ZONAS > 4
+#error "DHT_ZONAS debe estar entre 1 y 4 (margen de tiempo, ver arriba)"
+#endif
+
+#define DHT11M_PUERTO   PORTB
+#define DHT11M_TRIS     TRISB
+#define DHT11M_MASCARA  ((uint8_t)((1u << DHT_ZONAS) - 1))
+
+void dht11m_config(void);
+void dht11m_start(void);     // Todas las lineas en bajo (>= 18 ms)
+uint8_t dht11m_capture(void);  // Bloqueante; retorna la mascara de zonas OK
+uint8_t dht11m_estado(uint8_t zona);  // DHT11_OK o DHT11_ERR_*
+uint8_t dht11m_finish_fixed(uint8_t zona, q8_t *phum, q8_t *ptemp);
+void dht11m_raw(uint8_t zona, uint8_t *datos);  // 5 bytes de la zona
+
+#endif /* DHT11M_H */
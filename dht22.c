@@ -0,0 +1,42 @@
+/*
+ * File: dht22.c
+ * Formato de datos del DHT22 sobre la captura de dht11.c
+ */
+#include "dht22.h"
+
+// Decimas (0..1250) a Q8.8: x * 256 / 10 exacto, sin pasar por float
+static q8_t dht22_decimas(uint16_t d)
+{
+    return (q8_t)(((uint32_t)d << 8) / 10);
+}
+
+uint8_t dht22_convertir(const uint8_t *datos, q8_t *phum, q8_t *ptemp)
+{
+    uint16_t h = ((uint16_t)datos[0] << 8) | datos[1];
+    uint16_t t = ((uint16_t)(datos[2] & 0x7F) << 8) | datos[3];
+
+    // Con el checksum bien, un valor fuera de la hoja de datos es un
+    // sensor defectuoso o un DHT11 en el lugar del DHT22
+    if(h > DHT22_HUM_MAX || t > ((datos[2] & 0x80) ? DHT22_TEMP_MIN : DHT22_TEMP_MAX)) {
+        return DHT11_ERR_RANGO;
+    }
+    *phum = dht22_decimas(h);
+    *ptemp = dht22_decimas(t);
+    if(datos[2] & 0x80) {
+        *ptemp = -*ptemp;
+    }
+    return DHT11_OK;
+}
+
+uint8_t dht22_finish_fixed(q8_t *phum, q8_t *ptemp)
+{
+    uint8_t datos[5];
+    uint8_t res;
+
+    res = dht11_finish_raw();
+    if(res != DHT11_OK) {
+        return res;
+    }
+    dht11_raw(datos);
+    return dht22_convertir(datos, phum, ptemp);
+}
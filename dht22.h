@@ -0,0 +1,34 @@
+/*
+ * File: dht22.h
+ * DHT22 (AM2302): la misma trama que el DHT11 con otro formato de datos
+ *
+ * En el cable el DHT22 es igual al DHT11 (respuesta de 80 + 80 us, bits de
+ * 50 us en bajo y 26-28 / 70 us en alto, checksum de los 4 bytes), asi que
+ * la captura por RB0/INT es la de dht11.c. Cambian el pulso de arranque
+ * (1 a 20 ms en bajo) y los datos: humedad en decimas de 16 bits y
+ * temperatura en decimas con el bit 15 como signo (no complemento a 2).
+ */
+#ifndef DHT22_H
+#define DHT22_H
+
+#include <stdint.h>
+#include "fixpt.h"
+#include "dht11.h"
+
+#define DHT22_ARRANQUE_MS  2      // Pulso de arranque (minimo 1 ms)
+#define DHT22_HUM_MAX      1000   // 100.0 %
+#define DHT22_TEMP_MAX     800    // 80.0 C
+#define DHT22_TEMP_MIN     400    // -40.0 C (magnitud con el signo)
+
+// Captura: la de dht11.c
+#define dht22_config()    dht11_config()
+#define dht22_start()     dht11_start()
+#define dht22_capture()   dht11_capture()
+#define dht22_isr()       dht11_isr()
+#define dht22_desborde()  dht11_desborde()
+#define dht22_raw(d)      dht11_raw(d)
+
+uint8_t dht22_convertir(const uint8_t *datos, q8_t *phum, q8_t *ptemp);
+uint8_t dht22_finish_fixed(q8_t *phum, q8_t *ptemp);
+
+#endif /* DHT22_H */
@@ -0,0 +1,338 @@
+/*
+ * File: eelog.c
+ * Historial de lecturas en la EEPROM interna, con nivelado de desgaste
+ */
+#include "eelog.h"
+#include "eeprom.h"
+#include "logpack.h"
+#include "crc8.h"
+
+#define EELOG_SEQ    0
+#define EELOG_T0     1
+#define EELOG_H0     (EELOG_T0 + MUESTRA_BYTES)
+#define EELOG_MARCA  (EELOG_H0 + MUESTRA_BYTES)
+#define EELOG_CRC    (EELOG_MARCA + 2)
+#define EELOG_CAB    (EELOG_CRC + 1)    // Bytes de cabecera
+#define EELOG_DATOS  EELOG_CAB
+
+#if EELOG_CAB + PACK_BYTES != EELOG_SLOT_LEN
+#error "PACK_BYTES no coincide con la cabecera del bloque"
+#endif
+
+static uint8_t eelog_cabeza;   // Bloque abierto (el mas nuevo)
+static uint8_t eelog_seq;      // seq del bloque abierto
+static uint8_t eelog_bloques = 0;
+static uint16_t eelog_n = 0;
+static uint16_t eelog_marca = 0;   // Marca que le toca a la proxima lectura
+
+// Copia en RAM de los deltas del bloque abierto
+static uint8_t eelog_datos[PACK_BYTES];
+static Pack eelog_pack;
+
+// Muestra de la cabecera (little endian)
+static muestra_t eelog_muestra(const uint8_t *p)
+{
+#if MUESTRA_BYTES == 2
+    return (muestra_t)(p[0] | (uint16_t)p[1] << 8);
+#else
+    return p[0];
+#endif
+}
+
+static void eelog_poner(uint8_t *p, muestra_t v)
+{
+    p[0] = (uint8_t)v;
+#if MUESTRA_BYTES == 2
+    p[1] = (uint16_t)v >> 8;
+#endif
+}
+
+// Marca de la primera lectura del bloque: la del keyframe, o la siguiente
+// si el keyframe es solo el origen de un hueco
+static uint16_t eelog_marca_inicial(const uint8_t *cab, const uint8_t *datos)
+{
+    uint16_t m = cab[EELOG_MARCA] | (uint16_t)cab[EELOG_MARCA + 1] << 8;
+
+    if((datos[0] >> 4) == PACK_ORIGEN) m++;
+    return m;
+}
+
+// Lee la cabecera de un bloque; retorna 1 si el CRC es correcto
+static uint8_t eelog_cabecera(uint8_t slot, uint8_t *cab)
+{
+    uint8_t addr = slot * EELOG_SLOT_LEN;
+
+    for(uint8_t i = 0; i < EELOG_CAB; i++) {
+        cab[i] = EEPROM_Read(addr + i);
+    }
+    return crc8(cab, EELOG_CRC) == cab[EELOG_CRC];
+}
+
+static void eelog_leer_datos(uint8_t slot, uint8_t *datos)
+{
+    uint8_t addr = slot * EELOG_SLOT_LEN + EELOG_DATOS;
+
+    for(uint8_t i = 0; i < PACK_BYTES; i++) {
+        datos[i] = EEPROM_Read(addr + i);
+    }
+}
+
+// Lecturas guardadas en un bloque valido
+static uint8_t eelog_contar(uint8_t slot)
+{
+    uint8_t cab[EELOG_CAB];
+    uint8_t datos[PACK_BYTES];
+    Unpack u;
+    muestra_t t, h;
+    uint8_t n = 0;
+
+    eelog_cabecera(slot, cab);
+    eelog_leer_datos(slot, datos);
+    unpack_init(&u, datos, eelog_muestra(&cab[EELOG_T0]), eelog_muestra(&cab[EELOG_H0]));
+    while(unpack_next(&u, &t, &h)) {
+        n++;
+    }
+    return n;
+}
+
+static uint8_t eelog_anterior(uint8_t slot)
+{
+    return slot ? slot - 1 : EELOG_SLOTS - 1;
+}
+
+void eelog_init(void)
+{
+    uint8_t cab[EELOG_CAB];
+    uint8_t primero[EELOG_CAB];
+    uint8_t valido, primero_ok, seq_ant, ant_ok, addr;
+
+    // La cabeza es el bloque valido al que no sigue su seq + 1. Se recorre
+    // el anillo una vez comparando cada bloque con el anterior; el bloque 0
+    // se compara al final con el ultimo.
+    eelog_bloques = 0;
+    eelog_n = 0;
+    primero_ok = eelog_cabecera(0, primero);
+    ant_ok = primero_ok;
+    seq_ant = primero[EELOG_SEQ];
+
+    for(uint8_t s = 1; s <= EELOG_SLOTS; s++) {
+        if(s < EELOG_SLOTS) {
+            valido = eelog_cabecera(s, cab);
+        } else {
+            valido = primero_ok;
+            cab[EELOG_SEQ] = primero[EELOG_SEQ];
+        }
+
+        if(ant_ok && !(valido && cab[EELOG_SEQ] == (uint8_t)(seq_ant + 1))) {
+            eelog_cabeza = s - 1;
+            eelog_seq = seq_ant;
+            eelog_bloques = 1;
+            break;
+        }
+        ant_ok = valido;
+        seq_ant = cab[EELOG_SEQ];
+    }
+
+    if(eelog_bloques == 0) {
+        // EEPROM vacia: el primer bloque va al slot 0
+        eelog_cabeza = EELOG_SLOTS - 1;
+        eelog_seq = 0xFF;
+        return;
+    }
+
+    // Retomar el bloque abierto donde quedo
+    eelog_cabecera(eelog_cabeza, cab);
+    eelog_leer_datos(eelog_cabeza, eelog_datos);
+    eelog_n = pack_resume(&eelog_pack, eelog_datos, eelog_muestra(&cab[EELOG_T0]),
+                          eelog_muestra(&cab[EELOG_H0]));
+    eelog_marca = eelog_marca_inicial(cab, eelog_datos) + eelog_n;
+
+    // Un corte a mitad de un codigo de varios bytes puede dejar restos
+    // despues del fin: borrarlos antes de seguir agregando
+    addr = eelog_cabeza * EELOG_SLOT_LEN + EELOG_DATOS;
+    for(uint8_t i = 0; i < PACK_BYTES; i++) {
+        if(EEPROM_Read(addr + i) != eelog_datos[i]) {
+            EEPROM_Write(addr + i, eelog_datos[i]);
+        }
+    }
+
+    // Contar hacia atras mientras la secuencia siga
+    seq_ant = eelog_seq;
+    for(uint8_t s = eelog_anterior(eelog_cabeza); eelog_bloques < EELOG_SLOTS; s = eelog_anterior(s)) {
+        if(!eelog_cabecera(s, cab) || cab[EELOG_SEQ] != (uint8_t)(seq_ant - 1)) break;
+        seq_ant = cab[EELOG_SEQ];
+        eelog_bloques++;
+        eelog_n += eelog_contar(s);
+    }
+}
+
+// CRC para invalidar el bloque viejo mientras se pisa su cabecera: ninguna
+// de las cabeceras a medio escribir (la vieja con los bytes nuevos hasta
+// el i) puede darlo por bueno. Con solo invertir el CRC viejo, una de
+// cada 256 lo daba y un corte dejaba un bloque valido con la seq vieja
+static uint8_t eelog_crc_provisorio(uint8_t addr, const uint8_t *nueva)
+{
+    uint8_t mezcla[EELOG_CAB];
+    uint8_t malos[EELOG_CRC];
+    uint8_t c, i;
+
+    for(i = 0; i < EELOG_CAB; i++) {
+        mezcla[i] = EEPROM_Read(addr + i);
+    }
+    for(i = 0; i < EELOG_CRC; i++) {
+        if(i > EELOG_SEQ) mezcla[i] = nueva[i];
+        malos[i] = crc8(mezcla, EELOG_CRC);
+    }
+
+    c = ~mezcla[EELOG_CRC];
+    for(i = 0; i < EELOG_CRC; i++) {
+        if(malos[i] == c) {
+            c++;
+            i = 0xFF;   // Volver a mirar todos
+        }
+    }
+    return c;
+}
+
+// Abre un bloque nuevo con (temp, hum) como keyframe, de la marca dada; con
+// origen, el keyframe es solo el origen del hueco que sigue (no cuenta como
+// lectura)
+static void eelog_abrir(uint8_t origen, uint16_t marca, muestra_t temp, muestra_t hum)
+{
+    uint8_t cab[EELOG_CAB];
+    uint8_t addr;
+
+    eelog_cabeza++;
+    if(eelog_cabeza >= EELOG_SLOTS) eelog_cabeza = 0;
+    eelog_seq++;
+
+    // Anillo lleno: se pisa el bloque mas viejo
+    if(eelog_bloques == EELOG_SLOTS) {
+        eelog_n -= eelog_contar(eelog_cabeza);
+    } else {
+        eelog_bloques++;
+    }
+
+    if(origen) {
+        pack_init_origen(&eelog_pack, eelog_datos, temp, hum);
+    } else {
+        pack_init(&eelog_pack, eelog_datos, temp, hum);
+    }
+
+    cab[EELOG_SEQ] = eelog_seq;
+    eelog_poner(&cab[EELOG_T0], temp);
+    eelog_poner(&cab[EELOG_H0], hum);
+    cab[EELOG_MARCA] = (uint8_t)marca;
+    cab[EELOG_MARCA + 1] = marca >> 8;
+    cab[EELOG_CRC] = crc8(cab, EELOG_CRC);
+
+    // Invalidar el bloque viejo, borrar sus deltas (solo los bytes que no
+    // estan ya como deben quedar: 0xFF, o el nibble de origen) y escribir
+    // la cabecera con la seq al final: si el corte llega antes, el bloque
+    // conserva la seq vieja con datos y CRC nuevos y no se acepta
+    addr = eelog_cabeza * EELOG_SLOT_LEN;
+    EEPROM_Write(addr + EELOG_CRC, eelog_crc_provisorio(addr, cab));
+    for(uint8_t i = 0; i < PACK_BYTES; i++) {
+        if(EEPROM_Read(addr + EELOG_DATOS + i) != eelog_datos[i]) {
+            EEPROM_Write(addr + EELOG_DATOS + i, eelog_datos[i]);
+        }
+    }
+    for(uint8_t i = EELOG_SEQ + 1; i < EELOG_CAB; i++) {
+        EEPROM_Write(addr + i, cab[i]);
+    }
+    EEPROM_Write(addr + EELOG_SEQ, eelog_seq);
+}
+
+// Graba los bytes que cambio el ultimo pack_add()
+static void eelog_escribir(void)
+{
+    uint8_t addr, i;
+
+    // Del ultimo byte al primero: el nibble inicial del codigo va al final
+    addr = eelog_cabeza * EELOG_SLOT_LEN + EELOG_DATOS;
+    for(i = eelog_pack.mod_fin; ; i--) {
+        EEPROM_Write(addr + i, eelog_datos[i]);
+        if(i == eelog_pack.mod_ini) break;
+    }
+}
+
+void eelog_append(muestra_t temp, muestra_t hum)
+{
+    eelog_append_hueco(0, eelog_marca, temp, hum);
+}
+
+void eelog_append_hueco(uint8_t hueco, uint16_t marca, muestra_t temp, muestra_t hum)
+{
+    if(!eelog_bloques) {
+        hueco = 0;  // Sin lectura anterior la recta no tiene origen
+        eelog_abrir(0, marca, temp, hum);
+    } else if(marca == (uint16_t)(eelog_marca + hueco) &&
+              pack_add_hueco(&eelog_pack, eelog_datos, hueco, temp, hum)) {
+        eelog_escribir();
+    } else if(hueco) {
+        // El bloque nuevo arranca con el hueco: su keyframe es la ultima
+        // lectura guardada, solo como origen de la recta
+        eelog_abrir(1, marca - hueco - 1, eelog_pack.t, eelog_pack.h);
+        pack_add_hueco(&eelog_pack, eelog_datos, hueco, temp, hum);
+        eelog_escribir();
+    } else {
+        // Bloque lleno, o un salto en la serie (corte de energia, lectura
+        // fallida, reloj puesto en hora): otro keyframe con su marca
+        eelog_abrir(0, marca, temp, hum);
+    }
+    eelog_n += hueco + 1;
+    eelog_marca = marca + 1;
+}
+
+uint16_t eelog_total(void)
+{
+    return eelog_n;
+}
+
+uint8_t eelog_seq_abierto(void)
+{
+    return eelog_seq;
+}
+
+uint8_t eelog_bloque(uint8_t seq)
+{
+    uint8_t atras = eelog_seq - seq;   // Bloques antes del abierto
+    uint8_t slot;
+
+    if(atras == 0 || atras >= eelog_bloques) return EELOG_NINGUNO;
+    slot = eelog_cabeza + EELOG_SLOTS - atras;
+    if(slot >= EELOG_SLOTS) slot -= EELOG_SLOTS;
+    return slot;
+}
+
+void eelog_replay(uint16_t ultimas, Eelog_Fn fn)
+{
+    uint8_t cab[EELOG_CAB];
+    uint8_t datos[PACK_BYTES];
+    Unpack u;
+    muestra_t t, h;
+    uint8_t slot;
+    uint16_t marca;
+    uint16_t saltar = (eelog_n > ultimas) ? eelog_n - ultimas : 0;
+
+    // Bloque mas viejo
+    slot = eelog_cabeza + EELOG_SLOTS + 1 - eelog_bloques;
+    if(slot >= EELOG_SLOTS) slot -= EELOG_SLOTS;
+
+    for(uint8_t b = 0; b < eelog_bloques; b++) {
+        eelog_cabecera(slot, cab);
+        eelog_leer_datos(slot, datos);
+        unpack_init(&u, datos, eelog_muestra(&cab[EELOG_T0]), eelog_muestra(&cab[EELOG_H0]));
+        marca = eelog_marca_inicial(cab, datos);
+        while(unpack_next(&u, &t, &h)) {
+            if(saltar) {
+                saltar--;
+            } else {
+                fn(marca, t, h);
+            }
+            marca++;
+        }
+        slot++;
+        if(slot >= EELOG_SLOTS) slot = 0;
+    }
+}
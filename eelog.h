@@ -0,0 +1,58 @@
+/*
+ * File: eelog.h
+ * Historial de lecturas en la EEPROM interna, con nivelado de desgaste
+ *
+ * Los 256 bytes se usan como un anillo de EELOG_SLOTS bloques de 16 bytes
+ * mas los 16 del final, que son el indice del archivo externo (archivo.h):
+ *
+ *   [seq][T0][H0][marca][crc8] [10 bytes de deltas en nibbles (logpack.h)]
+ *
+ * T0 y H0 son muestra_t (fixpt.h): con el DHT22 ocupan dos bytes cada uno
+ * (little endian) y quedan 8 bytes de deltas por bloque.
+ *
+ * La cabecera es el keyframe del bloque; las lecturas siguientes se
+ * agregan como deltas hasta llenar el bloque y entonces se abre el
+ * siguiente. Con lecturas cada 20 s caben ~20 por bloque (~300 en total)
+ * contra 64 lecturas de 4 bytes sin comprimir. Las lecturas que no se
+ * guardan (eelog_append_hueco) cuentan igual: eelog_total() y
+ * eelog_replay() las entregan reconstruidas, una cada 20 s.
+ *
+ * La marca (16 bits, little endian) es el tiempo del keyframe en pasos de
+ * la serie (rtc_marca(), 20 s); la lectura i del bloque tiene la marca + i,
+ * asi que cada lectura lleva su hora sin gastar un byte. Si la marca de
+ * una lectura no es la que sigue en el bloque (corte de energia, una
+ * lectura perdida) se abre un bloque nuevo.
+ *
+ * seq crece en 1 con cada bloque (modulo 256) y el CRC8 cubre seq, T0, H0
+ * y la marca. No hay indice guardado: eelog_init() busca la cabeza como el bloque
+ * valido cuyo siguiente no continua la secuencia. Al abrir un bloque
+ * primero va un CRC que ninguna cabecera a medio escribir da por bueno, y
+ * la seq se escribe al final; y en cada lectura los bytes de deltas se
+ * escriben del ultimo al primero: un corte deja el codigo nuevo sin su
+ * primer nibble y la lectura simplemente no aparece.
+ */
+#ifndef EELOG_H
+#define EELOG_H
+
+#include <stdint.h>
+#include "fixpt.h"
+
+#define EELOG_SLOT_LEN  16
+#define EELOG_SLOTS     (256 / EELOG_SLOT_LEN - 1)
+#define EELOG_INDICE    (EELOG_SLOTS * EELOG_SLOT_LEN)  // 16 bytes para archivo.c
+#define EELOG_NINGUNO   0xFF
+
+typedef void (*Eelog_Fn)(uint16_t marca, muestra_t temp, muestra_t hum);
+
+void eelog_init(void);                          // Busca la cabeza
+void eelog_append(muestra_t temp, muestra_t hum);  // Con la marca que sigue
+// (temp, hum) de la marca dada tras `hueco` lecturas no guardadas
+// (1..PACK_HUECO_MAX), que la lectura reconstruye sobre la recta desde la
+// anterior (ver muestreo.h)
+void eelog_append_hueco(uint8_t hueco, uint16_t marca, muestra_t temp, muestra_t hum);
+uint16_t eelog_total(void);                     // Lecturas guardadas
+void eelog_replay(uint16_t ultimas, Eelog_Fn fn);  // De la mas vieja a la mas nueva
+uint8_t eelog_seq_abierto(void);                // seq del bloque abierto
+uint8_t eelog_bloque(uint8_t seq);  // Slot del bloque cerrado con esa seq, o EELOG_NINGUNO
+
+#endif /* EELOG_H */
@@ -0,0 +1,125 @@
+/*
+ * File: eeprom.c
+ * EEPROM de datos interna del PIC16F887
+ */
+#include "eeprom.h"
+#include "prof.h"
+
+static uint8_t eeprom_cola_addr[EEPROM_COLA_LEN];
+static uint8_t eeprom_cola_dato[EEPROM_COLA_LEN];
+
+// eeprom_wr solo lo mueve el programa principal, eeprom_rd solo la ISR
+static volatile uint8_t eeprom_wr = 0;
+static volatile uint8_t eeprom_rd = 0;
+static volatile uint8_t eeprom_activo = 0;  // Hay una escritura en curso
+
+// Arranca la escritura del frente de la cola (con GIE apagado o desde la ISR)
+static void eeprom_iniciar(void)
+{
+    PROF_INICIO(PROF_EEPROM);
+    EEADR = eeprom_cola_addr[eeprom_rd];
+    EEDAT = eeprom_cola_dato[eeprom_rd];
+    EEPGD = 0;
+    WREN = 1;
+    EECON2 = 0x55;
+    EECON2 = 0xAA;
+    WR = 1;
+}
+
+// Atiende el fin de escritura a mano si las interrupciones estan apagadas
+static void eeprom_poll(void)
+{
+    if(!INTCONbits.GIE && PIR2bits.EEIF) {
+        EEPROM_Isr();
+        return;   // El llamador vuelve a mirar la cola antes de esperar
+    }
+    HAL_ESPERA();
+}
+
+void EEPROM_Write(uint8_t addr, uint8_t data)
+{
+    uint8_t sig = eeprom_wr + 1;
+    uint8_t gie;
+
+    if(sig >= EEPROM_COLA_LEN) sig = 0;
+
+    // Cola llena: esperar a que la ISR grabe un byte
+    while(sig == eeprom_rd) {
+        eeprom_poll();
+    }
+
+    eeprom_cola_addr[eeprom_wr] = addr;
+    eeprom_cola_dato[eeprom_wr] = data;
+
+    // La secuencia 0x55/0xAA no admite interrupciones en medio
+    gie = INTCONbits.GIE;
+    INTCONbits.GIE = 0;
+    eeprom_wr = sig;
+    if(!eeprom_activo) {
+        eeprom_activo = 1;
+        PIR2bits.EEIF = 0;
+        PIE2bits.EEIE = 1;   // PEIE lo prenden los *_Init: aca pisaria la captura del sensor
+        eeprom_iniciar();
+    }
+    INTCONbits.GIE = gie;
+}
+
+uint8_t EEPROM_Read(uint8_t addr)
+{
+    uint8_t i, dato;
+    uint8_t ie = PIE2bits.EEIE;
+
+    // Sin EEIE la ISR no toca la cola ni EEADR mientras se lee
+    PIE2bits.EEIE = 0;
+
+    // Lo encolado mas nuevo para esta direccion manda sobre la EEPROM
+    i = eeprom_wr;
+    while(i != eeprom_rd) {
+        i = i ? i - 1 : EEPROM_COLA_LEN - 1;
+        if(eeprom_cola_addr[i] == addr) {
+            dato = eeprom_cola_dato[i];
+            PIE2bits.EEIE = ie;
+            return dato;
+        }
+    }
+
+    // EEADR no se puede cambiar con una escritura en curso
+    while(WR) HAL_ESPERA();
+    EEADR = addr;
+    EEPGD = 0;
+    RD = 1;
+    dato = EEDAT;
+
+    PIE2bits.EEIE = ie;
+    return dato;
+}
+
+uint8_t EEPROM_Busy(void)
+{
+    return eeprom_activo;
+}
+
+void EEPROM_Flush(void)
+{
+    while(eeprom_activo) {
+        eeprom_poll();
+    }
+}
+
+void EEPROM_Isr(void)
+{
+    uint8_t sig = eeprom_rd + 1;
+
+    PIR2bits.EEIF = 0;
+    PROF_FIN(PROF_EEPROM);
+    if(sig >= EEPROM_COLA_LEN) sig = 0;
+    eeprom_rd = sig;
+
+    if(sig != eeprom_wr) {
+        eeprom_iniciar();
+    } else {
+        WREN = 0;
+        eeprom_activo = 0;
+        PIE2bits.EEIE = 0;
+    }
+}
@@ -0,0 +1,28 @@
+/*
+ * File: eeprom.h
+ * EEPROM de datos interna del PIC16F887 (256 bytes)
+ *
+ * Las escrituras se encolan y se atienden desde la interrupcion de fin de
+ * escritura (EEIF): EEPROM_Write() vuelve enseguida salvo que la cola este
+ * llena. EEPROM_Read() de una direccion con escritura pendiente devuelve
+ * el valor encolado.
+ */
+#ifndef EEPROM_H
+#define EEPROM_H
+
+#include "hal.h"
+#include <stdint.h>
+
+#define EEPROM_TAMANO 256
+
+#ifndef EEPROM_COLA_LEN
+#define EEPROM_COLA_LEN 8   // Bytes pendientes (dos registros del historial)
+#endif
+
+void EEPROM_Write(uint8_t addr, uint8_t data);  // Espera solo si la cola esta llena
+uint8_t EEPROM_Read(uint8_t addr);
+uint8_t EEPROM_Busy(void);
+void EEPROM_Flush(void);   // Espera a que todo quede grabado (antes de apagar)
+void EEPROM_Isr(void);     // Llamar desde la ISR cuando EEIF y EEIE
+
+#endif /* EEPROM_H */
@@ -0,0 +1,72 @@
+/*
+ * File: eeprom_ext.c
+ * EEPROM externa 24LC256 (32 KB) en el bus I2C (ver eeprom_ext.h)
+ */
+#include "hal.h"
+#include "eeprom_ext.h"
+
+// tWC de 5 ms con margen: cada intento dura al menos EEXT_PAUSA_US, sea
+// cual sea la velocidad del bus
+#define EEXT_INTENTOS  60
+#define EEXT_PAUSA_US  100
+
+void EEXT_Begin(uint16_t addr)
+{
+    I2C_Queue_Begin(EEXT_ADDR);
+    I2C_Queue_Put(addr >> 8);
+    I2C_Queue_Put(addr & 0xFF);
+}
+
+uint8_t EEXT_Put(uint8_t data)
+{
+    return I2C_Queue_Put(data);
+}
+
+uint8_t EEXT_Commit(volatile uint8_t *done)
+{
+    return I2C_Queue_Commit(done, 0);
+}
+
+uint8_t EEXT_Poll(volatile uint8_t *done)
+{
+    return I2C_Queue_Write(EEXT_ADDR, 0, 0, done, 0);
+}
+
+// Toma el bus con la direccion de escritura, reintentando mientras el
+// chip graba; sin ACK deja el bus libre
+static uint8_t eext_direccion(void)
+{
+    for(uint8_t i = 0; i < EEXT_INTENTOS; i++) {
+        I2C_Start();
+        if(!I2C_Write(EEXT_ADDR)) return 1;
+        I2C_Stop();
+        __delay_us(EEXT_PAUSA_US);
+    }
+    return 0;
+}
+
+uint8_t EEXT_Wait(void)
+{
+    if(!eext_direccion()) return 0;
+    I2C_Stop();
+    return 1;
+}
+
+uint8_t EEXT_Read(uint16_t addr, uint8_t *buf, uint16_t len)
+{
+    if(!eext_direccion()) return 0;
+    I2C_Write(addr >> 8);
+    I2C_Write(addr & 0xFF);
+    I2C_Restart();
+    I2C_Write(EEXT_ADDR | 1);
+    while(len--) {
+        *buf++ = I2C_Read();
+        if(len) {
+            I2C_Ack();
+        } else {
+            I2C_Nack();   // Fin de la rafaga
+        }
+    }
+    I2C_Stop();
+    return 1;
+}
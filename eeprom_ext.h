@@ -0,0 +1,42 @@
+/*
+ * File: eeprom_ext.h
+ * EEPROM externa 24LC256 (32 KB) en el bus I2C
+ *
+ * Escritura por paginas de 64 bytes a traves de la cola de i2c.h: el
+ * programa encola direccion + datos (EEXT_Begin/Put/Commit) y sigue
+ * trabajando. Dentro de una escritura la direccion da la vuelta en la
+ * pagina, asi que una rafaga debe empezar y terminar en la misma pagina
+ * (si cruza el borde pisa el principio de la pagina).
+ *
+ * El chip graba la pagina despues del STOP (tWC, a lo sumo 5 ms) y no da
+ * ACK a su direccion mientras tanto. En lugar de esperar 5 ms fijos se
+ * sondea: EEXT_Poll() encola una transaccion de solo la direccion y el
+ * resultado (I2C_OK o I2C_NACK) dice si la escritura termino.
+ *
+ * EEXT_Read() es bloqueante: una sola rafaga con direccion (escritura del
+ * puntero, RESTART y lectura secuencial), de cualquier largo; al final del
+ * chip la lectura sigue desde la direccion 0.
+ */
+#ifndef EEPROM_EXT_H
+#define EEPROM_EXT_H
+
+#include <stdint.h>
+#include "i2c.h"
+
+#define EEXT_ADDR     0xA0    // A2..A0 a masa (7 bits: 0x50)
+#define EEXT_TAMANO   32768u
+#define EEXT_PAGINA   64
+#define EEXT_PAGINAS  (EEXT_TAMANO / EEXT_PAGINA)
+
+#if EEXT_PAGINA + 2 > I2C_BUF_LEN
+#error "Una pagina con su direccion no entra en la cola de i2c.h"
+#endif
+
+void EEXT_Begin(uint16_t addr);                    // Espera si la cola esta llena
+uint8_t EEXT_Put(uint8_t data);                    // 0 si la rafaga no cabe
+uint8_t EEXT_Commit(volatile uint8_t *done);
+uint8_t EEXT_Poll(volatile uint8_t *done);         // *done = I2C_OK: escritura terminada
+uint8_t EEXT_Wait(void);                           // Sondea bloqueando; 0 si no responde
+uint8_t EEXT_Read(uint16_t addr, uint8_t *buf, uint16_t len);  // 0 si no responde
+
+#endif /* EEPROM_EXT_H */
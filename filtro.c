@@ -0,0 +1,50 @@
+/*
+ * File: filtro.c
+ * Filtro de picos de las lecturas del sensor (ver filtro.h)
+ */
+#include "filtro.h"
+#include "stats.h"   // Canales STATS_TEMP y STATS_HUM
+#include "prof.h"
+
+static q8_t filtro_ant[STATS_CANALES][2];   // [0] la mas vieja
+static uint8_t filtro_n = 0;                // Lecturas en la ventana (hasta 2)
+
+void filtro_init(void)
+{
+    filtro_n = 0;
+}
+
+// Mediana de tres sin ordenar: max(min(a, b), min(max(a, b), c))
+static q8_t filtro_mediana(q8_t a, q8_t b, q8_t c)
+{
+    q8_t lo = a < b ? a : b;
+    q8_t hi = a < b ? b : a;
+
+    if(c < hi) hi = c;
+    return lo > hi ? lo : hi;
+}
+
+static q8_t filtro_canal(uint8_t c, q8_t x, q8_t umbral)
+{
+    q8_t *w = filtro_ant[c];
+    q8_t m, d, y = x;   // En el rango de los sensores la resta entra en 16 bits
+
+    if(filtro_n == 2) {
+        m = filtro_mediana(w[0], w[1], x);
+        d = x - m;
+        if(d > umbral || d < -umbral) {
+            y = m;
+            PROF_EVENTO(PROF_EV_PICO);
+        }
+    }
+    w[0] = w[1];
+    w[1] = x;
+    return y;
+}
+
+void filtro_paso(q8_t *phum, q8_t *ptemp)
+{
+    *ptemp = filtro_canal(STATS_TEMP, *ptemp, FILTRO_UMBRAL_T);
+    *phum = filtro_canal(STATS_HUM, *phum, FILTRO_UMBRAL_H);
+    if(filtro_n < 2) filtro_n++;
+}
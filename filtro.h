@@ -0,0 +1,38 @@
+/*
+ * File: filtro.h
+ * Filtro de picos de las lecturas del sensor (mediana de 3 con umbral)
+ *
+ * Un pico suelto con checksum correcto (un bit mal leido en el sensor, un
+ * glitch en la alimentacion) no debe llegar al registro, a los LEDs ni a
+ * la tendencia. Por canal se guardan las dos lecturas validas anteriores
+ * y cada lectura nueva x se compara con la mediana m de las tres
+ * (identificador de Hampel con ventana de 3):
+ *
+ *   |x - m| <= umbral   pasa x, sin retardo
+ *   |x - m| >  umbral   pasa m
+ *
+ * El ruido normal pasa tal cual. Un pico solo sale reemplazado por la
+ * lectura anterior; un cambio real mas grande que el umbral llega una
+ * lectura tarde, cuando la segunda lo confirma. La ventana es de lecturas
+ * crudas (no de las ya filtradas), asi que un escalon no queda trabado.
+ * Las dos primeras lecturas pasan sin filtrar. La telemetria manda la
+ * trama cruda: el analisis ve los picos; con PROF (prof.h) se cuentan.
+ * RAM: 9 bytes.
+ */
+#ifndef FILTRO_H
+#define FILTRO_H
+
+#include <stdint.h>
+#include "fixpt.h"
+
+#ifndef FILTRO_UMBRAL_T
+#define FILTRO_UMBRAL_T  Q8_DE_ENTERO(2)   // C: el error del DHT11
+#endif
+#ifndef FILTRO_UMBRAL_H
+#define FILTRO_UMBRAL_H  Q8_DE_ENTERO(5)   // %
+#endif
+
+void filtro_init(void);
+void filtro_paso(q8_t *phum, q8_t *ptemp);  // Reemplaza los picos en el lugar
+
+#endif /* FILTRO_H */
@@ -0,0 +1,62 @@
+/*
+ * File: fixpt.h
+ * Aritmetica de punto fijo Q8.8 para PIC16F887
+ *
+ * q8_t: 8 bits enteros con signo + 8 bits fraccionarios (1/256).
+ * Alcanza para -128..127.99, o sea temperatura y humedad de DHT11/DHT22.
+ *
+ * valor_t es el tipo con el que trabaja el analisis: Q8.8 por defecto,
+ * float si se compila con USE_FLOAT (arrastra la libreria soft-float).
+ *
+ * muestra_t es lo que se guarda (historial, estadisticas) y se muestra:
+ * un entero en 1/MUESTRA_ESCALA de grado o de %, con la resolucion del
+ * sensor elegido al compilar (sensor.h). El DHT11 da enteros y cabe en un
+ * byte; el DHT22 da decimas con signo y ocupa dos.
+ */
+#ifndef FIXPT_H
+#define FIXPT_H
+
+#include <stdint.h>
+
+typedef int16_t q8_t;
+
+#define Q8_UNO              256
+#define Q8_DE_ENTERO(x)     ((q8_t)((int16_t)(x) << 8))
+#define Q8_ENTERO(q)        ((int16_t)(q) >> 8)          // Trunca hacia -inf
+#define Q8_DECIMAS(d)       ((q8_t)(((d) * 205) >> 3))   // d/10 en Q8.8 (d = 0..9)
+
+#ifdef USE_FLOAT
+typedef float valor_t;
+#define VALOR_DE_ENTERO(x)      ((float)(x))
+#define VALOR_ENTERO(v)         ((int16_t)(v))
+#define VALOR_PROMEDIO(suma, n) ((float)(suma) / (n))
+#define VALOR_DE_Q8(q)          ((float)(q) / Q8_UNO)
+#else
+typedef q8_t valor_t;
+#define VALOR_DE_ENTERO(x)      Q8_DE_ENTERO(x)
+#define VALOR_ENTERO(v)         ((v) < 0 ? -Q8_ENTERO(-(v)) : Q8_ENTERO(v))   // Hacia 0, como float
+#define VALOR_PROMEDIO(suma, n) ((q8_t)(((int32_t)(suma) << 8) / (n)))
+#define VALOR_DE_Q8(q)          (q)
+#endif
+
+// ========== MUESTRAS ==========
+#ifdef SENSOR_DHT22
+typedef int16_t muestra_t;   // Decimas: -40.0..80.0 C, 0..99.9 %
+#define MUESTRA_ESCALA  10
+#define MUESTRA_BYTES   2
+#else
+typedef uint8_t muestra_t;   // Enteros: 0..50 C, 20..90 %
+#define MUESTRA_ESCALA  1
+#define MUESTRA_BYTES   1
+#endif
+
+// Redondeo al mas cercano
+#ifdef USE_FLOAT
+#define MUESTRA_DE_VALOR(v)  ((muestra_t)((v) * MUESTRA_ESCALA + ((v) < 0 ? -0.5f : 0.5f)))
+#else
+#define MUESTRA_DE_VALOR(v)  ((muestra_t)(((int32_t)(v) * MUESTRA_ESCALA + Q8_UNO / 2) >> 8))
+#endif
+
+// Para el LCD: fmt_muestra() en fmt.h
+
+#endif /* FIXPT_H */
@@ -0,0 +1,99 @@
+/*
+ * File: fmt.c
+ * Campos numericos de ancho fijo para el LCD (ver fmt.h)
+ */
+#include "fmt.h"
+
+#define FMT_DIGITOS  5   // 65535
+
+static const uint16_t fmt_pot10[FMT_DIGITOS - 1] = { 10000, 1000, 100, 10 };
+
+// Digitos de v en d, el mas significativo primero, sin ceros a la
+// izquierda pero con al menos `min` digitos. Retorna cuantos escribio
+static uint8_t fmt_digitos(char *d, uint16_t v, uint8_t min)
+{
+    uint8_t i, n = 0;
+    char c;
+
+    for(i = 0; i < FMT_DIGITOS - 1; i++) {
+        c = '0';
+        while(v >= fmt_pot10[i]) {
+            v -= fmt_pot10[i];
+            c++;
+        }
+        if(n || c != '0' || FMT_DIGITOS - i <= min) {
+            d[n++] = c;
+        }
+    }
+    d[n++] = '0' + (char)v;
+    return n;
+}
+
+// Campo de ancho fijo con el modulo v, el signo y dec decimales (0 o 1)
+static char *fmt_campo(char *p, uint16_t v, uint8_t neg, uint8_t dec, uint8_t ancho)
+{
+    char d[FMT_DIGITOS];
+    uint8_t n, largo;
+    char *fin = p + ancho;
+
+    n = fmt_digitos(d, v, dec + 1);
+    largo = n + neg + dec;
+    if(dec && largo > ancho) {
+        // Sin el decimal (truncado) antes que los asteriscos
+        n--;
+        largo -= 2;
+        dec = 0;
+    }
+    if(largo > ancho) {
+        while(p < fin) *p++ = '*';
+        return fin;
+    }
+    while(largo < ancho) {
+        *p++ = ' ';
+        largo++;
+    }
+    if(neg) *p++ = '-';
+    for(largo = 0; largo < n; largo++) {
+        *p++ = d[largo];
+        if(dec && largo == n - 2) *p++ = '.';
+    }
+    return fin;
+}
+
+char *fmt_txt(char *p, const char *s)
+{
+    while(*s) *p++ = *s++;
+    return p;
+}
+
+char *fmt_natural(char *p, uint16_t v, uint8_t ancho)
+{
+    return fmt_campo(p, v, 0, 0, ancho);
+}
+
+// El modulo en uint16_t: -32768 tambien tiene representacion
+char *fmt_entero(char *p, int16_t v, uint8_t ancho)
+{
+    if(v < 0) return fmt_campo(p, 0u - (uint16_t)v, 1, 0, ancho);
+    return fmt_campo(p, (uint16_t)v, 0, 0, ancho);
+}
+
+char *fmt_decimas(char *p, int16_t v, uint8_t ancho)
+{
+    if(v < 0) return fmt_campo(p, 0u - (uint16_t)v, 1, 1, ancho);
+    return fmt_campo(p, (uint16_t)v, 0, 1, ancho);
+}
+
+char *fmt_dos(char *p, uint8_t v)
+{
+    char d = '0';
+
+    if(v > 99) return fmt_txt(p, "**");
+    while(v >= 10) {
+        v -= 10;
+        d++;
+    }
+    *p++ = d;
+    *p++ = '0' + (char)v;
+    return p;
+}
@@ -0,0 +1,38 @@
+/*
+ * File: fmt.h
+ * Campos numericos de ancho fijo para el LCD, sin sprintf ni divisiones
+ *
+ * Cada funcion escribe exactamente `ancho` caracteres a partir de p,
+ * alineados a la derecha y rellenos con espacios, y retorna p + ancho; sin
+ * terminador. p apunta normalmente al framebuffer (Lcd_Fb_At()), asi los
+ * campos se encadenan sin buffer intermedio:
+ *
+ *   p = fmt_txt(Lcd_Fb_At(1, 1), "T:");
+ *   p = fmt_entero(p, -5, 3);        // "T: -5"
+ *
+ * Los digitos salen restando potencias de 10 de una tabla (a lo sumo 9
+ * restas por digito): el PIC16 no tiene division y las rutinas de la
+ * biblioteca (awdiv, doprnt) cuestan mas memoria de programa que todo este
+ * modulo. Un valor que no entra en el ancho se muestra como '*'; con
+ * decimas primero se prueba sin el decimal ("100.0" en 4 es " 100").
+ */
+#ifndef FMT_H
+#define FMT_H
+
+#include <stdint.h>
+#include "fixpt.h"
+
+char *fmt_txt(char *p, const char *s);  // Copia s sin el terminador
+char *fmt_natural(char *p, uint16_t v, uint8_t ancho);
+char *fmt_entero(char *p, int16_t v, uint8_t ancho);
+char *fmt_decimas(char *p, int16_t v, uint8_t ancho);  // 123 -> "12.3"
+char *fmt_dos(char *p, uint8_t v);  // "07": horas y minutos, con cero
+
+// muestra_t en su resolucion (grados enteros o decimas, segun el sensor)
+#if MUESTRA_ESCALA == 10
+#define fmt_muestra(p, m, ancho)  fmt_decimas(p, m, ancho)
+#else
+#define fmt_muestra(p, m, ancho)  fmt_entero(p, m, ancho)
+#endif
+
+#endif /* FMT_H */
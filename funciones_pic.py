@@ -0,0 +1,124 @@
+"""
+Funciones de la imagen del PIC
+==============================
+Lista las funciones de un .hex de XC8 (por defecto dist/default/production/
+lcd.X.production.hex) con los símbolos de su .sym: dirección, tamaño en
+palabras y cantidad de RETURN/RETLW, más el total de memoria de programa
+ocupada. Es un análisis estático: no ejecuta la imagen ni cuenta ciclos.
+
+- Del .sym salen el inicio (_funcion) y el fin (__end_of_funcion) de
+  cada función; del .hex, las instrucciones de retorno dentro de ese rango.
+- Si en el .sym no están las funciones del planificador (sched_init,
+  sched_run), la imagen no es de esta versión del programa y se avisa: la
+  de dist/ es la anterior, con DHT22_read y punto flotante, hasta que se
+  vuelva a compilar con MPLAB X.
+
+Los ciclos por función en gpsim quedaron fuera: ni gpsim ni XC8 estaban
+disponibles para compilar la versión actual, correrla y guardar una línea
+base, y sin un estímulo para el sensor y un esclavo I2C los números no
+dirían nada. Ver "Funciones de la imagen del PIC" en el README.
+
+Uso:
+    python funciones_pic.py [--hex archivo.hex] [--sym archivo.sym]
+"""
+
+import os
+import sys
+import argparse
+
+DIST = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'dist', 'default', 'production')
+HEX = os.path.join(DIST, 'lcd.X.production.hex')
+SYM = os.path.join(DIST, 'lcd.X.production.sym')
+
+PALABRAS = 8192            # Memoria de programa del PIC16F887
+ACTUALES = ('sched_init', 'sched_run')    # Solo en la versión con planificador
+
+RETURN, RETFIE = 0x0008, 0x0009
+RETLW_MASCARA, RETLW = 0x3C00, 0x3400
+
+
+# ============================================================================
+# IMAGEN Y SÍMBOLOS
+# ============================================================================
+
+def leer_hex(ruta):
+    """Intel HEX de XC8 -> {dirección de palabra: instrucción de 14 bits}"""
+    memoria, base = {}, 0
+    with open(ruta) as f:
+        for linea in f:
+            linea = linea.strip()
+            if not linea.startswith(':'):
+                continue
+            datos = bytes.fromhex(linea[1:])
+            n, addr, tipo = datos[0], datos[1] << 8 | datos[2], datos[3]
+            if tipo == 0x04:
+                base = (datos[4] << 8 | datos[5]) << 16
+            elif tipo == 0x00:
+                for i in range(0, n - 1, 2):
+                    byte = base + addr + i
+                    memoria[byte // 2] = datos[4 + i] | datos[5 + i] << 8
+    return memoria
+
+
+def leer_funciones(ruta):
+    """
+    Funciones del programa en el .sym: {nombre: (inicio, fin)} con las
+    direcciones de palabra; fin es la primera fuera de la función
+    """
+    inicio, fin = {}, {}
+    with open(ruta) as f:
+        for linea in f:
+            campos = linea.split()
+            if len(campos) < 4 or campos[3] != 'CODE':
+                continue
+            nombre, addr = campos[0], int(campos[1], 16)
+            if nombre.startswith('__end_of_'):
+                fin[nombre[len('__end_of_'):]] = addr
+            elif nombre.startswith('_'):
+                inicio[nombre[1:]] = addr
+    return {n: (inicio[n], fin[n]) for n in inicio if n in fin and fin[n] > inicio[n]}
+
+
+def retornos(memoria, inicio, fin):
+    """Direcciones de RETURN, RETLW y RETFIE en [inicio, fin)"""
+    r = []
+    for a in range(inicio, fin):
+        op = memoria.get(a)
+        if op is None:
+            continue
+        if op in (RETURN, RETFIE) or (op & RETLW_MASCARA) == RETLW:
+            r.append(a)
+    return r
+
+
+# ============================================================================
+# INFORME
+# ============================================================================
+
+def main(argv=None):
+    ap = argparse.ArgumentParser(description='Funciones de la imagen del PIC (.hex y .sym de XC8)')
+    ap.add_argument('--hex', default=HEX)
+    ap.add_argument('--sym', default=SYM)
+    a = ap.parse_args(argv)
+
+    memoria = leer_hex(a.hex)
+    funciones = leer_funciones(a.sym)
+    ret = {n: retornos(memoria, ini, fin) for n, (ini, fin) in funciones.items()}
+
+    for n, (ini, fin) in sorted(funciones.items(), key=lambda x: x[1]):
+        print(f"{n:<28} {ini:#06x}-{fin:#06x} {fin - ini:5d} palabras, "
+              f"{len(ret[n])} retornos")
+    usadas = len([d for d in memoria if d < PALABRAS])
+    print(f"\n{len(funciones)} funciones, {usadas} de {PALABRAS} palabras "
+          f"({100 * usadas / PALABRAS:.0f} %)")
+
+    faltan = [n for n in ACTUALES if n not in funciones]
+    if faltan:
+        print(f"⚠️  {os.path.basename(a.hex)} no es de esta versión (no tiene "
+              f"{', '.join(faltan)}): compilar con MPLAB X antes de sacar conclusiones",
+              file=sys.stderr)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,35 @@
+/*
+ * File: hal.h
+ * Capa de abstraccion del hardware del PIC16F887
+ *
+ * Los modulos incluyen este archivo en lugar de <xc.h>. La frontera es el
+ * registro (SFR): GPIO (PORTx/TRISx), timers (TMR0, TMR1, TMR2), MSSP
+ * (SSPxxx), EEPROM de datos (EEADR/EEDAT/EECON1) y retardos.
+ *
+ * - Por defecto (XC8) los nombres son los de <xc.h> y las macros HAL_*
+ *   no generan codigo: la imagen del PIC no cambia.
+ * - Con HAL_HOST (make host) los registros los implementa hal_host.c,
+ *   que modela el DHT11, el PCF8574 + HD44780 y la EEPROM sobre un reloj
+ *   virtual, y el mismo programa corre como ejecutable de Linux.
+ *
+ * Toda espera activa sobre un flag del hardware lleva HAL_ESPERA() en el
+ * cuerpo: en el host es donde avanza el reloj virtual.
+ */
+#ifndef HAL_H
+#define HAL_H
+
+#ifdef HAL_HOST
+
+#include "hal_host.h"
+
+#else
+
+#include <xc.h>
+
+#define HAL_INIT()     ((void)0)   // Primera linea de main()
+#define HAL_ESPERA()   ((void)0)   // Cuerpo de las esperas activas
+#define HAL_LECTURA()  ((void)0)   // Lectura valida del sensor (arranque en el host)
+
+#endif
+
+#endif /* HAL_H */
@@ -0,0 +1,1265 @@
+/*
+ * File: hal_host.c
+ * Simulador del hardware para el ejecutable de Linux (make host)
+ *
+ * Reloj virtual en ciclos de instruccion (Fosc/4 = 5 MHz, 200 ns). El
+ * programa corre a velocidad nativa y el tiempo solo avanza en
+ * HAL_ESPERA(), __delay_ms()/__delay_us() y SLEEP(): ahi se salta al
+ * proximo evento (tick de Timer2, fin de un byte I2C o de una escritura
+ * de EEPROM, flanco del DHT11) y se llama a isr() como lo haria el PIC.
+ *
+ * Modelos:
+ * - Timer0, Timer1 y Timer2 (solo reloj interno).
+ * - MSSP maestro con los dispositivos de la tabla hal_i2c (PCF8574 en
+ *   0x4E con un HD44780 de 16x2 en modo de 4 bits, con el tiempo de cada
+ *   instruccion y la lectura del busy flag con RW; DS1307 en 0xD0 con el
+ *   puntero de registro, la copia de los registros de hora al START, el
+ *   bit CH y los 56 bytes de RAM; 24LC256 en 0xA0 con escritura por
+ *   paginas de 64 bytes que da la vuelta dentro de la pagina, 3 ms de
+ *   grabacion sin ACK y lectura secuencial que da la vuelta al final).
+ * - EEPROM de datos: 4 ms por byte, EEIF al terminar.
+ * - EUSART: TXIF con TXREG + registro de desplazamiento; los bytes salen
+ *   por SIM_UART. Con SIM_UART=pty lo que se escribe en la pseudo-terminal
+ *   llega a RCREG (RCIF), un byte a la vez.
+ * - DHT11 en cada linea de PORTB (RB0 con INT): responde a un pulso bajo
+ *   de >= 18 ms con la trama de 40 bits; temperatura y humedad siguen un
+ *   ciclo diario con ruido. Cada sensor tiene su desvio de reloj. Con
+ *   -DSENSOR_DHT22 basta >= 1 ms y los datos van en decimas, con signo.
+ *
+ * Variables de entorno:
+ *   SIM_HORAS    horas virtuales a simular (24)
+ *   SIM_EEPROM   archivo con la EEPROM: se carga al iniciar y se guarda al
+ *                terminar (para probar el arranque con historial)
+ *   SIM_LCD      1 = imprimir la pantalla cada vez que cambia
+ *   SIM_UART     archivo o dispositivo donde escribir lo que transmite el
+ *                EUSART; "pty" crea una pseudo-terminal e imprime su nombre
+ *   SIM_FALLOS   porcentaje de lecturas de cada DHT11 sin respuesta (0)
+ *   SIM_CHECKSUM porcentaje de tramas con un bit de datos invertido (0)
+ *   SIM_CORTES   porcentaje de tramas que se cortan en un bit al azar (0)
+ *   SIM_PICOS    porcentaje de lecturas con un pico de 8..15 C o 15..30 %
+ *                en uno de los canales, con el checksum correcto (0)
+ *   SIM_TEMP     temperatura media del ciclo diario en C (24); el DHT11
+ *                satura en 0..50, el DHT22 llega a -40
+ *   SIM_ESCALONES  saltos bruscos de temperatura por dia (0): +-3..8 C
+ *                que se disipan en ~10 min, como una puerta abierta
+ *   SIM_RTC      hora del DS1307 al arrancar, "AAAA-MM-DD HH:MM[:SS]"
+ *                (2025-01-01 00:00, la hora 0 del ciclo diario); "no" =
+ *                sin DS1307 en el bus
+ *   SIM_EXT      archivo con la 24LC256, como SIM_EEPROM; "no" = sin
+ *                24LC256 en el bus
+ *   SIM_SEMILLA  semilla del ruido (1)
+ */
+#define _GNU_SOURCE   // posix_openpt(), cfmakeraw(), timegm()
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+#include "hal.h"
+
+void isr(void);  // main.c
+
+#define CICLOS_US      5ULL
+#define CICLOS_MS      5000ULL
+#define CICLOS_S       (1000 * CICLOS_MS)
+#define CICLOS_HORA    (3600ULL * 1000 * CICLOS_MS)
+#define NUNCA          UINT64_MAX
+
+// ========== REGISTROS ==========
+volatile INTCON_t hal_INTCON;
+volatile PIR1_t hal_PIR1;
+volatile PIE1_t hal_PIE1;
+volatile PIR2_t hal_PIR2;
+volatile PIE2_t hal_PIE2;
+volatile OPTION_REG_t hal_OPTION_REG;
+volatile T1CON_t hal_T1CON;
+volatile T2CON_t hal_T2CON;
+volatile SSPCON2_t hal_SSPCON2;
+volatile EECON1_t hal_EECON1;
+volatile RCSTA_t hal_RCSTA;
+volatile BAUDCTL_t hal_BAUDCTL;
+volatile PORTB_t hal_PORTB;
+volatile TRISB_t hal_TRISB;
+volatile TRISC_t hal_TRISC;
+volatile PORTD_t hal_PORTD;
+
+volatile uint8_t ANSEL, ANSELH, TRISD, PR2, TMR2;
+volatile uint8_t SSPSTAT, SSPCON, SSPADD;
+volatile uint8_t EEADR, EECON2;
+volatile uint8_t TXSTA, SPBRG, SPBRGH;
+volatile uint16_t hal_SSPBUF = 0x100, hal_TXREG = 0x100;
+
+static volatile uint8_t hal_tmr0, hal_tmr1h, hal_tmr1l, hal_eedat, hal_rcreg;
+
+// ========== ESTADO DEL SIMULADOR ==========
+static uint64_t ahora = 0;
+static uint64_t fin;
+static clock_t inicio_real;
+static int sim_lcd = 0;
+static int sim_fallos = 0;
+static int sim_checksum = 0, sim_cortes = 0, sim_picos = 0;
+static double sim_temp = 24;
+static double sim_escalones = 0;
+static const char *sim_eeprom = NULL;
+
+// Contadores para el resumen
+static unsigned long n_ticks, n_i2c_bytes, n_ee_escrituras, n_dht_tramas, n_dht_fallos;
+static unsigned long n_dht_checksum, n_dht_cortes, n_dht_picos;
+static unsigned long n_lcd_ocupado, n_lcd_tas;
+static uint64_t t_lectura = NUNCA, t_lectura_lcd = NUNCA;   // Arranque
+static unsigned long n_uart_bytes, n_uart_rx, n_rtc_lecturas;
+static unsigned long n_ext_paginas, n_ext_bytes, n_ext_sondeos;
+
+static void hal_fin(int codigo);
+
+// ========== TIMERS ==========
+static uint64_t t_tick = NUNCA;
+
+static uint32_t tmr0_prescaler(void)
+{
+    return OPTION_REGbits.PSA ? 1 : 2u << OPTION_REGbits.PS;
+}
+
+static uint64_t tmr2_periodo(void)
+{
+    static const uint8_t pre[4] = { 1, 4, 16, 16 };
+    return (uint64_t)(PR2 + 1) * pre[T2CONbits.T2CKPS] * (T2CONbits.TOUTPS + 1);
+}
+
+volatile uint8_t *hal_host_tmr0(void)
+{
+    hal_tmr0 = (uint8_t)(ahora / tmr0_prescaler());
+    return &hal_tmr0;
+}
+
+static uint16_t tmr1_valor(void)
+{
+    if(!T1CONbits.TMR1ON) return 0;
+    return (uint16_t)(ahora >> T1CONbits.T1CKPS);
+}
+
+volatile uint8_t *hal_host_tmr1h(void)
+{
+    hal_tmr1h = tmr1_valor() >> 8;
+    return &hal_tmr1h;
+}
+
+volatile uint8_t *hal_host_tmr1l(void)
+{
+    hal_tmr1l = tmr1_valor() & 0xFF;
+    return &hal_tmr1l;
+}
+
+// ========== HD44780 (4 bits, detras del PCF8574) ==========
+#define PCF_RS  0x01
+#define PCF_RW  0x02
+#define PCF_EN  0x04
+
+static char lcd_ddram[0x80];
+static char lcd_visto[2][17];
+static uint8_t lcd_ac, lcd_4bits, lcd_medio, lcd_alto, lcd_cgram;
+static uint8_t lcd_leido;              // La proxima lectura da el nibble bajo
+static uint64_t lcd_libre;             // Fin de la instruccion en curso
+static uint8_t pcf_puerto = 0xFF;
+static int lcd_rw = 1;                 // 0 = RW a GND en el modulo, P1 sin conectar
+
+static void lcd_byte(uint8_t b, uint8_t rs)
+{
+    // 37 us por instruccion (43 us las de datos), 1.52 ms borrar y volver
+    // al inicio. Una instruccion con el controlador ocupado se pierde en
+    // el HD44780 real; aca se cuenta y se ejecuta igual
+    if(ahora < lcd_libre) n_lcd_ocupado++;
+    lcd_libre = ahora + (!rs && b <= 0x03 ? 1520 : 43) * CICLOS_US;
+    if(rs && t_lectura != NUNCA && t_lectura_lcd == NUNCA) t_lectura_lcd = ahora;
+
+    if(rs) {
+        if(!lcd_cgram) lcd_ddram[lcd_ac++ & 0x7F] = (char)b;
+        return;
+    }
+    if(b & 0x80) {
+        lcd_ac = b & 0x7F;
+        lcd_cgram = 0;
+    } else if(b & 0x40) {
+        lcd_cgram = 1;
+    } else if(b & 0x20) {
+        lcd_4bits = !(b & 0x10);
+    } else if(b == 0x01) {
+        memset(lcd_ddram, ' ', sizeof(lcd_ddram));
+        lcd_ac = 0;
+    } else if((b & 0xFE) == 0x02) {
+        lcd_ac = 0;
+    }
+}
+
+static void lcd_nibble(uint8_t n, uint8_t rs)
+{
+    if(!lcd_4bits) {
+        // Modo de 8 bits: solo interesa el "function set"
+        if(!rs && n == 0x02) {
+            lcd_4bits = 1;
+            lcd_medio = 0;
+        }
+        return;
+    }
+    if(!lcd_medio) {
+        lcd_alto = n;
+        lcd_medio = 1;
+    } else {
+        lcd_medio = 0;
+        lcd_byte((uint8_t)(lcd_alto << 4) | n, rs);
+    }
+}
+
+static void lcd_mostrar(void)
+{
+    char fila[2][17];
+    unsigned long s = (unsigned long)(ahora / (1000 * CICLOS_MS));
+
+    for(int r = 0; r < 2; r++) {
+        memcpy(fila[r], &lcd_ddram[r * 0x40], 16);
+        fila[r][16] = '\0';
+    }
+    if(memcmp(fila, lcd_visto, sizeof(fila)) == 0) return;
+    memcpy(lcd_visto, fila, sizeof(fila));
+    printf("[%02lu:%02lu:%02lu] |%s|%s|\n", s / 3600, s / 60 % 60, s % 60, fila[0], fila[1]);
+}
+
+static uint8_t pcf_start(uint8_t addr)
+{
+    return 1;
+}
+
+static uint8_t pcf_write(uint8_t b)
+{
+    uint8_t rw = lcd_rw ? b & PCF_RW : 0;
+
+    // RW tiene que estar puesto antes de subir E (tAS): con RW cambiando en
+    // la misma escritura del puerto el HD44780 puede tomar una lectura por
+    // escritura o al reves, y se cuenta
+    if(!(pcf_puerto & PCF_EN) && (b & PCF_EN) && ((pcf_puerto ^ b) & PCF_RW)) {
+        n_lcd_tas++;
+    }
+    // El HD44780 toma el dato en el flanco de bajada de E; con RW en alto
+    // ese flanco pasa al otro nibble de la lectura
+    if((pcf_puerto & PCF_EN) && !(b & PCF_EN)) {
+        if(rw) {
+            lcd_leido = !lcd_leido;
+        } else {
+            lcd_nibble(b >> 4, b & PCF_RS);
+        }
+    }
+    if(!rw) lcd_leido = 0;
+    pcf_puerto = b;
+    return 1;
+}
+
+// Con RW y E en alto el HD44780 maneja D4-D7: busy flag y AC en dos
+// nibbles (solo con instrucciones, RS en bajo). Las salidas del PCF8574
+// en 0 tiran a bajo igual
+static uint8_t pcf_read(void)
+{
+    uint8_t n;
+
+    if(!lcd_rw || (pcf_puerto & (PCF_RW | PCF_EN | PCF_RS)) != (PCF_RW | PCF_EN)) return pcf_puerto;
+    if(lcd_leido) {
+        n = lcd_ac & 0x0F;
+    } else {
+        n = (ahora < lcd_libre ? 0x08 : 0) | ((lcd_ac >> 4) & 0x07);
+    }
+    return pcf_puerto & (uint8_t)((n << 4) | 0x0F);
+}
+
+void hal_host_lectura(void)
+{
+    if(t_lectura == NUNCA) t_lectura = ahora;
+}
+
+static void pcf_stop(void)
+{
+    if(sim_lcd) lcd_mostrar();
+}
+
+// ========== DS1307 ==========
+#define DS_REGS  64    // 7 de hora y fecha, control y 56 de RAM
+#define DS_CH    0x80
+
+static int ds_presente = 1;
+static time_t ds_base;           // Hora en ahora = 0 (UTC, sin zona)
+static time_t ds_parado_en;      // Con CH la hora no avanza
+static int ds_parado = 0;
+static uint8_t ds_reg[DS_REGS];
+static uint8_t ds_ptr;
+static int ds_puntero;           // El proximo byte escrito es el puntero
+static int ds_escrito;           // Se escribieron registros de hora
+
+static uint8_t ds_bcd(int v)
+{
+    return (uint8_t)((v / 10) << 4 | v % 10);
+}
+
+static int ds_bin(uint8_t b)
+{
+    return (b >> 4) * 10 + (b & 0x0F);
+}
+
+static time_t ds_ahora(void)
+{
+    return ds_parado ? ds_parado_en : ds_base + (time_t)(ahora / CICLOS_S);
+}
+
+// El chip copia los registros de hora al empezar cada acceso
+static void ds_copiar(void)
+{
+    time_t t = ds_ahora();
+    struct tm tm;
+
+    gmtime_r(&t, &tm);
+    ds_reg[0] = ds_bcd(tm.tm_sec) | (ds_parado ? DS_CH : 0);
+    ds_reg[1] = ds_bcd(tm.tm_min);
+    ds_reg[2] = ds_bcd(tm.tm_hour);
+    ds_reg[3] = (uint8_t)(tm.tm_wday + 1);
+    ds_reg[4] = ds_bcd(tm.tm_mday);
+    ds_reg[5] = ds_bcd(tm.tm_mon + 1);
+    ds_reg[6] = ds_bcd(tm.tm_year % 100);
+}
+
+static uint8_t ds_start(uint8_t addr)
+{
+    if(!ds_presente) return 0;
+    ds_copiar();
+    ds_puntero = !(addr & 1);
+    if(addr & 1) n_rtc_lecturas++;
+    return 1;
+}
+
+static uint8_t ds_write(uint8_t b)
+{
+    if(ds_puntero) {
+        ds_puntero = 0;
+        ds_ptr = b % DS_REGS;
+        return 1;
+    }
+    ds_reg[ds_ptr] = b;
+    if(ds_ptr < 7) ds_escrito = 1;
+    ds_ptr = (ds_ptr + 1) % DS_REGS;
+    return 1;
+}
+
+static uint8_t ds_read(void)
+{
+    uint8_t b = ds_reg[ds_ptr];
+
+    ds_ptr = (ds_ptr + 1) % DS_REGS;
+    return b;
+}
+
+static void ds_stop(void)
+{
+    struct tm tm = { 0 };
+    time_t t;
+
+    if(!ds_escrito) return;
+    ds_escrito = 0;
+    tm.tm_sec = ds_bin(ds_reg[0] & 0x7F);
+    tm.tm_min = ds_bin(ds_reg[1]);
+    tm.tm_hour = ds_bin(ds_reg[2] & 0x3F);   // Solo modo de 24 h
+    tm.tm_mday = ds_bin(ds_reg[4]);
+    tm.tm_mon = ds_bin(ds_reg[5]) - 1;
+    tm.tm_year = 100 + ds_bin(ds_reg[6]);
+    t = timegm(&tm);
+    ds_parado = (ds_reg[0] & DS_CH) != 0;
+    ds_parado_en = t;
+    ds_base = t - (time_t)(ahora / CICLOS_S);
+}
+
+static void ds_config(const char *hora)
+{
+    struct tm tm = { 0 };
+
+    if(strcmp(hora, "no") == 0) {
+        ds_presente = 0;
+        return;
+    }
+    if(sscanf(hora, "%d-%d-%d %d:%d:%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+              &tm.tm_hour, &tm.tm_min, &tm.tm_sec) < 5) {
+        fprintf(stderr, "hal_host: SIM_RTC \"%s\" no es AAAA-MM-DD HH:MM[:SS]\n", hora);
+        exit(1);
+    }
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    ds_base = timegm(&tm);
+}
+
+// ========== 24LC256 ==========
+#define EXT_TAMANO  32768
+#define EXT_PAGINA  64
+#define EXT_TWC     (3 * CICLOS_MS)   // Grabacion tipica (5 ms como maximo)
+
+static int ext_presente = 1;
+static const char *sim_ext = NULL;
+static uint8_t ext_mem[EXT_TAMANO];
+static uint8_t ext_pagina[EXT_PAGINA];   // Registro de pagina del chip
+static uint64_t ext_marcado;             // Bit i: byte i de la pagina escrito
+static uint64_t ext_libre_en = 0;        // Fin de la grabacion en curso
+static uint16_t ext_ptr;
+static int ext_fase;                     // Bytes de direccion recibidos
+
+static uint8_t ext_start(uint8_t addr)
+{
+    if(!ext_presente) return 0;
+    if(ahora < ext_libre_en) {
+        n_ext_sondeos++;
+        return 0;   // Grabando: sin ACK
+    }
+    ext_fase = (addr & 1) ? 2 : 0;
+    ext_marcado = 0;
+    return 1;
+}
+
+static uint8_t ext_write(uint8_t b)
+{
+    if(ext_fase == 0) {
+        ext_ptr = (uint16_t)((b & 0x7F) << 8);
+        ext_fase = 1;
+    } else if(ext_fase == 1) {
+        ext_ptr |= b;
+        ext_fase = 2;
+    } else {
+        // Dentro de la pagina la direccion da la vuelta
+        ext_pagina[ext_ptr % EXT_PAGINA] = b;
+        ext_marcado |= 1ULL << (ext_ptr % EXT_PAGINA);
+        ext_ptr = (uint16_t)((ext_ptr & ~(EXT_PAGINA - 1)) | ((ext_ptr + 1) % EXT_PAGINA));
+    }
+    return 1;
+}
+
+static uint8_t ext_read(void)
+{
+    uint8_t b = ext_mem[ext_ptr];
+
+    ext_ptr = (ext_ptr + 1) % EXT_TAMANO;
+    return b;
+}
+
+static void ext_stop(void)
+{
+    uint16_t base = ext_ptr & ~(EXT_PAGINA - 1);
+
+    if(!ext_marcado) return;
+    for(int i = 0; i < EXT_PAGINA; i++) {
+        if(ext_marcado & (1ULL << i)) {
+            ext_mem[base + i] = ext_pagina[i];
+            n_ext_bytes++;
+        }
+    }
+    ext_marcado = 0;
+    ext_libre_en = ahora + EXT_TWC;
+    n_ext_paginas++;
+}
+
+// ========== MSSP (I2C maestro) ==========
+typedef struct {
+    uint8_t addr;                   // Direccion de 8 bits (escritura)
+    uint8_t (*start)(uint8_t addr); // Retorna ACK
+    uint8_t (*write)(uint8_t b);    // Retorna ACK
+    uint8_t (*read)(void);
+    void (*stop)(void);
+} Hal_I2c_Dev;
+
+static const Hal_I2c_Dev hal_i2c[] = {
+    { 0x4E, pcf_start, pcf_write, pcf_read, pcf_stop },
+    { 0xD0, ds_start, ds_write, ds_read, ds_stop },
+    { 0xA0, ext_start, ext_write, ext_read, ext_stop },
+};
+
+#define SSP_START  1
+#define SSP_STOP   2
+#define SSP_TX     3
+#define SSP_RX     4
+#define SSP_ACK    5
+
+static uint64_t t_ssp = NUNCA;
+static uint8_t ssp_op;
+static uint8_t ssp_direccion;  // El proximo byte es la direccion
+static const Hal_I2c_Dev *ssp_dev;
+
+static void ssp_poll(void)
+{
+    uint64_t bit = SSPADD + 1;  // Ciclos por bit
+
+    if(t_ssp != NUNCA) return;
+    if(SSPCON2bits.SEN || SSPCON2bits.RSEN) {
+        ssp_op = SSP_START;
+        t_ssp = ahora + bit;
+    } else if(SSPCON2bits.PEN) {
+        ssp_op = SSP_STOP;
+        t_ssp = ahora + bit;
+    } else if(SSPCON2bits.RCEN) {
+        ssp_op = SSP_RX;
+        t_ssp = ahora + 8 * bit;
+    } else if(SSPCON2bits.ACKEN) {
+        ssp_op = SSP_ACK;
+        t_ssp = ahora + bit;
+    } else if(hal_SSPBUF < 0x100) {
+        ssp_op = SSP_TX;
+        t_ssp = ahora + 9 * bit;
+    }
+}
+
+static void ssp_evento(void)
+{
+    uint8_t b, ack = 0;
+
+    t_ssp = NUNCA;
+    switch(ssp_op) {
+        case SSP_START:
+            SSPCON2bits.SEN = 0;
+            SSPCON2bits.RSEN = 0;
+            ssp_direccion = 1;
+            break;
+
+        case SSP_STOP:
+            SSPCON2bits.PEN = 0;
+            if(ssp_dev && ssp_dev->stop) ssp_dev->stop();
+            ssp_dev = NULL;
+            break;
+
+        case SSP_TX:
+            b = (uint8_t)hal_SSPBUF;
+            hal_SSPBUF = 0x100 | b;
+            n_i2c_bytes++;
+            if(ssp_direccion) {
+                ssp_direccion = 0;
+                ssp_dev = NULL;
+                for(size_t i = 0; i < sizeof(hal_i2c) / sizeof(hal_i2c[0]); i++) {
+                    if(hal_i2c[i].addr == (b & 0xFE)) ssp_dev = &hal_i2c[i];
+                }
+                ack = ssp_dev && ssp_dev->start(b);
+            } else {
+                ack = ssp_dev && ssp_dev->write(b);
+            }
+            SSPCON2bits.ACKSTAT = !ack;
+            break;
+
+        case SSP_RX:
+            SSPCON2bits.RCEN = 0;
+            hal_SSPBUF = 0x100 | (ssp_dev ? ssp_dev->read() : 0xFF);
+            n_i2c_bytes++;
+            break;
+
+        case SSP_ACK:
+            SSPCON2bits.ACKEN = 0;
+            break;
+    }
+    PIR1bits.SSPIF = 1;
+}
+
+// ========== EEPROM DE DATOS ==========
+static uint8_t ee_mem[256];
+static uint16_t ee_desgaste[256];
+static uint64_t t_ee = NUNCA;
+static uint8_t ee_addr, ee_dato;
+static long ee_corte = -1;   // Escrituras hasta el corte de energia (-1 = no hay)
+
+volatile uint8_t *hal_host_eedat(void)
+{
+    if(RD) {
+        hal_eedat = ee_mem[EEADR];
+        RD = 0;
+    }
+    return &hal_eedat;
+}
+
+static void ee_poll(void)
+{
+    if(t_ee == NUNCA && WR && WREN) {
+        ee_addr = EEADR;
+        ee_dato = hal_eedat;
+        t_ee = ahora + 4 * CICLOS_MS;
+    }
+}
+
+static void ee_evento(void)
+{
+    t_ee = NUNCA;
+    // Despues del corte el PIC sigue (la prueba hace de reinicio) pero las
+    // escrituras ya no llegan a las celdas
+    if(ee_corte != 0) {
+        ee_mem[ee_addr] = ee_dato;
+        ee_desgaste[ee_addr]++;
+        n_ee_escrituras++;
+        if(ee_corte > 0) ee_corte--;
+    }
+    WR = 0;
+    PIR2bits.EEIF = 1;
+}
+
+// ========== EUSART ==========
+#define TXSTA_TXEN  0x20
+#define TXSTA_BRGH  0x04
+#define TXSTA_TRMT  0x02
+#define RCSTA_SPEN  0x80
+
+static uint64_t t_tx = NUNCA;  // Fin del byte en el registro de desplazamiento
+static uint8_t tx_tsr;
+static int uart_fd = -1;
+static int uart_pty = -1;      // Lado esclavo de SIM_UART=pty
+static uint8_t *uart_cap;      // Copia de lo transmitido (test_uart.c)
+static unsigned long uart_cap_len, uart_cap_n;
+
+// Ciclos de instruccion por bit segun BRG16/BRGH
+static uint64_t uart_bit(void)
+{
+    if(BAUDCTLbits.BRG16) {
+        return (((uint64_t)SPBRGH << 8 | SPBRG) + 1) * ((TXSTA & TXSTA_BRGH) ? 1 : 4);
+    }
+    return ((uint64_t)SPBRG + 1) * ((TXSTA & TXSTA_BRGH) ? 4 : 16);
+}
+
+// Recepcion: el byte siguiente de la pty cuando RCREG ya se leyo
+static void uart_rx_poll(void)
+{
+    int pendientes = 0;
+    uint8_t c;
+
+    if(uart_pty < 0 || !RCSTAbits.SPEN || !RCSTAbits.CREN || PIR1bits.RCIF) return;
+    if(ioctl(uart_fd, FIONREAD, &pendientes) != 0 || pendientes <= 0) return;
+    if(read(uart_fd, &c, 1) == 1) {
+        hal_rcreg = c;
+        PIR1bits.RCIF = 1;
+        n_uart_rx++;
+    }
+}
+
+volatile uint8_t *hal_host_rcreg(void)
+{
+    PIR1bits.RCIF = 0;
+    return &hal_rcreg;
+}
+
+static void uart_poll(void)
+{
+    uart_rx_poll();
+    TXSTA = (uint8_t)((TXSTA & ~TXSTA_TRMT) | (hal_TXREG >= 0x100 && t_tx == NUNCA ? TXSTA_TRMT : 0));
+    if(!(TXSTA & TXSTA_TXEN) || !(RCSTA & RCSTA_SPEN)) {
+        PIR1bits.TXIF = 0;
+        return;
+    }
+    // TXREG pasa al registro de desplazamiento apenas este libre
+    if(hal_TXREG < 0x100 && t_tx == NUNCA) {
+        tx_tsr = (uint8_t)hal_TXREG;
+        hal_TXREG |= 0x100;
+        t_tx = ahora + 10 * uart_bit();   // Start + 8 datos + stop
+    }
+    PIR1bits.TXIF = hal_TXREG >= 0x100;
+}
+
+static void uart_evento(void)
+{
+    t_tx = NUNCA;
+    n_uart_bytes++;
+    if(uart_cap_n < uart_cap_len) uart_cap[uart_cap_n++] = tx_tsr;
+    if(uart_fd >= 0 && write(uart_fd, &tx_tsr, 1) != 1) {
+        perror("hal_host: SIM_UART");
+        close(uart_fd);
+        uart_fd = -1;
+    }
+}
+
+static void uart_abrir(const char *destino)
+{
+    struct termios tio;
+    int pty;
+
+    if(strcmp(destino, "pty") != 0) {
+        uart_fd = open(destino, O_WRONLY | O_CREAT | O_TRUNC | O_NOCTTY, 0644);
+        if(uart_fd < 0) perror(destino);
+        return;
+    }
+
+    // El lado esclavo queda abierto y en modo crudo: el decodificador lo
+    // abre como si fuera el puerto serie y los bytes no se pierden ni se
+    // traducen mientras tanto
+    pty = posix_openpt(O_RDWR | O_NOCTTY);
+    if(pty < 0 || grantpt(pty) != 0 || unlockpt(pty) != 0) {
+        perror("hal_host: pty");
+        return;
+    }
+    uart_pty = open(ptsname(pty), O_RDWR | O_NOCTTY);
+    if(uart_pty >= 0 && tcgetattr(uart_pty, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(uart_pty, TCSANOW, &tio);
+    }
+    fprintf(stderr, "hal_host: EUSART en %s\n", ptsname(pty));
+    uart_fd = pty;
+}
+
+// ========== DHT11 ==========
+// Un sensor por linea de PORTB (como en dht11m.h); solo RB0 genera INTF.
+// Cada sensor tiene su reloj RC con un desvio fijo de hasta +-8 %, asi
+// que las tramas de varias lineas arrancan juntas y se van corriendo
+#define DHT_LINEAS        8
+#define DHT_TRANSICIONES  90
+#ifdef SENSOR_DHT22
+#define DHT_ARRANQUE      (1 * CICLOS_MS)   // Pulso bajo minimo del micro
+#else
+#define DHT_ARRANQUE      (18 * CICLOS_MS)
+#endif
+
+typedef struct {
+    uint64_t t[DHT_TRANSICIONES];
+    uint8_t nivel_sig[DHT_TRANSICIONES];
+    uint8_t n, i;
+    uint8_t nivel;        // Lo que maneja el sensor (1 = suelta)
+    uint8_t linea;        // Nivel real del bus
+    uint64_t bajo_desde;
+    double escala;        // Desvio del reloj del sensor
+    uint32_t jitter;      // +-us en cada tramo
+} Dht;
+
+// Trama impuesta por una prueba para la proxima respuesta de cada linea
+typedef struct {
+    int bits;             // < 0 = ninguna (la del modelo)
+    int responde;
+    uint8_t d[5];
+    uint32_t jitter;
+} Dht_Forzada;
+
+static Dht dht[DHT_LINEAS];
+static Dht_Forzada dht_forzada[DHT_LINEAS];
+static double ruido_t, ruido_h;
+static double escalon;                 // Salto brusco en curso (C)
+static uint64_t t_escalon, proximo_escalon;
+static uint64_t t_dht = NUNCA;   // Proxima transicion de cualquier linea
+static uint8_t dht_bajo;         // Lineas que el micro tiene en bajo
+
+static double azar(void)
+{
+    return rand() / (RAND_MAX + 1.0);
+}
+
+static void dht_proximo(void)
+{
+    t_dht = NUNCA;
+    for(int z = 0; z < DHT_LINEAS; z++) {
+        if(dht[z].i < dht[z].n && dht[z].t[dht[z].i] < t_dht) t_dht = dht[z].t[dht[z].i];
+    }
+}
+
+static void dht_agregar(Dht *s, uint64_t *t, uint32_t us, uint8_t nivel)
+{
+    // +-jitter us en cada tramo
+    *t += (uint64_t)(us * s->escala * CICLOS_US) + (uint64_t)(azar() * 2 * s->jitter * CICLOS_US) - s->jitter * CICLOS_US;
+    s->t[s->n] = *t;
+    s->nivel_sig[s->n] = nivel;
+    s->n++;
+}
+
+// Lo que mide el sensor de la linea z: 5 bytes y los bits que llega a
+// mandar; 0 si no responde
+static int dht_medir(int z, uint8_t *d, int *bits)
+{
+    double horas = (double)ahora / CICLOS_HORA;
+    double hum, tem;
+
+    if(azar() * 100 < sim_fallos) {
+        n_dht_fallos++;
+        return 0;
+    }
+
+    // Ciclo diario (maximo a las 15 h) con ruido de paseo aleatorio; la
+    // linea 0 lleva el ruido nuevo y cada zona un poco de desvio propio
+    if(z == 0) {
+        ruido_t = 0.95 * ruido_t + 0.2 * (azar() - 0.5);
+        ruido_h = 0.95 * ruido_h + 0.6 * (azar() - 0.5);
+    }
+    hum = 60 - 12 * sin(2 * M_PI * (horas - 9) / 24) + ruido_h - 2 * z;
+    if(z == 0 && sim_escalones > 0) {
+        escalon *= exp(-(double)(ahora - t_escalon) / (10 * 60 * 1000 * CICLOS_MS));
+        t_escalon = ahora;
+        if(ahora >= proximo_escalon) {
+            escalon += (azar() < 0.5 ? -1 : 1) * (3 + 5 * azar());
+            proximo_escalon = ahora + (uint64_t)((0.5 + azar()) * 24 * CICLOS_HORA / sim_escalones);
+        }
+    }
+    tem = sim_temp + 5 * sin(2 * M_PI * (horas - 9) / 24) + ruido_t + 0.5 * z + escalon;
+    // Fallas inyectadas (el azar solo se consume si estan activas, para
+    // que las corridas sin ellas no cambien)
+    if(sim_picos && azar() * 100 < sim_picos) {
+        double signo = azar() < 0.5 ? -1 : 1;
+
+        n_dht_picos++;
+        if(azar() < 0.5) {
+            tem += signo * (8 + 7 * azar());
+        } else {
+            hum += signo * (15 + 15 * azar());
+            hum = hum < 0 ? 0 : hum > 99 ? 99 : hum;
+        }
+    }
+#ifdef SENSOR_DHT22
+    // Decimas: humedad en 16 bits, temperatura en signo y magnitud
+    long dh = lround(hum * 10), dt = lround(fabs(tem) * 10);
+    d[0] = dh >> 8;
+    d[1] = dh & 0xFF;
+    d[2] = ((dt >> 8) & 0x7F) | (tem < 0 ? 0x80 : 0);
+    d[3] = dt & 0xFF;
+#else
+    d[0] = (uint8_t)lround(hum);
+    d[1] = 0;
+    d[2] = (uint8_t)lround(tem < 0 ? 0 : tem > 50 ? 50 : tem);
+    d[3] = 0;
+#endif
+    d[4] = d[0] + d[1] + d[2] + d[3];
+    if(sim_checksum && azar() * 100 < sim_checksum) {
+        int b = (int)(azar() * 32);
+
+        n_dht_checksum++;
+        d[b >> 3] ^= 0x80 >> (b & 7);
+    }
+    if(sim_cortes && azar() * 100 < sim_cortes) {
+        n_dht_cortes++;
+        *bits = (int)(azar() * 40);   // El sensor suelta la linea antes de tiempo
+    }
+    return 1;
+}
+
+// Trama de respuesta a partir del instante en que el micro suelta la linea
+static void dht_trama(int z)
+{
+    Dht *s = &dht[z];
+    Dht_Forzada *f = &dht_forzada[z];
+    uint8_t d[5];
+    uint64_t t = ahora;
+    int bits = 40;
+
+    s->n = s->i = 0;
+    s->jitter = 2;
+    n_dht_tramas++;
+    if(f->bits >= 0) {
+        memcpy(d, f->d, sizeof(d));
+        bits = f->bits;
+        s->jitter = f->jitter;
+        f->bits = -1;
+        if(!f->responde) return;
+    } else if(!dht_medir(z, d, &bits)) {
+        return;
+    }
+
+    dht_agregar(s, &t, 20 + (uint32_t)(azar() * 20), 0);  // Respuesta tras 20-40 us:
+    dht_agregar(s, &t, 80, 1);                             // 80 us bajo, 80 us alto
+    dht_agregar(s, &t, 80, 0);
+    for(int i = 0; i < bits; i++) {
+        dht_agregar(s, &t, 50, 1);
+        dht_agregar(s, &t, (d[i >> 3] << (i & 7)) & 0x80 ? 70 : 27, 0);
+    }
+    dht_agregar(s, &t, 50, 1);   // Fin de trama: suelta la linea
+}
+
+static void linea_actualizar(int z)
+{
+    uint8_t nueva = (dht_bajo & (1 << z)) ? 0 : dht[z].nivel;
+
+    if(nueva != dht[z].linea) {
+        // RB0/INT: INTEDG = 0 flanco de bajada, 1 de subida
+        if(z == 0 && nueva == OPTION_REGbits.INTEDG) INTCONbits.INTF = 1;
+        dht[z].linea = nueva;
+    }
+}
+
+static void dht_poll(void)
+{
+    // Solo las lineas en las que el micro empezo o dejo de tirar a bajo
+    uint8_t bajo = ~TRISB & ~hal_PORTB.reg;
+    uint8_t cambio = bajo ^ dht_bajo;
+
+    if(!cambio) return;
+    dht_bajo = bajo;
+    for(int z = 0; z < DHT_LINEAS; z++) {
+        Dht *s = &dht[z];
+
+        if(!(cambio & (1 << z))) continue;
+        if(bajo & (1 << z)) {
+            s->bajo_desde = ahora;
+            s->n = s->i = 0;
+            s->nivel = 1;
+        } else {
+            if(ahora - s->bajo_desde >= DHT_ARRANQUE) dht_trama(z);
+            s->bajo_desde = NUNCA;
+        }
+        linea_actualizar(z);
+    }
+    dht_proximo();
+}
+
+static void dht_evento(void)
+{
+    for(int z = 0; z < DHT_LINEAS; z++) {
+        Dht *s = &dht[z];
+        while(s->i < s->n && s->t[s->i] <= ahora) {
+            s->nivel = s->nivel_sig[s->i++];
+            linea_actualizar(z);
+        }
+    }
+    dht_proximo();
+}
+
+// Como en el PIC, leer PORTB trae el nivel de los pines de entrada (el
+// latch de esos bits queda con lo leido); los de salida dan el latch
+volatile uint8_t *hal_host_portb(void)
+{
+    uint8_t pines = 0;
+
+    dht_poll();
+    for(int z = 0; z < DHT_LINEAS; z++) {
+        if(dht[z].linea) pines |= 1 << z;
+    }
+    hal_PORTB.reg = (hal_PORTB.reg & ~TRISB) | (pines & TRISB);
+    return &hal_PORTB.reg;
+}
+
+// ========== RELOJ VIRTUAL ==========
+static void hal_poll(void)
+{
+    if(T2CONbits.TMR2ON) {
+        if(t_tick == NUNCA) t_tick = ahora + tmr2_periodo();
+    } else {
+        t_tick = NUNCA;
+    }
+    ssp_poll();
+    ee_poll();
+    uart_poll();
+    dht_poll();
+}
+
+static uint64_t hal_proximo(void)
+{
+    uint64_t t = t_tick;
+
+    if(t_ssp < t) t = t_ssp;
+    if(t_ee < t) t = t_ee;
+    if(t_dht < t) t = t_dht;
+    if(t_tx < t) t = t_tx;
+
+    // Desborde de Timer0 solo si alguien espera T0IF (timeout del DHT11)
+    if(!INTCONbits.T0IF) {
+        uint64_t desborde = 256ULL * tmr0_prescaler();
+        uint64_t t0 = (ahora / desborde + 1) * desborde;
+        if(t0 < t) t = t0;
+    }
+    return t;
+}
+
+static void hal_avanzar(uint64_t t)
+{
+    uint64_t desborde = 256ULL * tmr0_prescaler();
+
+    if(t >= fin) {
+        ahora = fin;
+        hal_fin(0);
+    }
+    if(t / desborde != ahora / desborde) INTCONbits.T0IF = 1;
+    ahora = t;
+}
+
+// Hay una interrupcion habilitada con su flag arriba
+static int hal_irq_pendiente(void)
+{
+    return (INTCONbits.INTE && INTCONbits.INTF) ||
+           (INTCONbits.T0IE && INTCONbits.T0IF) ||
+           (INTCONbits.PEIE && ((PIE1 & PIR1) || (PIE2 & PIR2)));
+}
+
+// Procesa los eventos que vencen en t y atiende las interrupciones
+static void hal_ir_a(uint64_t t)
+{
+    hal_avanzar(t);
+
+    if(t_tick <= ahora) {
+        PIR1bits.TMR2IF = 1;
+        t_tick += tmr2_periodo();
+        n_ticks++;
+    }
+    if(t_ssp <= ahora) ssp_evento();
+    if(t_ee <= ahora) ee_evento();
+    if(t_tx <= ahora) uart_evento();
+    if(t_dht <= ahora) dht_evento();
+
+    // Como el PIC: GIE se apaga durante la ISR y RETFIE lo vuelve a prender
+    for(int n = 0; n < 8 && INTCONbits.GIE; n++) {
+        if(!hal_irq_pendiente()) break;
+        INTCONbits.GIE = 0;
+        isr();
+        INTCONbits.GIE = 1;
+        hal_poll();
+    }
+    hal_poll();
+}
+
+void hal_host_espera(void)
+{
+    uint64_t t;
+
+    hal_poll();
+    // Un flag que quedo arriba con la interrupcion deshabilitada (EEIE
+    // apagado en EEPROM_Read(), por ejemplo) se atiende al habilitarla,
+    // sin esperar al proximo evento
+    if(INTCONbits.GIE && hal_irq_pendiente()) {
+        hal_ir_a(ahora);
+        return;
+    }
+    t = hal_proximo();
+    if(t == NUNCA) {
+        fprintf(stderr, "hal_host: espera sin ningun evento pendiente\n");
+        hal_fin(1);
+    }
+    hal_ir_a(t);
+}
+
+void hal_host_delay_us(uint32_t us)
+{
+    uint64_t hasta = ahora + us * CICLOS_US;
+
+    hal_poll();
+    // Como en hal_host_espera(): una interrupcion recien habilitada con su
+    // flag arriba (TXIE tras UART_Frame()) se atiende enseguida
+    if(INTCONbits.GIE && hal_irq_pendiente()) hal_ir_a(ahora);
+    while(hal_proximo() <= hasta) {
+        hal_ir_a(hal_proximo());
+    }
+    hal_avanzar(hasta);
+    hal_poll();
+}
+
+uint16_t hal_host_reposo(uint16_t n)
+{
+    uint64_t periodo, limite;
+    uint16_t k;
+
+    hal_poll();
+    if(n < 2 || t_tick == NUNCA || PIR1bits.TMR2IF) return 0;
+    if(INTCONbits.GIE && hal_irq_pendiente()) return 0;
+
+    // Los demas eventos (y el fin de la simulacion) cortan el salto
+    periodo = tmr2_periodo();
+    limite = fin;
+    if(t_ssp < limite) limite = t_ssp;
+    if(t_ee < limite) limite = t_ee;
+    if(t_dht < limite) limite = t_dht;
+    if(t_tx < limite) limite = t_tx;
+    if(limite <= t_tick) return 0;
+
+    k = n - 1;
+    if((limite - t_tick - 1) / periodo + 1 < k) k = (limite - t_tick - 1) / periodo + 1;
+
+    hal_avanzar(t_tick + (uint64_t)(k - 1) * periodo);
+    t_tick += (uint64_t)k * periodo;
+    n_ticks += k;
+    return k;
+}
+
+// ========== PRUEBAS ==========
+uint64_t hal_host_ahora(void)
+{
+    return ahora;
+}
+
+unsigned long hal_host_i2c_bytes(void)
+{
+    return n_i2c_bytes;
+}
+
+const char *hal_host_lcd(uint8_t fila)
+{
+    return &lcd_ddram[(fila - 1) * 0x40];
+}
+
+void hal_host_lcd_rw(int conectado)
+{
+    lcd_rw = conectado;
+}
+
+unsigned long hal_host_lcd_ocupado(void)
+{
+    return n_lcd_ocupado;
+}
+
+unsigned long hal_host_lcd_tas(void)
+{
+    return n_lcd_tas;
+}
+
+void hal_host_dht_trama(int z, const uint8_t *datos, int bits, uint32_t jitter_us)
+{
+    Dht_Forzada *f = &dht_forzada[z];
+
+    f->responde = datos != NULL;
+    if(datos) memcpy(f->d, datos, sizeof(f->d));
+    f->bits = bits;
+    f->jitter = jitter_us;
+}
+
+void hal_host_dht_escala(int z, double escala)
+{
+    dht[z].escala = escala;
+}
+
+unsigned long hal_host_uart_captura(uint8_t *buf, unsigned long len)
+{
+    unsigned long n = uart_cap_n;
+
+    uart_cap = buf;
+    uart_cap_len = buf ? len : 0;
+    uart_cap_n = 0;
+    return n;
+}
+
+unsigned long hal_host_uart_bytes(void)
+{
+    return uart_cap_n;
+}
+
+unsigned long hal_host_ee_escrituras(void)
+{
+    return n_ee_escrituras;
+}
+
+void hal_host_ee_corte(long n)
+{
+    ee_corte = n;
+}
+
+void hal_host_ee_borrar(void)
+{
+    memset(ee_mem, 0xFF, sizeof(ee_mem));
+}
+
+// ========== INICIO Y RESUMEN ==========
+static const char *hal_env(const char *nombre, const char *def)
+{
+    const char *v = getenv(nombre);
+    return (v && *v) ? v : def;
+}
+
+void hal_host_init(void)
+{
+    FILE *f;
+
+    fin = (uint64_t)(atof(hal_env("SIM_HORAS", "24")) * CICLOS_HORA);
+    sim_lcd = atoi(hal_env("SIM_LCD", "0"));
+    sim_fallos = atoi(hal_env("SIM_FALLOS", "0"));
+    sim_checksum = atoi(hal_env("SIM_CHECKSUM", "0"));
+    sim_cortes = atoi(hal_env("SIM_CORTES", "0"));
+    sim_picos = atoi(hal_env("SIM_PICOS", "0"));
+    sim_temp = atof(hal_env("SIM_TEMP", "24"));
+    sim_escalones = atof(hal_env("SIM_ESCALONES", "0"));
+    if(sim_escalones > 0) proximo_escalon = (uint64_t)(azar() * 24 * CICLOS_HORA / sim_escalones);
+    ds_config(hal_env("SIM_RTC", "2025-01-01 00:00"));
+    sim_ext = getenv("SIM_EXT");
+    if(sim_ext && strcmp(sim_ext, "no") == 0) {
+        ext_presente = 0;
+        sim_ext = NULL;
+    }
+    sim_eeprom = getenv("SIM_EEPROM");
+    if(getenv("SIM_UART")) uart_abrir(getenv("SIM_UART"));
+    srand((unsigned)atoi(hal_env("SIM_SEMILLA", "1")));
+
+    memset(ee_mem, 0xFF, sizeof(ee_mem));
+    if(sim_eeprom && (f = fopen(sim_eeprom, "rb")) != NULL) {
+        if(fread(ee_mem, 1, sizeof(ee_mem), f) != sizeof(ee_mem)) {
+            fprintf(stderr, "hal_host: %s incompleto\n", sim_eeprom);
+        }
+        fclose(f);
+    }
+    memset(ext_mem, 0xFF, sizeof(ext_mem));
+    if(sim_ext && (f = fopen(sim_ext, "rb")) != NULL) {
+        if(fread(ext_mem, 1, sizeof(ext_mem), f) != sizeof(ext_mem)) {
+            fprintf(stderr, "hal_host: %s incompleto\n", sim_ext);
+        }
+        fclose(f);
+    }
+    memset(lcd_ddram, ' ', sizeof(lcd_ddram));
+    for(int z = 0; z < DHT_LINEAS; z++) {
+        dht[z].nivel = dht[z].linea = 1;
+        dht[z].bajo_desde = NUNCA;
+        dht[z].escala = 0.92 + 0.16 * azar();
+        dht_forzada[z].bits = -1;
+    }
+
+    // Estado de reset
+    TRISB = 0xFF;
+    TRISC = 0xFF;
+    TRISD = 0xFF;
+    OPTION_REG = 0xFF;
+    PR2 = 0xFF;
+    TXSTA = TXSTA_TRMT;
+
+    inicio_real = clock();
+}
+
+static void hal_fin(int codigo)
+{
+    FILE *f;
+    unsigned max_desgaste = 0;
+    double real = (double)(clock() - inicio_real) / CLOCKS_PER_SEC;
+    double virtual_s = (double)ahora / (1000 * CICLOS_MS);
+
+    for(int i = 0; i < 256; i++) {
+        if(ee_desgaste[i] > max_desgaste) max_desgaste = ee_desgaste[i];
+    }
+
+    printf("---- simulacion: %.1f h virtuales en %.3f s (x%.0f) ----\n",
+           virtual_s / 3600, real, real > 0 ? virtual_s / real : 0);
+    printf("LCD   |%.16s|\n      |%.16s|\n", &lcd_ddram[0], &lcd_ddram[0x40]);
+    if(t_lectura != NUNCA) {
+        printf("Arranque: primera lectura a los %.3f s", (double)t_lectura / CICLOS_S);
+        if(t_lectura_lcd != NUNCA) printf(", en el LCD a los %.3f s", (double)t_lectura_lcd / CICLOS_S);
+        printf("\n");
+    }
+    if(n_lcd_ocupado) printf("LCD   %lu instrucciones con el HD44780 ocupado\n", n_lcd_ocupado);
+    if(n_lcd_tas) printf("LCD   %lu pulsos de E con RW cambiando\n", n_lcd_tas);
+    printf("LEDs  RD0-RD5: %d%d%d%d%d%d\n", PORTDbits.RD0, PORTDbits.RD1, PORTDbits.RD2,
+           PORTDbits.RD3, PORTDbits.RD4, PORTDbits.RD5);
+    printf("ticks %lu  bytes I2C %lu  tramas DHT11 %lu (sin respuesta %lu)\n",
+           n_ticks, n_i2c_bytes, n_dht_tramas, n_dht_fallos);
+    if(sim_checksum || sim_cortes || sim_picos) {
+        printf("      inyectadas: %lu con checksum mal, %lu cortadas, %lu con pico\n",
+               n_dht_checksum, n_dht_cortes, n_dht_picos);
+    }
+    printf("UART  %lu bytes", n_uart_bytes);
+    if(n_uart_rx) printf(", %lu recibidos", n_uart_rx);
+    printf("\n");
+    if(ds_presente) {
+        time_t t = ds_ahora();
+        char hora[32];
+
+        strftime(hora, sizeof(hora), "%Y-%m-%d %H:%M:%S", gmtime(&t));
+        printf("RTC   %s, %lu lecturas del DS1307\n", hora, n_rtc_lecturas);
+    }
+    printf("EEPROM: %lu escrituras, maximo %u en una celda\n", n_ee_escrituras, max_desgaste);
+    if(ext_presente) {
+        printf("24LC256: %lu escrituras (%lu bytes), %lu sondeos sin ACK\n",
+               n_ext_paginas, n_ext_bytes, n_ext_sondeos);
+    }
+
+    // Al cerrar la pty se pierde lo que el lector no saco todavia
+    for(int i = 0; i < 300 && uart_pty >= 0; i++) {
+        int pendientes = 0;
+        if(ioctl(uart_pty, FIONREAD, &pendientes) != 0 || pendientes == 0) break;
+        usleep(10000);
+    }
+
+    if(sim_eeprom && (f = fopen(sim_eeprom, "wb")) != NULL) {
+        fwrite(ee_mem, 1, sizeof(ee_mem), f);
+        fclose(f);
+    }
+    if(sim_ext && (f = fopen(sim_ext, "wb")) != NULL) {
+        fwrite(ext_mem, 1, sizeof(ext_mem), f);
+        fclose(f);
+    }
+    fflush(stdout);
+    exit(codigo);
+}
@@ -0,0 +1,165 @@
+/*
+ * File: hal_host.h
+ * Backend de hal.h para compilar el firmware en Linux (make host)
+ *
+ * Declara los registros del PIC16F887 que usa el programa como variables
+ * del simulador (hal_host.c). Los que tienen efectos al leerse (timers,
+ * EEDAT, PORTB, RCREG) pasan por una funcion que los actualiza con el reloj virtual; los
+ * que disparan una operacion (SEN, SSPBUF, WR, ...) los detecta el
+ * simulador en cada HAL_ESPERA().
+ */
+#ifndef HAL_HOST_H
+#define HAL_HOST_H
+
+#include <stdint.h>
+
+#ifdef SCHED_T1OSC
+#error "El simulador solo modela el tick de Timer2"
+#endif
+
+// ========== REGISTROS ==========
+#define HAL_REG(nombre, campos) \
+    typedef union { uint8_t reg; struct { campos } bits; } nombre##_t; \
+    extern volatile nombre##_t hal_##nombre;
+
+HAL_REG(INTCON, unsigned RBIF:1; unsigned INTF:1; unsigned T0IF:1; unsigned RBIE:1;
+                unsigned INTE:1; unsigned T0IE:1; unsigned PEIE:1; unsigned GIE:1;)
+HAL_REG(PIR1, unsigned TMR1IF:1; unsigned TMR2IF:1; unsigned CCP1IF:1; unsigned SSPIF:1;
+              unsigned TXIF:1; unsigned RCIF:1; unsigned ADIF:1; unsigned _r:1;)
+HAL_REG(PIE1, unsigned TMR1IE:1; unsigned TMR2IE:1; unsigned CCP1IE:1; unsigned SSPIE:1;
+              unsigned TXIE:1; unsigned RCIE:1; unsigned ADIE:1; unsigned _r:1;)
+HAL_REG(PIR2, unsigned CCP2IF:1; unsigned ULPWUIF:1; unsigned BCLIF:1; unsigned EEIF:1;
+              unsigned C1IF:1; unsigned C2IF:1; unsigned OSFIF:1; unsigned _r:1;)
+HAL_REG(PIE2, unsigned CCP2IE:1; unsigned ULPWUIE:1; unsigned BCLIE:1; unsigned EEIE:1;
+              unsigned C1IE:1; unsigned C2IE:1; unsigned OSFIE:1; unsigned _r:1;)
+HAL_REG(OPTION_REG, unsigned PS:3; unsigned PSA:1; unsigned T0SE:1; unsigned T0CS:1;
+                    unsigned INTEDG:1; unsigned nRBPU:1;)
+HAL_REG(T1CON, unsigned TMR1ON:1; unsigned TMR1CS:1; unsigned nT1SYNC:1; unsigned T1OSCEN:1;
+               unsigned T1CKPS:2; unsigned TMR1GE:1; unsigned T1GINV:1;)
+HAL_REG(T2CON, unsigned T2CKPS:2; unsigned TMR2ON:1; unsigned TOUTPS:4; unsigned _r:1;)
+HAL_REG(SSPCON2, unsigned SEN:1; unsigned RSEN:1; unsigned PEN:1; unsigned RCEN:1;
+                 unsigned ACKEN:1; unsigned ACKDT:1; unsigned ACKSTAT:1; unsigned GCEN:1;)
+HAL_REG(EECON1, unsigned RD:1; unsigned WR:1; unsigned WREN:1; unsigned WRERR:1;
+                unsigned _r:3; unsigned EEPGD:1;)
+HAL_REG(RCSTA, unsigned RX9D:1; unsigned OERR:1; unsigned FERR:1; unsigned ADDEN:1;
+               unsigned CREN:1; unsigned SREN:1; unsigned RX9:1; unsigned SPEN:1;)
+HAL_REG(BAUDCTL, unsigned ABDEN:1; unsigned WUE:1; unsigned _r1:1; unsigned BRG16:1;
+                 unsigned SCKP:1; unsigned _r2:1; unsigned RCIDL:1; unsigned ABDOVF:1;)
+HAL_REG(PORTB, unsigned RB0:1; unsigned RB1:1; unsigned RB2:1; unsigned RB3:1;
+               unsigned RB4:1; unsigned RB5:1; unsigned RB6:1; unsigned RB7:1;)
+HAL_REG(TRISB, unsigned TRISB0:1; unsigned TRISB1:1; unsigned TRISB2:1; unsigned TRISB3:1;
+               unsigned TRISB4:1; unsigned TRISB5:1; unsigned TRISB6:1; unsigned TRISB7:1;)
+HAL_REG(TRISC, unsigned TRISC0:1; unsigned TRISC1:1; unsigned TRISC2:1; unsigned TRISC3:1;
+               unsigned TRISC4:1; unsigned TRISC5:1; unsigned TRISC6:1; unsigned TRISC7:1;)
+HAL_REG(PORTD, unsigned RD0:1; unsigned RD1:1; unsigned RD2:1; unsigned RD3:1;
+               unsigned RD4:1; unsigned RD5:1; unsigned RD6:1; unsigned RD7:1;)
+
+#define INTCON          hal_INTCON.reg
+#define INTCONbits      hal_INTCON.bits
+#define PIR1            hal_PIR1.reg
+#define PIR1bits        hal_PIR1.bits
+#define PIE1            hal_PIE1.reg
+#define PIE1bits        hal_PIE1.bits
+#define PIR2            hal_PIR2.reg
+#define PIR2bits        hal_PIR2.bits
+#define PIE2            hal_PIE2.reg
+#define PIE2bits        hal_PIE2.bits
+#define OPTION_REG      hal_OPTION_REG.reg
+#define OPTION_REGbits  hal_OPTION_REG.bits
+#define T1CON           hal_T1CON.reg
+#define T1CONbits       hal_T1CON.bits
+#define T2CON           hal_T2CON.reg
+#define T2CONbits       hal_T2CON.bits
+#define SSPCON2         hal_SSPCON2.reg
+#define SSPCON2bits     hal_SSPCON2.bits
+#define EECON1          hal_EECON1.reg
+#define EECON1bits      hal_EECON1.bits
+#define RCSTA           hal_RCSTA.reg
+#define RCSTAbits       hal_RCSTA.bits
+#define BAUDCTL         hal_BAUDCTL.reg
+#define BAUDCTLbits     hal_BAUDCTL.bits
+#define PORTB           (*hal_host_portb())
+#define PORTBbits       hal_PORTB.bits
+#define TRISB           hal_TRISB.reg
+#define TRISBbits       hal_TRISB.bits
+#define TRISC           hal_TRISC.reg
+#define TRISCbits       hal_TRISC.bits
+#define PORTD           hal_PORTD.reg
+#define PORTDbits       hal_PORTD.bits
+
+// Alias cortos de <xc.h> para EECON1
+#define RD     EECON1bits.RD
+#define WR     EECON1bits.WR
+#define WREN   EECON1bits.WREN
+#define EEPGD  EECON1bits.EEPGD
+
+// Registros sin efectos laterales
+extern volatile uint8_t ANSEL, ANSELH, TRISD, PR2, TMR2;
+extern volatile uint8_t SSPSTAT, SSPCON, SSPADD;
+extern volatile uint8_t EEADR, EECON2;
+extern volatile uint8_t TXSTA, SPBRG, SPBRGH;
+
+// SSPBUF y TXREG de 16 bits: el simulador marca con 0x100 lo que ya
+// proceso, asi una escritura del programa (siempre < 0x100) se distingue
+extern volatile uint16_t hal_SSPBUF, hal_TXREG;
+#define SSPBUF  hal_SSPBUF
+#define TXREG   hal_TXREG
+
+// Leidos a traves del reloj virtual
+volatile uint8_t *hal_host_tmr0(void);
+volatile uint8_t *hal_host_tmr1h(void);
+volatile uint8_t *hal_host_tmr1l(void);
+volatile uint8_t *hal_host_eedat(void);
+volatile uint8_t *hal_host_portb(void);
+volatile uint8_t *hal_host_rcreg(void);
+#define TMR0    (*hal_host_tmr0())
+#define TMR1H   (*hal_host_tmr1h())
+#define TMR1L   (*hal_host_tmr1l())
+#define EEDAT   (*hal_host_eedat())
+#define RCREG   (*hal_host_rcreg())
+
+// ========== COMPILADOR ==========
+#define __interrupt(...)
+#define __delay_ms(x)   hal_host_delay_us((uint32_t)(x) * 1000UL)
+#define __delay_us(x)   hal_host_delay_us(x)
+#define SLEEP()         hal_host_espera()
+#define NOP()           ((void)0)
+
+// ========== HAL ==========
+#define HAL_INIT()      hal_host_init()
+#define HAL_ESPERA()    hal_host_espera()
+#define HAL_LECTURA()   hal_host_lectura()
+
+void hal_host_init(void);
+void hal_host_espera(void);
+void hal_host_delay_us(uint32_t us);
+void hal_host_lectura(void);   // Para el tiempo de arranque del resumen
+
+// Avanza el reloj hasta el tick numero n (sin incluirlo) si no hay otros
+// eventos antes; retorna los ticks saltados, que el planificador suma a su
+// cuenta como si la ISR los hubiera atendido
+uint16_t hal_host_reposo(uint16_t n);
+
+// ========== PRUEBAS (test_*.c) ==========
+uint64_t hal_host_ahora(void);            // Reloj virtual en ciclos (200 ns)
+unsigned long hal_host_i2c_bytes(void);   // Bytes por el bus, direcciones incluidas
+const char *hal_host_lcd(uint8_t fila);   // DDRAM de la fila 1 o 2 (16 chars, sin '\0')
+void hal_host_lcd_rw(int conectado);      // 0 = RW del HD44780 a GND, P1 sin efecto
+unsigned long hal_host_lcd_ocupado(void); // Instrucciones con el HD44780 ocupado
+unsigned long hal_host_lcd_tas(void);     // Flancos de subida de E con RW cambiando
+// La proxima respuesta del sensor de la linea z trae estos 5 bytes (NULL =
+// no responde), solo los primeros bits (< 40 = trama cortada) y +-jitter_us
+// en cada tramo en lugar de +-2 us
+void hal_host_dht_trama(int z, const uint8_t *datos, int bits, uint32_t jitter_us);
+void hal_host_dht_escala(int z, double escala);   // Desvio del reloj del sensor (1 = exacto)
+// Los bytes que terminan de salir por TX se copian en buf (hasta len);
+// retorna los copiados en la captura anterior. NULL = sin captura
+unsigned long hal_host_uart_captura(uint8_t *buf, unsigned long len);
+unsigned long hal_host_uart_bytes(void);      // Copiados en la captura actual
+unsigned long hal_host_ee_escrituras(void);   // Bytes grabados en la EEPROM
+// Corte de energia despues de n bytes grabados mas: los siguientes terminan
+// (EEIF) sin llegar a la celda. -1 = sin corte
+void hal_host_ee_corte(long n);
+void hal_host_ee_borrar(void);   // EEPROM en 0xFF, como nueva
+
+#endif /* HAL_HOST_H */
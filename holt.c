@@ -0,0 +1,58 @@
+/*
+ * File: holt.c
+ * Pronostico de Holt (nivel + tendencia) en enteros (ver holt.h)
+ */
+#include "holt.h"
+
+static int32_t holt_nivel[STATS_CANALES];      // Q.HOLT_FRAC
+static int32_t holt_tendencia[STATS_CANALES];  // Por muestra, Q.HOLT_FRAC
+static uint8_t holt_listo = 0;                 // Ya hay nivel
+
+void holt_init(void)
+{
+    holt_listo = 0;
+}
+
+// x / 2^sh redondeado al mas cercano: con >> solo (hacia -inf) la
+// tendencia deriva hacia abajo en una senal quieta
+static int32_t holt_div(int32_t x, uint8_t sh)
+{
+    return (x + ((int32_t)1 << (sh - 1))) >> sh;
+}
+
+static void holt_canal(uint8_t c, muestra_t v)
+{
+    int32_t y = (int32_t)v << HOLT_FRAC;
+    int32_t p;
+
+    if(!holt_listo) {
+        holt_nivel[c] = y;
+        holt_tendencia[c] = 0;
+    } else {
+        p = holt_nivel[c] + holt_tendencia[c];
+        y = p + holt_div(y - p, HOLT_ALFA_SH);
+        holt_tendencia[c] += holt_div(y - holt_nivel[c] - holt_tendencia[c], HOLT_BETA_SH);
+        holt_nivel[c] = y;
+    }
+}
+
+void holt_push(muestra_t temp, muestra_t hum)
+{
+    holt_canal(STATS_TEMP, temp);
+    holt_canal(STATS_HUM, hum);
+    holt_listo = 1;
+}
+
+muestra_t holt_pronostico(uint8_t canal)
+{
+    int32_t f;
+
+    if(!holt_listo) return 0;
+    f = holt_nivel[canal] + HOLT_PASOS * holt_tendencia[canal];
+    f = holt_div(f, HOLT_FRAC);
+#if MUESTRA_BYTES == 1
+    if(f < 0) return 0;
+    if(f > 255) return 255;
+#endif
+    return (muestra_t)f;
+}
@@ -0,0 +1,55 @@
+/*
+ * File: holt.h
+ * Pronostico de Holt (nivel + tendencia) en enteros para PIC16F887
+ *
+ * Suavizado exponencial doble sobre la serie de las estadisticas (una
+ * muestra cada 20 s), por canal:
+ *
+ *   p  = L + B                  pronostico a un paso
+ *   L' = p + alfa * (y - p)
+ *   B' = B + beta * (L' - L - B)
+ *
+ * con alfa = 2^-HOLT_ALFA_SH y beta = 2^-HOLT_BETA_SH, asi que las
+ * multiplicaciones son desplazamientos y cada muestra cuesta unas pocas
+ * sumas de 32 bits. Reemplaza al promedio de las ultimas 5 muestras, que
+ * va siempre atrasado cuando la temperatura sube o baja. holt_pronostico() da L + HOLT_PASOS * B redondeado:
+ * la muestra esperada dentro de HOLT_PASOS pasos (2 min).
+ *
+ * L y B van en unidades de muestra_t con HOLT_FRAC bits fraccionarios en
+ * un int32_t: una tendencia real (4 C de ciclo diario) es de milesimas de
+ * grado por muestra. Los desplazamientos redondean al mas cercano; con >>
+ * solo la tendencia derivaria. La primera muestra fija el nivel con
+ * tendencia 0: una diferencia sola entre dos lecturas enteras es casi
+ * todo ruido.
+ *
+ * pronostico_holt.py tiene la misma cuenta en Python, con los mismos
+ * redondeos, y el banco contra statsmodels (make banco_holt).
+ * RAM: 8 bytes por canal mas 1.
+ */
+#ifndef HOLT_H
+#define HOLT_H
+
+#include <stdint.h>
+#include "fixpt.h"
+#include "stats.h"   // Canales STATS_TEMP y STATS_HUM
+
+#ifndef HOLT_ALFA_SH
+#define HOLT_ALFA_SH  2    // alfa = 1/4
+#endif
+#ifndef HOLT_BETA_SH
+#define HOLT_BETA_SH  8    // beta = 1/256
+#endif
+#ifndef HOLT_PASOS
+#define HOLT_PASOS    6    // Horizonte en muestras
+#endif
+#define HOLT_FRAC     16
+
+#if HOLT_ALFA_SH < 1 || HOLT_BETA_SH < 1
+#error "HOLT_ALFA_SH y HOLT_BETA_SH deben ser al menos 1"
+#endif
+
+void holt_init(void);
+void holt_push(muestra_t temp, muestra_t hum);
+muestra_t holt_pronostico(uint8_t canal);   // 0 sin muestras
+
+#endif /* HOLT_H */
@@ -1,81 +1,302 @@
 /* 
  * File: i2c.c
  * I2C Library Implementation for PIC16F887
- * Sin warnings de compilacin
+ * Sin warnings de compilaci�n
  */
 #include "i2c.h"
+#include "prof.h"
 
 #ifdef I2C_MASTER_MODE
 
+// Estados de la maquina de la cola (lo que el MSSP acaba de terminar)
+#define I2C_EST_LIBRE  0
+#define I2C_EST_START  1
+#define I2C_EST_DATOS  2
+#define I2C_EST_STOP   3
+
+typedef struct {
+    uint8_t addr;
+    uint8_t len;
+    volatile uint8_t *done;
+    I2C_Callback cb;
+} I2C_Trans;
+
+static I2C_Trans i2c_cola[I2C_COLA_LEN];
+static uint8_t i2c_buf[I2C_BUF_LEN];
+
+// Indices *_wr solo los mueve el programa principal, *_rd solo la ISR
+static volatile uint8_t i2c_cola_wr = 0;
+static volatile uint8_t i2c_cola_rd = 0;
+static volatile uint8_t i2c_buf_wr = 0;
+static volatile uint8_t i2c_buf_rd = 0;
+static uint8_t i2c_buf_tmp;       // Escritura de la transaccion abierta
+static uint8_t i2c_len_tmp;
+static uint8_t i2c_desborde;
+
+static volatile uint8_t i2c_estado = I2C_EST_LIBRE;
+static volatile uint8_t i2c_restante;
+static volatile uint8_t i2c_resultado;
+static volatile uint8_t i2c_bloqueo = 0;  // API bloqueante usando el bus
+
+static void i2c_wait(void)
+{
+    while(PIR1bits.SSPIF == 0) HAL_ESPERA();
+    PIR1bits.SSPIF = 0;
+}
+
+// Atiende el MSSP a mano si las interrupciones estan apagadas. Con PEIE
+// apagado por la captura del sensor se espera: la ISR la corta a los ~6 ms
+// aunque el sensor no responda (dht11_desborde()), y atenderlo desde aca
+// demoraria la marca de los flancos
+static void i2c_poll(void)
+{
+    if(!INTCONbits.GIE && PIR1bits.SSPIF) {
+        I2C_Isr();
+        return;   // El llamador vuelve a mirar el estado antes de esperar
+    }
+    HAL_ESPERA();
+}
+
+static void i2c_kick(void)
+{
+    if(i2c_estado == I2C_EST_LIBRE && !i2c_bloqueo && i2c_cola_rd != i2c_cola_wr) {
+        PROF_INICIO(PROF_I2C);
+        i2c_estado = I2C_EST_START;
+        PIR1bits.SSPIF = 0;
+        PIE1bits.SSPIE = 1;
+        SSPCON2bits.SEN = 1;
+    }
+}
+
+// La API bloqueante espera a que la cola termine y deshabilita SSPIE
+static void i2c_take_bus(void)
+{
+    I2C_Flush();
+    i2c_bloqueo = 1;
+    PIE1bits.SSPIE = 0;
+}
+
 void I2C_Init_Master(unsigned char sp_i2c)
 {
     TRIS_SCL = 1;
     TRIS_SDA = 1;
-    
+
     SSPSTAT = sp_i2c;
-    SSPCON = 0x28; 
+    SSPCON = 0x28;
     SSPCON2 = 0x00;
-    
+
     if(sp_i2c == I2C_100KHZ){
         SSPADD = 49;
     }
     else if(sp_i2c == I2C_400KHZ){
         SSPADD = 12;
     }
+
+    PIR1bits.SSPIF = 0;
+    PIE1bits.SSPIE = 0;
+    INTCONbits.PEIE = 1;
 }
 
 void I2C_Start(void)
 {
+    i2c_take_bus();
+    PROF_INICIO(PROF_I2C);
     SSPCON2bits.SEN = 1;
-    while(PIR1bits.SSPIF == 0);
-    PIR1bits.SSPIF = 0;
+    i2c_wait();
 }
 
 void I2C_Stop(void)
 {
     SSPCON2bits.PEN = 1;
-    while(PIR1bits.SSPIF == 0);
-    PIR1bits.SSPIF = 0;
+    i2c_wait();
+    PROF_FIN(PROF_I2C);
+    i2c_bloqueo = 0;
+    i2c_kick();
 }
 
 void I2C_Restart(void)
 {
     SSPCON2bits.RSEN = 1;
-    while(PIR1bits.SSPIF == 0);
-    PIR1bits.SSPIF = 0;
+    i2c_wait();
 }
 
 void I2C_Ack(void)
 {
     SSPCON2bits.ACKDT = 0;
     SSPCON2bits.ACKEN = 1;
-    while(PIR1bits.SSPIF == 0);
-    PIR1bits.SSPIF = 0;
+    i2c_wait();
 }
 
 void I2C_Nack(void)
 {
     SSPCON2bits.ACKDT = 1;
     SSPCON2bits.ACKEN = 1;
-    while(PIR1bits.SSPIF == 0);
-    PIR1bits.SSPIF = 0;
+    i2c_wait();
 }
 
 uint8_t I2C_Write(char data)
 {
-    SSPBUF = data;
-    while(!PIR1bits.SSPIF);
-    PIR1bits.SSPIF = 0;
-    
+    SSPBUF = (uint8_t)data;  // char con signo en el host
+    i2c_wait();
+
+    if(SSPCON2bits.ACKSTAT) PROF_EVENTO(PROF_EV_NACK);
     return (uint8_t)SSPCON2bits.ACKSTAT;
 }
 
 unsigned char I2C_Read(void)
 {
     SSPCON2bits.RCEN = 1;
-    while(PIR1bits.SSPIF == 0);
-    PIR1bits.SSPIF = 0;
+    i2c_wait();
     return SSPBUF;
 }
 
-#endif
\ No newline at end of file
+// ========== COLA DE TRANSACCIONES ==========
+void I2C_Queue_Begin(uint8_t addr)
+{
+    uint8_t sig = i2c_cola_wr + 1;
+    if(sig >= I2C_COLA_LEN) sig = 0;
+
+    // Cola llena: esperar a que la ISR libere un descriptor
+    while(sig == i2c_cola_rd) {
+        i2c_poll();
+    }
+
+    i2c_cola[i2c_cola_wr].addr = addr;
+    i2c_buf_tmp = i2c_buf_wr;
+    i2c_len_tmp = 0;
+    i2c_desborde = 0;
+}
+
+uint8_t I2C_Queue_Put(uint8_t data)
+{
+    uint8_t sig = i2c_buf_tmp + 1;
+    if(sig >= I2C_BUF_LEN) sig = 0;
+
+    while(sig == i2c_buf_rd) {
+        // Si la ISR ya consumio todo lo confirmado, la rafaga no cabe
+        if(i2c_buf_rd == i2c_buf_wr) {
+            i2c_desborde = 1;
+            return 0;
+        }
+        i2c_poll();
+    }
+
+    i2c_buf[i2c_buf_tmp] = data;
+    i2c_buf_tmp = sig;
+    i2c_len_tmp++;
+    return 1;
+}
+
+uint8_t I2C_Queue_Commit(volatile uint8_t *done, I2C_Callback cb)
+{
+    I2C_Trans *t = &i2c_cola[i2c_cola_wr];
+    uint8_t sig;
+
+    if(i2c_desborde) {
+        return 0;
+    }
+
+    t->len = i2c_len_tmp;
+    t->done = done;
+    t->cb = cb;
+    if(done) *done = I2C_PENDIENTE;
+
+    // Publicar datos y descriptor antes de mirar el estado de la ISR
+    i2c_buf_wr = i2c_buf_tmp;
+    sig = i2c_cola_wr + 1;
+    if(sig >= I2C_COLA_LEN) sig = 0;
+    i2c_cola_wr = sig;
+
+    i2c_kick();
+    return 1;
+}
+
+uint8_t I2C_Queue_Write(uint8_t addr, const uint8_t *data, uint8_t len,
+                        volatile uint8_t *done, I2C_Callback cb)
+{
+    I2C_Queue_Begin(addr);
+    while(len--) {
+        if(!I2C_Queue_Put(*data++)) return 0;
+    }
+    return I2C_Queue_Commit(done, cb);
+}
+
+uint8_t I2C_Busy(void)
+{
+    return (i2c_estado != I2C_EST_LIBRE) || (i2c_cola_rd != i2c_cola_wr);
+}
+
+void I2C_Flush(void)
+{
+    while(I2C_Busy()) {
+        i2c_poll();
+    }
+}
+
+static void i2c_stop_async(void)
+{
+    SSPCON2bits.PEN = 1;
+    i2c_estado = I2C_EST_STOP;
+}
+
+void I2C_Isr(void)
+{
+    I2C_Trans *t = &i2c_cola[i2c_cola_rd];
+    uint8_t sig;
+
+    PIR1bits.SSPIF = 0;
+
+    switch(i2c_estado) {
+        case I2C_EST_START:  // START listo: enviar direccion
+            i2c_restante = t->len;
+            i2c_estado = I2C_EST_DATOS;
+            SSPBUF = t->addr;
+            break;
+
+        case I2C_EST_DATOS:  // Byte enviado: siguiente o STOP
+            if(SSPCON2bits.ACKSTAT) {
+                // NACK: descartar lo que quede de la rafaga
+                sig = i2c_buf_rd + i2c_restante;
+                if(sig >= I2C_BUF_LEN) sig -= I2C_BUF_LEN;
+                i2c_buf_rd = sig;
+                i2c_resultado = I2C_NACK;
+                if(t->len) PROF_EVENTO(PROF_EV_NACK);  // Sin datos: un sondeo
+                i2c_stop_async();
+            } else if(i2c_restante) {
+                i2c_restante--;
+                SSPBUF = i2c_buf[i2c_buf_rd];
+                sig = i2c_buf_rd + 1;
+                if(sig >= I2C_BUF_LEN) sig = 0;
+                i2c_buf_rd = sig;
+            } else {
+                i2c_resultado = I2C_OK;
+                i2c_stop_async();
+            }
+            break;
+
+        case I2C_EST_STOP:  // Transaccion terminada
+            PROF_FIN(PROF_I2C);
+            if(t->done) *t->done = i2c_resultado;
+            if(t->cb) t->cb(i2c_resultado);
+
+            sig = i2c_cola_rd + 1;
+            if(sig >= I2C_COLA_LEN) sig = 0;
+            i2c_cola_rd = sig;
+
+            if(sig != i2c_cola_wr && !i2c_bloqueo) {
+                PROF_INICIO(PROF_I2C);
+                i2c_estado = I2C_EST_START;
+                SSPCON2bits.SEN = 1;
+            } else {
+                i2c_estado = I2C_EST_LIBRE;
+                PIE1bits.SSPIE = 0;
+            }
+            break;
+
+        default:
+            PIE1bits.SSPIE = 0;
+            break;
+    }
+}
+
+#endif
@@ -1,24 +1,42 @@
-/* 
+/*
  * File: i2c.h
  * I2C Library for PIC16F887
  * Compatible con DHT11, DS1307 y LCD I2C
+ *
+ * Dos formas de uso:
+ * - Cola de transacciones por interrupcion (I2C_Queue_*): el programa
+ *   encola direccion + rafaga de bytes y sigue trabajando; el MSSP se
+ *   atiende desde I2C_Isr().
+ * - API bloqueante clasica (I2C_Start, I2C_Write, ...): espera a que la
+ *   cola se vacie, toma el bus y lo libera en I2C_Stop().
  */
 #ifndef I2C_H
 #define I2C_H
 
-#include <xc.h>
+#include "hal.h"
 #include <stdint.h>
 
 #define _XTAL_FREQ 20000000
 
-#define TRIS_SCL TRISCbits.TRISC3 
-#define TRIS_SDA TRISCbits.TRISC4 
+#define TRIS_SCL TRISCbits.TRISC3
+#define TRIS_SDA TRISCbits.TRISC4
 
 #define I2C_100KHZ 0x80
 #define I2C_400KHZ 0x00
 
 #define I2C_MASTER_MODE
 
+// Tamanos de la cola (un array no puede ocupar mas de un banco de RAM)
+#define I2C_COLA_LEN   4    // Transacciones pendientes
+#define I2C_BUF_LEN    80   // Bytes de datos en el anillo (una fila de 16 chars cabe)
+
+// Estado de una transaccion encolada
+#define I2C_PENDIENTE  0
+#define I2C_OK         1
+#define I2C_NACK       2
+
+typedef void (*I2C_Callback)(uint8_t estado);
+
 #ifdef I2C_MASTER_MODE
 
 void I2C_Init_Master(unsigned char sp_i2c);
@@ -30,6 +48,16 @@ void I2C_Nack(void);
 unsigned char I2C_Read(void);
 uint8_t I2C_Write(char data);  // Retorna 0 si ACK, 1 si NACK
 
+// Cola de transacciones de escritura
+void I2C_Queue_Begin(uint8_t addr);     // Espera si la cola esta llena
+uint8_t I2C_Queue_Put(uint8_t data);    // Retorna 0 si la rafaga no cabe
+uint8_t I2C_Queue_Commit(volatile uint8_t *done, I2C_Callback cb);
+uint8_t I2C_Queue_Write(uint8_t addr, const uint8_t *data, uint8_t len,
+                        volatile uint8_t *done, I2C_Callback cb);
+uint8_t I2C_Busy(void);
+void I2C_Flush(void);
+void I2C_Isr(void);  // Llamar desde la ISR cuando SSPIF y SSPIE
+
 #endif
 
-#endif /* I2C_H */
\ No newline at end of file
+#endif /* I2C_H */
@@ -0,0 +1,599 @@
+/*
+ * File: ingesta.c
+ * Servicio de ingesta de la telemetria de muchos nodos (Linux)
+ *
+ * Lee las tramas COBS de uart.c de cada fuente (puerto serie, pty, FIFO o
+ * archivo) con un solo hilo sobre epoll. Las tramas se decodifican en el
+ * mismo buffer de lectura (cobs_decodificar(), sin copiar el registro) y
+ * cada registro se agrega a un almacen columnar por nodo y zona, en
+ * archivos mapeados en memoria (<zona> es <nodo> para la zona 0 y
+ * <nodo>_z<k> para las demas):
+ *
+ *   <dir>/<zona>/filas.u8    cantidad de filas validas (uint64)
+ *   <dir>/<zona>/tiempo.i8   ms desde 1970 (int64)
+ *   <dir>/<zona>/temp.i2     decimas de grado (int16, INT16_MIN si fallo)
+ *   <dir>/<zona>/hum.i2      decimas de % (int16, INT16_MIN si fallo)
+ *   <dir>/<zona>/estado.u1   DHT11_OK, DHT11_ERR_* (uint8)
+ *   <dir>/<zona>/seq.u1      seq del registro (uint8)
+ *
+ * Los archivos crecen de a potencias de 2; filas.u8 se actualiza despues
+ * de escribir la fila, asi un lector (np.memmap) nunca ve filas a medias.
+ * Si el directorio ya existe los datos nuevos se agregan al final.
+ *
+ * Por zona se llevan en vivo media y varianza (Welford), minimo, maximo y
+ * un promedio exponencial de lo recibido en esta corrida;
+ * <dir>/resumen.csv se reescribe cada -r segundos y al terminar.
+ *
+ * Uso:
+ *   ingesta [-d dir] [-r seg] fuente...
+ *   ingesta -c nodos [-n rondas] [-t registros/s] [-d dir]
+ *
+ * La segunda forma es el banco de prueba: un hilo generador simula los
+ * nodos sobre pipes y al final se informa registros/s y los percentiles
+ * de la latencia de ingesta (de write() en el generador a la fila
+ * guardada).
+ *
+ * COBS y CRC-8 son los de cobs.c y crc8.c, los mismos del firmware. Con
+ * INGESTA_PRUEBA solo se compilan el almacen y la decodificacion:
+ * test_ingesta.c usa las funciones de ingesta.h.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <termios.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include "ingesta.h"
+#include "cobs.h"
+#include "crc8.h"
+
+#define EVENTOS      256
+#define EWMA_ALFA    (1.0 / 30)  // ~1 minuto con una lectura cada 2 s
+
+// ========== ALMACEN COLUMNAR ==========
+typedef struct {
+    const char *archivo;
+    uint8_t ancho;
+} Columna;
+
+static const Columna columnas[N_COLS] = {
+    { "tiempo.i8", 8 }, { "temp.i2", 2 }, { "hum.i2", 2 }, { "estado.u1", 1 }, { "seq.u1", 1 },
+};
+
+static Nodo *nodos;
+const char *dir_base = "ingesta";
+#ifndef INGESTA_PRUEBA
+static int n_nodos;
+static volatile sig_atomic_t terminar = 0;
+#endif
+
+// Banco de prueba: hora de envio de cada (nodo, seq)
+static uint64_t *envio_ns;
+static uint64_t *latencias;
+static uint64_t n_latencias, max_latencias;
+static _Atomic uint64_t total_ingresados;
+
+static uint64_t ahora_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int64_t reloj_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void fallar(const char *que)
+{
+    perror(que);
+    exit(1);
+}
+
+// Mapea (o vuelve a mapear con mas capacidad) una columna
+static void *col_mapear(Almacen *a, const char *archivo, uint64_t bytes, void *viejo, uint64_t viejo_bytes)
+{
+    char ruta[600];
+    void *p;
+    int fd;
+
+    snprintf(ruta, sizeof(ruta), "%s/%s", a->dir, archivo);
+    if(viejo) munmap(viejo, viejo_bytes);
+    fd = open(ruta, O_RDWR | O_CREAT, 0644);
+    if(fd < 0) fallar(ruta);
+    if(ftruncate(fd, (off_t)bytes) != 0) fallar(ruta);
+    // MAP_POPULATE: los fallos de pagina se pagan aca y no al guardar cada fila
+    p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    if(p == MAP_FAILED) fallar(ruta);
+    close(fd);  // El mapeo sigue valido
+    return p;
+}
+
+static void almacen_abrir(Almacen *a)
+{
+    struct stat st;
+    char ruta[600];
+
+    snprintf(a->dir, sizeof(a->dir), "%s/%s", dir_base, a->nombre);
+    if(mkdir(a->dir, 0755) != 0 && errno != EEXIST) fallar(a->dir);
+
+    a->filas = col_mapear(a, "filas.u8", sizeof(uint64_t), NULL, 0);
+
+    // Capacidad: la de los archivos existentes o la inicial
+    a->capacidad = FILAS_INI;
+    snprintf(ruta, sizeof(ruta), "%s/%s", a->dir, columnas[COL_ESTADO].archivo);
+    if(stat(ruta, &st) == 0 && (uint64_t)st.st_size > a->capacidad) a->capacidad = st.st_size;
+    while(a->capacidad < *a->filas) a->capacidad *= 2;
+
+    for(int c = 0; c < N_COLS; c++) {
+        a->col[c] = col_mapear(a, columnas[c].archivo, a->capacidad * columnas[c].ancho, NULL, 0);
+    }
+}
+
+static void almacen_crecer(Almacen *a)
+{
+    for(int c = 0; c < N_COLS; c++) {
+        a->col[c] = col_mapear(a, columnas[c].archivo, 2 * a->capacidad * columnas[c].ancho,
+                                a->col[c], a->capacidad * columnas[c].ancho);
+    }
+    a->capacidad *= 2;
+}
+
+void almacen_cerrar(Almacen *a)
+{
+    for(int c = 0; c < N_COLS; c++) {
+        munmap(a->col[c], a->capacidad * columnas[c].ancho);
+    }
+    munmap(a->filas, sizeof(uint64_t));
+}
+
+// Almacen de la zona z del nodo, abierto la primera vez que se pide
+Almacen *nodo_zona(Nodo *nd, uint8_t z)
+{
+    Almacen *a = nd->zona[z];
+
+    if(a) return a;
+    a = calloc(1, sizeof(Almacen));
+    if(!a) fallar("calloc");
+    if(z == 0) {
+        snprintf(a->nombre, sizeof(a->nombre), "%s", nd->nombre);
+    } else {
+        snprintf(a->nombre, sizeof(a->nombre), "%s_z%u", nd->nombre, z);
+    }
+    almacen_abrir(a);
+    nd->zona[z] = a;
+    return a;
+}
+
+// ========== ESTADISTICAS ==========
+static void serie_agregar(Serie *s, uint64_t n, int16_t v)
+{
+    double d = v - s->media;
+
+    // Welford: media y suma de cuadrados sin restas catastroficas
+    s->media += d / n;
+    s->m2 += d * (v - s->media);
+    s->ewma = (n == 1) ? v : s->ewma + EWMA_ALFA * (v - s->ewma);
+    if(n == 1 || v < s->min) s->min = v;
+    if(n == 1 || v > s->max) s->max = v;
+    s->ultima = v;
+}
+
+#ifndef INGESTA_PRUEBA
+static void serie_csv(FILE *f, const Serie *s, uint64_t n)
+{
+    if(n == 0) {
+        fprintf(f, ",,,,,,");
+        return;
+    }
+    fprintf(f, ",%.1f,%.2f,%.2f,%.1f,%.1f,%.2f", s->ultima / 10.0, s->media / 10,
+            n > 1 ? sqrt(s->m2 / (n - 1)) / 10 : 0.0, s->min / 10.0, s->max / 10.0, s->ewma / 10);
+}
+
+static void resumen_escribir(void)
+{
+    char ruta[600], tmp[610];
+    FILE *f;
+
+    snprintf(ruta, sizeof(ruta), "%s/resumen.csv", dir_base);
+    snprintf(tmp, sizeof(tmp), "%s.tmp", ruta);
+    f = fopen(tmp, "w");
+    if(!f) {
+        perror(tmp);
+        return;
+    }
+    fprintf(f, "nodo,registros,perdidas,corruptas,fallos,descartadas,"
+               "temp_ultima,temp_media,temp_desv,temp_min,temp_max,temp_ewma,"
+               "hum_ultima,hum_media,hum_desv,hum_min,hum_max,hum_ewma\n");
+    // Una fila por zona; perdidas, corruptas y descartadas son del nodo
+    for(int i = 0; i < n_nodos; i++) {
+        Nodo *nd = &nodos[i];
+        for(int z = 0; z < ZONAS_MAX; z++) {
+            Almacen *a = nd->zona[z];
+            if(!a) continue;
+            fprintf(f, "%s,%llu,%llu,%llu,%llu,%u", a->nombre, (unsigned long long)a->registros,
+                    (unsigned long long)nd->perdidas, (unsigned long long)nd->corruptas,
+                    (unsigned long long)a->fallos, nd->descartadas);
+            serie_csv(f, &a->temp, a->validos);
+            serie_csv(f, &a->hum, a->validos);
+            fputc('\n', f);
+        }
+    }
+    fclose(f);
+    rename(tmp, ruta);  // Los lectores nunca ven el archivo a medias
+}
+#endif /* INGESTA_PRUEBA */
+
+// ========== DECODIFICACION ==========
+static void nodo_registro(Nodo *nd, const uint8_t *r)
+{
+    uint16_t tick = r[1] | r[2] << 8;
+    uint8_t estado = r[8] & 0x07;
+    Almacen *a = nodo_zona(nd, r[8] >> 4);
+    uint64_t f = *a->filas;
+    int16_t t = SIN_DATO, h = SIN_DATO;
+
+    // Hora: la del primer registro mas el avance del tick del PIC
+    if(nd->con_previo) {
+        nd->t_base += (uint16_t)(tick - nd->tick_prev);
+        nd->perdidas += (uint8_t)(r[0] - nd->seq_prev - 1);
+    } else {
+        nd->t_base = reloj_ms();
+        nd->con_previo = 1;
+    }
+    nd->tick_prev = tick;
+    nd->seq_prev = r[0];
+    nd->descartadas = r[9];
+    a->registros++;
+
+    if(estado == DHT11_OK) {
+        if(r[8] & TELEM_DHT22) {
+            // Ya en decimas; la temperatura en signo y magnitud
+            h = r[3] << 8 | r[4];
+            t = (r[5] & 0x7F) << 8 | r[6];
+            if(r[5] & 0x80) t = -t;
+        } else {
+            h = r[3] * 10 + r[4];
+            t = r[5] * 10 + r[6];
+        }
+        a->validos++;
+        serie_agregar(&a->temp, a->validos, t);
+        serie_agregar(&a->hum, a->validos, h);
+    } else {
+        a->fallos++;
+    }
+
+    if(f >= a->capacidad) almacen_crecer(a);
+    ((int64_t *)a->col[COL_TIEMPO])[f] = nd->t_base;
+    ((int16_t *)a->col[COL_TEMP])[f] = t;
+    ((int16_t *)a->col[COL_HUM])[f] = h;
+    ((uint8_t *)a->col[COL_ESTADO])[f] = estado;
+    ((uint8_t *)a->col[COL_SEQ])[f] = r[0];
+    __atomic_store_n(a->filas, f + 1, __ATOMIC_RELEASE);
+
+    if(envio_ns) {
+        uint64_t lat = ahora_ns() - envio_ns[(nd - nodos) * 256 + r[0]];
+        if(n_latencias < max_latencias) latencias[n_latencias++] = lat;
+        atomic_fetch_add_explicit(&total_ingresados, 1, memory_order_release);
+    }
+}
+
+// Separa las tramas en el buffer (delimitador 0x00) y guarda lo que sobra.
+// Cada trama se decodifica en su lugar: el registro queda desde p + 1
+void nodo_procesar(Nodo *nd)
+{
+    uint8_t *p = nd->buf, *fin = nd->buf + nd->n, *z, *r;
+    uint32_t resto;
+
+    while((z = memchr(p, 0x00, fin - p)) != NULL) {
+        if(z > p) {
+            r = p + 1;
+            // Un registro de 11 bytes ocupa 12 con COBS (sin el 0x00)
+            if(z - p == COBS_LEN(TELEM_LEN) - 1 && cobs_decodificar(p, z - p) &&
+               crc8(r, TELEM_LEN - 1) == r[TELEM_LEN - 1]) {
+                nodo_registro(nd, r);
+            } else {
+                nd->corruptas++;
+            }
+        }
+        p = z + 1;
+    }
+
+    // Sin delimitador en todo el buffer: basura, se descarta
+    resto = fin - p;
+    if(resto == BUF_LEN) {
+        nd->corruptas++;
+        resto = 0;
+    }
+    memmove(nd->buf, p, resto);
+    nd->n = resto;
+}
+
+#ifndef INGESTA_PRUEBA
+// Lee todo lo disponible; retorna 0 al llegar al fin de la fuente
+static int nodo_leer(Nodo *nd)
+{
+    ssize_t r;
+
+    for(;;) {
+        r = read(nd->fd, nd->buf + nd->n, BUF_LEN - nd->n);
+        if(r > 0) {
+            nd->n += r;
+            nodo_procesar(nd);
+        } else if(r == 0 || (errno != EAGAIN && errno != EINTR)) {
+            return 0;  // EOF, o EIO de una pty cuyo otro lado se cerro
+        } else if(errno == EAGAIN) {
+            return 1;
+        }
+    }
+}
+
+// ========== FUENTES ==========
+static void nodo_nombre(Nodo *nd, const char *ruta, int i)
+{
+    const char *base = strrchr(ruta, '/');
+    base = base ? base + 1 : ruta;
+    snprintf(nd->nombre, sizeof(nd->nombre), "%s", base);
+    if(nd->nombre[0] == '.') nd->nombre[0] = '_';  // Sin directorios ocultos
+    for(int j = 0; j < i; j++) {
+        if(strcmp(nodos[j].nombre, nd->nombre) == 0) {
+            snprintf(nd->nombre, sizeof(nd->nombre), "%.50s_%d", base, i);
+            break;
+        }
+    }
+}
+
+static int fuente_abrir(const char *ruta)
+{
+    struct termios tio;
+    int fd = open(ruta, O_RDONLY | O_NOCTTY | O_NONBLOCK);
+
+    if(fd < 0) fallar(ruta);
+    if(isatty(fd) && tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        cfsetspeed(&tio, B115200);
+        tcsetattr(fd, TCSANOW, &tio);  // TCSANOW: no descartar lo recibido
+    }
+    return fd;
+}
+
+static void nodo_cerrar(int ep, Nodo *nd)
+{
+    if(!nd->abierto) return;
+    epoll_ctl(ep, EPOLL_CTL_DEL, nd->fd, NULL);
+    close(nd->fd);
+    nd->abierto = 0;
+}
+
+// Bucle principal: termina cuando se cierran todas las fuentes
+static void ingerir(int periodo_resumen)
+{
+    struct epoll_event ev, eventos[EVENTOS];
+    int ep = epoll_create1(0), abiertos = 0;
+    uint64_t proximo_resumen = ahora_ns() + (uint64_t)periodo_resumen * 1000000000ULL;
+
+    if(ep < 0) fallar("epoll_create1");
+    for(int i = 0; i < n_nodos; i++) {
+        ev.events = EPOLLIN;
+        ev.data.ptr = &nodos[i];
+        nodos[i].abierto = 1;
+        if(epoll_ctl(ep, EPOLL_CTL_ADD, nodos[i].fd, &ev) == 0) {
+            abiertos++;
+        } else if(errno == EPERM) {
+            // Archivo comun: epoll no lo admite, se lee completo ahora
+            nodo_leer(&nodos[i]);
+            close(nodos[i].fd);
+            nodos[i].abierto = 0;
+        } else {
+            fallar("epoll_ctl");
+        }
+    }
+
+    while(abiertos > 0 && !terminar) {
+        int n = epoll_wait(ep, eventos, EVENTOS, 1000);
+        if(n < 0 && errno != EINTR) fallar("epoll_wait");
+        for(int i = 0; i < n; i++) {
+            Nodo *nd = eventos[i].data.ptr;
+            if(!nodo_leer(nd)) {
+                nodo_cerrar(ep, nd);
+                abiertos--;
+            }
+        }
+        if(periodo_resumen > 0 && ahora_ns() >= proximo_resumen) {
+            resumen_escribir();
+            proximo_resumen += (uint64_t)periodo_resumen * 1000000000ULL;
+        }
+    }
+    for(int i = 0; i < n_nodos; i++) nodo_cerrar(ep, &nodos[i]);
+    close(ep);
+}
+
+// ========== BANCO DE PRUEBA ==========
+typedef struct {
+    int *fds;
+    int nodos;
+    uint64_t rondas;
+    double tasa;   // Registros/s en total (0 = sin limite)
+} Carga;
+
+static void *carga_hilo(void *arg)
+{
+    Carga *c = arg;
+    uint8_t r[TELEM_LEN], t[COBS_LEN(TELEM_LEN)];
+    uint64_t inicio = ahora_ns();
+    unsigned semilla = 1;
+
+    for(uint64_t ronda = 0; ronda < c->rondas && !terminar; ronda++) {
+        // Nunca mas de 64 rondas por delante: el seq (8 bits) identifica
+        // sin ambiguedad la hora de envio
+        while(ronda >= 64 &&
+              atomic_load_explicit(&total_ingresados, memory_order_acquire) < (ronda - 64) * c->nodos) {
+            sched_yield();
+        }
+        for(int i = 0; i < c->nodos; i++) {
+            // Con tasa fija los envios se reparten parejo, no por rondas
+            if(c->tasa > 0) {
+                uint64_t objetivo = inicio + (uint64_t)((ronda * c->nodos + i) / c->tasa * 1e9);
+                while(ahora_ns() < objetivo) {
+                    struct timespec ts = { 0, 20000 };
+                    nanosleep(&ts, NULL);
+                }
+            }
+            uint16_t tick = (uint16_t)(ronda * 2000);
+            uint8_t temp = 20 + (i + ronda / 300) % 10, hum = 50 + (i * 7 + ronda / 100) % 30;
+
+            r[0] = (uint8_t)ronda;
+            r[1] = tick & 0xFF;
+            r[2] = tick >> 8;
+            r[3] = hum;
+            r[4] = 0;
+            r[5] = temp;
+            r[6] = 0;
+            r[7] = hum + temp;
+            r[8] = (rand_r(&semilla) % 100 == 0) ? 1 : DHT11_OK;  // 1% sin respuesta
+            r[9] = 0;
+            r[10] = crc8(r, TELEM_LEN - 1);
+
+            cobs_codificar(r, TELEM_LEN, t, 0, sizeof(t));
+            envio_ns[(uint64_t)i * 256 + r[0]] = ahora_ns();
+            if(write(c->fds[i], t, sizeof(t)) != (ssize_t)sizeof(t)) fallar("write");
+        }
+    }
+    for(int i = 0; i < c->nodos; i++) close(c->fds[i]);
+    return NULL;
+}
+
+static int comparar_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentil_us(double p)
+{
+    uint64_t i = (uint64_t)(p / 100 * (n_latencias - 1));
+    return latencias[i] / 1000.0;
+}
+
+static void banco(int n, uint64_t rondas, double tasa)
+{
+    Carga c = { malloc(n * sizeof(int)), n, rondas, tasa };
+    pthread_t hilo;
+    uint64_t t0, t1;
+
+    envio_ns = calloc((size_t)n * 256, sizeof(uint64_t));
+    max_latencias = (uint64_t)n * rondas;
+    if(max_latencias > 16000000) max_latencias = 16000000;
+    latencias = malloc(max_latencias * sizeof(uint64_t));
+    if(!c.fds || !envio_ns || !latencias) fallar("malloc");
+
+    for(int i = 0; i < n; i++) {
+        int p[2];
+        if(pipe2(p, O_NONBLOCK) != 0) fallar("pipe2");
+        fcntl(p[1], F_SETFL, 0);  // El generador escribe bloqueando
+        nodos[i].fd = p[0];
+        c.fds[i] = p[1];
+        snprintf(nodos[i].nombre, sizeof(nodos[i].nombre), "nodo%04d", i);
+        nodo_zona(&nodos[i], 0);
+    }
+
+    t0 = ahora_ns();
+    pthread_create(&hilo, NULL, carga_hilo, &c);
+    ingerir(0);
+    pthread_join(hilo, NULL);
+    t1 = ahora_ns();
+
+    qsort(latencias, n_latencias, sizeof(uint64_t), comparar_u64);
+    printf("%d nodos, %llu registros en %.3f s: %.0f registros/s\n", n,
+           (unsigned long long)atomic_load(&total_ingresados), (t1 - t0) / 1e9,
+           atomic_load(&total_ingresados) / ((t1 - t0) / 1e9));
+    if(n_latencias) {
+        printf("latencia (us): p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n",
+               percentil_us(50), percentil_us(90), percentil_us(99), percentil_us(99.9),
+               latencias[n_latencias - 1] / 1000.0);
+    }
+    free(c.fds);
+}
+
+// ========== PRINCIPAL ==========
+static void al_senal(int s)
+{
+    (void)s;
+    terminar = 1;
+}
+
+static void uso(void)
+{
+    fprintf(stderr, "uso: ingesta [-d dir] [-r seg] fuente...\n"
+                    "     ingesta -c nodos [-n rondas] [-t registros/s] [-d dir]\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    struct rlimit rl;
+    int opt, carga = 0, periodo = 5;
+    uint64_t rondas = 1000;
+    double tasa = 0;
+
+    while((opt = getopt(argc, argv, "d:r:c:n:t:")) != -1) {
+        switch(opt) {
+            case 'd': dir_base = optarg; break;
+            case 'r': periodo = atoi(optarg); break;
+            case 'c': carga = atoi(optarg); break;
+            case 'n': rondas = strtoull(optarg, NULL, 10); break;
+            case 't': tasa = atof(optarg); break;
+            default: uso();
+        }
+    }
+    if(!carga && optind >= argc) uso();
+
+    // Dos descriptores por nodo en el banco de prueba
+    if(getrlimit(RLIMIT_NOFILE, &rl) == 0) {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+    signal(SIGINT, al_senal);
+    signal(SIGTERM, al_senal);
+    signal(SIGPIPE, SIG_IGN);
+    if(mkdir(dir_base, 0755) != 0 && errno != EEXIST) fallar(dir_base);
+
+    n_nodos = carga ? carga : argc - optind;
+    nodos = calloc(n_nodos, sizeof(Nodo));
+    if(!nodos) fallar("calloc");
+
+    if(carga) {
+        banco(carga, rondas, tasa);
+    } else {
+        for(int i = 0; i < n_nodos; i++) {
+            nodos[i].fd = fuente_abrir(argv[optind + i]);
+            nodo_nombre(&nodos[i], argv[optind + i], i);
+            nodo_zona(&nodos[i], 0);
+        }
+        ingerir(periodo);
+    }
+
+    resumen_escribir();
+    for(int i = 0; i < n_nodos; i++) {
+        for(int z = 0; z < ZONAS_MAX; z++) {
+            if(nodos[i].zona[z]) almacen_cerrar(nodos[i].zona[z]);
+        }
+    }
+    return 0;
+}
+#endif /* INGESTA_PRUEBA */
@@ -0,0 +1,72 @@
+/*
+ * File: ingesta.h
+ * Nodos y almacen columnar del servicio de ingesta (ver ingesta.c)
+ *
+ * Lo que usa test_ingesta.c: se llena nd->buf/nd->n como lo haria read()
+ * y nodo_procesar() separa, decodifica y guarda los registros en el
+ * almacen de cada zona, bajo dir_base.
+ */
+#ifndef INGESTA_H
+#define INGESTA_H
+
+#include <stdint.h>
+
+// Registro de main.c: [seq][tick L][tick H][5 bytes DHT11][zona:4|estado:4]
+// [descartadas][crc8]; el bit 3 del estado marca los bytes de un DHT22
+#define TELEM_LEN    11
+#define TELEM_DHT22  0x08
+#define DHT11_OK     0
+#define ZONAS_MAX    16
+#define SIN_DATO     INT16_MIN
+
+#define BUF_LEN      4096      // Lectura por nodo
+#define FILAS_INI    4096      // Capacidad inicial del almacen
+
+enum { COL_TIEMPO, COL_TEMP, COL_HUM, COL_ESTADO, COL_SEQ, N_COLS };
+
+typedef struct {
+    double media, m2, ewma;
+    int16_t min, max, ultima;
+} Serie;
+
+// Almacen y estadisticas en vivo (solo lecturas DHT11_OK) de una zona
+typedef struct {
+    char nombre[72];
+    char dir[512];
+
+    void *col[N_COLS];
+    uint64_t *filas;
+    uint64_t capacidad;
+
+    uint64_t registros, validos, fallos;
+    Serie temp, hum;
+} Almacen;
+
+typedef struct {
+    int fd;
+    int abierto;
+    char nombre[64];
+
+    uint8_t buf[BUF_LEN];
+    uint32_t n;              // Bytes sin procesar en buf
+
+    // Desenrollado del tick de 16 bits (seq y tick son comunes a las zonas)
+    int64_t t_base;
+    uint16_t tick_prev;
+    uint8_t seq_prev;
+    uint8_t con_previo;
+
+    uint64_t perdidas, corruptas;
+    uint8_t descartadas;
+
+    // La zona 0 se abre al empezar; las demas con su primer registro
+    Almacen *zona[ZONAS_MAX];
+} Nodo;
+
+extern const char *dir_base;   // Directorio de los almacenes ("ingesta")
+
+Almacen *nodo_zona(Nodo *nd, uint8_t z);   // Abre el almacen la primera vez
+void nodo_procesar(Nodo *nd);              // Tramas completas de nd->buf
+void almacen_cerrar(Almacen *a);
+
+#endif /* INGESTA_H */
@@ -3,57 +3,135 @@
  * LCD I2C Library Implementation for PIC16F887
  */
 
-#include <xc.h>
+#include "hal.h"
 #include <stdint.h>
 #include "i2c.h"
 #include "lcd_i2c.h"
 
 #define _XTAL_FREQ 20000000
 
+// Bits del PCF8574: P0=RS, P1=RW, P2=E, P3=luz de fondo, P4-P7=D4-D7
+#define LCD_RS  0x01
+#define LCD_RW  0x02
+#define LCD_EN  0x04
+#define LCD_BL  0x08
+#define LCD_BF  0x80   // Busy flag en D7, con el nibble alto
+
+// Cada lectura del busy flag son ~1 ms de bus a 100 kHz; el borrado mas
+// lento del HD44780 es de 1.52 ms (2 ms con el oscilador al minimo)
+#define LCD_ESPERA_MAX  4
+#define LCD_BORRAR_MS   2   // Sin RW: el retardo fijo de antes
+
+// Copia en RAM de la pantalla: lo que se quiere mostrar y lo que ya muestra
+static char lcd_fb[LCD_ROWS][LCD_COLS];
+static char lcd_shadow[LCD_ROWS][LCD_COLS];
+
+static uint8_t lcd_rw = 0;   // RW conectado a P1: se lee el busy flag
+
+static uint8_t lcd_leer_bf(void);
+static void lcd_esperar(void);
+
+// Los 20 ms del encendido no se pueden cambiar por el busy flag: el
+// HD44780 no lo contesta hasta el "function set" de 4 bits. Despues se
+// mira una vez si RW esta conectado: con RW a GND en el modulo (hay
+// adaptadores asi) el HD44780 no maneja D4-D7, las salidas del PCF8574
+// quedan en 1 y se lee "ocupado" aunque ya termino el "function set". Los
+// dos pulsos de E de esa lectura escriben entonces la instruccion 0xFF
+// (DDRAM en 0x7F), que el borrado de abajo deshace
 void Lcd_Init(void)
 {
     __delay_ms(20);
     Lcd_Cmd(0x33);
     Lcd_Cmd(0x32);
     Lcd_Cmd(0x28);
+    I2C_Flush();
+    __delay_us(100);    // El "function set" tarda 37 us
+    lcd_rw = !lcd_leer_bf();
     Lcd_Cmd(0x0C);
     Lcd_Cmd(0x06);
     Lcd_Cmd(0x01);
-    __delay_ms(3);
+    lcd_esperar();
+    Lcd_Fb_Invalidate();
 }
 
-void Lcd_Cmd(unsigned char cmd)
+// Lee el busy flag por el PCF8574: RW en alto con E en bajo (tAS), D4-D7
+// en 1 (las salidas del PCF8574 solo tiran a bajo), E en alto y una
+// lectura del puerto con el nibble alto; el segundo pulso de E saca el
+// nibble bajo, que se descarta. Termina con RW en bajo, para que el
+// proximo pulso de E de una escritura no lo cambie. Con el bus
+// bloqueante: la instruccion tiene que haber salido de la cola
+static uint8_t lcd_leer_bf(void)
 {
-    char data_u, data_l;
-    data_u = (cmd & 0xF0);
-    data_l = ((cmd<<4) & 0xF0); 
-   
-    
+    uint8_t bf;
+
     I2C_Start();
     I2C_Write(ADDRESS_LCD);
-    I2C_Write(data_u|0x0C);
-    I2C_Write(data_u|0x08);
-    I2C_Write(data_l|0x0C);
-    I2C_Write(data_l|0x08);
+    I2C_Write(0xF0|LCD_BL|LCD_RW);
+    I2C_Write(0xF0|LCD_BL|LCD_RW|LCD_EN);
+    I2C_Restart();
+    I2C_Write(ADDRESS_LCD | 1);
+    bf = I2C_Read() & LCD_BF;
+    I2C_Nack();
+    I2C_Restart();
+    I2C_Write(ADDRESS_LCD);
+    I2C_Write(0xF0|LCD_BL|LCD_RW);
+    I2C_Write(0xF0|LCD_BL|LCD_RW|LCD_EN);
+    I2C_Write(0xF0|LCD_BL|LCD_RW);
+    I2C_Write(0xF0|LCD_BL);
     I2C_Stop();
+    return bf;
 }
 
-void Lcd_Write_Char(char c)
+// Espera a que el HD44780 termine un borrado. Sin RW (ver Lcd_Init) cada
+// sondeo escribiria 0xFF como instruccion: se espera el tiempo fijo
+static void lcd_esperar(void)
 {
-    char data_u, data_l;
+    if(!lcd_rw)
+    {
+        I2C_Flush();
+        __delay_ms(LCD_BORRAR_MS);
+        return;
+    }
+    for(uint8_t i = 0; i < LCD_ESPERA_MAX && lcd_leer_bf(); i++);
+}
+
+// Cada byte del LCD son 4 bytes del PCF8574; una rafaga debe caber en la cola I2C
+#define LCD_RAFAGA_MAX  ((I2C_BUF_LEN - 1) / 4)
+
+static uint8_t lcd_rafaga_n;
+
+// Abre una transaccion I2C donde se acumulan varios bytes del LCD
+static void lcd_burst_begin(void)
+{
+    I2C_Queue_Begin(ADDRESS_LCD);
+    lcd_rafaga_n = 0;
+}
+
+static void lcd_burst_end(void)
+{
+    I2C_Queue_Commit(0, 0);
+}
+
+// Agrega un byte (nibble alto y bajo con pulso en E) a la rafaga abierta
+static void lcd_burst_put(unsigned char c, unsigned char ctrl)
+{
+    unsigned char data_u, data_l;
     data_u = (c & 0xF0);
     data_l = ((c<<4) & 0xF0);
-    
-    I2C_Start();
-    I2C_Write(ADDRESS_LCD);
-    I2C_Write(data_u|0x0D);
-    I2C_Write(data_u|0x09);
-    I2C_Write(data_l|0x0D);
-    I2C_Write(data_l|0x09);
-    I2C_Stop();
+
+    if(lcd_rafaga_n >= LCD_RAFAGA_MAX) {
+        lcd_burst_end();
+        lcd_burst_begin();
+    }
+
+    I2C_Queue_Put(data_u|ctrl|LCD_EN);
+    I2C_Queue_Put(data_u|ctrl);
+    I2C_Queue_Put(data_l|ctrl|LCD_EN);
+    I2C_Queue_Put(data_l|ctrl);
+    lcd_rafaga_n++;
 }
 
-void Lcd_Set_Cursor(char col, char row)
+static unsigned char lcd_address(char col, char row)
 {
     unsigned char address;
     switch(row)
@@ -74,22 +152,56 @@ void Lcd_Set_Cursor(char col, char row)
             address = 0x00;
             break;
     }
-    address += col - 1;
-    Lcd_Cmd(0x80 | address);
+    return address + col - 1;
 }
 
+void Lcd_Cmd(unsigned char cmd)
+{
+    lcd_burst_begin();
+    lcd_burst_put(cmd, LCD_BL);
+    lcd_burst_end();
+}
+
+void Lcd_Write_Char(char c)
+{
+    lcd_burst_begin();
+    lcd_burst_put(c, LCD_BL|LCD_RS);
+    lcd_burst_end();
+}
+
+void Lcd_Set_Cursor(char col, char row)
+{
+    Lcd_Cmd(0x80 | lcd_address(col, row));
+}
+
+// Toda la cadena viaja en una sola transaccion (START/STOP una vez)
 void Lcd_Write_String(const char *str)
 {
+    lcd_burst_begin();
     while(*str != '\0')
     {
-        Lcd_Write_Char(*str++);
+        lcd_burst_put(*str++, LCD_BL|LCD_RS);
     }
+    lcd_burst_end();
+}
+
+// Posicion del cursor + cadena en la misma transaccion
+void Lcd_Write_String_At(char col, char row, const char *str)
+{
+    lcd_burst_begin();
+    lcd_burst_put(0x80 | lcd_address(col, row), LCD_BL);
+    while(*str != '\0')
+    {
+        lcd_burst_put(*str++, LCD_BL|LCD_RS);
+    }
+    lcd_burst_end();
 }
 
 void Lcd_Clear(void)
 {
     Lcd_Cmd(0x01);
-    __delay_ms(2);
+    lcd_esperar();
+    Lcd_Fb_Invalidate();
 }
 
 void Lcd_Shift_Right(void)
@@ -121,10 +233,117 @@ void Lcd_CGRAM_CreateChar(char pos, const char* new_char)
 {
     if(pos < 8)
     {
-        Lcd_Cmd(0x40 + (pos*8));
-        for(char i=0; i<8; i++)
+        // Direccion CGRAM + 8 filas del glifo en una sola transaccion
+        lcd_burst_begin();
+        lcd_burst_put(0x40 + (pos*8), LCD_BL);
+        for(uint8_t i=0; i<8; i++)
+        {
+            lcd_burst_put(new_char[i], LCD_BL|LCD_RS);
+        }
+        lcd_burst_end();
+    }
+}
+
+// ========== FRAMEBUFFER ==========
+// Vacia el framebuffer (no toca el LCD hasta Lcd_Flush)
+void Lcd_Fb_Clear(void)
+{
+    for(uint8_t r = 0; r < LCD_ROWS; r++)
+    {
+        for(uint8_t c = 0; c < LCD_COLS; c++)
         {
-            Lcd_Write_Char(new_char[i]);
+            lcd_fb[r][c] = ' ';
         }
     }
-}
\ No newline at end of file
+}
+
+// Tras un Lcd_Clear el LCD queda en blanco: framebuffer y sombra coinciden
+void Lcd_Fb_Invalidate(void)
+{
+    Lcd_Fb_Clear();
+    for(uint8_t r = 0; r < LCD_ROWS; r++)
+    {
+        for(uint8_t c = 0; c < LCD_COLS; c++)
+        {
+            lcd_shadow[r][c] = ' ';
+        }
+    }
+}
+
+void Lcd_Fb_Write_Char(char col, char row, char c)
+{
+    if(row >= 1 && row <= LCD_ROWS && col >= 1 && col <= LCD_COLS)
+    {
+        lcd_fb[row-1][col-1] = c;
+    }
+}
+
+void Lcd_Fb_Write_String(char col, char row, const char *str)
+{
+    while(*str != '\0' && col <= LCD_COLS)
+    {
+        Lcd_Fb_Write_Char(col++, row, *str++);
+    }
+}
+
+// Posicion de una celda en el framebuffer; quien escribe no debe pasar del
+// fin de la fila (no hay control de limites)
+char *Lcd_Fb_At(char col, char row)
+{
+    return &lcd_fb[row-1][col-1];
+}
+
+// Envia solo las celdas que cambiaron. Un hueco de una celda igual se
+// reescribe (4 bytes, lo mismo que mover el cursor); huecos mayores se
+// saltan con un comando de posicion.
+void Lcd_Flush(void)
+{
+    uint8_t r, c, fin, j;
+    uint8_t abierta = 0;
+    unsigned char cursor = 0xFF;
+    unsigned char address;
+
+    for(r = 0; r < LCD_ROWS; r++)
+    {
+        c = 0;
+        while(c < LCD_COLS)
+        {
+            if(lcd_fb[r][c] == lcd_shadow[r][c])
+            {
+                c++;
+                continue;
+            }
+
+            // Buscar el final del tramo sucio
+            fin = c;
+            for(j = c + 1; j < LCD_COLS && j <= fin + 2; j++)
+            {
+                if(lcd_fb[r][j] != lcd_shadow[r][j]) fin = j;
+            }
+
+            if(!abierta)
+            {
+                lcd_burst_begin();
+                abierta = 1;
+            }
+
+            address = lcd_address(c + 1, r + 1);
+            if(cursor != address)
+            {
+                lcd_burst_put(0x80 | address, LCD_BL);
+            }
+
+            for(; c <= fin; c++)
+            {
+                lcd_burst_put(lcd_fb[r][c], LCD_BL|LCD_RS);
+                lcd_shadow[r][c] = lcd_fb[r][c];
+            }
+            cursor = lcd_address(c + 1, r + 1);  // El LCD avanza solo
+        }
+    }
+
+    if(abierta)
+    {
+        lcd_burst_end();
+    }
+}
@@ -8,11 +8,20 @@
 
 #define ADDRESS_LCD 0x4E  //if this now works, you must use any of them -> 0x7E o 0x50
 
+// Tamano de la pantalla (16x2 o 20x4)
+#ifndef LCD_COLS
+#define LCD_COLS 16
+#endif
+#ifndef LCD_ROWS
+#define LCD_ROWS 2
+#endif
+
 void Lcd_Init(void);
 void Lcd_Cmd(unsigned char cmd);
 void Lcd_Set_Cursor(char col, char row);
 void Lcd_Write_Char(char c);
 void Lcd_Write_String(const char *str);
+void Lcd_Write_String_At(char col, char row, const char *str);
 void Lcd_Clear(void);
 void Lcd_Shift_Right(void);
 void Lcd_Shift_Left(void);
@@ -21,4 +30,12 @@ void Lcd_NoBlink(void);
 void Lcd_CGRAM_WriteChar(char n);
 void Lcd_CGRAM_CreateChar(char pos, const char* new_char);
 
+// Framebuffer: se escribe en RAM y Lcd_Flush manda solo lo que cambio
+void Lcd_Fb_Clear(void);
+void Lcd_Fb_Invalidate(void);
+void Lcd_Fb_Write_Char(char col, char row, char c);
+void Lcd_Fb_Write_String(char col, char row, const char *str);
+char *Lcd_Fb_At(char col, char row);  // Para escribir campos (fmt.h) en su lugar
+void Lcd_Flush(void);
+
 #endif /* LCD_I2C_H */
\ No newline at end of file
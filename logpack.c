@@ -0,0 +1,282 @@
+/*
+ * File: logpack.c
+ * Codificacion compacta de lecturas (keyframe + deltas en nibbles)
+ */
+#include "logpack.h"
+
+#define PACK_NADA  0xFF
+
+static uint8_t pack_nib(const uint8_t *datos, uint8_t pos)
+{
+    uint8_t b = datos[pos >> 1];
+    return (pos & 1) ? (b & 0x0F) : (b >> 4);
+}
+
+static void pack_set(Pack *p, uint8_t *datos, uint8_t pos, uint8_t v)
+{
+    uint8_t i = pos >> 1;
+
+    if(pos & 1) {
+        datos[i] = (datos[i] & 0xF0) | v;
+    } else {
+        datos[i] = (datos[i] & 0x0F) | (uint8_t)(v << 4);
+    }
+    if(i < p->mod_ini) p->mod_ini = i;
+    if(i > p->mod_fin) p->mod_fin = i;
+}
+
+static void pack_put(Pack *p, uint8_t *datos, uint8_t v)
+{
+    pack_set(p, datos, p->pos, v);
+    p->pos++;
+}
+
+// Valor completo para el escape, del nibble alto al bajo
+static void pack_put_abs(Pack *p, uint8_t *datos, muestra_t v)
+{
+    for(uint8_t i = PACK_ABS_NIB; i > 0; i--) {
+        pack_put(p, datos, (uint8_t)((uint16_t)v >> (4 * (i - 1))) & 0x0F);
+    }
+}
+
+static muestra_t unpack_abs(const uint8_t *datos, uint8_t pos)
+{
+    uint16_t v = 0;
+
+    for(uint8_t i = 0; i < PACK_ABS_NIB; i++) {
+        v = (v << 4) | pack_nib(datos, pos + i);
+    }
+    return (muestra_t)v;
+}
+
+// Codigo de valor (delta o absoluto), precedido por el hueco si hay uno.
+// Sin corridas: el "sin cambio" que cierra un hueco no puede convertirse
+// despues en corrida
+static uint8_t pack_valor(Pack *p, uint8_t *datos, uint8_t hueco, muestra_t t, muestra_t h)
+{
+    int16_t dt = (int16_t)(t - p->t);
+    int16_t dh = (int16_t)(h - p->h);
+    uint8_t largo = hueco ? 2 : 0;
+
+    if(dt >= -1 && dt <= 1 && dh >= -1 && dh <= 1) {
+        largo += 1;
+    } else if(dt >= -8 && dt <= 7 && dh >= -8 && dh <= 7) {
+        largo += 3;
+    } else {
+        largo += 1 + 2 * PACK_ABS_NIB;
+    }
+    if(PACK_NIBBLES - p->pos < largo) return 0;
+
+    if(hueco) {
+        pack_put(p, datos, PACK_HUECO);
+        pack_put(p, datos, hueco - 1);
+    }
+    if(dt >= -1 && dt <= 1 && dh >= -1 && dh <= 1) {
+        pack_put(p, datos, (uint8_t)((dt + 1) * 3 + (dh + 1)));
+    } else if(dt >= -8 && dt <= 7 && dh >= -8 && dh <= 7) {
+        pack_put(p, datos, PACK_MEDIO);
+        pack_put(p, datos, (uint8_t)dt & 0x0F);
+        pack_put(p, datos, (uint8_t)dh & 0x0F);
+    } else {
+        pack_put(p, datos, PACK_ABS);
+        pack_put_abs(p, datos, t);
+        pack_put_abs(p, datos, h);
+    }
+
+    p->t = t;
+    p->h = h;
+    p->corrida = PACK_NADA;
+    p->cero = PACK_NADA;
+    return 1;
+}
+
+void pack_init(Pack *p, uint8_t *datos, muestra_t t, muestra_t h)
+{
+    for(uint8_t i = 0; i < PACK_BYTES; i++) {
+        datos[i] = 0xFF;
+    }
+    p->t = t;
+    p->h = h;
+    p->pos = 0;
+    p->corrida = PACK_NADA;
+    p->cero = PACK_NADA;
+}
+
+void pack_init_origen(Pack *p, uint8_t *datos, muestra_t t, muestra_t h)
+{
+    pack_init(p, datos, t, h);
+    pack_put(p, datos, PACK_ORIGEN);
+}
+
+uint8_t pack_add(Pack *p, uint8_t *datos, muestra_t t, muestra_t h)
+{
+    int16_t dt = (int16_t)(t - p->t);
+    int16_t dh = (int16_t)(h - p->h);
+    uint8_t libres = PACK_NIBBLES - p->pos;
+
+    p->mod_ini = PACK_NADA;
+    p->mod_fin = 0;
+
+    if(dt == 0 && dh == 0) {
+        // Extender la corrida abierta, o convertir "sin cambio" en corrida
+        if(p->corrida != PACK_NADA && pack_nib(datos, p->corrida) < 0x0F) {
+            pack_set(p, datos, p->corrida, pack_nib(datos, p->corrida) + 1);
+            return 1;
+        }
+        // Solo si el 4 esta en el nibble alto: 9 y contador quedan en el
+        // mismo byte y se graban juntos. En el bajo, el contador caeria en
+        // el byte siguiente, que se graba primero, y un corte en medio
+        // dejaria "4 0": una lectura fantasma. Ahi va otro 4, que si queda
+        // en un nibble alto
+        if(p->cero != PACK_NADA && !(p->cero & 1) && libres >= 1) {
+            pack_set(p, datos, p->cero, PACK_CORRIDA);
+            p->corrida = p->pos;
+            p->cero = PACK_NADA;
+            pack_put(p, datos, 0);
+            return 1;
+        }
+        if(libres < 1) return 0;
+        p->cero = p->pos;
+        p->corrida = PACK_NADA;
+        pack_put(p, datos, 4);
+        return 1;
+    }
+
+    return pack_valor(p, datos, 0, t, h);
+}
+
+uint8_t pack_add_hueco(Pack *p, uint8_t *datos, uint8_t hueco, muestra_t t, muestra_t h)
+{
+    if(hueco == 0) return pack_add(p, datos, t, h);
+    p->mod_ini = PACK_NADA;
+    p->mod_fin = 0;
+    return pack_valor(p, datos, hueco, t, h);
+}
+
+uint8_t pack_resume(Pack *p, uint8_t *datos, muestra_t t, muestra_t h)
+{
+    Unpack u;
+    uint8_t n = 0;
+
+    p->mod_ini = PACK_NADA;
+    p->mod_fin = 0;
+    unpack_init(&u, datos, t, h);
+    while(unpack_next(&u, &t, &h)) {
+        n++;
+    }
+
+    // Lo que quede despues del ultimo codigo valido se da por borrado
+    p->t = t;
+    p->h = h;
+    p->pos = u.pos;
+    p->corrida = PACK_NADA;
+    p->cero = PACK_NADA;
+    for(uint8_t i = u.pos; i < PACK_NIBBLES; i++) {
+        pack_set(p, datos, i, PACK_FIN);
+    }
+    return n;
+}
+
+void unpack_init(Unpack *u, const uint8_t *datos, muestra_t t, muestra_t h)
+{
+    u->datos = datos;
+    u->t = t;
+    u->h = h;
+    u->pos = 0;
+    u->repetir = 0;
+    u->hueco = 0;
+    u->paso = 0;
+    u->keyframe = 1;
+    if(pack_nib(datos, 0) == PACK_ORIGEN) {
+        u->keyframe = 0;
+        u->pos = 1;
+    }
+}
+
+// Aplica el codigo de valor en pos a u->t, u->h; retorna la posicion
+// siguiente, o 0 si no hay un codigo de valor completo
+static uint8_t unpack_valor(Unpack *u, uint8_t pos)
+{
+    uint8_t c, libres;
+    int8_t dt;
+
+    if(pos >= PACK_NIBBLES) return 0;
+    libres = PACK_NIBBLES - pos - 1;
+    c = pack_nib(u->datos, pos);
+
+    if(c <= 8) {
+        dt = (c >= 6) ? 1 : (c >= 3) ? 0 : -1;
+        u->t += dt;
+        u->h += c - 3 * (dt + 1) - 1;
+        return pos + 1;
+    }
+    if(c == PACK_MEDIO && libres >= 2) {
+        // Extender el signo de los nibbles
+        u->t += (int8_t)(pack_nib(u->datos, pos + 1) << 4) >> 4;
+        u->h += (int8_t)(pack_nib(u->datos, pos + 2) << 4) >> 4;
+        return pos + 3;
+    }
+    if(c == PACK_ABS && libres >= 2 * PACK_ABS_NIB) {
+        u->t = unpack_abs(u->datos, pos + 1);
+        u->h = unpack_abs(u->datos, pos + 1 + PACK_ABS_NIB);
+        return pos + 1 + 2 * PACK_ABS_NIB;
+    }
+    return 0;  // Fin, codigo reservado o codigo cortado
+}
+
+// Punto i de n sobre la recta de a a b, redondeado al mas cercano
+static muestra_t unpack_interp(muestra_t a, muestra_t b, uint8_t i, uint8_t n)
+{
+    int16_t d = (int16_t)(b - a) * i;
+
+    if(d < 0) return a - (muestra_t)((-d + n / 2) / n);
+    return a + (muestra_t)((d + n / 2) / n);
+}
+
+uint8_t unpack_next(Unpack *u, muestra_t *t, muestra_t *h)
+{
+    uint8_t pos;
+
+    if(u->keyframe) {
+        u->keyframe = 0;
+    } else if(u->repetir) {
+        u->repetir--;
+    } else if(u->paso < u->hueco) {
+        // Lecturas del hueco; el final ya esta en u->t, u->h
+        u->paso++;
+        *t = unpack_interp(u->ot, u->t, u->paso, u->hueco + 1);
+        *h = unpack_interp(u->oh, u->h, u->paso, u->hueco + 1);
+        return 1;
+    } else if(u->hueco) {
+        u->hueco = 0;  // El final del hueco
+        u->paso = 0;
+    } else {
+        if(u->pos >= PACK_NIBBLES) return 0;
+        pos = u->pos;
+        if(pack_nib(u->datos, pos) == PACK_CORRIDA) {
+            if(pos + 1 >= PACK_NIBBLES) return 0;
+            u->repetir = pack_nib(u->datos, pos + 1) + 1;
+            u->pos = pos + 2;
+        } else if(pack_nib(u->datos, pos) == PACK_HUECO) {
+            if(pos + 1 >= PACK_NIBBLES) return 0;
+            u->ot = u->t;
+            u->oh = u->h;
+            pos = unpack_valor(u, pos + 2);
+            if(!pos) return 0;  // Hueco sin su final: no se entrega nada
+            u->hueco = pack_nib(u->datos, u->pos + 1) + 1;
+            u->pos = pos;
+            u->paso = 1;
+            *t = unpack_interp(u->ot, u->t, 1, u->hueco + 1);
+            *h = unpack_interp(u->oh, u->h, 1, u->hueco + 1);
+            return 1;
+        } else {
+            pos = unpack_valor(u, pos);
+            if(!pos) return 0;
+            u->pos = pos;
+        }
+    }
+
+    *t = u->t;
+    *h = u->h;
+    return 1;
+}
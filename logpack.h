@@ -0,0 +1,82 @@
+/*
+ * File: logpack.h
+ * Codificacion compacta de lecturas (keyframe + deltas en nibbles)
+ *
+ * Un bloque empieza con una lectura completa (keyframe) que se guarda
+ * aparte; cada lectura siguiente se codifica respecto de la anterior en
+ * PACK_BYTES bytes de nibbles (el alto primero). Los deltas van en
+ * unidades de muestra_t (fixpt.h): grados con el DHT11, decimas con el
+ * DHT22.
+ *
+ *   0x0-0x8  dT, dH en {-1, 0, 1}: codigo = (dT + 1) * 3 + (dH + 1)
+ *   0x9 C    C + 2 repeticiones de la lectura anterior (el 9 siempre en
+ *            el nibble alto de un byte y C en el bajo)
+ *   0xA N    N + 1 lecturas no guardadas antes del codigo siguiente (un
+ *            valor): se reconstruyen sobre la recta entre la lectura
+ *            anterior y ese valor
+ *   0xB      (primer nibble) el keyframe es solo el origen de un hueco que
+ *            no entraba en el bloque anterior, no una lectura
+ *   0xD T H  dT, dH en -8..7 (nibbles con signo)
+ *   0xE TT HH valor absoluto (escape para saltos grandes; TTTT HHHH con
+ *            muestras de 2 bytes)
+ *   0xF      fin (un byte borrado 0xFF no contiene lecturas)
+ *
+ * El codificador solo escribe hacia adelante y reporta que bytes cambio,
+ * para grabar en la EEPROM solo esos. Grabados del ultimo al primero
+ * (eelog.c), ningun codigo se puede leer antes de que llegue el byte de
+ * su primer nibble: un codigo nuevo empieza en un nibble en 0xF, y los
+ * que se reescriben (el 4 que pasa a corrida, el contador) no salen de
+ * su byte. No depende del hardware: el mismo
+ * codigo compila en el host.
+ */
+#ifndef LOGPACK_H
+#define LOGPACK_H
+
+#include <stdint.h>
+#include "fixpt.h"
+
+#ifndef PACK_BYTES
+#define PACK_BYTES   (12 - 2 * MUESTRA_BYTES)  // Bloque de eelog.c sin la cabecera
+#endif
+#define PACK_NIBBLES (PACK_BYTES * 2)
+
+#define PACK_CORRIDA 0x9
+#define PACK_HUECO   0xA
+#define PACK_HUECO_MAX 16   // Lecturas interpoladas por codigo
+#define PACK_ORIGEN  0xB
+#define PACK_MEDIO   0xD
+#define PACK_ABS     0xE
+#define PACK_FIN     0xF
+
+#define PACK_ABS_NIB (2 * MUESTRA_BYTES)  // Nibbles de cada valor del escape
+
+typedef struct {
+    muestra_t t, h;      // Ultima lectura codificada
+    uint8_t pos;         // Proximo nibble libre
+    uint8_t corrida;     // Nibble contador de la corrida abierta (0xFF = ninguna)
+    uint8_t cero;        // Nibble del ultimo codigo "sin cambio" (0xFF = ninguno)
+    uint8_t mod_ini;     // Bytes modificados por el ultimo pack_add()
+    uint8_t mod_fin;
+} Pack;
+
+typedef struct {
+    const uint8_t *datos;
+    muestra_t t, h;
+    uint8_t pos;
+    uint8_t repetir;     // Repeticiones pendientes de una corrida
+    uint8_t keyframe;    // La primera lectura es el keyframe
+    muestra_t ot, oh;    // Origen del hueco abierto (t, h tienen el final)
+    uint8_t hueco;       // Lecturas del hueco abierto, 0 = ninguno
+    uint8_t paso;        // Lecturas del hueco ya entregadas
+} Unpack;
+
+void pack_init(Pack *p, uint8_t *datos, muestra_t t, muestra_t h);
+void pack_init_origen(Pack *p, uint8_t *datos, muestra_t t, muestra_t h);  // Keyframe sin lectura
+uint8_t pack_add(Pack *p, uint8_t *datos, muestra_t t, muestra_t h);  // 0 si no cabe
+uint8_t pack_add_hueco(Pack *p, uint8_t *datos, uint8_t hueco, muestra_t t, muestra_t h);
+uint8_t pack_resume(Pack *p, uint8_t *datos, muestra_t t, muestra_t h);  // Retorna lecturas
+
+void unpack_init(Unpack *u, const uint8_t *datos, muestra_t t, muestra_t h);
+uint8_t unpack_next(Unpack *u, muestra_t *t, muestra_t *h);  // 0 al terminar
+
+#endif /* LOGPACK_H */
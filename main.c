@@ -1,6 +1,6 @@
 /*
  * File: main.c
- * DHT11 con LCD I2C + EEPROM + LEDs indicadores
+ * DHT11 (o DHT22, ver sensor.h) con LCD I2C + EEPROM + LEDs indicadores
  * Microcontrolador: PIC16F887
  * Cristal: 20MHz (HS)
  * 
@@ -8,15 +8,33 @@
  * - DHT11: Temp 0-50°C (±2°C), Hum 20-80% (±5%)
  * - DHT11: Solo valores enteros (sin decimales)
  * - DHT11: Tiempo de respuesta más rápido
+ * - DHT22: Temp -40-80°C (±0.5°C), Hum 0-100% (±2%), en décimas
+ *
+ * El sensor se elige al compilar (-DSENSOR_DHT22); historial, estadísticas
+ * y pantalla trabajan con muestra_t, que conserva las décimas del DHT22.
  */
-#include <xc.h>
+#include "hal.h"
 #include <stdbool.h>
-#include <stdio.h>
 #include "i2c.h"
 #include "lcd_i2c.h"
-#include "dht11.h"
-// Para DHT11 usar: #include "dht11.h"  (en lugar de dht22.h)
+#include "sensor.h"
+#include "dht11m.h"
+#include "sched.h"
+#include "fixpt.h"
+#include "stats.h"
+#include "eeprom.h"
+#include "eelog.h"
+#include "muestreo.h"
+#include "holt.h"
+#include "rtc.h"
+#include "archivo.h"
+#include "uart.h"
+#include "crc8.h"
+#include "fmt.h"
+#include "prof.h"
+#include "filtro.h"
 
+#ifndef HAL_HOST
 #pragma config FOSC = HS
 #pragma config WDTE = OFF
 #pragma config PWRTE = ON
@@ -28,6 +46,7 @@
 #pragma config FCMEN = OFF
 #pragma config LVP = OFF
 #pragma config DEBUG = OFF
+#endif
 
 #define _XTAL_FREQ 20000000
 
@@ -39,188 +58,550 @@
 #define LED_HUMEDO   PORTDbits.RD4  // Hum > 70%
 #define LED_PRONOSTICO PORTDbits.RD5  // Parpadea según tendencia
 
-// ========== CONFIGURACIÓN EEPROM ==========
-#define MAX_LECTURAS 30  // Más espacio por ser datos enteros (2 bytes/lectura)
-#define EEPROM_BASE_ADDR 0x00
+// Variables globales
+uint16_t pasos_registro = 0;
+uint16_t marca_registro;  // Marca de la muestra en curso (rtc.h)
 
-// Estructura para guardar en EEPROM (2 bytes por lectura)
-typedef struct {
-    uint8_t temperatura;  // Temp entera (0-50°C)
-    uint8_t humedad;      // Hum entera (20-80%)
-} Lectura;
+// Planificación
+#define TAREA_SENSOR    0     // Índices en la tabla de tareas
+#define TAREA_DISPLAY   5
+#define TAREA_ARCHIVO   6
+#define PERIODO_SENSOR  MUESTREO_RAPIDO_MS  // El DHT22 pide al menos 2 s
+#define PASOS_REGISTRO  10    // Una muestra del historial cada 10 x 2 s
+#if PASOS_REGISTRO * 2 != RTC_MARCA_S
+#error "La marca del historial (RTC_MARCA_S) debe ser el paso del registro"
+#endif
+// Páginas del LCD: actual, pronóstico, estadísticas, contadores de
+// prof.h (con PROF) y zonas
+#define MODO_PROF       3
+#ifdef PROF
+#define MODO_ZONAS      4
+#else
+#define MODO_ZONAS      3
+#endif
+#if DHT_ZONAS > 1
+#define PLAZO_SENSOR    10    // La captura en paralelo es bloqueante (~5 ms)
+#define MODOS_DISPLAY   (MODO_ZONAS + (DHT_ZONAS + 3) / 4)  // Una página cada 4 zonas
+#else
+#define PLAZO_SENSOR    5
+#define MODOS_DISPLAY   MODO_ZONAS
+#endif
 
-// Variables globales
-char buffer_tem[16];
-char buffer_hum[16];
-uint8_t indice_lectura = 0;
-uint8_t total_lecturas = 0;
-uint16_t contador_muestras = 0;
+// Campos del LCD (fmt.h): "-40.0" con décimas, "-9".."999" sin ellas.
+// Con décimas la humedad va en 4 ("100.0" se ve " 100") para que la fila
+// entre en 16 columnas
+#if MUESTRA_ESCALA == 10
+#define ANCHO_T  5
+#define ANCHO_H  4
+#define SEP_TH   "C H:"
+#else
+#define ANCHO_T  3
+#define ANCHO_H  3
+#define SEP_TH   "C  H:"
+#endif
 
-// ========== FUNCIONES EEPROM ==========
-void EEPROM_Write(uint8_t addr, uint8_t data) {
-    while(WR);
-    EEADR = addr;
-    EEDAT = data;
-    EEPGD = 0;
-    WREN = 1;
-    
-    INTCONbits.GIE = 0;
-    EECON2 = 0x55;
-    EECON2 = 0xAA;
-    WR = 1;
-    INTCONbits.GIE = 1;
-    
-    while(WR);
-    WREN = 0;
+// Estado compartido entre tareas
+valor_t tem, hum;  // Q8.8 (float con USE_FLOAT)
+uint8_t lectura_ok = 0;
+uint8_t lectura_nueva = 0;  // Hubo una lectura válida desde la última muestra
+muestra_t registro_t, registro_h;  // Muestra del paso: la lectura que más se
+uint16_t registro_desvio;          // sale de la banda (muestreo_desvio())
+uint8_t intentos = 0;      // Lecturas fallidas seguidas (satura en 255)
+uint8_t analisis_pendiente = 0;
+valor_t tendencia = 0;
+muestra_t pronostico_t, pronostico_h;
+muestra_t temp_min, temp_max, hum_min, hum_max;
+uint8_t modo_display = 0;  // 0=Actual, 1=Pronóstico, 2=Estadísticas, 3=Perfil, 3/4..=Zonas
+#if DHT_ZONAS > 1
+// Con varias zonas tem/hum son el promedio de las que respondieron
+int8_t zona_tem[DHT_ZONAS], zona_hum[DHT_ZONAS];  // Enteros, para la página de zonas
+uint8_t zonas_ok = 0;  // Bit z: la zona z respondió en la última lectura
+#endif
+
+// ========== HISTORIAL ==========
+// Con el DS1307 solo entran a las estadísticas las lecturas de la última
+// ventana: tras un corte largo las viejas ya no dicen nada de la tendencia
+void historial_push(uint16_t marca, muestra_t t, muestra_t h) {
+    if(rtc_presente() && (uint16_t)(rtc_marca() - marca) > STATS_VENTANA) return;
+    stats_push(t, h);
+    holt_push(t, h);
 }
 
-uint8_t EEPROM_Read(uint8_t addr) {
-    EEADR = addr;
-    EEPGD = 0;
-    RD = 1;
-    return EEDAT;
+// Busca la cabeza del historial y reconstruye las estadísticas con las
+// lecturas más nuevas, de la más vieja a la más nueva (solo al arrancar)
+void cargar_historial(void) {
+    eelog_init();
+    stats_init();
+    holt_init();
+    eelog_replay(STATS_VENTANA, historial_push);
 }
 
-// Guardar lectura en EEPROM (solo 2 bytes por lectura)
-void guardar_lectura(uint8_t temp, uint8_t hum) {
-    uint8_t base_addr = EEPROM_BASE_ADDR + (indice_lectura * 2);
+// ========== TELEMETRÍA ==========
+// Registro por cada intento de lectura (uno por zona), en una trama COBS
+// por la UART: [seq][tick L][tick H][5 bytes del sensor][zona:4|estado:4]
+// [descartadas][crc8]. El bit 3 del estado marca el formato del DHT22;
+// con una sola zona y DHT11 el byte 8 es el estado.
+#define TELEM_LEN  11
+uint8_t telem_seq = 0;
+
+void enviar_telemetria(uint8_t zona, uint8_t estado) {
+    uint8_t r[TELEM_LEN];
+    uint16_t tick = sched_ticks();
     
-    EEPROM_Write(base_addr, temp);
-    EEPROM_Write(base_addr + 1, hum);
+    r[0] = telem_seq++;
+    r[1] = tick & 0xFF;
+    r[2] = tick >> 8;
+#if DHT_ZONAS > 1
+    dht11m_raw(zona, &r[3]);
+#else
+    sensor_raw(&r[3]);
+#endif
+    r[8] = (uint8_t)(zona << 4) | SENSOR_TELEM | estado;
+    r[9] = UART_Overflows();
+    r[10] = crc8(r, TELEM_LEN - 1);
+    UART_Frame(r, TELEM_LEN);  // Si no entra solo suma una descartada
+}
+
+// ========== CONTROL DE LEDs ==========
+void actualizar_leds(int16_t temp, int16_t hum, valor_t tendencia) {
+    // LEDs de temperatura actual
+    LED_FRIO = (temp < 20) ? 1 : 0;
+    LED_NORMAL = (temp >= 20 && temp <= 28) ? 1 : 0;
+    LED_CALOR = (temp > 28) ? 1 : 0;
     
-    indice_lectura++;
-    if(indice_lectura >= MAX_LECTURAS) {
-        indice_lectura = 0;
-    }
+    // LEDs de humedad
+    LED_SECO = (hum < 40) ? 1 : 0;
+    LED_HUMEDO = (hum > 70) ? 1 : 0;
     
-    if(total_lecturas < MAX_LECTURAS) {
-        total_lecturas++;
+    // LED de pronóstico (indica tendencia fuerte)
+    if(tendencia > VALOR_DE_ENTERO(2) || tendencia < -VALOR_DE_ENTERO(2)) {
+        LED_PRONOSTICO = 1;
+    } else {
+        LED_PRONOSTICO = 0;
     }
 }
 
-// Leer lectura de EEPROM
-Lectura leer_lectura(uint8_t index) {
-    Lectura lec;
-    uint8_t base_addr = EEPROM_BASE_ADDR + (index * 2);
-    
-    lec.temperatura = EEPROM_Read(base_addr);
-    lec.humedad = EEPROM_Read(base_addr + 1);
-    
-    return lec;
+// ========== INTERRUPCIONES ==========
+void __interrupt() isr(void)
+{
+    // Primero el sensor: el instante del flanco es el dato
+    if(INTCONbits.INTE && INTCONbits.INTF) {
+        sensor_isr();
+    }
+    if(SCHED_TICK_PENDIENTE()) {
+        sched_tick_isr();
+    }
+    // Desborde de Timer0 durante la captura: la corta si la trama no
+    // termina, para que PEIE vuelva aunque el sensor no responda
+    if(INTCONbits.T0IE && INTCONbits.T0IF) {
+        sensor_desborde();
+    }
+    // Captura del sensor en curso (PEIE apagado, ver dht11.c): el resto
+    // de los periféricos espera a que termine la trama
+    if(!INTCONbits.PEIE) {
+        return;
+    }
+    if(PIE1bits.SSPIE && PIR1bits.SSPIF) {
+        I2C_Isr();
+    }
+    if(PIE2bits.EEIE && PIR2bits.EEIF) {
+        EEPROM_Isr();
+    }
+    if(PIE1bits.TXIE && PIR1bits.TXIF) {
+        UART_Isr();
+    }
+#ifdef UART_RX
+    if(PIE1bits.RCIE && PIR1bits.RCIF) {
+        UART_Isr_Rx();
+    }
+#endif
 }
 
-// ========== FUNCIONES DE ANÁLISIS ==========
-float calcular_promedio_temp(uint8_t ultimas_n) {
-    if(total_lecturas == 0) return 0.0;
+// ========== LECTURAS ==========
+// Fallas seguidas antes de dar el sensor por perdido: hasta entonces el
+// LCD y los LEDs siguen con la última lectura buena. Tras una falla se
+// reintenta a SENSOR_RECUPERACION_MS, no al periodo completo
+#define SENSOR_REINTENTOS  3
+
+// Lectura válida: pasa por el filtro de picos antes de llegar al registro,
+// los LEDs y la tendencia
+void lectura_valida(q8_t h, q8_t t)
+{
+    uint16_t d;
     
-    uint16_t suma = 0;
-    uint8_t n = (ultimas_n < total_lecturas) ? ultimas_n : total_lecturas;
+    HAL_LECTURA();
+    if(!lectura_ok) sched_delay(TAREA_DISPLAY, 0);   // Sin esperar su periodo
+    filtro_paso(&h, &t);
+    tem = VALOR_DE_Q8(t);
+    hum = VALOR_DE_Q8(h);
     
-    for(uint8_t i = 0; i < n; i++) {
-        Lectura lec = leer_lectura(i);
-        suma += lec.temperatura;
+    // Todas las lecturas del paso compiten por la muestra del registro
+    d = muestreo_desvio(MUESTRA_DE_VALOR(tem), MUESTRA_DE_VALOR(hum));
+    if(!lectura_nueva || d >= registro_desvio) {
+        registro_t = MUESTRA_DE_VALOR(tem);
+        registro_h = MUESTRA_DE_VALOR(hum);
+        registro_desvio = d;
     }
-    
-    return (float)suma / n;
+    lectura_ok = 1;
+    lectura_nueva = 1;
+    intentos = 0;
 }
 
-float calcular_promedio_hum(uint8_t ultimas_n) {
-    if(total_lecturas == 0) return 0.0;
+void lectura_fallida(void)
+{
+    if(intentos < 255) intentos++;
+    if(intentos >= SENSOR_REINTENTOS) lectura_ok = 0;
+}
+
+// ========== TAREAS ==========
+#if DHT_ZONAS > 1
+// Todas las zonas a la vez: arranque (20 ms en bajo), captura en paralelo
+// (~5 ms) y después un registro de telemetría por zona cada 2 ms, para que
+// el anillo de la UART no se llene
+void tarea_sensor(void)
+{
+    static uint8_t fase = 0;
+    uint8_t z, res, n = 0;
+    int32_t suma_t = 0, suma_h = 0;
+    q8_t h, t;
     
-    uint16_t suma = 0;
-    uint8_t n = (ultimas_n < total_lecturas) ? ultimas_n : total_lecturas;
+    if(fase == 0) {
+        dht11m_start();
+        sched_delay(TAREA_SENSOR, SENSOR_ARRANQUE_MS);
+        fase = 1;
+        return;
+    }
     
-    for(uint8_t i = 0; i < n; i++) {
-        Lectura lec = leer_lectura(i);
-        suma += lec.humedad;
+    if(fase == 1) {
+        PROF_INICIO(PROF_DHT);
+        dht11m_capture();
+        zonas_ok = 0;
+        for(z = 0; z < DHT_ZONAS; z++) {
+            res = dht11m_finish_fixed(z, &h, &t);
+            PROF_SENSOR(res);
+            if(res != DHT11_OK) continue;
+            zonas_ok |= 1 << z;
+            zona_tem[z] = (int8_t)Q8_ENTERO(t);
+            zona_hum[z] = (int8_t)Q8_ENTERO(h);
+            suma_t += t;
+            suma_h += h;
+            n++;
+        }
+        if(n) {
+            lectura_valida((q8_t)(suma_h / n), (q8_t)(suma_t / n));
+        } else {
+            lectura_fallida();
+        }
+        PROF_FIN(PROF_DHT);
+    }
+    
+    enviar_telemetria(fase - 1, dht11m_estado(fase - 1));
+    if(fase < DHT_ZONAS) {
+        sched_delay(TAREA_SENSOR, 2);
+        fase++;
+    } else if(zonas_ok) {
+        sched_delay(TAREA_SENSOR, muestreo_periodo(tendencia) - SENSOR_ARRANQUE_MS - 5 - 2 * (DHT_ZONAS - 1));
+        fase = 0;
+    } else {
+        sched_delay(TAREA_SENSOR, SENSOR_RECUPERACION_MS);   // Ninguna respondió
+        fase = 0;
     }
+}
+#else
+// Adquisición en tres fases sin esperas activas:
+// arranque (SENSOR_ARRANQUE_MS en bajo), captura por interrupción (~5 ms),
+// decodificación. DHT11 requiere mínimo 1 segundo entre lecturas; el
+// periodo sube a 6 s con la temperatura quieta (muestreo_periodo()) y
+// baja a SENSOR_RECUPERACION_MS para reintentar tras una falla
+void tarea_sensor(void)
+{
+    static uint8_t fase = 0;
+    uint8_t res;
+    q8_t h, t;
     
-    return (float)suma / n;
+    switch(fase) {
+        case 0:
+            sensor_start();
+            sched_delay(TAREA_SENSOR, SENSOR_ARRANQUE_MS);
+            fase = 1;
+            break;
+            
+        case 1:
+            sensor_capture();
+            sched_delay(TAREA_SENSOR, 10);
+            fase = 2;
+            break;
+            
+        default:
+            PROF_INICIO(PROF_DHT);
+            res = sensor_finish(&h, &t);
+            PROF_FIN(PROF_DHT);
+            PROF_SENSOR(res);
+            enviar_telemetria(0, res);
+            if(res == DHT11_OK) {
+                lectura_valida(h, t);
+                sched_delay(TAREA_SENSOR, muestreo_periodo(tendencia) - SENSOR_ARRANQUE_MS - 10);
+            } else {
+                lectura_fallida();
+                sched_delay(TAREA_SENSOR, SENSOR_RECUPERACION_MS);
+            }
+            fase = 0;
+            break;
+    }
 }
+#endif
 
-// Calcular tendencia de temperatura
-float calcular_tendencia_temp() {
-    if(total_lecturas < 6) return 0.0;
+// Registro en EEPROM: una muestra cada 20 s, la lectura del paso que más
+// se sale de la banda de muestreo.c, o la última si ninguna se sale (ver
+// muestreo.h): leyendo cada 2 s un transitorio corto llega al registro.
+// Estadísticas y pronóstico reciben todas las muestras de 20 s; la EEPROM
+// solo los puntos que elige muestreo.c, el resto se reconstruye
+void tarea_registro(void)
+{
+    Punto p;
+    int16_t desvio;
+    
+    if(++pasos_registro < PASOS_REGISTRO) return;
+    pasos_registro = 0;
     
-    float promedio_reciente = calcular_promedio_temp(3);
+    // La marca avanza una por muestra y solo se corrige si el reloj se
+    // aparta más de una: el tick y el DS1307 no derivan igual
+    marca_registro++;
+    desvio = (int16_t)(rtc_marca() - marca_registro);
+    if(desvio > 1 || desvio < -1) marca_registro = rtc_marca();
     
-    // Calcular promedio de 3 lecturas anteriores
-    uint16_t suma_anterior = 0;
-    for(uint8_t i = 3; i < 6; i++) {
-        Lectura lec = leer_lectura(i);
-        suma_anterior += lec.temperatura;
+    if(!lectura_nueva) {
+        // Ninguna lectura válida en 20 s: muestra perdida, el tramo se
+        // cierra en la anterior y el historial abre otro bloque
+        if(muestreo_cortar(&p)) {
+            eelog_append_hueco(p.hueco, marca_registro - 1, p.t, p.h);
+        }
+        return;
     }
-    float promedio_anterior = (float)suma_anterior / 3.0;
+    lectura_nueva = 0;
     
-    return promedio_reciente - promedio_anterior;
+    if(muestreo_paso(registro_t, registro_h, &p)) {
+        eelog_append_hueco(p.hueco, marca_registro - muestreo_pendientes(), p.t, p.h);
+    }
+    stats_push(registro_t, registro_h);
+    holt_push(registro_t, registro_h);
+    analisis_pendiente = 1;
 }
 
-// Pronóstico simple
-uint8_t pronostico_temperatura() {
-    if(total_lecturas < 5) {
-        return (uint8_t)calcular_promedio_temp(total_lecturas);
-    }
-    return (uint8_t)calcular_promedio_temp(5);
+// Copia del historial a la 24LC256: cada 100 ms mira si hay una página
+// de bloques cerrados; mientras graba, sondea el ACK cada 1 ms
+void tarea_archivo(void)
+{
+    sched_delay(TAREA_ARCHIVO, archivo_tarea());
+}
+
+// Análisis tras cada guardado
+void tarea_analisis(void)
+{
+    if(!analisis_pendiente) return;
+    analisis_pendiente = 0;
+    PROF_INICIO(PROF_ANALISIS);
+    
+    // Todo sale de las sumas y deques de stats.c y del estado de holt.c:
+    // sin lecturas de EEPROM
+    tendencia = stats_tendencia();
+    pronostico_t = holt_pronostico(STATS_TEMP);
+    pronostico_h = holt_pronostico(STATS_HUM);
+    temp_min = stats_min(STATS_TEMP);
+    temp_max = stats_max(STATS_TEMP);
+    hum_min = stats_min(STATS_HUM);
+    hum_max = stats_max(STATS_HUM);
+    PROF_FIN(PROF_ANALISIS);
 }
 
-uint8_t pronostico_humedad() {
-    if(total_lecturas < 5) {
-        return (uint8_t)calcular_promedio_hum(total_lecturas);
+void tarea_leds(void)
+{
+    if(lectura_ok) {
+        actualizar_leds(VALOR_ENTERO(tem), VALOR_ENTERO(hum), tendencia);
+    } else if(intentos) {
+        PORTD = 0x00;  // Apagar LEDs
     }
-    return (uint8_t)calcular_promedio_hum(5);
 }
 
-// Calcular mínimo y máximo
-void calcular_min_max(uint8_t *temp_min, uint8_t *temp_max, 
-                      uint8_t *hum_min, uint8_t *hum_max) {
-    if(total_lecturas == 0) {
-        *temp_min = *temp_max = *hum_min = *hum_max = 0;
+// "T: 24C  H: 60%" (o "T: 23.5C H:65.2%") directo en el framebuffer
+void mostrar_lectura(char fila, muestra_t t, muestra_t h)
+{
+    char *p = fmt_txt(Lcd_Fb_At(1, fila), "T:");
+    
+    p = fmt_muestra(p, t, ANCHO_T);
+    p = fmt_txt(p, SEP_TH);
+    p = fmt_muestra(p, h, ANCHO_H);
+    *p = '%';
+}
+
+// Mínimo y máximo: "T: 18/ 26C"
+void mostrar_rango(char fila, char letra, muestra_t min, muestra_t max, char unidad)
+{
+    char *p = Lcd_Fb_At(1, fila);
+    
+    *p++ = letra;
+    *p++ = ':';
+    p = fmt_muestra(p, min, ANCHO_T);
+    *p++ = '/';
+    p = fmt_muestra(p, max, ANCHO_T);
+    *p = unidad;
+}
+
+#ifdef PROF
+// Contadores de prof.h, una región por refresco: "I2C n:   1234" y
+// "   812/  8123us" (mínimo y máximo); al final los eventos
+const char *const prof_nombres[PROF_REGIONES] = {
+    "DHT ", "I2C ", "EE  ", "EXT ", "LCD ", "ANA "
+};
+
+void mostrar_prof(uint8_t i)
+{
+    Prof_Region r;
+    char *p;
+    
+    if(i >= PROF_REGIONES) {
+        p = fmt_txt(Lcd_Fb_At(1, 1), "Chk");
+        p = fmt_natural(p, prof_eventos(PROF_EV_CHECKSUM), 5);
+        p = fmt_txt(p, " TO");
+        fmt_natural(p, prof_eventos(PROF_EV_TIMEOUT), 5);
+        p = fmt_txt(Lcd_Fb_At(1, 2), "Nak");
+        p = fmt_natural(p, prof_eventos(PROF_EV_NACK), 5);
+        p = fmt_txt(p, " Pi");
+        fmt_natural(p, prof_eventos(PROF_EV_PICO), 5);
         return;
     }
+    prof_leer(i, &r);
+    p = fmt_txt(Lcd_Fb_At(1, 1), prof_nombres[i]);
+    p = fmt_txt(p, "n:");
+    fmt_natural(p, r.n, 6);
+    p = fmt_natural(Lcd_Fb_At(1, 2), prof_us(r.min), 6);
+    *p++ = '/';
+    p = fmt_natural(p, prof_us(r.max), 6);
+    fmt_txt(p, "us");
+}
+#endif
+
+// Mostrar en LCD según modo (solo se envían las celdas que cambian)
+void tarea_display(void)
+{
+    static uint8_t ciclos = 0;
+    uint8_t vuelta = 4;
+    char flecha;
+    char *p;
+#if DHT_ZONAS > 1
+    uint8_t i, z;
+#endif
+    
+    if(!lectura_ok && intentos == 0) return;  // Aún sin lectura: splash
     
-    Lectura primera = leer_lectura(0);
-    *temp_min = *temp_max = primera.temperatura;
-    *hum_min = *hum_max = primera.humedad;
+    PROF_INICIO(PROF_LCD);
+    Lcd_Fb_Clear();
     
-    for(uint8_t i = 1; i < total_lecturas; i++) {
-        Lectura lec = leer_lectura(i);
+    if(!lectura_ok) {
+        // Error en la lectura
+        Lcd_Fb_Write_String(1, 1, " Error " SENSOR_NOMBRE);
         
-        if(lec.temperatura < *temp_min) *temp_min = lec.temperatura;
-        if(lec.temperatura > *temp_max) *temp_max = lec.temperatura;
-        if(lec.humedad < *hum_min) *hum_min = lec.humedad;
-        if(lec.humedad > *hum_max) *hum_max = lec.humedad;
+        if(intentos < SENSOR_REINTENTOS) {
+            Lcd_Fb_Write_String(1, 2, " Reintentando..");
+        } else {
+            Lcd_Fb_Write_String(1, 2, " Check conexion");
+        }
+        Lcd_Flush();
+        PROF_FIN(PROF_LCD);
+        return;
     }
-}
-
-// ========== CONTROL DE LEDs ==========
-void actualizar_leds(uint8_t temp, uint8_t hum, float tendencia) {
-    // LEDs de temperatura actual
-    LED_FRIO = (temp < 20) ? 1 : 0;
-    LED_NORMAL = (temp >= 20 && temp <= 28) ? 1 : 0;
-    LED_CALOR = (temp > 28) ? 1 : 0;
     
-    // LEDs de humedad
-    LED_SECO = (hum < 40) ? 1 : 0;
-    LED_HUMEDO = (hum > 70) ? 1 : 0;
+    switch(modo_display) {
+        case 0:  // Vista actual
+            mostrar_lectura(1, MUESTRA_DE_VALOR(tem), MUESTRA_DE_VALOR(hum));
+            
+            if(tendencia > VALOR_DE_ENTERO(1)) {
+                flecha = '^';  // Subiendo
+            } else if(tendencia < -VALOR_DE_ENTERO(1)) {
+                flecha = 'v';  // Bajando
+            } else {
+                flecha = '-';  // Estable
+            }
+            p = fmt_txt(Lcd_Fb_At(1, 2), "Mem:");
+            p = fmt_natural(p, eelog_total(), 4);
+            p = fmt_txt(p, " Tend:");
+            *p = flecha;
+            break;
+            
+        case 1:  // Vista pronóstico, con la hora si hay DS1307
+            if(rtc_presente()) {
+                p = fmt_txt(Lcd_Fb_At(1, 1), "PRONOSTICO ");
+                p = fmt_dos(p, rtc_hora());
+                *p++ = ':';
+                fmt_dos(p, rtc_minuto());
+            } else {
+                Lcd_Fb_Write_String(1, 1, "PRONOSTICO:");
+            }
+            
+            mostrar_lectura(2, pronostico_t, pronostico_h);
+            break;
+            
+        case 2:  // Vista estadísticas
+            mostrar_rango(1, 'T', temp_min, temp_max, 'C');
+            mostrar_rango(2, 'H', hum_min, hum_max, '%');
+            break;
+            
+#ifdef PROF
+        case MODO_PROF:  // Perfil: dura una vuelta por las regiones
+            mostrar_prof(ciclos);
+            vuelta = PROF_REGIONES + 1;
+            break;
+#endif
+            
+#if DHT_ZONAS > 1
+        default:  // Vista por zonas: "1 24/60 2 25/58", 4 por página
+            for(i = 0; i < 4; i++) {
+                z = (modo_display - MODO_ZONAS) * 4 + i;
+                if(z >= DHT_ZONAS) break;
+                p = Lcd_Fb_At(1 + (i & 1) * 8, 1 + (i >> 1));
+                *p++ = '1' + z;
+                if(zonas_ok & (1 << z)) {
+                    p = fmt_entero(p, zona_tem[z], 3);
+                    *p++ = '/';
+                    fmt_entero(p, zona_hum[z] > 99 ? 99 : zona_hum[z], 2);
+                } else {
+                    fmt_txt(p, " --/--");
+                }
+            }
+            break;
+#endif
+    }
+    Lcd_Flush();
+    PROF_FIN(PROF_LCD);
     
-    // LED de pronóstico (indica tendencia fuerte)
-    if(tendencia > 2.0 || tendencia < -2.0) {
-        LED_PRONOSTICO = 1;
-    } else {
-        LED_PRONOSTICO = 0;
+    // Rotar modo cada 4 ciclos
+    ciclos++;
+    if(ciclos >= vuelta) {
+        modo_display++;
+        if(modo_display >= MODOS_DISPLAY) modo_display = 0;
+        ciclos = 0;
     }
 }
 
+// Tabla de tareas: función, periodo (ms), plazo (ms), fase (ms)
+Tarea tareas[] = {
+    SCHED_TAREA(tarea_sensor,   PERIODO_SENSOR, PLAZO_SENSOR, SENSOR_ENCENDIDO_MS),
+    SCHED_TAREA(rtc_tarea,      1000,  10, 50),
+    SCHED_TAREA(tarea_registro, 2000, 100, 60),
+    SCHED_TAREA(tarea_analisis, 2000, 200, 70),
+    SCHED_TAREA(tarea_leds,      500,  10, 80),
+    SCHED_TAREA(tarea_display,  2000, 100, 90),
+    SCHED_TAREA(tarea_archivo,   100,  20, 95),
+#ifdef PROF
+    SCHED_TAREA(prof_tarea,       50,   0, 97),
+#endif
+};
+
 // ========== PROGRAMA PRINCIPAL ==========
 int main(void) 
 {
-    float tem, hum;  // Cambiar a float para compatibilidad con dht11_read
-    uint8_t intentos = 0;
-    float tendencia = 0.0;
-    uint8_t pronostico_t, pronostico_h;
-    uint8_t temp_min, temp_max, hum_min, hum_max;
-    uint8_t modo_display = 0;  // 0=Actual, 1=Pronóstico, 2=Estadísticas
-    
+    HAL_INIT();
+
     // Configurar puertos
     ANSEL = 0x00;
     ANSELH = 0x00;
@@ -229,122 +610,48 @@ int main(void)
     PORTD = 0x00;
     TRISD = 0x00;
     
-    // Puerto B para DHT11 (si es necesario configurar el pin)
-    // La librería dht11.h usa RA0, no necesitas configurar RB0
-    // TRISB = 0x01;  // Comentado porque el DHT11 está en RA0
+    // Puerto B para el sensor: dht11.c (también para el DHT22) usa RB0/INT
+    // y configura el pin en sensor_config(); con DHT_ZONAS > 1 los sensores van en
+    // RB0..RB(DHT_ZONAS-1) y los configura dht11m_config()
     
-    // Inicializar I2C y LCD
+    // Inicializar I2C y LCD (la cola I2C trabaja por interrupcion). Sin
+    // esperas fijas: el power-up timer (PWRTE) y Lcd_Init() cubren el
+    // encendido del LCD, y el busy flag el resto de sus instrucciones
     I2C_Init_Master(I2C_100KHZ);
-    __delay_ms(100);
-    
+    INTCONbits.GIE = 1;
     Lcd_Init();
-    __delay_ms(50);
     
-    dht11_config();
-    __delay_ms(100);
+    // Mensaje inicial: queda mientras el sensor se estabiliza y hasta la
+    // primera lectura (tarea_display() no lo pisa antes)
+    Lcd_Fb_Write_String(1, 1, "Sistema " SENSOR_NOMBRE);
+    Lcd_Fb_Write_String(1, 2, "Iniciando...");
+    Lcd_Flush();
     
+    // La primera lectura va SENSOR_ENCENDIDO_MS después del arranque del
+    // planificador (fase de tarea_sensor en la tabla)
+#if DHT_ZONAS > 1
+    dht11m_config();
+#else
+    sensor_config();
+#endif
     
-    // Mensaje inicial
-    Lcd_Set_Cursor(1,1);
-    Lcd_Write_String("Sistema DHT11");
-    Lcd_Set_Cursor(1,2);
-    Lcd_Write_String("Iniciando...");
-    __delay_ms(2000);
+    // Telemetría por la UART (115200 8N1, tramas COBS)
+    UART_Init();
     
-    while(1) {
-        if(dht11_read(&hum, &tem)) {
-            // Lectura exitosa
-            intentos = 0;
-            contador_muestras++;
-            
-            // Guardar cada 10 lecturas (~20 seg para pruebas)
-            // Para proyecto real: cambiar a 1800 (1 hora con DHT11)
-            if(contador_muestras >= 10) {
-                guardar_lectura((uint8_t)tem, (uint8_t)hum);
-                contador_muestras = 0;
-                
-                // Actualizar análisis
-                tendencia = calcular_tendencia_temp();
-                pronostico_t = pronostico_temperatura();
-                pronostico_h = pronostico_humedad();
-                calcular_min_max(&temp_min, &temp_max, &hum_min, &hum_max);
-            }
-            
-            // Actualizar LEDs
-            actualizar_leds((uint8_t)tem, (uint8_t)hum, tendencia);
-            
-            // Mostrar en LCD según modo
-            Lcd_Clear();
-            __delay_ms(2);
-            
-            switch(modo_display) {
-                case 0:  // Vista actual
-                    Lcd_Set_Cursor(1, 1);
-                    sprintf(buffer_tem, "T:%dC  H:%d%%", (int)tem, (int)hum);
-                    Lcd_Write_String(buffer_tem);
-                    
-                    Lcd_Set_Cursor(1, 2);
-                    sprintf(buffer_tem, "Mem:%d Tend:", total_lecturas);
-                    Lcd_Write_String(buffer_tem);
-                    if(tendencia > 1.0) {
-                        Lcd_Write_Char('^');  // Subiendo
-                    } else if(tendencia < -1.0) {
-                        Lcd_Write_Char('v');  // Bajando
-                    } else {
-                        Lcd_Write_Char('-');  // Estable
-                    }
-                    break;
-                    
-                case 1:  // Vista pronóstico
-                    Lcd_Set_Cursor(1, 1);
-                    Lcd_Write_String("PRONOSTICO:");
-                    
-                    Lcd_Set_Cursor(1, 2);
-                    sprintf(buffer_tem, "T:%dC  H:%d%%", pronostico_t, pronostico_h);
-                    Lcd_Write_String(buffer_tem);
-                    break;
-                    
-                case 2:  // Vista estadísticas
-                    Lcd_Set_Cursor(1, 1);
-                    sprintf(buffer_tem, "T:%d-%dC", temp_min, temp_max);
-                    Lcd_Write_String(buffer_tem);
-                    
-                    Lcd_Set_Cursor(1, 2);
-                    sprintf(buffer_tem, "H:%d-%d%%", hum_min, hum_max);
-                    Lcd_Write_String(buffer_tem);
-                    break;
-            }
-            
-            // Rotar modo cada 4 ciclos
-            static uint8_t ciclos = 0;
-            ciclos++;
-            if(ciclos >= 4) {
-                modo_display++;
-                if(modo_display > 2) modo_display = 0;
-                ciclos = 0;
-            }
-            
-        } else {
-            // Error en la lectura
-            intentos++;
-            
-            Lcd_Clear();
-            Lcd_Set_Cursor(1,1);
-            Lcd_Write_String(" Error DHT11");
-            Lcd_Set_Cursor(1,2);
-            
-            if(intentos < 3) {
-                Lcd_Write_String(" Reintentando..");
-            } else {
-                Lcd_Write_String(" Check conexion");
-            }
-            
-            PORTD = 0x00;  // Apagar LEDs
-        }
-        
-        // DHT11 requiere mínimo 1 segundo entre lecturas
-        __delay_ms(2000);
-    }
+    // Hora del DS1307 (si está) para las marcas del historial
+    rtc_init();
+    marca_registro = rtc_marca();  // La primera muestra llega un paso después
+    
+    // Estadísticas a partir del historial guardado
+    cargar_historial();
+    archivo_init();
+    muestreo_init(MUESTREO_BANDA_T, MUESTREO_BANDA_H);
+    filtro_init();
+    analisis_pendiente = (stats_total() > 0);
+    
+    // A partir de aquí todo corre en las tareas
+    sched_init(tareas, sizeof(tareas) / sizeof(tareas[0]));
+    sched_run();
     
     return 0;
-}
+}
\ No newline at end of file
@@ -0,0 +1,148 @@
+/*
+ * File: muestreo.c
+ * Muestreo adaptivo y registro por cambio (ver muestreo.h)
+ */
+#include "muestreo.h"
+
+#define MUESTREO_CANALES  2   // Temperatura y humedad
+
+static muestra_t muestreo_a[MUESTREO_CANALES];      // Ultimo punto guardado
+static int32_t muestreo_sup[MUESTREO_CANALES];      // Pendientes en Q8 por paso
+static int32_t muestreo_inf[MUESTREO_CANALES];
+static muestra_t muestreo_banda[MUESTREO_CANALES];
+static uint8_t muestreo_k = 0;      // Pasos desde A de la ultima muestra pendiente
+static uint8_t muestreo_hay_a = 0;
+
+// Pendientes de las rectas desde A que pasan a menos de la banda de v,
+// que esta n pasos despues
+static void muestreo_rango(uint8_t c, muestra_t v, uint8_t n, int32_t *sup, int32_t *inf)
+{
+    int32_t d = (int32_t)((int16_t)v - (int16_t)muestreo_a[c]) * 256;
+    int32_t b = (int32_t)muestreo_banda[c] * 256;
+
+    *sup = (d + b) / n;
+    *inf = (d - b) / n;
+}
+
+// Punto de la recta central, k pasos despues de A
+static muestra_t muestreo_recta(uint8_t c, uint8_t k)
+{
+    int32_t d = (muestreo_sup[c] + muestreo_inf[c]) / 2 * k;
+
+    return (muestra_t)(muestreo_a[c] + (int16_t)((d + 128) >> 8));
+}
+
+// Guarda el punto central a k pasos y lo toma como el nuevo A
+static void muestreo_cerrar(uint8_t k, Punto *guardar)
+{
+    muestreo_a[0] = guardar->t = muestreo_recta(0, k);
+    muestreo_a[1] = guardar->h = muestreo_recta(1, k);
+    guardar->hueco = k - 1;
+}
+
+void muestreo_init(muestra_t banda_t, muestra_t banda_h)
+{
+    muestreo_banda[0] = banda_t;
+    muestreo_banda[1] = banda_h;
+    muestreo_k = 0;
+    muestreo_hay_a = 0;
+}
+
+uint8_t muestreo_paso(muestra_t t, muestra_t h, Punto *guardar)
+{
+    muestra_t v[MUESTREO_CANALES];
+    int32_t sup[MUESTREO_CANALES], inf[MUESTREO_CANALES];
+    uint8_t c, n, cerrada = 0;
+
+    v[0] = t;
+    v[1] = h;
+
+    if(!muestreo_hay_a) {
+        // La primera muestra se guarda tal cual
+        muestreo_a[0] = guardar->t = t;
+        muestreo_a[1] = guardar->h = h;
+        guardar->hueco = 0;
+        muestreo_hay_a = 1;
+        muestreo_k = 0;
+        return 1;
+    }
+
+    n = muestreo_k + 1;
+    for(c = 0; c < MUESTREO_CANALES; c++) {
+        muestreo_rango(c, v[c], n, &sup[c], &inf[c]);
+        if(muestreo_k) {
+            if(sup[c] > muestreo_sup[c]) sup[c] = muestreo_sup[c];
+            if(inf[c] < muestreo_inf[c]) inf[c] = muestreo_inf[c];
+        }
+        if(inf[c] > sup[c]) cerrada = 1;
+    }
+
+    if(cerrada) {
+        // La puerta se cerro: se guarda la muestra anterior y la nueva
+        // queda como la primera pendiente desde ahi
+        muestreo_cerrar(muestreo_k, guardar);
+        for(c = 0; c < MUESTREO_CANALES; c++) {
+            muestreo_rango(c, v[c], 1, &muestreo_sup[c], &muestreo_inf[c]);
+        }
+        muestreo_k = 1;
+        return 1;
+    }
+
+    for(c = 0; c < MUESTREO_CANALES; c++) {
+        muestreo_sup[c] = sup[c];
+        muestreo_inf[c] = inf[c];
+    }
+    muestreo_k = n;
+    if(n >= MUESTREO_MAX_PASOS) {
+        muestreo_cerrar(n, guardar);  // Latido
+        muestreo_k = 0;
+        return 1;
+    }
+    return 0;
+}
+
+uint16_t muestreo_desvio(muestra_t t, muestra_t h)
+{
+    muestra_t v[MUESTREO_CANALES];
+    int32_t d;
+    uint16_t max = 0;
+    uint8_t c;
+
+    if(!muestreo_hay_a) return 0;
+    v[0] = t;
+    v[1] = h;
+    for(c = 0; c < MUESTREO_CANALES; c++) {
+        // Sin muestras pendientes no hay pendiente: la recta es plana en A
+        d = (int16_t)v[c] - (int16_t)(muestreo_k ? muestreo_recta(c, muestreo_k + 1) : muestreo_a[c]);
+        if(d < 0) d = -d;
+        if(d <= muestreo_banda[c]) continue;    // Dentro de la banda: ruido
+        d = (d - muestreo_banda[c]) * 256 / (muestreo_banda[c] + 1);
+        if(d > 0xFFFF) d = 0xFFFF;
+        if((uint16_t)d > max) max = (uint16_t)d;
+    }
+    return max;
+}
+
+uint8_t muestreo_pendientes(void)
+{
+    return muestreo_k;
+}
+
+uint8_t muestreo_cortar(Punto *guardar)
+{
+    uint8_t k = muestreo_k;
+
+    muestreo_hay_a = 0;
+    muestreo_k = 0;
+    if(!k) return 0;
+    muestreo_cerrar(k, guardar);
+    return 1;
+}
+
+uint16_t muestreo_periodo(valor_t tendencia)
+{
+    if(tendencia >= MUESTREO_TENDENCIA || tendencia <= -MUESTREO_TENDENCIA) {
+        return MUESTREO_RAPIDO_MS;
+    }
+    return MUESTREO_LENTO_MS;
+}
@@ -0,0 +1,75 @@
+/*
+ * File: muestreo.h
+ * Muestreo adaptivo y registro por cambio (puerta giratoria)
+ *
+ * El historial sigue siendo una serie cada 20 s, pero no se graba cada
+ * punto: muestreo_paso() recibe cada muestra y decide cuales guardar con
+ * la compresion de puerta giratoria (swinging door). Desde el ultimo punto
+ * guardado A se lleva, por canal, el rango de pendientes de las rectas
+ * que pasan a menos de la banda de todas las muestras pendientes. Mientras
+ * el rango no quede vacio no se graba nada; cuando se vacia se guarda el
+ * punto de la recta central en la ultima muestra que entraba y las
+ * pendientes se reinician desde ahi. Las muestras salteadas se guardan
+ * como un hueco (logpack.h) y se reconstruyen sobre la recta: el error de
+ * cada una queda dentro de la banda mas el redondeo (1 unidad).
+ *
+ * Con MUESTREO_MAX_PASOS muestras pendientes se guarda igual (latido): en
+ * una senal quieta hay un punto cada ~5 min en lugar de cada 20 s, y un
+ * corte pierde a lo sumo esos minutos.
+ *
+ * muestreo_periodo() da el periodo de lectura del sensor segun la
+ * tendencia: rapido con un cambio fuerte, lento con la senal quieta (antes
+ * era siempre el rapido). muestreo_paso() sigue recibiendo una muestra cada
+ * 20 s, pero cada lectura valida pasa antes por muestreo_desvio(), y la
+ * muestra del paso es la que mas se sale de la banda alrededor de la recta
+ * (sin ninguna afuera, o a igual distancia, la ultima). Con la senal quieta
+ * es la ultima lectura, como antes: el ruido dentro de la banda no elige.
+ * Con la senal moviendose hay 10 lecturas por paso en lugar de 3, y un
+ * transitorio entre dos pasos llega al registro en lugar de perderse.
+ */
+#ifndef MUESTREO_H
+#define MUESTREO_H
+
+#include <stdint.h>
+#include "fixpt.h"
+
+// Bandas por defecto en unidades de muestra_t (la mitad del error del sensor)
+#ifndef MUESTREO_BANDA_T
+#if MUESTRA_ESCALA == 10
+#define MUESTREO_BANDA_T   3    // 0.3 C
+#define MUESTREO_BANDA_H   10   // 1 %
+#else
+#define MUESTREO_BANDA_T   1
+#define MUESTREO_BANDA_H   1
+#endif
+#endif
+
+#ifndef MUESTREO_MAX_PASOS
+#define MUESTREO_MAX_PASOS  15   // Latido: 15 x 20 s = 5 min
+#endif
+#if MUESTREO_MAX_PASOS < 1 || MUESTREO_MAX_PASOS > 17
+#error "MUESTREO_MAX_PASOS debe estar entre 1 y 17 (hueco de logpack)"
+#endif
+
+#define MUESTREO_RAPIDO_MS  2000   // Lectura del sensor con cambio fuerte
+#define MUESTREO_LENTO_MS   6000   // y con la senal quieta
+#define MUESTREO_TENDENCIA  VALOR_DE_ENTERO(1)  // |stats_tendencia()| fuerte
+
+// Punto a guardar con eelog_append_hueco()
+typedef struct {
+    muestra_t t, h;
+    uint8_t hueco;   // Muestras no guardadas antes de (t, h)
+} Punto;
+
+void muestreo_init(muestra_t banda_t, muestra_t banda_h);
+uint8_t muestreo_paso(muestra_t t, muestra_t h, Punto *guardar);  // 1 si hay que guardar
+uint8_t muestreo_pendientes(void);  // Muestras recibidas aun no guardadas
+// Cuanto se sale una lectura de la banda alrededor de la recta en la
+// muestra siguiente, en bandas Q8 (0 = adentro), el mayor de los canales
+uint16_t muestreo_desvio(muestra_t t, muestra_t h);
+// Corta el tramo en la ultima muestra recibida (una muestra perdida): 1 si
+// queda un punto por guardar; la muestra siguiente se guarda tal cual
+uint8_t muestreo_cortar(Punto *guardar);
+uint16_t muestreo_periodo(valor_t tendencia);
+
+#endif /* MUESTREO_H */
@@ -0,0 +1,110 @@
+"""
+Contadores de perfil de la placa (prof.h)
+==========================================
+Pide por el puerto serie el volcado de los contadores de un firmware
+compilado con PROF y muestra la tabla: por región, cuántas veces pasó y
+su duración mínima, media y máxima, y los eventos (checksum, timeout,
+NACK, picos del filtro). Las tramas de perfil vienen mezcladas con las
+de telemetría (COBS de uart.c, decodificadas con telemetria.py); se
+separan por el largo y el primer byte.
+
+Uso:
+    python perfil.py /dev/ttyUSB0            # pide el volcado y muestra la tabla
+    python perfil.py /dev/ttyUSB0 --borrar   # y después pone los contadores en cero
+
+Con el simulador: make -B host PROF=1 && SIM_UART=pty SIM_HORAS=1000
+./build/host/termo, y perfil.py con la pseudo-terminal que imprime.
+"""
+
+import os
+import sys
+import time
+import select
+import termios
+import argparse
+
+from telemetria import cobs_decodificar, crc8
+
+REGIONES = ['DHT', 'I2C', 'EEPROM', 'EEXT', 'LCD', 'ANALISIS']   # prof.h
+EVENTOS = ['checksum', 'timeout', 'nack', 'picos']
+
+TRAMA = ord('P')
+PEDIDO = b'P'
+BORRAR = b'R'
+REG_LEN = 13
+EV_LEN = 6 + 2 * len(EVENTOS)
+
+
+def _u16(r, i):
+    return r[i] | r[i + 1] << 8
+
+
+def abrir(ruta):
+    """Puerto serie (o pty del simulador) crudo a 115200 8N1"""
+    fd = os.open(ruta, os.O_RDWR | os.O_NOCTTY)
+    if os.isatty(fd):
+        a = termios.tcgetattr(fd)
+        a[0] = a[1] = a[3] = 0                                     # iflag, oflag, lflag
+        a[2] = termios.CS8 | termios.CREAD | termios.CLOCAL        # cflag
+        a[4] = a[5] = termios.B115200
+        termios.tcsetattr(fd, termios.TCSANOW, a)
+        termios.tcflush(fd, termios.TCIFLUSH)
+    return fd
+
+
+def volcado(fd, espera_s=3.0):
+    """
+    Manda el pedido y junta las tramas de perfil hasta la de eventos.
+    Devuelve ({región: (n, min, max, total)}, {evento: n}, dus)
+    """
+    os.write(fd, PEDIDO)
+    regiones, eventos, dus = {}, None, None
+    resto = b''
+    limite = time.monotonic() + espera_s
+    while eventos is None and time.monotonic() < limite:
+        listo, _, _ = select.select([fd], [], [], 0.1)
+        if not listo:
+            continue
+        *tramas, resto = (resto + os.read(fd, 256)).split(b'\x00')
+        for t in tramas:
+            r = cobs_decodificar(t)
+            if r is None or len(r) not in (REG_LEN, EV_LEN) or r[0] != TRAMA or crc8(r[:-1]) != r[-1]:
+                continue
+            if len(r) == REG_LEN and r[1] < len(REGIONES):
+                total = r[8] | r[9] << 8 | r[10] << 16 | r[11] << 24
+                regiones[REGIONES[r[1]]] = (_u16(r, 2), _u16(r, 4), _u16(r, 6), total)
+            elif len(r) == EV_LEN and r[1] == 0xFF:
+                dus = _u16(r, 3)
+                eventos = {e: _u16(r, 5 + 2 * i) for i, e in enumerate(EVENTOS)}
+    if eventos is None:
+        sys.exit("sin respuesta (¿firmware sin PROF?)")
+    return regiones, eventos, dus
+
+
+def main(argv=None):
+    ap = argparse.ArgumentParser(description='Contadores de perfil de la placa (prof.h)')
+    ap.add_argument('puerto')
+    ap.add_argument('--borrar', action='store_true', help='Pone los contadores en cero después')
+    a = ap.parse_args(argv)
+
+    fd = abrir(a.puerto)
+    regiones, eventos, dus = volcado(fd)
+    us = dus / 10   # Microsegundos por cuenta
+
+    print(f"{'región':<10} {'n':>6} {'mín us':>9} {'media us':>9} {'máx us':>9} {'total ms':>10}")
+    for nombre in REGIONES:
+        n, mn, mx, total = regiones.get(nombre, (0, 0, 0, 0))
+        media = total / n * us if n else 0
+        print(f"{nombre:<10} {n:>6} {mn * us:>9.0f} {media:>9.0f} {mx * us:>9.0f} "
+              f"{total * us / 1000:>10.1f}")
+    print()
+    print('  '.join(f'{e} {n}' for e, n in eventos.items()))
+
+    if a.borrar:
+        os.write(fd, BORRAR)
+    os.close(fd)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,174 @@
+/*
+ * File: prof.c
+ * Contadores de perfil en la placa (ver prof.h)
+ */
+#include "prof.h"
+
+#ifdef PROF
+
+#include "hal.h"
+#include "sched.h"
+#include "dht11.h"   // DHT11_ERR_*, tambien del DHT22
+#include "uart.h"
+#include "crc8.h"
+
+#define PROF_REG_LEN  13
+#define PROF_EV_LEN   (6 + 2 * PROF_EVENTOS)
+#define PROF_TRAMA_MAX  (PROF_EV_LEN > PROF_REG_LEN ? PROF_EV_LEN : PROF_REG_LEN)
+
+#if PROF_EV_LEN == 11 || PROF_EV_LEN == PROF_REG_LEN
+#error "La trama de eventos no debe confundirse con la telemetria ni con las regiones"
+#endif
+// Las duraciones salen de Timer1 libre a 1.6 us; con SCHED_T1OSC Timer1 es
+// el tick de 32 kHz y sched_ciclos() avanza de a 7-8 ms
+#ifdef SCHED_T1OSC
+#error "PROF necesita Timer1 libre: no se puede compilar con SCHED_T1OSC"
+#endif
+#define PROF_INACTIVO 0xFF
+
+static Prof_Region prof_tabla[PROF_REGIONES];
+static uint16_t prof_t0[PROF_REGIONES];
+static uint8_t prof_armado[PROF_REGIONES];     // Hubo prof_inicio() valido
+static uint16_t prof_ev[PROF_EVENTOS];
+static uint8_t prof_volcado = PROF_INACTIVO;   // Proxima trama del volcado
+
+// Timer1 arranca en sched_init(): lo que
+// empieza antes, al arrancar el programa, no se mide
+void prof_inicio(uint8_t r)
+{
+    prof_armado[r] = T1CONbits.TMR1ON;
+    prof_t0[r] = sched_ciclos();
+}
+
+// PROF_I2C y PROF_EEPROM empiezan en el programa (o en la ISR, con la
+// siguiente de la cola) y terminan en la ISR. No se pisan: la cola atiende
+// una transaccion o un byte a la vez, y prof_inicio() se llama antes de que
+// pueda llegar la interrupcion que cierra la region (con SSPIE apagado en
+// i2c_kick(), con GIE apagado en EEPROM_Write()), asi que prof_t0[r] y
+// prof_armado[r] ya estan escritos cuando la ISR los lee
+void prof_fin(uint8_t r)
+{
+    Prof_Region *p = &prof_tabla[r];
+    uint16_t dur = sched_ciclos() - prof_t0[r];
+
+    if(!prof_armado[r]) return;
+    prof_armado[r] = 0;
+
+    if(p->n == 0xFFFF) {
+        p->n >>= 1;
+        p->total >>= 1;
+    }
+    if(p->n == 0 || dur < p->min) p->min = dur;
+    if(dur > p->max) p->max = dur;
+    p->n++;
+    p->total += dur;
+}
+
+void prof_evento(uint8_t e)
+{
+    if(prof_ev[e] < 0xFFFF) prof_ev[e]++;
+}
+
+void prof_sensor(uint8_t res)
+{
+    if(res == DHT11_ERR_CHECKSUM) {
+        prof_evento(PROF_EV_CHECKSUM);
+    } else if(res == DHT11_ERR_RESPUESTA || res == DHT11_ERR_TIMEOUT) {
+        prof_evento(PROF_EV_TIMEOUT);
+    }
+}
+
+void prof_leer(uint8_t r, Prof_Region *copia)
+{
+    uint8_t gie = INTCONbits.GIE;
+
+    INTCONbits.GIE = 0;
+    *copia = prof_tabla[r];
+    INTCONbits.GIE = gie;
+}
+
+uint16_t prof_eventos(uint8_t e)
+{
+    return prof_ev[e];
+}
+
+uint16_t prof_us(uint16_t cuentas)
+{
+    uint32_t us;
+
+    us = ((uint32_t)cuentas * 26214) >> 14;   // x 1.6 sin division
+    return us > 0xFFFF ? 0xFFFF : (uint16_t)us;
+}
+
+void prof_borrar(void)
+{
+    uint8_t gie = INTCONbits.GIE;
+    uint8_t *p = (uint8_t *)prof_tabla;
+
+    INTCONbits.GIE = 0;
+    for(uint8_t i = 0; i < sizeof(prof_tabla); i++) p[i] = 0;
+    INTCONbits.GIE = gie;
+    for(uint8_t i = 0; i < PROF_EVENTOS; i++) prof_ev[i] = 0;
+}
+
+// Trama i del volcado en r; retorna el largo
+static uint8_t prof_trama(uint8_t i, uint8_t *r)
+{
+    Prof_Region c;
+    uint8_t n;
+
+    r[0] = PROF_TRAMA;
+    if(i < PROF_REGIONES) {
+        prof_leer(i, &c);
+        r[1] = i;
+        r[2] = c.n & 0xFF;
+        r[3] = c.n >> 8;
+        r[4] = c.min & 0xFF;
+        r[5] = c.min >> 8;
+        r[6] = c.max & 0xFF;
+        r[7] = c.max >> 8;
+        r[8] = c.total & 0xFF;
+        r[9] = (c.total >> 8) & 0xFF;
+        r[10] = (c.total >> 16) & 0xFF;
+        r[11] = c.total >> 24;
+        n = PROF_REG_LEN;
+    } else {
+        r[1] = 0xFF;
+        r[2] = PROF_REGIONES;
+        r[3] = SCHED_WCET_DUS & 0xFF;
+        r[4] = SCHED_WCET_DUS >> 8;
+        for(uint8_t e = 0; e < PROF_EVENTOS; e++) {
+            r[5 + 2 * e] = prof_ev[e] & 0xFF;
+            r[6 + 2 * e] = prof_ev[e] >> 8;
+        }
+        n = PROF_EV_LEN;
+    }
+    r[n - 1] = crc8(r, n - 1);
+    return n;
+}
+
+// Una trama por llamada, para no llenar el anillo de la UART con la
+// telemetria; si no entra se repite en la siguiente
+void prof_tarea(void)
+{
+    uint8_t r[PROF_TRAMA_MAX];
+    uint8_t n;
+
+    switch(UART_Recibido()) {
+        case PROF_PEDIDO:
+            prof_volcado = 0;
+            break;
+        case PROF_BORRAR:
+            prof_borrar();
+            break;
+    }
+    if(prof_volcado == PROF_INACTIVO) return;
+
+    n = prof_trama(prof_volcado, r);
+    if(!UART_Cabe(n)) return;   // Sin contarla como descartada
+    UART_Frame(r, n);
+    prof_volcado++;
+    if(prof_volcado > PROF_REGIONES) prof_volcado = PROF_INACTIVO;
+}
+
+#endif
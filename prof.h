@@ -0,0 +1,100 @@
+/*
+ * File: prof.h
+ * Contadores de perfil en la placa (compilar con -DPROF)
+ *
+ * Cada region medida guarda cuantas veces paso, el minimo, el maximo y el
+ * total de su duracion, tomada con la misma marca de Timer1 que el WCET
+ * del planificador (sched_ciclos(): 1.6 us por cuenta). Con SCHED_T1OSC
+ * Timer1 es el tick de 32 kHz y no queda marca fina: PROF no compila con
+ * SCHED_T1OSC. Una medida vale hasta 65535 cuentas (~104 ms). Al llegar
+ * la cuenta a 65535 se dividen por 2 la cuenta y el total: el promedio se
+ * conserva y el total no desborda.
+ *
+ *   PROF_DHT       decodificacion de la trama (captura y decodificacion
+ *                  con varias zonas)
+ *   PROF_I2C       cada transaccion, del START al STOP (cola o bloqueante)
+ *   PROF_EEPROM    cada byte de la EEPROM interna, hasta EEIF
+ *   PROF_EEXT      cada pagina de la 24LC256, hasta el ACK del sondeo
+ *   PROF_LCD       tarea_display()
+ *   PROF_ANALISIS  tarea_analisis()
+ *
+ * y se cuentan los eventos: checksum del sensor incorrecto, sensor sin
+ * respuesta o trama incompleta, NACK de I2C (I2C_Write() y la cola, sin
+ * los sondeos de la 24LC256, que esperan NACK mientras graba) y picos
+ * reemplazados por filtro.c.
+ *
+ * En el host el tiempo solo corre en las esperas (hal.h): las regiones
+ * de pura CPU dan 0 y las de bus y EEPROM dan los tiempos del simulador.
+ *
+ * Volcado: un byte PROF_PEDIDO por la UART (RC7/RX) hace que prof_tarea()
+ * mande la tabla en tramas COBS como las de la telemetria, una por
+ * region:
+ *
+ *   ['P'][region][n L][n H][min L][min H][max L][max H][total 0..3][crc8]
+ *
+ * y una de eventos con las unidades:
+ *
+ *   ['P'][0xFF][regiones][dus L][dus H][checksum L H][timeout L H][nack L H]
+ *   [picos L H][crc8]
+ *
+ * (13 y 14 bytes: distintas de las 11 de la telemetria, que ingesta.c y
+ * termo.py saltean por el largo). PROF_BORRAR pone todo en cero. Sin PROF
+ * las macros no generan codigo y prof.c queda vacio.
+ * RAM: 13 bytes por region mas 9.
+ */
+#ifndef PROF_H
+#define PROF_H
+
+#include <stdint.h>
+
+#define PROF_DHT       0
+#define PROF_I2C       1
+#define PROF_EEPROM    2
+#define PROF_EEXT      3
+#define PROF_LCD       4
+#define PROF_ANALISIS  5
+#define PROF_REGIONES  6
+
+#define PROF_EV_CHECKSUM  0
+#define PROF_EV_TIMEOUT   1
+#define PROF_EV_NACK      2
+#define PROF_EV_PICO      3
+#define PROF_EVENTOS      4
+
+#define PROF_TRAMA     'P'
+#define PROF_PEDIDO    'P'   // Bytes recibidos por la UART
+#define PROF_BORRAR    'R'
+
+typedef struct {
+    uint16_t n;
+    uint16_t min, max;    // Cuentas de sched_ciclos()
+    uint32_t total;
+} Prof_Region;
+
+#ifdef PROF
+
+void prof_inicio(uint8_t r);
+void prof_fin(uint8_t r);
+void prof_evento(uint8_t e);
+void prof_sensor(uint8_t res);    // Cuenta los errores DHT11_ERR_*
+void prof_leer(uint8_t r, Prof_Region *copia);  // Sin cortes de la ISR
+uint16_t prof_eventos(uint8_t e);
+uint16_t prof_us(uint16_t cuentas);   // Satura en 65535
+void prof_borrar(void);
+void prof_tarea(void);            // Pedidos por la UART y volcado
+
+#define PROF_INICIO(r)   prof_inicio(r)
+#define PROF_FIN(r)      prof_fin(r)
+#define PROF_EVENTO(e)   prof_evento(e)
+#define PROF_SENSOR(res) prof_sensor(res)
+
+#else
+
+#define PROF_INICIO(r)   ((void)0)
+#define PROF_FIN(r)      ((void)0)
+#define PROF_EVENTO(e)   ((void)0)
+#define PROF_SENSOR(res) ((void)0)
+
+#endif
+
+#endif /* PROF_H */
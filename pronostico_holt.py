@@ -0,0 +1,259 @@
+"""
+Pronóstico de Holt en enteros, igual que holt.c
+================================================
+Referencia en Python del pronóstico del firmware (holt.h): suavizado
+exponencial doble (nivel + tendencia) con alfa = 2^-ALFA_SH y
+beta = 2^-BETA_SH, nivel y tendencia en enteros con FRAC bits
+fraccionarios y los mismos redondeos. Con la misma serie de muestras da
+exactamente los mismos números que la placa; termo.py lo usa para que el
+informe y el LCD coincidan.
+
+El banco (--banco) compara holt.c (build/host/banco_holt) con esta
+implementación, muestra por muestra, y mide el error absoluto medio (MAE)
+del pronóstico a PASOS muestras contra el valor real, junto con el
+promedio de las últimas 5 muestras (el pronóstico anterior del firmware),
+la última muestra, y SimpleExpSmoothing y Holt de statsmodels ajustados
+sobre la serie entera. Las series son sintéticas (ciclo diario, saltos y
+ruido, cuantizadas como el sensor) y las trazas de telemetría que se
+pasen (tramas COBS de uart.c: un puerto serie grabado o SIM_UART del
+simulador), llevadas a una muestra cada 20 s como en el PIC.
+
+Uso:
+    make banco_holt && python pronostico_holt.py --banco [traza.bin ...] [-z zona]
+    make -B banco_holt SENSOR=dht22 && python pronostico_holt.py --banco ...
+"""
+
+import os
+import sys
+import math
+import random
+import argparse
+import subprocess
+
+from telemetria import leer_tramas
+
+# Los de holt.h por defecto
+ALFA_SH = 2
+BETA_SH = 8
+PASOS = 6
+FRAC = 16
+
+PASO_MS = 20000   # Una muestra de las estadísticas cada 20 s
+BANCO = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'build', 'host', 'banco_holt')
+
+
+def _desplazar(x, sh):
+    """x / 2^sh redondeado al más cercano, como holt_div() en holt.c"""
+    return (x + (1 << (sh - 1))) >> sh
+
+
+def holt_entero(serie, pasos=PASOS, alfa_sh=ALFA_SH, beta_sh=BETA_SH, frac=FRAC, muestra_bytes=1):
+    """
+    Pronóstico a `pasos` muestras después de cada muestra de `serie`
+    (enteros en unidades de muestra_t), como holt_push() seguido de
+    holt_pronostico(). Devuelve una lista del mismo largo.
+    """
+    pronosticos = []
+    nivel = tendencia = None
+    for v in serie:
+        y = int(v) << frac
+        if nivel is None:
+            nivel, tendencia = y, 0
+        else:
+            p = nivel + tendencia
+            y = p + _desplazar(y - p, alfa_sh)
+            tendencia += _desplazar(y - nivel - tendencia, beta_sh)
+            nivel = y
+        f = _desplazar(nivel + pasos * tendencia, frac)
+        if muestra_bytes == 1:
+            f = min(max(f, 0), 255)
+        pronosticos.append(f)
+    return pronosticos
+
+
+def pronostico_holt(datos, pasos=PASOS, *, escala):
+    """
+    Para termo.py: los valores de 1 a `pasos` muestras después de la
+    última de `datos` (en grados o %), con la cuenta de holt.c sobre los
+    datos llevados a 1/escala: la del sensor de donde salieron (1 con el
+    DHT11, 10 con el DHT22), sin valor por defecto. `datos` tiene que
+    venir al paso de las estadísticas del PIC (PASO_MS).
+    """
+    nivel = tendencia = None
+    for x in datos:
+        y = int(round(x * escala)) << FRAC
+        if nivel is None:
+            nivel, tendencia = y, 0
+        else:
+            p = nivel + tendencia
+            y = p + _desplazar(y - p, ALFA_SH)
+            tendencia += _desplazar(y - nivel - tendencia, BETA_SH)
+            nivel = y
+    if nivel is None:
+        return []
+    pron = [_desplazar(nivel + k * tendencia, FRAC) for k in range(1, pasos + 1)]
+    if escala == 1:
+        pron = [min(max(f, 0), 255) for f in pron]   # muestra_t de un byte
+    return [f / escala for f in pron]
+
+
+# ============================================================================
+# SERIES DEL BANCO
+# ============================================================================
+
+def serie_sintetica(dias, escala, semilla=1):
+    """
+    Una muestra cada 20 s: ciclo diario, deriva lenta, saltos que decaen
+    (una puerta abierta) y ruido, cuantizada a 1/escala como el sensor
+    """
+    rng = random.Random(semilla)
+    n = int(dias * 86400 * 1000 / PASO_MS)
+    t, h = [], []
+    deriva = salto = 0.0
+    for i in range(n):
+        fase = 2 * math.pi * i / (86400 * 1000 / PASO_MS)
+        deriva += rng.gauss(0, 0.01)
+        salto *= 0.97
+        if rng.random() < 6 / (86400 * 1000 / PASO_MS):
+            salto += rng.choice((-1, 1)) * rng.uniform(2, 5)
+        temp = 24 + 4 * math.sin(fase) + deriva + salto + rng.gauss(0, 0.15)
+        hum = 60 - 10 * math.sin(fase) - 2 * deriva - 3 * salto + rng.gauss(0, 0.5)
+        t.append(int(round(temp * escala)))
+        h.append(int(round(hum * escala)))
+    return t, h
+
+
+def serie_traza(ruta, zona, escala):
+    """
+    Lecturas válidas de una zona de la traza, una muestra cada PASO_MS: la
+    última lectura válida. tarea_registro() toma la que más se sale de la
+    banda de muestreo.c, que con la señal quieta es la misma
+    """
+    t, h = [], []
+    ms, proximo, tick_prev, hay = 0, PASO_MS, None, False
+    with open(ruta, 'rb') as f:
+        for r in leer_tramas(f):
+            if r['zona'] != zona:
+                continue
+            if tick_prev is not None:
+                ms += (r['tick'] - tick_prev) & 0xFFFF
+            tick_prev = r['tick']
+            while ms >= proximo:
+                if hay:
+                    t.append(vt)
+                    h.append(vh)
+                proximo += PASO_MS
+            if r['estado']:
+                continue
+            d = r['dht']
+            if r['dht22'] != (escala == 10):
+                sys.exit(f"{ruta}: la traza es de otro sensor (make -B banco_holt SENSOR=...)")
+            if escala == 10:
+                vt = (d[2] & 0x7F) << 8 | d[3]
+                vt = -vt if d[2] & 0x80 else vt
+                vh = d[0] << 8 | d[1]
+            else:
+                vt = d[2] + (d[3] >= 5)
+                vh = d[0] + (d[1] >= 5)
+            hay = True
+    return t, h
+
+
+# ============================================================================
+# BANCO
+# ============================================================================
+
+def _firmware(t, h):
+    """Corre build/host/banco_holt; devuelve (parámetros, pronósticos T, H)"""
+    entrada = ''.join(f'{a} {b}\n' for a, b in zip(t, h))
+    salida = subprocess.run([BANCO], input=entrada, capture_output=True, text=True,
+                            check=True).stdout.splitlines()
+    campos = salida[0].split()[1:]
+    param = {campos[i]: int(campos[i + 1]) for i in range(0, len(campos), 2)}
+    filas = [tuple(map(int, l.split())) for l in salida[1:]]
+    return param, [f[0] for f in filas], [f[1] for f in filas]
+
+
+def _mae(pron, serie, pasos):
+    """Error del pronóstico hecho en i contra la muestra i + pasos"""
+    n = len(serie) - pasos
+    return sum(abs(pron[i] - serie[i + pasos]) for i in range(n)) / n if n > 0 else float('nan')
+
+
+def _statsmodels(serie, pasos):
+    """Pronósticos de SES y Holt de statsmodels; None sin statsmodels"""
+    try:
+        import numpy as np
+        from statsmodels.tsa.holtwinters import SimpleExpSmoothing, Holt
+    except ImportError:
+        return None
+    y = np.asarray(serie, dtype=float)
+    ses = SimpleExpSmoothing(y, initialization_method='estimated').fit()
+    holt = Holt(y, initialization_method='estimated').fit()
+    # level[i] y trend[i] son los del final de la muestra i
+    return list(ses.level), list(np.asarray(holt.level) + pasos * np.asarray(holt.trend))
+
+
+def banco(series, param):
+    pasos, escala = param['pasos'], param['escala']
+    distintos = total = 0
+    sin_sm = False
+
+    print(f"holt.c: alfa 1/{1 << param['alfa_sh']}, beta 1/{1 << param['beta_sh']}, "
+          f"{pasos} pasos de {PASO_MS // 1000} s; MAE en unidades del sensor")
+    print()
+    print(f"{'serie':<24} {'canal':<5} {'muestras':>8} {'holt.c':>7} {'prom. 5':>7} {'última':>7} "
+          f"{'SES sm':>7} {'Holt sm':>7}")
+    for nombre, t, h in series:
+        _, ft, fh = _firmware(t, h)
+        for canal, serie, fw in (('T', t, ft), ('H', h, fh)):
+            py = holt_entero(serie, pasos, param['alfa_sh'], param['beta_sh'], param['frac'],
+                             param['bytes'])
+            distintos += sum(a != b for a, b in zip(fw, py)) + abs(len(fw) - len(py))
+            total += len(serie)
+
+            prom = [sum(serie[max(0, i - 4):i + 1]) / (i + 1 - max(0, i - 4)) for i in range(len(serie))]
+            cols = [_mae(fw, serie, pasos), _mae(prom, serie, pasos), _mae(serie, serie, pasos)]
+            sm = _statsmodels(serie, pasos)
+            if sm is None:
+                sin_sm = True
+                cols += [float('nan')] * 2
+            else:
+                cols += [_mae(sm[0], serie, pasos), _mae(sm[1], serie, pasos)]
+            print(f"{nombre:<24} {canal:<5} {len(serie):>8} " +
+                  ' '.join(f'{c / escala:>7.3f}' for c in cols))
+
+    print()
+    print(f"paridad holt.c / pronostico_holt.py: {total} pronósticos, {distintos} distintos")
+    if sin_sm:
+        print("(sin statsmodels: columnas de statsmodels en nan)")
+    return 1 if distintos else 0
+
+
+def main(argv=None):
+    ap = argparse.ArgumentParser(description='Pronóstico de Holt del firmware: paridad y error')
+    ap.add_argument('--banco', action='store_true', help='Compara holt.c, esta referencia y statsmodels')
+    ap.add_argument('trazas', nargs='*', help='Telemetría grabada (tramas COBS de uart.c)')
+    ap.add_argument('-z', '--zona', type=int, default=0)
+    ap.add_argument('--dias', type=float, default=3, help='Días de cada serie sintética')
+    a = ap.parse_args(argv)
+
+    if not a.banco:
+        ap.error('falta --banco')
+    if not os.path.exists(BANCO):
+        sys.exit(f"falta {BANCO}: make banco_holt")
+
+    param, _, _ = _firmware([], [])
+    series = []
+    for semilla in (1, 2):
+        t, h = serie_sintetica(a.dias, param['escala'], semilla)
+        series.append((f'sintética {semilla}', t, h))
+    for ruta in a.trazas:
+        t, h = serie_traza(ruta, a.zona, param['escala'])
+        if t:
+            series.append((os.path.basename(ruta), t, h))
+    return banco(series, param)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
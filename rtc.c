@@ -0,0 +1,182 @@
+/*
+ * File: rtc.c
+ * Reloj de tiempo real DS1307 por I2C, con la hora en cache (ver rtc.h)
+ */
+#include "rtc.h"
+#include "i2c.h"
+#include "sched.h"
+
+#if 60 % RTC_MARCA_S != 0
+#error "RTC_MARCA_S debe dividir al minuto"
+#endif
+
+#define RTC_REGS  7      // Segundos, minutos, horas, dia de semana, dia, mes, anio
+#define RTC_CH    0x80   // Oscilador detenido (registro de segundos)
+#define RTC_12H   0x40   // Modo de 12 h (registro de horas)
+#define RTC_PM    0x20
+
+// Dias del anio antes de cada mes (anio no bisiesto)
+static const uint16_t rtc_acumulado[12] = {
+    0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334
+};
+
+// Copia en RAM de la hora
+static uint16_t rtc_dias = 0;    // Desde el 2000-01-01
+static uint8_t rtc_h = 0, rtc_m = 0, rtc_s = 0;
+static uint16_t rtc_ms;          // Fraccion del segundo en curso
+static uint16_t rtc_tick;        // sched_ticks() de la ultima actualizacion
+static uint16_t rtc_resync;      // Segundos hasta la proxima lectura del chip
+static uint8_t rtc_ok = 0;
+
+static uint8_t rtc_bcd(uint8_t b)
+{
+    return (uint8_t)((b >> 4) * 10 + (b & 0x0F));
+}
+
+// Los 7 registros en una rafaga; 0 si el chip no responde
+static uint8_t rtc_rafaga(uint8_t *r)
+{
+    uint8_t i, ok;
+
+    I2C_Start();
+    ok = !I2C_Write(RTC_ADDR) && !I2C_Write(0x00);
+    if(ok) {
+        I2C_Restart();
+        ok = !I2C_Write(RTC_ADDR | 1);
+    }
+    if(ok) {
+        for(i = 0; i < RTC_REGS; i++) {
+            r[i] = I2C_Read();
+            if(i < RTC_REGS - 1) {
+                I2C_Ack();
+            } else {
+                I2C_Nack();   // Fin de la rafaga
+            }
+        }
+    }
+    I2C_Stop();
+    return ok;
+}
+
+uint8_t rtc_leer(Rtc_Fecha *f)
+{
+    uint8_t r[RTC_REGS];
+
+    if(!rtc_rafaga(r)) return 0;
+
+    f->seg = rtc_bcd(r[0] & 0x7F);
+    f->min = rtc_bcd(r[1]);
+    if(r[2] & RTC_12H) {
+        f->hora = rtc_bcd(r[2] & 0x1F);
+        if(f->hora == 12) f->hora = 0;
+        if(r[2] & RTC_PM) f->hora += 12;
+    } else {
+        f->hora = rtc_bcd(r[2] & 0x3F);
+    }
+    f->dia = rtc_bcd(r[4]);
+    f->mes = rtc_bcd(r[5]);
+    f->anio = rtc_bcd(r[6]);
+
+    // Sin bateria los registros pueden quedar con cualquier cosa
+    return f->seg < 60 && f->min < 60 && f->hora < 24 && f->dia >= 1 && f->dia <= 31 &&
+           f->mes >= 1 && f->mes <= 12 && f->anio < 100;
+}
+
+static void rtc_cargar(const Rtc_Fecha *f)
+{
+    uint16_t d;
+
+    // Los anios 2000..2099 bisiestos son los multiplos de 4
+    d = f->anio * 365u + ((f->anio + 3u) >> 2) + rtc_acumulado[f->mes - 1] + f->dia - 1;
+    if(f->mes > 2 && !(f->anio & 3)) d++;
+
+    rtc_dias = d;
+    rtc_h = f->hora;
+    rtc_m = f->min;
+    rtc_s = f->seg;
+    rtc_ms = 500;   // La lectura cae, en promedio, a mitad del segundo del chip
+}
+
+static void rtc_sincronizar(void)
+{
+    Rtc_Fecha f;
+
+    if(rtc_leer(&f)) rtc_cargar(&f);
+    rtc_tick = sched_ticks();
+    rtc_resync = RTC_RESYNC_S;
+}
+
+uint8_t rtc_init(void)
+{
+    uint8_t r[RTC_REGS];
+
+    rtc_ok = rtc_rafaga(r);
+    if(rtc_ok && (r[0] & RTC_CH)) {
+        // Chip nuevo o sin bateria: arrancar el oscilador sin tocar la hora
+        I2C_Start();
+        I2C_Write(RTC_ADDR);
+        I2C_Write(0x00);
+        I2C_Write(r[0] & ~RTC_CH);
+        I2C_Stop();
+    }
+    if(rtc_ok) rtc_sincronizar();
+
+    // El tick arranca con sched_init(): la primera rtc_tarea() vuelve a
+    // leer el chip para no perder lo que tarde el arranque
+    rtc_tick = sched_ticks();
+    rtc_resync = 0;
+    return rtc_ok;
+}
+
+static void rtc_segundo(void)
+{
+    if(rtc_resync) rtc_resync--;
+    if(++rtc_s < 60) return;
+    rtc_s = 0;
+    if(++rtc_m < 60) return;
+    rtc_m = 0;
+    if(++rtc_h < 24) return;
+    rtc_h = 0;
+    rtc_dias++;
+    rtc_resync = 0;   // Medianoche: el calendario lo lleva el chip
+}
+
+void rtc_tarea(void)
+{
+    uint16_t t = sched_ticks();
+
+    rtc_ms += t - rtc_tick;
+    rtc_tick = t;
+    while(rtc_ms >= 1000) {
+        rtc_ms -= 1000;
+        rtc_segundo();
+    }
+    if(rtc_ok && rtc_resync == 0) rtc_sincronizar();
+}
+
+uint8_t rtc_presente(void)
+{
+    return rtc_ok;
+}
+
+uint8_t rtc_hora(void)
+{
+    return rtc_h;
+}
+
+uint8_t rtc_minuto(void)
+{
+    return rtc_m;
+}
+
+uint16_t rtc_marca(void)
+{
+    uint16_t m;
+    uint8_t s;
+
+    // Modulo 65536: los productos de 16 bits ya dan la vuelta solos
+    m = rtc_dias * (uint16_t)(86400UL / RTC_MARCA_S) + rtc_h * (uint16_t)(3600 / RTC_MARCA_S) +
+        rtc_m * (uint16_t)(60 / RTC_MARCA_S);
+    for(s = rtc_s; s >= RTC_MARCA_S; s -= RTC_MARCA_S) m++;
+    return m;
+}
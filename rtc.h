@@ -0,0 +1,44 @@
+/*
+ * File: rtc.h
+ * Reloj de tiempo real DS1307 por I2C, con la hora en cache
+ *
+ * rtc_leer() trae los 7 registros de hora y fecha en una sola rafaga:
+ * START, direccion + escritura, puntero 0, RESTART, direccion + lectura y
+ * 7 bytes (ACK en todos menos el ultimo). Los registros se copian juntos
+ * en el chip al empezar la lectura, asi que no hay acarreo a medias.
+ *
+ * El bus no se usa en cada muestra: rtc_tarea() avanza la copia en RAM con
+ * el tick del planificador (sched_ticks()) y solo cada RTC_RESYNC_S vuelve
+ * a leer el chip, y al pasar la medianoche para que el DS1307 haga el
+ * calendario. Sin el chip (NACK) la hora cuenta desde el arranque, el
+ * 2000-01-01 00:00.
+ *
+ * rtc_marca() es la hora en pasos de RTC_MARCA_S segundos desde el
+ * 2000-01-01, modulo 65536 (~15 dias): la marca de las lecturas del
+ * historial (eelog.h), que es una serie con ese mismo paso.
+ */
+#ifndef RTC_H
+#define RTC_H
+
+#include <stdint.h>
+
+#define RTC_ADDR      0xD0   // Direccion de escritura (7 bits: 0x68)
+#define RTC_MARCA_S   20     // Segundos por marca
+#ifndef RTC_RESYNC_S
+#define RTC_RESYNC_S  600    // Lectura del chip cada 10 min
+#endif
+
+typedef struct {
+    uint8_t seg, min, hora;   // 24 h
+    uint8_t dia, mes, anio;   // dia 1..31, mes 1..12, anio 0..99 (2000..2099)
+} Rtc_Fecha;
+
+uint8_t rtc_leer(Rtc_Fecha *f);   // Rafaga de I2C; 0 si el chip no responde
+uint8_t rtc_init(void);           // Arranca el oscilador si estaba parado; 0 sin chip
+void rtc_tarea(void);             // Llamar al menos cada 60 s (tick de 16 bits)
+uint8_t rtc_presente(void);
+uint8_t rtc_hora(void);
+uint8_t rtc_minuto(void);
+uint16_t rtc_marca(void);
+
+#endif /* RTC_H */
@@ -0,0 +1,170 @@
+/*
+ * File: sched.c
+ * Planificador cooperativo por tick para PIC16F887
+ */
+#include "hal.h"
+#include "sched.h"
+#ifdef SCHED_T1OSC
+#include "i2c.h"
+#include "uart.h"
+#include "dht11.h"
+#endif
+
+// Con Timer1 a 1.6 us por cuenta, una medida vale hasta ~104 ms
+#define SCHED_WCET_MAX_MS  100
+
+static Tarea *sched_tabla;
+static uint8_t sched_n = 0;
+static volatile uint16_t sched_tick = 0;
+#ifdef SCHED_T1OSC
+static uint8_t sched_frac = 0;
+#endif
+
+// Marca de tiempo para medir duraciones
+uint16_t sched_ciclos(void)
+{
+#ifdef SCHED_T1OSC
+    return sched_ticks();
+#else
+    uint8_t h, l;
+    do {
+        h = TMR1H;
+        l = TMR1L;
+    } while(h != TMR1H);
+    return ((uint16_t)h << 8) | l;
+#endif
+}
+
+void sched_init(Tarea *tabla, uint8_t n)
+{
+    sched_tabla = tabla;
+    sched_n = n;
+
+#ifdef SCHED_T1OSC
+    // Timer1 asincrono con cristal de 32.768 kHz: desborda cada 256 cuentas
+    T1CON = 0x0F;        // T1OSCEN, sin sincronizar, reloj externo, ON
+    TMR1H = 0xFF;
+    PIR1bits.TMR1IF = 0;
+    PIE1bits.TMR1IE = 1;
+#else
+    // Timer2: 5 MHz / 4 (prescaler) / 250 (PR2) / 5 (postscaler) = 1 kHz
+    T2CON = 0x21;        // TOUTPS = 1:5, T2CKPS = 1:4
+    PR2 = 249;
+    TMR2 = 0;
+    PIR1bits.TMR2IF = 0;
+    PIE1bits.TMR2IE = 1;
+    T2CONbits.TMR2ON = 1;
+
+    // Timer1 libre a Fosc/4 con prescaler 1:8 para medir el WCET
+    T1CON = 0x31;
+#endif
+    INTCONbits.PEIE = 1;
+}
+
+void sched_tick_isr(void)
+{
+#ifdef SCHED_T1OSC
+    // 256 cuentas de 32.768 kHz = 7.8125 ms = 7 ms + 13/16 ms
+    TMR1H = 0xFF;
+    PIR1bits.TMR1IF = 0;
+    sched_frac += 13;
+    sched_tick += 7 + (sched_frac >> 4);
+    sched_frac &= 0x0F;
+#else
+    PIR1bits.TMR2IF = 0;
+    sched_tick++;
+#endif
+}
+
+uint16_t sched_ticks(void)
+{
+    uint16_t t;
+    // Lectura de 16 bits no atomica: repetir si la ISR la cambio
+    do {
+        t = sched_tick;
+    } while(t != sched_tick);
+    return t;
+}
+
+void sched_delay(uint8_t id, uint16_t ms)
+{
+    sched_tabla[id].proxima = sched_ticks() + ms;
+}
+
+void sched_dispatch(void)
+{
+    Tarea *t;
+    uint16_t ahora, liberada, inicio, dur;
+
+    for(uint8_t i = 0; i < sched_n; i++) {
+        t = &sched_tabla[i];
+        ahora = sched_ticks();
+        if((int16_t)(ahora - t->proxima) < 0) continue;
+
+        // La proxima activacion se fija antes de correr la tarea para que
+        // ella misma pueda adelantarla con sched_delay()
+        liberada = t->proxima;
+        t->proxima += t->periodo;
+        if((int16_t)(ahora - t->proxima) >= 0) {
+            t->proxima = ahora + t->periodo;  // Muy atrasada: no acumular
+        }
+
+        inicio = sched_ciclos();
+        t->fn();
+        dur = sched_ciclos() - inicio;
+
+        ahora = sched_ticks() - ahora;
+#ifndef SCHED_T1OSC
+        if(ahora >= SCHED_WCET_MAX_MS) dur = 0xFFFF;
+#endif
+        if(dur > t->wcet) t->wcet = dur;
+
+        if(t->plazo && (uint16_t)(sched_ticks() - liberada) > t->plazo) {
+            if(t->perdidos < 255) t->perdidos++;
+        }
+    }
+}
+
+#ifdef HAL_HOST
+// Ticks hasta la proxima activacion
+static uint16_t sched_libres(void)
+{
+    uint16_t ahora = sched_ticks(), min = 0xFFFF;
+    int16_t d;
+
+    for(uint8_t i = 0; i < sched_n; i++) {
+        d = (int16_t)(sched_tabla[i].proxima - ahora);
+        if(d <= 0) return 0;
+        if((uint16_t)d < min) min = d;
+    }
+    return min;
+}
+#endif
+
+void sched_run(void)
+{
+    uint16_t visto;
+
+    while(1) {
+        visto = sched_ticks();
+        sched_dispatch();
+
+#ifdef SCHED_T1OSC
+        // En SLEEP se detienen el MSSP, el EUSART y Timer0 (las marcas de
+        // la captura del sensor): dormir solo con la cola I2C vacia, la
+        // UART sin nada por salir y sin captura armada
+        if(!I2C_Busy() && !UART_Busy() && !dht11_capturando()) {
+            SLEEP();
+            NOP();
+        }
+#else
+        // Timer2 se detiene en SLEEP: con este tick no se duerme nunca, se
+        // espera despierto al siguiente
+#ifdef HAL_HOST
+        // Simulador: los ticks sin ninguna tarea lista se saltan de una vez
+        sched_tick += hal_host_reposo(sched_libres());
+#endif
+        while(sched_ticks() == visto) HAL_ESPERA();
+#endif
+    }
+}
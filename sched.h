@@ -0,0 +1,58 @@
+/*
+ * File: sched.h
+ * Planificador cooperativo por tick para PIC16F887
+ *
+ * Tabla fija de tareas con periodo, fase y plazo. Cada tarea corre hasta
+ * terminar (no hay expropiacion); el planificador mide el peor tiempo de
+ * ejecucion (WCET) y cuenta los plazos incumplidos.
+ *
+ * Fuente del tick:
+ * - Por defecto Timer2 a 1 ms. Timer2 se detiene en SLEEP, asi que este
+ *   build nunca ejecuta SLEEP: entre tareas la CPU espera despierta el
+ *   siguiente tick y no hay ahorro de energia en reposo.
+ * - Con SCHED_T1OSC el tick sale de Timer1 asincrono con un cristal de
+ *   32.768 kHz en RC0/RC1 (no esta en la placa por defecto), que sigue
+ *   contando en SLEEP: solo en este modo sched_run() duerme. El tick
+ *   avanza de a 7-8 ms y el WCET se mide en ticks. Timer1 deja de ser la
+ *   marca libre de 1.6 us, asi que PROF no compila con SCHED_T1OSC
+ *   (prof.c) y el simulador tampoco (hal_host.h).
+ */
+#ifndef SCHED_H
+#define SCHED_H
+
+#include <stdint.h>
+
+// Flag de interrupcion del tick (para la ISR de main.c)
+#ifdef SCHED_T1OSC
+#define SCHED_TICK_PENDIENTE()  (PIE1bits.TMR1IE && PIR1bits.TMR1IF)
+#else
+#define SCHED_TICK_PENDIENTE()  (PIE1bits.TMR2IE && PIR1bits.TMR2IF)
+#endif
+
+// Unidad del WCET en decimas de microsegundo
+#ifdef SCHED_T1OSC
+#define SCHED_WCET_DUS 10000  // 1 ms (contador de ticks)
+#else
+#define SCHED_WCET_DUS 16     // Timer1 a Fosc/4 con prescaler 1:8 = 1.6 us
+#endif
+
+typedef struct {
+    void (*fn)(void);
+    uint16_t periodo;    // ms entre activaciones
+    uint16_t plazo;      // ms desde la activacion para terminar (0 = sin plazo)
+    uint16_t proxima;    // tick de la proxima activacion (al iniciar: fase)
+    uint16_t wcet;       // Peor tiempo medido (unidades SCHED_WCET_DUS)
+    uint8_t  perdidos;   // Plazos incumplidos (satura en 255)
+} Tarea;
+
+#define SCHED_TAREA(fn, periodo, plazo, fase)  { fn, periodo, plazo, fase, 0, 0 }
+
+void sched_init(Tarea *tabla, uint8_t n);
+void sched_dispatch(void);   // Corre una vez cada tarea lista
+void sched_run(void);        // Bucle principal, no retorna
+void sched_tick_isr(void);   // Llamar desde la ISR con el flag del tick
+uint16_t sched_ticks(void);
+uint16_t sched_ciclos(void);  // Marca en unidades SCHED_WCET_DUS (prof.h)
+void sched_delay(uint8_t id, uint16_t ms);  // Reprograma la tarea id
+
+#endif /* SCHED_H */
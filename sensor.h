@@ -0,0 +1,64 @@
+/*
+ * File: sensor.h
+ * Sensor de temperatura y humedad, elegido al compilar
+ *
+ * DHT11 por defecto; con -DSENSOR_DHT22 el DHT22 (AM2302). Los nombres
+ * sensor_* son macros que llaman directo al driver: no hay punteros a
+ * funcion ni despacho en tiempo de ejecucion. La misma macro fija la
+ * resolucion de las muestras guardadas (muestra_t en fixpt.h).
+ *
+ * Lectura no bloqueante: sensor_start(), SENSOR_ARRANQUE_MS en bajo,
+ * sensor_capture(), ~5 ms de flancos en sensor_isr() (sensor_desborde()
+ * la corta a los ~6 ms si no terminan) y sensor_finish() con el
+ * resultado en Q8.8 o un DHT11_ERR_* (sin respuesta, trama incompleta,
+ * tiempo fuera de rango, checksum, valor imposible).
+ *
+ * SENSOR_RECUPERACION_MS es lo minimo entre el fin de una lectura y el
+ * arranque de la siguiente: tras un error se reintenta a ese plazo en
+ * lugar de esperar el periodo completo. SENSOR_ENCENDIDO_MS es lo que
+ * el sensor necesita despues de alimentarlo antes de la primera lectura.
+ */
+#ifndef SENSOR_H
+#define SENSOR_H
+
+#ifdef SENSOR_DHT22
+
+#include "dht22.h"
+
+#define SENSOR_NOMBRE          "DHT22"
+#define SENSOR_ARRANQUE_MS     DHT22_ARRANQUE_MS
+#define SENSOR_RECUPERACION_MS 2000   // Una lectura cada 2 s como mucho
+#define SENSOR_ENCENDIDO_MS    1000
+#define SENSOR_TELEM           0x08   // Marca en el byte de estado de la telemetria
+
+#define sensor_config()        dht22_config()
+#define sensor_start()         dht22_start()
+#define sensor_capture()       dht22_capture()
+#define sensor_isr()           dht22_isr()
+#define sensor_desborde()      dht22_desborde()
+#define sensor_finish(ph, pt)  dht22_finish_fixed(ph, pt)
+#define sensor_raw(d)          dht22_raw(d)
+#define sensor_convertir(d, ph, pt)  dht22_convertir(d, ph, pt)
+
+#else
+
+#include "dht11.h"
+
+#define SENSOR_NOMBRE          "DHT11"
+#define SENSOR_ARRANQUE_MS     20     // Minimo 18 ms
+#define SENSOR_RECUPERACION_MS 1000   // Una lectura por segundo como mucho
+#define SENSOR_ENCENDIDO_MS    1000
+#define SENSOR_TELEM           0x00
+
+#define sensor_config()        dht11_config()
+#define sensor_start()         dht11_start()
+#define sensor_capture()       dht11_capture()
+#define sensor_isr()           dht11_isr()
+#define sensor_desborde()      dht11_desborde()
+#define sensor_finish(ph, pt)  dht11_finish_fixed(ph, pt)
+#define sensor_raw(d)          dht11_raw(d)
+#define sensor_convertir(d, ph, pt)  dht11_convertir(d, ph, pt)
+
+#endif
+
+#endif /* SENSOR_H */
@@ -0,0 +1,130 @@
+/*
+ * File: stats.c
+ * Estadisticas incrementales del historial para PIC16F887
+ */
+#include "stats.h"
+
+// Arrays separados por tipo: un struct por canal no cabria en un banco
+static muestra_t stats_val[STATS_CANALES][STATS_VENTANA];   // Anillo de muestras
+static uint8_t stats_dq_min[STATS_CANALES][STATS_VENTANA];  // Posiciones, valores crecientes
+static uint8_t stats_dq_max[STATS_CANALES][STATS_VENTANA];  // Posiciones, valores decrecientes
+static uint8_t stats_min_ini[STATS_CANALES], stats_min_n[STATS_CANALES];
+static uint8_t stats_max_ini[STATS_CANALES], stats_max_n[STATS_CANALES];
+
+static int16_t stats_suma_rec;                   // Temp: ultimas STATS_TENDENCIA
+static int16_t stats_suma_ant;                   // Temp: las STATS_TENDENCIA previas
+
+static uint8_t stats_pos = 0;  // Donde va la proxima muestra
+static uint8_t stats_n = 0;
+
+// Posicion de la muestra de hace k (k = 1 es la mas nueva)
+static uint8_t stats_atras(uint8_t k)
+{
+    return (stats_pos >= k) ? stats_pos - k : stats_pos + STATS_VENTANA - k;
+}
+
+static uint8_t stats_sig(uint8_t i)
+{
+    return (i + 1 >= STATS_VENTANA) ? 0 : i + 1;
+}
+
+// Ultima posicion ocupada de un deque
+static uint8_t stats_cola(uint8_t ini, uint8_t n)
+{
+    ini += n - 1;
+    return (ini >= STATS_VENTANA) ? ini - STATS_VENTANA : ini;
+}
+
+static void stats_canal_push(uint8_t c, muestra_t v)
+{
+    muestra_t *val = stats_val[c];
+    uint8_t *dq;
+
+    // Ventana llena: la muestra que se pisa es la mas vieja y, si sigue
+    // en un deque, es su frente
+    if(stats_n == STATS_VENTANA) {
+        if(stats_min_n[c] && stats_dq_min[c][stats_min_ini[c]] == stats_pos) {
+            stats_min_ini[c] = stats_sig(stats_min_ini[c]);
+            stats_min_n[c]--;
+        }
+        if(stats_max_n[c] && stats_dq_max[c][stats_max_ini[c]] == stats_pos) {
+            stats_max_ini[c] = stats_sig(stats_max_ini[c]);
+            stats_max_n[c]--;
+        }
+    }
+
+    // Sumas deslizantes: entra v, sale la que queda fuera de cada ventana
+    if(c == STATS_TEMP) {
+        stats_suma_rec += v;
+        if(stats_n >= STATS_TENDENCIA) {
+            muestra_t sale = val[stats_atras(STATS_TENDENCIA)];
+            stats_suma_rec -= sale;
+            stats_suma_ant += sale;
+        }
+        if(stats_n >= 2 * STATS_TENDENCIA) {
+            stats_suma_ant -= val[stats_atras(2 * STATS_TENDENCIA)];
+        }
+    }
+
+    val[stats_pos] = v;
+
+    // Minimo: descartar por detras las que ya nunca seran minimo
+    dq = stats_dq_min[c];
+    while(stats_min_n[c] && val[dq[stats_cola(stats_min_ini[c], stats_min_n[c])]] >= v) {
+        stats_min_n[c]--;
+    }
+    dq[stats_cola(stats_min_ini[c], stats_min_n[c] + 1)] = stats_pos;
+    stats_min_n[c]++;
+
+    // Maximo: igual con la comparacion invertida
+    dq = stats_dq_max[c];
+    while(stats_max_n[c] && val[dq[stats_cola(stats_max_ini[c], stats_max_n[c])]] <= v) {
+        stats_max_n[c]--;
+    }
+    dq[stats_cola(stats_max_ini[c], stats_max_n[c] + 1)] = stats_pos;
+    stats_max_n[c]++;
+}
+
+void stats_init(void)
+{
+    for(uint8_t c = 0; c < STATS_CANALES; c++) {
+        stats_min_ini[c] = stats_min_n[c] = 0;
+        stats_max_ini[c] = stats_max_n[c] = 0;
+    }
+    stats_suma_rec = stats_suma_ant = 0;
+    stats_pos = 0;
+    stats_n = 0;
+}
+
+void stats_push(muestra_t temp, muestra_t hum)
+{
+    stats_canal_push(STATS_TEMP, temp);
+    stats_canal_push(STATS_HUM, hum);
+
+    stats_pos = stats_sig(stats_pos);
+    if(stats_n < STATS_VENTANA) stats_n++;
+}
+
+uint8_t stats_total(void)
+{
+    return stats_n;
+}
+
+valor_t stats_tendencia(void)
+{
+    if(stats_n < 2 * STATS_TENDENCIA) return 0;
+    return VALOR_PROMEDIO(stats_suma_rec, STATS_TENDENCIA * MUESTRA_ESCALA) -
+           VALOR_PROMEDIO(stats_suma_ant, STATS_TENDENCIA * MUESTRA_ESCALA);
+}
+
+muestra_t stats_min(uint8_t canal)
+{
+    if(stats_min_n[canal] == 0) return 0;
+    return stats_val[canal][stats_dq_min[canal][stats_min_ini[canal]]];
+}
+
+muestra_t stats_max(uint8_t canal)
+{
+    if(stats_max_n[canal] == 0) return 0;
+    return stats_val[canal][stats_dq_max[canal][stats_max_ini[canal]]];
+}
@@ -0,0 +1,45 @@
+/*
+ * File: stats.h
+ * Estadisticas incrementales del historial para PIC16F887
+ *
+ * Cada muestra guardada se empuja con stats_push() y actualiza en O(1):
+ * - Sumas deslizantes de las ultimas 2*STATS_TENDENCIA muestras
+ *   (tendencia). El pronostico es de holt.c.
+ * - Minimo y maximo de la ventana circular de STATS_VENTANA muestras con
+ *   deques monotonicos: cada posicion entra y sale una sola vez.
+ *
+ * La copia en RAM evita releer la EEPROM en cada analisis; el historial
+ * de la EEPROM solo se recorre al arrancar para reconstruir el estado.
+ * Las muestras son muestra_t (fixpt.h); la tendencia sale en valor_t ya
+ * dividida por MUESTRA_ESCALA.
+ * RAM: (2 * MUESTRA_BYTES + 4) * STATS_VENTANA bytes mas ~16 de indices y
+ * sumas; con muestras de 2 bytes la ventana baja a 20 para que quepa.
+ */
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include "fixpt.h"
+
+#ifndef STATS_VENTANA
+#if MUESTRA_BYTES == 2
+#define STATS_VENTANA     20   // Muestras para min/max (las mas nuevas del historial)
+#else
+#define STATS_VENTANA     30
+#endif
+#endif
+#define STATS_TENDENCIA   3    // Muestras de cada mitad de la tendencia
+
+// Canales
+#define STATS_TEMP  0
+#define STATS_HUM   1
+#define STATS_CANALES 2
+
+void stats_init(void);
+void stats_push(muestra_t temp, muestra_t hum);
+uint8_t stats_total(void);                 // Muestras en la ventana
+valor_t stats_tendencia(void);             // Temperatura: reciente - anterior
+muestra_t stats_min(uint8_t canal);
+muestra_t stats_max(uint8_t canal);
+
+#endif /* STATS_H */
@@ -0,0 +1,69 @@
+"""
+Tramas de la UART del PIC (uart.c)
+==================================
+El único decodificador de la telemetría en Python: lo usan termo.py
+(leer_telemetria), pronostico_holt.py (trazas del banco) y perfil.py
+(tramas de prof.c). COBS y CRC-8 son los de cobs.c y crc8.c.
+
+Registro de 11 bytes por cada lectura, en tramas COBS terminadas en 0x00:
+[seq][tick L][tick H][5 bytes del sensor][zona:4|estado:4][descartadas][crc8]
+(con varios sensores, DHT_ZONAS > 1, sale un registro por zona). El bit 3
+del estado indica DHT22: humedad en décimas en 16 bits y temperatura en
+décimas con el signo en el bit 7 del byte 2.
+"""
+
+TELEM_LEN = 11
+TELEM_DHT22 = 0x08
+
+
+def crc8(datos):
+    """CRC-8 polinomio 0x07, valor inicial 0 (igual que crc8.c)"""
+    crc = 0
+    for b in datos:
+        crc ^= b
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def cobs_decodificar(trama):
+    """Deshace el COBS de una trama (sin el 0x00 final); None si está corrupta"""
+    salida = bytearray()
+    i = 0
+    while i < len(trama):
+        cod = trama[i]
+        if cod == 0 or i + cod > len(trama):
+            return None
+        salida += trama[i + 1:i + cod]
+        i += cod
+        if i < len(trama) and cod < 0xFF:
+            salida.append(0)
+    return bytes(salida)
+
+
+def tramas(flujo):
+    """Genera las tramas decodificadas de un flujo de bytes (las corruptas no)"""
+    pendiente = bytearray()
+    while True:
+        try:
+            bloque = flujo.read(4096)
+        except OSError:  # La pty se cerró
+            return
+        if not bloque:
+            return
+        pendiente += bloque
+        *partes, pendiente = pendiente.split(b'\x00')
+        for t in partes:
+            r = cobs_decodificar(t)
+            if r:
+                yield r
+
+
+def leer_tramas(flujo):
+    """Genera los registros válidos de un flujo de bytes; descarta los corruptos"""
+    for r in tramas(flujo):
+        if len(r) != TELEM_LEN or crc8(r[:-1]) != r[-1]:
+            continue
+        yield {'seq': r[0], 'tick': r[1] | r[2] << 8, 'dht': r[3:8],
+               'zona': r[8] >> 4, 'estado': r[8] & 0x07,
+               'dht22': bool(r[8] & TELEM_DHT22), 'descartadas': r[9]}
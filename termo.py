@@ -9,6 +9,13 @@ Microcontrolador: PIC16F887
 Sensores: DHT11, DS1307
 """
 
+# Modo por flujo para logs grandes o de muchos nodos (ver analisis_flujo.py):
+#   python termo.py --flujo datos.csv ingesta/ [-o salida] [-j procesos]
+import sys
+if __name__ == '__main__' and sys.argv[1:2] == ['--flujo']:
+    from analisis_flujo import main as analisis_flujo
+    sys.exit(analisis_flujo(sys.argv[2:]))
+
 # ============================================================================
 # 1. IMPORTAR LIBRERÍAS
 # ============================================================================
@@ -20,6 +27,8 @@ import seaborn as sns
 from datetime import datetime, timedelta
 from scipy import stats
 from statsmodels.tsa.holtwinters import SimpleExpSmoothing
+from pronostico_holt import pronostico_holt, PASO_MS
+from telemetria import crc8, leer_tramas
 import warnings
 warnings.filterwarnings('ignore')
 
@@ -58,6 +67,8 @@ def generar_datos_ejemplo(num_horas=24):
         'temperatura': temperatura,
         'humedad': humedad
     })
+    # Escala de las muestras y paso entre ellas (ver escala_y_paso())
+    df.attrs.update(escala=1, paso_s=3600)
     
     return df
 
@@ -97,6 +108,266 @@ def leer_datos_sd(archivo='datos_sensor.csv'):
 # Descomentar para leer datos reales de SD:
 # df = leer_datos_sd('datos_sensor.csv')
 
+# ============================================================================
+# 3b. FUNCIÓN PARA LEER EL HISTORIAL DE LA EEPROM DEL PIC
+# ============================================================================
+
+def _desempaquetar(t, h, datos, mb=1):
+    """
+    Decodifica un bloque: keyframe (t, h) + deltas en nibbles (logpack.c).
+    mb son los bytes de cada muestra (2 con el DHT22); la aritmética da la
+    vuelta como muestra_t en el PIC. Devuelve las lecturas en unidades del
+    sensor.
+    """
+    nib = [n for b in datos for n in (b >> 4, b & 0x0F)]
+    s4 = lambda n: n - 16 if n & 0x08 else n  # Nibble con signo
+    ajustar = (lambda v: (v + 0x8000 & 0xFFFF) - 0x8000) if mb == 2 else (lambda v: v & 0xFF)
+    abs_nib = 2 * mb
+
+    def valor(i, t, h):
+        """Código de valor en i: (t, h, posición siguiente) o None"""
+        if i >= len(nib):
+            return None
+        c, libres = nib[i], len(nib) - i - 1
+        if c <= 8:
+            return ajustar(t + c // 3 - 1), ajustar(h + c % 3 - 1), i + 1
+        if c == 0xD and libres >= 2:
+            return ajustar(t + s4(nib[i + 1])), ajustar(h + s4(nib[i + 2])), i + 3
+        if c == 0xE and libres >= 2 * abs_nib:
+            v = [0, 0]
+            for k in range(2):
+                for n in nib[i + 1 + k * abs_nib:i + 1 + (k + 1) * abs_nib]:
+                    v[k] = v[k] << 4 | n
+            return ajustar(v[0]), ajustar(v[1]), i + 1 + 2 * abs_nib
+        return None  # Fin, código reservado o cortado
+
+    def interp(a, b, k, n):
+        """Punto k de n entre a y b, redondeado como unpack_interp()"""
+        d = (b - a) * k
+        return ajustar(a - (-d + n // 2) // n if d < 0 else a + (d + n // 2) // n)
+
+    lecturas = []
+    i = 0
+    if nib and nib[0] == 0xB:
+        i = 1  # El keyframe es solo el origen de un hueco
+    else:
+        lecturas.append((t, h))
+    while i < len(nib):
+        c = nib[i]
+        if c == 0x9 and i + 1 < len(nib):
+            lecturas.extend([(t, h)] * (nib[i + 1] + 2))
+            i += 2
+            continue
+        if c == 0xA and i + 1 < len(nib):
+            r = valor(i + 2, t, h)
+            if r is None:
+                break
+            n = nib[i + 1] + 2
+            lecturas.extend((interp(t, r[0], k, n), interp(h, r[1], k, n)) for k in range(1, n))
+        else:
+            r = valor(i, t, h)
+            if r is None:
+                break
+        t, h, i = r
+        lecturas.append((t, h))
+    return lecturas
+
+def _bloques_validos(bloques, mb):
+    """Separa los bloques con CRC correcto: lista de (seq, t0, h0, marca, datos)"""
+    cab = 1 + 2 * mb + 2
+    entero = lambda b: int.from_bytes(b, 'little', signed=(mb == 2))
+    validos = []
+    for b in bloques:
+        if len(b) < cab + 1 or crc8(b[:cab]) != b[cab]:
+            validos.append(None)
+            continue
+        validos.append((b[0], entero(b[1:1 + mb]), entero(b[1 + mb:1 + 2 * mb]),
+                        b[cab - 2] | b[cab - 1] << 8, bytes(b[cab + 1:])))
+    return validos
+
+def _anillo(volcado, mb, bloque=16):
+    """Bloques del anillo interno de eelog.c, del más viejo al más nuevo"""
+    # Los últimos 16 bytes son el índice del archivo externo (archivo.c)
+    n = len(volcado) // bloque - 1
+    bloques = _bloques_validos([volcado[i * bloque:(i + 1) * bloque] for i in range(n)], mb)
+    sigue = lambda a, b: a is not None and b is not None and b[0] == (a[0] + 1) & 0xFF
+
+    # Cabeza: bloque válido al que no sigue su seq + 1
+    cabeza = next((i for i in range(n) if bloques[i] is not None and
+                   not sigue(bloques[i], bloques[(i + 1) % n])), None)
+    if cabeza is None:
+        return []
+    orden = [bloques[cabeza]]
+    i = cabeza
+    while len(orden) < n and sigue(bloques[(i - 1) % n], bloques[i]):
+        i = (i - 1) % n
+        orden.append(bloques[i])
+    return orden[::-1]
+
+def _tabla(bloques, mb, ahora):
+    """
+    Lecturas de los bloques con su fecha. La marca del keyframe (pasos de
+    20 s desde el 2000-01-01, módulo 65536) se completa con la fecha de
+    ahora, la de la lectura del volcado, y las lecturas de cada bloque
+    siguen de a un paso.
+    """
+    if ahora is None:
+        ahora = datetime.now()
+    epoca = datetime(2000, 1, 1)
+    actual = int((ahora - epoca).total_seconds()) // 20
+    filas = []
+    for seq, t, h, marca, datos in bloques:
+        lecturas = _desempaquetar(t, h, datos, mb)
+        if datos and datos[0] >> 4 == 0xB:
+            marca += 1
+        for k, (t, h) in enumerate(lecturas):
+            filas.append(((marca + k) & 0xFFFF, t, h))
+    if not filas:
+        vacia = pd.DataFrame(columns=['fecha_hora', 'temperatura', 'humedad'])
+        vacia.attrs.update(escala=10 if mb == 2 else 1, paso_s=PASO_MS // 1000)
+        return vacia
+
+    # De la más nueva hacia atrás, la marca completa más cercana
+    completa = actual - ((actual - filas[-1][0]) & 0xFFFF)
+    marcas = [completa]
+    for i in range(len(filas) - 2, -1, -1):
+        completa -= (filas[i + 1][0] - filas[i][0]) & 0xFFFF
+        marcas.append(completa)
+    marcas.reverse()
+
+    escala = 10 if mb == 2 else 1
+    tabla = pd.DataFrame({
+        'fecha_hora': [epoca + timedelta(seconds=20 * m) for m in marcas],
+        'temperatura': [f[1] / escala for f in filas],
+        'humedad': [f[2] / escala for f in filas],
+    })
+    # Una muestra por marca de 20 s, en la resolución del sensor
+    tabla.attrs.update(escala=escala, paso_s=PASO_MS // 1000)
+    return tabla
+
+def leer_historial_eeprom(volcado, dht22=False, ahora=None):
+    """
+    Decodifica un volcado de los 256 bytes de la EEPROM (p. ej. leído con
+    el programador, o SIM_EEPROM del simulador) con el formato de eelog.c:
+    bloques de 16 bytes [seq][T0][H0][marca][crc8] + deltas. Con dht22=True
+    T0 y H0 son de 2 bytes (décimas). ahora es la fecha del volcado, para
+    completar las marcas. Devuelve un DataFrame con las lecturas de la más
+    vieja a la más nueva.
+    """
+    mb = 2 if dht22 else 1
+    return _tabla(_anillo(volcado, mb), mb, ahora)
+
+def leer_archivo_externo(volcado_ext, volcado_eeprom, dht22=False, ahora=None):
+    """
+    Historial completo: los bloques archivados en la 24LC256 (volcado de
+    32 KB, o SIM_EXT del simulador) seguidos por los del anillo interno
+    que todavía no se copiaron. El índice del archivo está en los 16 bytes
+    finales de la EEPROM interna, en dos copias alternadas
+    [contador][seq][página L][página H][crc8]; vale la más nueva con CRC
+    correcto. El bit 15 de la página indica que el archivo dio la vuelta.
+    """
+    mb = 2 if dht22 else 1
+    indices = []
+    for base in (240, 248):
+        ind = volcado_eeprom[base:base + 5]
+        if crc8(ind[:4]) == ind[4]:
+            indices.append(ind)
+    bloques = []
+    seq_archivo = None
+    if indices:
+        ind = indices[0]
+        if len(indices) == 2 and (indices[1][0] - indices[0][0]) & 0xFF < 0x80:
+            ind = indices[1]
+        seq_archivo = ind[1]
+        pagina = ind[2] | ind[3] << 8
+        paginas = len(volcado_ext) // 64
+        if pagina & 0x8000:
+            orden = list(range(pagina & 0x7FFF, paginas)) + list(range(pagina & 0x7FFF))
+        else:
+            orden = range(pagina)
+        for p in orden:
+            pag = volcado_ext[p * 64:(p + 1) * 64]
+            bloques.extend(b for b in _bloques_validos([pag[k:k + 16] for k in range(0, 64, 16)], mb)
+                           if b is not None)
+
+    # Del anillo, solo lo posterior al último bloque archivado
+    for b in _anillo(volcado_eeprom, mb):
+        if seq_archivo is None or 0 < (b[0] - seq_archivo) & 0xFF < 0x80:
+            bloques.append(b)
+    return _tabla(bloques, mb, ahora)
+
+# Descomentar para leer un volcado binario de la EEPROM (y de la 24LC256):
+# df_eeprom = leer_historial_eeprom(open('eeprom.bin', 'rb').read())
+# df_archivo = leer_archivo_externo(open('24lc256.bin', 'rb').read(),
+#                                   open('eeprom.bin', 'rb').read())
+
+# ============================================================================
+# 3c. TELEMETRÍA BINARIA POR UART (uart.c)
+# ============================================================================
+
+# Registros de 11 bytes en tramas COBS (formato y decodificador en
+# telemetria.py); estado de cada lectura:
+TELEM_ESTADOS = {0: 'ok', 1: 'sin respuesta', 2: 'timeout', 3: 'tiempo', 4: 'checksum',
+                 5: 'fuera de rango'}
+
+def _dht_valores(d, dht22):
+    """(temperatura, humedad) de los 5 bytes del sensor"""
+    if dht22:
+        t = ((d[2] & 0x7F) << 8 | d[3]) / 10
+        return (-t if d[2] & 0x80 else t), (d[0] << 8 | d[1]) / 10
+    return d[2] + d[3] / 10, d[0] + d[1] / 10
+
+def _abrir_serie(puerto, baudios=115200):
+    """Abre el puerto serie en modo crudo (también la pty de SIM_UART=pty o un archivo)"""
+    import os, termios, tty
+    fd = os.open(puerto, os.O_RDONLY | os.O_NOCTTY)
+    if os.isatty(fd):
+        tty.setraw(fd, termios.TCSANOW)  # Sin descartar lo ya recibido
+        attrs = termios.tcgetattr(fd)
+        attrs[4] = attrs[5] = getattr(termios, f'B{baudios}')
+        termios.tcsetattr(fd, termios.TCSANOW, attrs)
+    return os.fdopen(fd, 'rb', buffering=0)
+
+def leer_telemetria(puerto, baudios=115200, max_registros=None, inicio=None):
+    """
+    Lee la telemetría del PIC por la UART (115200 8N1). La hora sale del
+    tick del PIC (ms en 16 bits), desenrollado a partir de `inicio`; las
+    lecturas perdidas se deducen de los saltos de seq. Devuelve un
+    DataFrame compatible con leer_datos_sd() más las columnas de zona y
+    estado (para una zona: df[df['zona'] == 2]).
+    """
+    inicio = inicio or datetime.now()
+    filas, ms, previo, dht22 = [], 0, None, False
+    with _abrir_serie(puerto, baudios) as flujo:
+        for r in leer_tramas(flujo):
+            perdidas = 0
+            if previo is not None:
+                ms += (r['tick'] - previo['tick']) & 0xFFFF
+                perdidas = (r['seq'] - previo['seq'] - 1) & 0xFF
+            previo = r
+            dht22 = dht22 or r['dht22']
+            t, h = _dht_valores(r['dht'], r['dht22']) if r['estado'] == 0 else (np.nan, np.nan)
+            filas.append({
+                'fecha_hora': inicio + timedelta(milliseconds=ms),
+                'temperatura': t,
+                'humedad': h,
+                'zona': r['zona'],
+                'estado': TELEM_ESTADOS.get(r['estado'], r['estado']),
+                'perdidas': perdidas,
+                'descartadas': r['descartadas'],
+            })
+            if max_registros and len(filas) >= max_registros:
+                break
+    # Llega cada lectura (cada 2 o 6 s); las estadísticas y holt.c del PIC
+    # toman una cada 20 s, y el pronóstico de abajo hace lo mismo
+    df = pd.DataFrame(filas)
+    df.attrs.update(escala=10 if dht22 else 1, paso_s=PASO_MS // 1000)
+    return df
+
+# Descomentar para leer la telemetría (o la pty que imprime el simulador
+# con SIM_UART=pty ./build/host/termo):
+# df = leer_telemetria('/dev/ttyUSB0', max_registros=1800)
+
 # ============================================================================
 # 4. RESUMEN ESTADÍSTICO
 # ============================================================================
@@ -196,12 +467,12 @@ print("✅ Gráficos guardados en 'analisis_datos.png'")
 plt.show()
 
 # ============================================================================
-# 6. PRONÓSTICO DE 6 PASOS (6 HORAS)
+# 6. PRONÓSTICO DE 6 PASOS (6 HORAS CON LOS DATOS DE EJEMPLO)
 # ============================================================================
 
 print()
 print("=" * 60)
-print("  PRONÓSTICO - 6 HORAS HACIA EL FUTURO")
+print("  PRONÓSTICO - 6 MUESTRAS HACIA EL FUTURO")
 print("=" * 60)
 print()
 
@@ -231,11 +502,41 @@ def pronostico_suavizamiento_exponencial(datos, pasos=6):
     pronostico = ajuste.forecast(steps=pasos)
     return pronostico
 
-# Generar pronósticos
-temp_actual = df['temperatura'].values
-hum_actual = df['humedad'].values
+def escala_y_paso(df):
+    """
+    Escala de las muestras (1: grados enteros del DHT11, 10: décimas del
+    DHT22) y segundos entre muestras del equipo que generó df. Las
+    funciones de lectura los dejan en df.attrs; si no están (un CSV), la
+    escala sale de si hay decimales y el paso de la mediana entre fechas.
+    """
+    escala = df.attrs.get('escala')
+    if escala is None:
+        v = pd.concat([df['temperatura'], df['humedad']]).dropna()
+        escala = 1 if np.allclose(v, np.round(v)) else 10
+    paso = df.attrs.get('paso_s')
+    if paso is None:
+        paso = df['fecha_hora'].diff().median().total_seconds()
+    return escala, paso
+
+def serie_al_paso(df, columna, paso):
+    """
+    La serie con una muestra cada `paso` segundos, como la ve el PIC: si
+    llegan más seguido (telemetría), la última de cada paso
+    """
+    serie = df.set_index('fecha_hora')[columna].dropna()
+    if len(serie) > 1 and serie.index.to_series().diff().median().total_seconds() < paso:
+        serie = serie.resample(f'{int(paso)}s').last().dropna()
+    return serie.values
+
+# Generar pronósticos, con la escala y el paso de los datos: con el DHT11
+# holt.c cuenta en grados enteros, con el DHT22 en décimas
+escala, paso = escala_y_paso(df)
+temp_actual = serie_al_paso(df, 'temperatura', paso)
+hum_actual = serie_al_paso(df, 'humedad', paso)
+print(f"Escala 1/{escala}, una muestra cada {paso:g} s: pronóstico a 6 muestras")
+print()
 
-# Método 1: Media Móvil (para microcontrolador)
+# Método 1: Media Móvil
 forecast_temp_ma = pronostico_media_movil(temp_actual, ventana=3, pasos=6)
 forecast_hum_ma = pronostico_media_movil(hum_actual, ventana=3, pasos=6)
 
@@ -243,12 +544,16 @@ forecast_hum_ma = pronostico_media_movil(hum_actual, ventana=3, pasos=6)
 forecast_temp_es = pronostico_suavizamiento_exponencial(temp_actual, pasos=6)
 forecast_hum_es = pronostico_suavizamiento_exponencial(hum_actual, pasos=6)
 
-# Crear fechas futuras
+# Método 3: Holt en enteros, la misma cuenta que holt.c en el PIC
+forecast_temp_holt = pronostico_holt(temp_actual, pasos=6, escala=escala)
+forecast_hum_holt = pronostico_holt(hum_actual, pasos=6, escala=escala)
+
+# Crear fechas futuras, un paso de los datos cada una
 ultima_fecha = df['fecha_hora'].iloc[-1]
-fechas_futuras = [ultima_fecha + timedelta(hours=i+1) for i in range(6)]
+fechas_futuras = [ultima_fecha + timedelta(seconds=paso * (i + 1)) for i in range(6)]
 
 # Mostrar pronósticos
-print("🔮 PRONÓSTICO - MÉTODO 1: MEDIA MÓVIL (Microcontrolador)")
+print("🔮 PRONÓSTICO - MÉTODO 1: MEDIA MÓVIL")
 print("-" * 60)
 print(f"{'Hora':<20} {'Temperatura (°C)':>18} {'Humedad (%)':>18}")
 print("-" * 60)
@@ -264,14 +569,23 @@ for i, fecha in enumerate(fechas_futuras):
     print(f"{fecha.strftime('%Y-%m-%d %H:%M'):<20} {forecast_temp_es[i]:>18.2f} {forecast_hum_es[i]:>18.2f}")
 print()
 
+print("🔮 PRONÓSTICO - MÉTODO 3: HOLT EN ENTEROS (Microcontrolador, holt.c)")
+print("-" * 60)
+print(f"{'Hora':<20} {'Temperatura (°C)':>18} {'Humedad (%)':>18}")
+print("-" * 60)
+for i, fecha in enumerate(fechas_futuras):
+    print(f"{fecha.strftime('%Y-%m-%d %H:%M'):<20} {forecast_temp_holt[i]:>18.2f} {forecast_hum_holt[i]:>18.2f}")
+print()
+
 # Visualizar pronósticos
 fig, axes = plt.subplots(1, 2, figsize=(14, 5))
-fig.suptitle('Pronóstico de 6 Horas', fontsize=16, fontweight='bold')
+fig.suptitle(f'Pronóstico de 6 muestras ({paso:g} s cada una)', fontsize=16, fontweight='bold')
 
 # Pronóstico de temperatura
 axes[0].plot(df['fecha_hora'], df['temperatura'], 'o-', label='Datos Históricos', color='orangered', linewidth=2)
 axes[0].plot(fechas_futuras, forecast_temp_ma, 's--', label='Media Móvil', color='darkred', linewidth=2)
 axes[0].plot(fechas_futuras, forecast_temp_es, '^--', label='Suav. Exponencial', color='coral', linewidth=2)
+axes[0].plot(fechas_futuras, forecast_temp_holt, 'd--', label='Holt (PIC)', color='saddlebrown', linewidth=2)
 axes[0].set_title('Pronóstico de Temperatura')
 axes[0].set_xlabel('Fecha y Hora')
 axes[0].set_ylabel('Temperatura (°C)')
@@ -283,6 +597,7 @@ axes[0].tick_params(axis='x', rotation=45)
 axes[1].plot(df['fecha_hora'], df['humedad'], 'o-', label='Datos Históricos', color='dodgerblue', linewidth=2)
 axes[1].plot(fechas_futuras, forecast_hum_ma, 's--', label='Media Móvil', color='darkblue', linewidth=2)
 axes[1].plot(fechas_futuras, forecast_hum_es, '^--', label='Suav. Exponencial', color='skyblue', linewidth=2)
+axes[1].plot(fechas_futuras, forecast_hum_holt, 'd--', label='Holt (PIC)', color='navy', linewidth=2)
 axes[1].set_title('Pronóstico de Humedad')
 axes[1].set_xlabel('Fecha y Hora')
 axes[1].set_ylabel('Humedad (%)')
@@ -311,7 +626,9 @@ df_forecast = pd.DataFrame({
     'temp_media_movil': forecast_temp_ma,
     'hum_media_movil': forecast_hum_ma,
     'temp_exp_smoothing': forecast_temp_es,
-    'hum_exp_smoothing': forecast_hum_es
+    'hum_exp_smoothing': forecast_hum_es,
+    'temp_holt': forecast_temp_holt,
+    'hum_holt': forecast_hum_holt
 })
 
 # Guardar estadísticas
@@ -0,0 +1,64 @@
+/*
+ * File: test.h
+ * Macros de las pruebas de host (make test)
+ *
+ * Cada test_*.c es un ejecutable de Linux: PRUEBA() anota la falla con el
+ * archivo y la linea y sigue con las demas; PRUEBA_FIN() imprime la cuenta
+ * y da el codigo de salida (0 = todas bien) para el Makefile. Si el
+ * programa termina por otro lado (el simulador llego a SIM_HORAS) sale 1.
+ */
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static unsigned prueba_n = 0, prueba_fallas = 0;
+static int prueba_terminada = 0;
+
+#define PRUEBA(cond) do { \
+        prueba_n++; \
+        if(!(cond)) { \
+            prueba_fallas++; \
+            printf("%s:%d: falla: %s\n", __FILE__, __LINE__, #cond); \
+        } \
+    } while(0)
+
+// Igualdad de enteros, con los dos valores en el mensaje
+#define PRUEBA_IGUAL(a, b) do { \
+        long long a_ = (long long)(a), b_ = (long long)(b); \
+        prueba_n++; \
+        if(a_ != b_) { \
+            prueba_fallas++; \
+            printf("%s:%d: falla: %s == %s (%lld != %lld)\n", \
+                   __FILE__, __LINE__, #a, #b, a_, b_); \
+        } \
+    } while(0)
+
+#define PRUEBA_FIN()  prueba_fin(__FILE__)
+
+static int prueba_fin(const char *archivo)
+{
+    printf("%s: %u pruebas, %u fallas\n", archivo, prueba_n, prueba_fallas);
+    prueba_terminada = 1;
+    return prueba_fallas != 0;
+}
+
+// El simulador sale con exit() al llegar a SIM_HORAS o sin eventos: una
+// prueba que se traba no debe terminar con 0
+static void prueba_salida(void)
+{
+    if(!prueba_terminada) {
+        printf("la prueba no llego a PRUEBA_FIN() (%u pruebas, %u fallas)\n", prueba_n, prueba_fallas);
+        fflush(stdout);
+        _exit(1);
+    }
+}
+
+__attribute__((constructor)) static void prueba_registrar(void)
+{
+    atexit(prueba_salida);
+}
+
+#endif /* TEST_H */
@@ -0,0 +1,145 @@
+"""
+Pruebas de analisis_flujo.py (make test)
+
+Las tablas del modo por flujo tienen que dar lo mismo que
+calcular_estadisticas() de termo.py sobre la serie entera. La función se
+saca del fuente de termo.py (termo.py es un script y no se puede importar
+sin correr el análisis completo). Con numpy se ejecuta tal cual; sin numpy
+se ejecuta sobre un reemplazo a fuerza bruta con las mismas definiciones
+(desvío con ddof, percentil con interpolación lineal como np.percentile).
+
+Se prueban almacenes con varios nodos partidos en bloques y tramos, un CSV,
+uno y varios procesos, y los nombres de las tablas (a/datos.csv y
+b/datos.csv no se pisan, una fuente repetida es un error).
+"""
+
+import io
+import os
+import ast
+import math
+import array
+import struct
+import tempfile
+import unittest
+import contextlib
+
+import analisis_flujo as af
+
+AQUI = os.path.dirname(os.path.abspath(__file__))
+
+
+class _NumpyMinimo:
+    """Lo que usa calcular_estadisticas(), con las definiciones de numpy"""
+    mean = staticmethod(lambda s: math.fsum(s) / len(s))
+    min = staticmethod(min)
+    max = staticmethod(max)
+
+    @staticmethod
+    def std(s, ddof=0):
+        m = math.fsum(s) / len(s)
+        return math.sqrt(math.fsum((x - m) ** 2 for x in s) / (len(s) - ddof))
+
+    @staticmethod
+    def percentile(s, p):
+        s = sorted(s)
+        pos = p / 100 * (len(s) - 1)
+        k = int(pos)
+        return s[k] + (s[min(k + 1, len(s) - 1)] - s[k]) * (pos - k)
+
+
+def _calcular_estadisticas():
+    """calcular_estadisticas() de termo.py, sin ejecutar el resto del script"""
+    with open(os.path.join(AQUI, 'termo.py'), encoding='utf-8') as f:
+        arbol = ast.parse(f.read())
+    fn = next(n for n in arbol.body
+              if isinstance(n, ast.FunctionDef) and n.name == 'calcular_estadisticas')
+    entorno = {'np': af.np if af.np is not None else _NumpyMinimo}
+    exec(compile(ast.Module(body=[fn], type_ignores=[]), 'termo.py', 'exec'), entorno)
+    return entorno['calcular_estadisticas']
+
+calcular_estadisticas = _calcular_estadisticas()
+
+
+def referencia(serie):
+    with contextlib.redirect_stdout(io.StringIO()):
+        return calcular_estadisticas(serie, 'referencia')
+
+def leer_almacen(ruta, col):
+    """Columna entera de un almacén, en unidades (sin las lecturas fallidas)"""
+    with open(os.path.join(ruta, 'filas.u8'), 'rb') as f:
+        filas = struct.unpack('<Q', f.read(8))[0]
+    a = array.array('h')
+    with open(os.path.join(ruta, col), 'rb') as f:
+        a.fromfile(f, filas)
+    return [v / 10 for v in a if v != af.SIN_DATO]
+
+
+class PruebaFlujo(unittest.TestCase):
+
+    def setUp(self):
+        self.dir = tempfile.TemporaryDirectory(prefix='test_flujo_')
+        self.d = self.dir.name
+        self.bloque, self.distintos = af.BLOQUE, af.DISTINTOS_CSV
+        af.BLOQUE = 1000            # Varios bloques y tramos por nodo
+        af.DISTINTOS_CSV = 100      # y varios conteos por CSV
+
+    def tearDown(self):
+        af.BLOQUE, af.DISTINTOS_CSV = self.bloque, self.distintos
+        self.dir.cleanup()
+
+    def comparar(self, tabla, serie):
+        ref = referencia(serie)
+        self.assertEqual(tabla['Count'], ref['Count'])
+        for e in ('Mean', 'Std'):
+            self.assertAlmostEqual(tabla[e], float(ref[e]), delta=1e-9 * max(1, abs(ref[e])), msg=e)
+        for e in ('Min', '25%', '50%', '75%', 'Max'):
+            self.assertAlmostEqual(tabla[e], float(ref[e]), delta=1e-9, msg=e)
+
+    def test_almacenes(self):
+        af.generar_almacenes(self.d, 12_345, 3, semilla=7)
+        for procesos in (1, 2):
+            tablas, total = af.analizar([self.d], procesos)
+            self.assertEqual(sorted(tablas), ['nodo0000', 'nodo0001', 'nodo0002'])
+            todas = ([], [])
+            for nombre, (t, h) in tablas.items():
+                ruta = os.path.join(self.d, nombre)
+                serie_t, serie_h = leer_almacen(ruta, 'temp.i2'), leer_almacen(ruta, 'hum.i2')
+                self.comparar(t, serie_t)
+                self.comparar(h, serie_h)
+                todas[0].extend(serie_t)
+                todas[1].extend(serie_h)
+            self.comparar(total[0].tabla(), todas[0])
+            self.comparar(total[1].tabla(), todas[1])
+
+    def test_csv(self):
+        ruta = os.path.join(self.d, 'datos.csv')
+        serie_t = [round(20 + 8 * math.sin(i / 50), 1) for i in range(3_210)]
+        serie_h = [round(60 + 20 * math.cos(i / 70), 1) for i in range(3_210)]
+        with open(ruta, 'w') as f:
+            f.write('fecha_hora,temperatura,humedad\n')
+            for i, (t, h) in enumerate(zip(serie_t, serie_h)):
+                f.write(f'2025-10-29 00:{i // 60 % 60:02d}:{i % 60:02d},{t},{h}\n')
+        tablas, total = af.analizar([ruta], 1)
+        t, h = tablas['datos.csv']
+        self.comparar(t, serie_t)
+        self.comparar(h, serie_h)
+
+    def test_nombres(self):
+        for sub in ('a', 'b'):
+            os.makedirs(os.path.join(self.d, sub))
+            with open(os.path.join(self.d, sub, 'datos.csv'), 'w') as f:
+                f.write('fecha_hora,temperatura,humedad\n2025-10-29 00:00:00,20.0,50.0\n')
+        a, b = (os.path.join(self.d, s, 'datos.csv') for s in ('a', 'b'))
+        tablas, _ = af.analizar([a, b], 1)
+        self.assertEqual(sorted(tablas), [os.path.join('a', 'datos.csv'), os.path.join('b', 'datos.csv')])
+        self.assertNotEqual(*(af.archivo_tabla(n) for n in tablas))
+        with self.assertRaises(ValueError):
+            af.analizar([a, os.path.join(self.d, 'b', '..', 'a', 'datos.csv')], 1)
+
+        af.generar_almacenes(self.d, 10, 1)
+        with self.assertRaises(ValueError):      # El nodo suelto y dentro del directorio
+            af.analizar([self.d, os.path.join(self.d, 'nodo0000')], 1)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,232 @@
+/*
+ * File: test_dht11.c
+ * Pruebas de la captura por flancos de dht11.c (make test)
+ *
+ * dht11_decode() con periodos armados a mano, y la lectura no bloqueante
+ * entera (start, capture, finish) contra tramas impuestas al DHT11 del
+ * simulador: valida, con jitter, con el reloj del sensor corrido, cortada,
+ * con el checksum mal y sin respuesta. La ISR es la de main.c, con el bus
+ * I2C y la UART ocupados durante la captura.
+ */
+#include <string.h>
+#include "hal.h"
+#include "dht11.h"
+#include "i2c.h"
+#include "sched.h"
+#include "uart.h"
+#include "test.h"
+
+#define CICLOS_MS  5000
+
+static Tarea ninguna[1];
+
+void __interrupt() isr(void)
+{
+    if(INTCONbits.INTE && INTCONbits.INTF) {
+        dht11_isr();
+    }
+    if(SCHED_TICK_PENDIENTE()) {
+        sched_tick_isr();
+    }
+    if(INTCONbits.T0IE && INTCONbits.T0IF) {
+        dht11_desborde();
+    }
+    if(!INTCONbits.PEIE) {
+        return;
+    }
+    if(PIE1bits.SSPIE && PIR1bits.SSPIF) {
+        I2C_Isr();
+    }
+    if(PIE1bits.TXIE && PIR1bits.TXIF) {
+        UART_Isr();
+    }
+}
+
+// ========== DECODIFICACION ==========
+// Periodos en ticks de 0.8 us: respuesta 160 us, '0' 77 us, '1' 120 us
+#define P_RESP  200
+#define P_CERO  96
+#define P_UNO   150
+
+static uint8_t armar(uint8_t *periodo, const uint8_t *datos, int8_t desvio)
+{
+    periodo[0] = P_RESP;
+    for(uint8_t i = 0; i < 40; i++) {
+        uint8_t p = (datos[i >> 3] << (i & 7)) & 0x80 ? P_UNO : P_CERO;
+        periodo[i + 1] = (uint8_t)(p + ((i & 1) ? desvio : -desvio));
+    }
+    return DHT11_FLANCOS;
+}
+
+static void prueba_decode(void)
+{
+    const uint8_t datos[5] = { 55, 0, 23, 0, 78 };
+    uint8_t periodo[DHT11_FLANCOS], leido[5];
+    uint8_t n;
+
+    n = armar(periodo, datos, 0);
+    PRUEBA_IGUAL(dht11_decode(periodo, n, leido), DHT11_OK);
+    PRUEBA(memcmp(leido, datos, 5) == 0);
+
+    // +-20 ticks (16 us) alrededor de cada periodo siguen del lado correcto
+    n = armar(periodo, datos, 20);
+    PRUEBA_IGUAL(dht11_decode(periodo, n, leido), DHT11_OK);
+    PRUEBA(memcmp(leido, datos, 5) == 0);
+
+    PRUEBA_IGUAL(dht11_decode(periodo, 0, leido), DHT11_ERR_RESPUESTA);
+    PRUEBA_IGUAL(dht11_decode(periodo, DHT11_ESPERA, leido), DHT11_ERR_RESPUESTA);
+    PRUEBA_IGUAL(dht11_decode(periodo, 30, leido), DHT11_ERR_TIMEOUT);
+
+    n = armar(periodo, datos, 0);
+    periodo[0] = DHT11_RESP_MIN - 1;
+    PRUEBA_IGUAL(dht11_decode(periodo, n, leido), DHT11_ERR_TIEMPO);
+
+    n = armar(periodo, datos, 0);
+    periodo[17] = DHT11_BIT_MIN - 1;   // Un pulso de ruido
+    PRUEBA_IGUAL(dht11_decode(periodo, n, leido), DHT11_ERR_TIEMPO);
+    periodo[17] = DHT11_BIT_MAX + 1;   // Un flanco perdido
+    PRUEBA_IGUAL(dht11_decode(periodo, n, leido), DHT11_ERR_TIEMPO);
+
+    const uint8_t malo[5] = { 55, 0, 23, 0, 79 };
+    n = armar(periodo, malo, 0);
+    PRUEBA_IGUAL(dht11_decode(periodo, n, leido), DHT11_ERR_CHECKSUM);
+}
+
+// ========== CAPTURA ==========
+static void esperar_ms(uint16_t ms)
+{
+    uint16_t t0 = sched_ticks();
+
+    while((uint16_t)(sched_ticks() - t0) < ms) HAL_ESPERA();
+}
+
+// Rafagas al LCD y tramas por la UART para que el bus y el EUSART tengan
+// interrupciones pendientes durante la captura
+static void trafico(void)
+{
+    static const uint8_t rafaga[40] = { 0 };
+    static const uint8_t trama[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+
+    I2C_Queue_Write(0x4E, rafaga, sizeof(rafaga), 0, 0);
+    I2C_Queue_Write(0x4E, rafaga, sizeof(rafaga), 0, 0);
+    UART_Frame(trama, sizeof(trama));
+}
+
+// Lectura no bloqueante como en tarea_sensor(); deja los bytes en datos
+static uint8_t leer(uint8_t *datos)
+{
+    uint8_t res;
+    uint16_t t0;
+    uint64_t c0;
+
+    dht11_start();
+    esperar_ms(20);
+    trafico();
+    dht11_capture();
+    PRUEBA(!INTCONbits.PEIE);
+    PRUEBA(dht11_capturando());
+
+    // El tick sigue contando con los perifericos apagados, haya flancos o no
+    t0 = sched_ticks();
+    c0 = hal_host_ahora();
+    esperar_ms(10);
+    PRUEBA((hal_host_ahora() - c0) / CICLOS_MS <= 10);
+
+    res = dht11_finish_raw();
+    PRUEBA(INTCONbits.PEIE);
+    PRUEBA(!INTCONbits.T0IE);
+    PRUEBA_IGUAL((uint16_t)(sched_ticks() - t0), 10);
+    dht11_raw(datos);
+    I2C_Flush();
+    return res;
+}
+
+static void prueba_trama(const uint8_t *datos, int bits, uint32_t jitter, uint8_t esperado)
+{
+    uint8_t leido[5];
+
+    hal_host_dht_trama(0, datos, bits, jitter);
+    PRUEBA_IGUAL(leer(leido), esperado);
+    if(esperado == DHT11_OK || esperado == DHT11_ERR_CHECKSUM) {
+        PRUEBA(memcmp(leido, datos, 5) == 0);
+    }
+    esperar_ms(1000);
+}
+
+static void prueba_captura(void)
+{
+    const uint8_t datos[5] = { 61, 0, 24, 0, 85 };
+    const uint8_t malo[5] = { 61, 0, 24, 0, 86 };
+    const uint8_t unos[5] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFC };
+
+    hal_host_dht_escala(0, 1.0);
+    prueba_trama(datos, 40, 2, DHT11_OK);
+    prueba_trama(unos, 40, 2, DHT11_OK);
+
+    // Jitter de +-8 us en cada tramo (el bit '0' queda a ~23 us del umbral)
+    for(uint8_t i = 0; i < 10; i++) {
+        prueba_trama(datos, 40, 8, DHT11_OK);
+    }
+
+    // Reloj del sensor corrido +-8 %
+    hal_host_dht_escala(0, 0.92);
+    prueba_trama(datos, 40, 2, DHT11_OK);
+    hal_host_dht_escala(0, 1.08);
+    prueba_trama(unos, 40, 2, DHT11_OK);
+    hal_host_dht_escala(0, 1.0);
+
+    prueba_trama(datos, 25, 2, DHT11_ERR_TIMEOUT);
+    prueba_trama(datos, 0, 2, DHT11_ERR_TIMEOUT);
+    prueba_trama(malo, 40, 2, DHT11_ERR_CHECKSUM);
+    prueba_trama(NULL, 0, 2, DHT11_ERR_RESPUESTA);
+
+    // Despues de los errores, una lectura normal
+    prueba_trama(datos, 40, 2, DHT11_OK);
+}
+
+// Sin respuesta la captura se corta sola a los ~6 ms: PEIE vuelve antes
+// de dht11_finish_raw() y el programa no queda esperando a la cola I2C
+// (antes I2C_Flush() no volvia nunca)
+static void prueba_sin_respuesta(void)
+{
+    uint64_t c0;
+
+    hal_host_dht_trama(0, NULL, 0, 2);
+    dht11_start();
+    esperar_ms(20);
+    dht11_capture();
+    c0 = hal_host_ahora();
+    while(dht11_capturando()) HAL_ESPERA();
+    PRUEBA((hal_host_ahora() - c0) / CICLOS_MS >= 5);
+    PRUEBA((hal_host_ahora() - c0) / CICLOS_MS < 7);
+    PRUEBA(INTCONbits.PEIE);
+    PRUEBA(!INTCONbits.T0IE);
+    PRUEBA_IGUAL(dht11_finish_raw(), DHT11_ERR_RESPUESTA);
+    esperar_ms(1000);
+
+    hal_host_dht_trama(0, NULL, 0, 2);
+    dht11_start();
+    esperar_ms(20);
+    trafico();
+    dht11_capture();
+    I2C_Flush();
+    PRUEBA(!I2C_Busy());
+    PRUEBA(!dht11_capturando());
+    PRUEBA_IGUAL(dht11_finish_raw(), DHT11_ERR_RESPUESTA);
+    esperar_ms(1000);
+}
+
+int main(void)
+{
+    HAL_INIT();
+    I2C_Init_Master(I2C_100KHZ);
+    UART_Init();
+    dht11_config();
+    sched_init(ninguna, 0);
+    INTCONbits.GIE = 1;
+
+    prueba_decode();
+    prueba_captura();
+    prueba_sin_respuesta();
+    return PRUEBA_FIN();
+}
@@ -0,0 +1,172 @@
+/*
+ * File: test_dht11m.c
+ * Lectura en paralelo de dht11m.c con 4 zonas (make test)
+ *
+ * Cada linea del simulador tiene su reloj corrido (-8 %, 0, +8 %, -4 %) y
+ * su demora de respuesta, asi que los flancos de las cuatro tramas arrancan
+ * casi juntos y se van cruzando a lo largo de la captura. Con todas bien,
+ * con jitter (los relojes exactos), y con una zona sin responder, cortada o con el checksum mal:
+ * cada zona da su estado y sus bytes, y la falla de una no toca a las
+ * otras. El simulador no cobra ciclos por el bucle de muestreo, asi que
+ * el margen de tiempo con muchas zonas no se prueba aca (ver dht11m.h).
+ */
+#include <string.h>
+#include "hal.h"
+#include "dht11m.h"
+#include "sched.h"
+#include "test.h"
+
+#if DHT_ZONAS != 4
+#error "test_dht11m se compila con DHT_ZONAS=4"
+#endif
+
+#define CICLOS_MS  5000
+
+static Tarea ninguna[1];
+
+static const double escala[DHT_ZONAS] = { 0.92, 1.0, 1.08, 0.96 };
+
+void __interrupt() isr(void)
+{
+    if(SCHED_TICK_PENDIENTE()) {
+        sched_tick_isr();
+    }
+}
+
+static void esperar_ms(uint16_t ms)
+{
+    uint16_t t0 = sched_ticks();
+
+    while((uint16_t)(sched_ticks() - t0) < ms) HAL_ESPERA();
+}
+
+// Una lectura como en tarea_sensor(): la trama de cada zona (NULL = no
+// responde) con sus bits, y el estado esperado de cada una
+static void leer(const uint8_t *const *datos, const int *bits, uint32_t jitter,
+                 const uint8_t *esperado)
+{
+    uint8_t leido[5], ok = 0;
+    uint16_t t0;
+    q8_t h, t;
+
+    for(uint8_t z = 0; z < DHT_ZONAS; z++) {
+        hal_host_dht_trama(z, datos[z], bits[z], jitter);
+        if(esperado[z] == DHT11_OK) ok |= 1 << z;
+    }
+    dht11m_start();
+    esperar_ms(20);
+    t0 = sched_ticks();
+    PRUEBA_IGUAL(dht11m_capture(), ok);
+    PRUEBA(INTCONbits.GIE);
+    // El tick se atendio a mano durante la captura
+    PRUEBA((uint16_t)(sched_ticks() - t0) >= 4);
+
+    for(uint8_t z = 0; z < DHT_ZONAS; z++) {
+        // Todos '1': la trama llega bien pero el valor es imposible
+        uint8_t fin = esperado[z];
+
+        if(fin == DHT11_OK && datos[z][0] > DHT11_HUM_MAX) fin = DHT11_ERR_RANGO;
+        PRUEBA_IGUAL(dht11m_estado(z), esperado[z]);
+        PRUEBA_IGUAL(dht11m_finish_fixed(z, &h, &t), fin);
+        PRUEBA_IGUAL(dht11m_estado(z), fin);
+        dht11m_raw(z, leido);
+        if(esperado[z] == DHT11_OK || esperado[z] == DHT11_ERR_CHECKSUM) {
+            PRUEBA(memcmp(leido, datos[z], 5) == 0);
+        }
+        if(fin == DHT11_OK) {
+            PRUEBA_IGUAL(Q8_ENTERO(h), datos[z][0]);
+            PRUEBA_IGUAL(Q8_ENTERO(t), datos[z][2]);
+        }
+    }
+    esperar_ms(1000);
+}
+
+static void prueba_zonas(void)
+{
+    static const uint8_t datos[DHT_ZONAS][5] = {
+        { 61, 0, 24, 0, 85 },
+        { 0xFF, 0xFF, 0xFF, 0xFF, 0xFC },   // Todos '1': los periodos largos
+        { 0, 0, 0, 0, 0 },                  // Todos '0': los cortos
+        { 0x55, 0, 0x2A, 0, 0x7F },         // Alternados
+    };
+    static const int completas[DHT_ZONAS] = { 40, 40, 40, 40 };
+    static const uint8_t bien[DHT_ZONAS] = { DHT11_OK, DHT11_OK, DHT11_OK, DHT11_OK };
+    const uint8_t *trama[DHT_ZONAS];
+    uint8_t malo[5], esperado[DHT_ZONAS];
+    int bits[DHT_ZONAS];
+
+    for(uint8_t z = 0; z < DHT_ZONAS; z++) {
+        hal_host_dht_escala(z, escala[z]);
+        trama[z] = datos[z];
+    }
+    // Cada vez con otra demora de respuesta en cada linea
+    for(uint8_t i = 0; i < 10; i++) {
+        leer(trama, completas, 2, bien);
+    }
+
+    // Jitter de +-8 us en cada tramo de las cuatro lineas, con los relojes
+    // exactos como en test_dht11.c (con +-8 % y +-8 us un '0' sale de rango)
+    for(uint8_t z = 0; z < DHT_ZONAS; z++) {
+        hal_host_dht_escala(z, 1.0);
+    }
+    for(uint8_t i = 0; i < 10; i++) {
+        leer(trama, completas, 8, bien);
+    }
+    for(uint8_t z = 0; z < DHT_ZONAS; z++) {
+        hal_host_dht_escala(z, escala[z]);
+    }
+
+    // Las mismas tramas rotadas: cada dato con otro reloj
+    for(uint8_t r = 1; r < DHT_ZONAS; r++) {
+        for(uint8_t z = 0; z < DHT_ZONAS; z++) {
+            trama[z] = datos[(z + r) % DHT_ZONAS];
+        }
+        leer(trama, completas, 4, bien);
+    }
+
+    // Una zona con cada falla; las demas se leen igual
+    for(uint8_t mala = 0; mala < DHT_ZONAS; mala++) {
+        for(uint8_t falla = 0; falla < 3; falla++) {
+            for(uint8_t z = 0; z < DHT_ZONAS; z++) {
+                trama[z] = datos[z];
+                bits[z] = 40;
+                esperado[z] = DHT11_OK;
+            }
+            if(falla == 0) {
+                trama[mala] = NULL;
+                esperado[mala] = DHT11_ERR_RESPUESTA;
+            } else if(falla == 1) {
+                bits[mala] = 25;   // El sensor suelta la linea a mitad de trama
+                esperado[mala] = DHT11_ERR_TIMEOUT;
+            } else {
+                memcpy(malo, datos[mala], 5);
+                malo[4] ^= 0x01;
+                trama[mala] = malo;
+                esperado[mala] = DHT11_ERR_CHECKSUM;
+            }
+            leer(trama, bits, 2, esperado);
+        }
+    }
+
+    // Ninguna responde, y despues todas bien otra vez
+    for(uint8_t z = 0; z < DHT_ZONAS; z++) {
+        trama[z] = NULL;
+        esperado[z] = DHT11_ERR_RESPUESTA;
+    }
+    leer(trama, completas, 2, esperado);
+    for(uint8_t z = 0; z < DHT_ZONAS; z++) {
+        trama[z] = datos[z];
+    }
+    leer(trama, completas, 2, bien);
+}
+
+int main(void)
+{
+    HAL_INIT();
+    dht11m_config();
+    sched_init(ninguna, 0);
+    INTCONbits.GIE = 1;
+
+    prueba_zonas();
+    return PRUEBA_FIN();
+}
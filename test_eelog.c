@@ -0,0 +1,229 @@
+/*
+ * File: test_eelog.c
+ * Recuperacion del historial de eelog.c tras un corte de energia (make test)
+ *
+ * Una corrida de referencia graba una serie larga (deltas chicos y
+ * medianos, saltos, huecos, marcas salteadas, corridas, el anillo dando la
+ * vuelta) y
+ * anota cuantos bytes lleva grabados cada lectura. Despues se repite la
+ * serie cortando la energia en cada uno de esos bytes: eelog_init() tiene
+ * que encontrar exactamente las lecturas terminadas antes del corte (mas,
+ * a lo sumo, la que estaba grabandose), sin lecturas fantasma, y seguir
+ * agregando detras de ellas.
+ */
+#include <string.h>
+#include "hal.h"
+#include "eeprom.h"
+#include "eelog.h"
+#include "test.h"
+
+#define PASOS     400
+#define LECTURAS  (PASOS * 4)
+
+typedef struct {
+    uint8_t hueco;
+    uint16_t marca;
+    muestra_t t, h;
+} Paso;
+
+typedef struct {
+    uint16_t marca;
+    muestra_t t, h;
+} Lectura;
+
+static Paso serie[PASOS];
+static unsigned long escritas[PASOS + 1];   // Bytes grabados al terminar cada paso
+static uint16_t hechas[PASOS + 1];          // Lecturas entregadas hasta cada paso
+static uint16_t en_log[PASOS + 1];          // eelog_total() en la referencia
+
+static Lectura ref[LECTURAS];
+static Lectura leido[LECTURAS];
+static uint16_t n_leido;
+
+void __interrupt() isr(void)
+{
+    if(PIE2bits.EEIE && PIR2bits.EEIF) {
+        EEPROM_Isr();
+    }
+}
+
+static void anotar(uint16_t marca, muestra_t t, muestra_t h)
+{
+    leido[n_leido].marca = marca;
+    leido[n_leido].t = t;
+    leido[n_leido].h = h;
+    n_leido++;
+}
+
+static void releer(uint16_t ultimas)
+{
+    n_leido = 0;
+    eelog_replay(ultimas, anotar);
+}
+
+// Serie determinista para cada semilla. Con repetir, algunos pasos repiten la lectura
+// anterior (corridas de logpack.c)
+static void armar(uint32_t azar, uint8_t repetir)
+{
+    int16_t t = 22 * MUESTRA_ESCALA, h = 60 * MUESTRA_ESCALA;
+    uint16_t marca = 1000;
+
+    for(uint16_t i = 0; i < PASOS; i++) {
+        int16_t t0 = t, h0 = h;
+        uint8_t r;
+
+        azar = azar * 1103515245UL + 12345;
+        r = (azar >> 16) & 0xFF;
+        serie[i].hueco = 0;
+        if(i % 37 == 36) {
+            serie[i].hueco = 1 + r % 5;
+        } else if(i % 53 == 52) {
+            marca += 50;   // Corte o reloj puesto en hora
+        }
+        marca += serie[i].hueco;
+
+        if(repetir && r < 100) {
+            // Sin cambio
+        } else if(r < 180) {
+            t += (int8_t)(r % 3) - 1;
+            h += (int8_t)((r / 3) % 3) - 1;
+        } else if(r < 240) {
+            t += (int8_t)(r % 11) - 5;
+            h += (int8_t)((r / 11) % 11) - 5;
+        } else {
+            t += (r & 1) ? 20 : -20;
+        }
+        if(!repetir && t == t0 && h == h0) h++;
+        if(t < 0) t += 40;
+        if(t > 60 * MUESTRA_ESCALA) t -= 40;
+        if(h < 20 * MUESTRA_ESCALA) h += 30;
+        if(h > 95 * MUESTRA_ESCALA) h -= 30;
+        serie[i].marca = marca++;
+        serie[i].t = (muestra_t)t;
+        serie[i].h = (muestra_t)h;
+    }
+}
+
+static void grabar(uint16_t i)
+{
+    eelog_append_hueco(serie[i].hueco, serie[i].marca, serie[i].t, serie[i].h);
+}
+
+static void arrancar_vacia(void)
+{
+    EEPROM_Flush();
+    hal_host_ee_borrar();
+    eelog_init();
+}
+
+// Serie entera sin cortes: las lecturas de referencia, con las de los
+// huecos ya reconstruidas
+static void referencia(void)
+{
+    unsigned long w0;
+
+    arrancar_vacia();
+    w0 = hal_host_ee_escrituras();
+    escritas[0] = 0;
+    hechas[0] = 0;
+    en_log[0] = 0;
+    for(uint16_t i = 0; i < PASOS; i++) {
+        grabar(i);
+        EEPROM_Flush();
+        escritas[i + 1] = hal_host_ee_escrituras() - w0;
+        releer(serie[i].hueco + 1);
+        memcpy(&ref[hechas[i]], leido, n_leido * sizeof(Lectura));
+        hechas[i + 1] = hechas[i] + n_leido;
+        en_log[i + 1] = eelog_total();
+    }
+    // El final de cada paso es el valor grabado
+    for(uint16_t i = 0; i < PASOS; i++) {
+        PRUEBA_IGUAL(ref[hechas[i + 1] - 1].marca, serie[i].marca);
+        PRUEBA_IGUAL(ref[hechas[i + 1] - 1].t, serie[i].t);
+        PRUEBA_IGUAL(ref[hechas[i + 1] - 1].h, serie[i].h);
+    }
+}
+
+// Corta despues de `corte` bytes y reinicia: lo recuperado es un tramo de
+// la referencia que termina en el ultimo paso completo o en el siguiente
+static void cortar(unsigned long corte)
+{
+    uint16_t paso, fin, n, min;
+    Lectura ultima;
+    const muestra_t nt = 30 * MUESTRA_ESCALA, nh = 40 * MUESTRA_ESCALA;
+
+    arrancar_vacia();
+    hal_host_ee_corte((long)corte);
+    for(uint16_t i = 0; i < PASOS; i++) {
+        grabar(i);
+    }
+    EEPROM_Flush();
+    hal_host_ee_corte(-1);
+
+    eelog_init();
+    releer(LECTURAS);
+    n = n_leido;
+    PRUEBA_IGUAL(n, eelog_total());
+
+    for(paso = 0; paso < PASOS && escritas[paso + 1] <= corte; paso++);
+    if(n == 0) {
+        PRUEBA_IGUAL(hechas[paso], 0);
+        return;
+    }
+    fin = hechas[paso];
+    if(paso < PASOS && leido[n - 1].marca == serie[paso].marca) {
+        fin = hechas[paso + 1];
+    }
+    if(fin < n || memcmp(leido, &ref[fin - n], n * sizeof(Lectura)) != 0) {
+        printf("corte en el byte %lu (paso %u): %u lecturas no siguen a la referencia\n",
+               corte, paso, n);
+        PRUEBA(0);
+        return;
+    }
+    // Se pierde a lo sumo el bloque mas viejo, si el corte lo agarro
+    // pisandolo para abrir uno nuevo
+    min = en_log[paso];
+    if(paso < PASOS && en_log[paso + 1] - serie[paso].hueco - 1 < min) {
+        min = en_log[paso + 1] - serie[paso].hueco - 1;
+    }
+    PRUEBA(n >= min);
+
+    // Se sigue grabando detras de lo recuperado, y sobrevive otro reinicio
+    ultima = leido[n - 1];
+    eelog_append(nt, nh);
+    eelog_append(nt + 1, nh);
+    EEPROM_Flush();
+    eelog_init();
+    releer(3);
+    PRUEBA(n_leido == 3 && memcmp(&leido[0], &ultima, sizeof(Lectura)) == 0);
+    PRUEBA(leido[1].marca == (uint16_t)(ultima.marca + 1) && leido[1].t == nt);
+    PRUEBA(leido[2].marca == (uint16_t)(ultima.marca + 2) && leido[2].t == nt + 1);
+}
+
+static void prueba_cortes(uint32_t semilla, uint8_t repetir)
+{
+    unsigned fallas;
+
+    armar(semilla, repetir);
+    referencia();
+    PRUEBA(en_log[PASOS] < hechas[PASOS]);   // El anillo dio la vuelta
+
+    fallas = prueba_fallas;
+    for(unsigned long c = 0; c <= escritas[PASOS] && prueba_fallas - fallas < 10; c++) {
+        cortar(c);
+    }
+}
+
+int main(void)
+{
+    HAL_INIT();
+    INTCONbits.PEIE = 1;
+    INTCONbits.GIE = 1;
+
+    // Varias series: cada bloque que se abre es otra cabecera a medio pisar
+    for(uint32_t semilla = 1; semilla <= 8; semilla++) {
+        prueba_cortes(semilla * 12345, 0);
+        prueba_cortes(semilla * 12345, 1);   // Con corridas (logpack.c)
+    }
+    return PRUEBA_FIN();
+}
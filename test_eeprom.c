@@ -0,0 +1,162 @@
+/*
+ * File: test_eeprom.c
+ * Cola de escrituras de eeprom.c sobre la EEPROM del simulador (make test)
+ *
+ * El simulador hace de EECON1/EEDAT: cada byte tarda 4 ms desde WR y
+ * termina con EEIF. Se comprueba que EEPROM_Write() no espera, que los
+ * bytes se graban en orden desde la ISR, que EEPROM_Read() ve lo encolado,
+ * la cola llena, la cola sin GIE y, al final, una tanda larga de
+ * escrituras y lecturas al azar contra una copia en RAM.
+ */
+#include <string.h>
+#include "hal.h"
+#include "eeprom.h"
+#include "test.h"
+
+#define CICLOS_MS  5000
+
+static uint8_t copia[EEPROM_TAMANO];
+
+void __interrupt() isr(void)
+{
+    if(PIE2bits.EEIE && PIR2bits.EEIF) {
+        EEPROM_Isr();
+    }
+}
+
+static void esperar_us(uint32_t us)
+{
+    __delay_us(us);
+}
+
+// Encolar no espera; la ISR graba un byte cada 4 ms, en orden
+static void prueba_sin_espera(void)
+{
+    const uint8_t datos[4] = { 0x11, 0x22, 0x33, 0x44 };
+    uint64_t t0 = hal_host_ahora();
+    unsigned long w0 = hal_host_ee_escrituras();
+
+    for(uint8_t i = 0; i < 4; i++) {
+        EEPROM_Write(0x10 + i, datos[i]);
+    }
+    PRUEBA_IGUAL(hal_host_ahora(), t0);
+    PRUEBA(EEPROM_Busy());
+    PRUEBA(PIE2bits.EEIE);
+    PRUEBA(INTCONbits.GIE);
+
+    // Lo encolado se lee antes de grabarse
+    for(uint8_t i = 0; i < 4; i++) {
+        PRUEBA_IGUAL(EEPROM_Read(0x10 + i), datos[i]);
+    }
+
+    // A los 4.5 ms el primero esta en la celda y el segundo en curso
+    esperar_us(4500);
+    PRUEBA_IGUAL(hal_host_ee_escrituras() - w0, 1);
+    esperar_us(4000);
+    PRUEBA_IGUAL(hal_host_ee_escrituras() - w0, 2);
+
+    EEPROM_Flush();
+    PRUEBA_IGUAL(hal_host_ee_escrituras() - w0, 4);
+    PRUEBA((hal_host_ahora() - t0) / CICLOS_MS <= 17);
+    PRUEBA(!EEPROM_Busy());
+    PRUEBA(!PIE2bits.EEIE);
+    PRUEBA(!WREN);
+    for(uint8_t i = 0; i < 4; i++) {
+        PRUEBA_IGUAL(EEPROM_Read(0x10 + i), datos[i]);
+    }
+}
+
+// Dos escrituras pendientes a la misma direccion: manda la ultima
+static void prueba_misma_direccion(void)
+{
+    EEPROM_Write(0x20, 0xAA);
+    EEPROM_Write(0x21, 0x01);
+    EEPROM_Write(0x20, 0xBB);
+    PRUEBA_IGUAL(EEPROM_Read(0x20), 0xBB);
+    EEPROM_Flush();
+    PRUEBA_IGUAL(EEPROM_Read(0x20), 0xBB);
+    PRUEBA_IGUAL(EEPROM_Read(0x21), 0x01);
+}
+
+// La cola guarda EEPROM_COLA_LEN - 1 bytes: el siguiente espera que se
+// grabe uno
+static void prueba_llena(void)
+{
+    uint64_t t0 = hal_host_ahora();
+
+    for(uint8_t i = 0; i < EEPROM_COLA_LEN - 1; i++) {
+        EEPROM_Write(0x30 + i, i);
+    }
+    PRUEBA_IGUAL(hal_host_ahora(), t0);
+    EEPROM_Write(0x30 + EEPROM_COLA_LEN - 1, 0x77);
+    PRUEBA((hal_host_ahora() - t0) / CICLOS_MS >= 3);
+    PRUEBA((hal_host_ahora() - t0) / CICLOS_MS <= 4);
+    EEPROM_Flush();
+    for(uint8_t i = 0; i < EEPROM_COLA_LEN - 1; i++) {
+        PRUEBA_IGUAL(EEPROM_Read(0x30 + i), i);
+    }
+    PRUEBA_IGUAL(EEPROM_Read(0x30 + EEPROM_COLA_LEN - 1), 0x77);
+}
+
+// Con GIE apagado (arranque) la cola se atiende mirando EEIF
+static void prueba_sin_gie(void)
+{
+    INTCONbits.GIE = 0;
+    for(uint8_t i = 0; i < 2 * EEPROM_COLA_LEN; i++) {
+        EEPROM_Write(0x40 + i, 0x80 + i);
+    }
+    EEPROM_Flush();
+    PRUEBA(!INTCONbits.GIE);
+    INTCONbits.GIE = 1;
+    for(uint8_t i = 0; i < 2 * EEPROM_COLA_LEN; i++) {
+        PRUEBA_IGUAL(EEPROM_Read(0x40 + i), 0x80 + i);
+    }
+}
+
+// Escrituras, lecturas y esperas al azar contra la copia; al final las 256
+// celdas tienen que ser la copia
+static void prueba_azar(void)
+{
+    uint32_t azar = 1;
+    unsigned fallas = prueba_fallas;
+
+    for(uint8_t a = 0; ; a++) {
+        copia[a] = EEPROM_Read(a);
+        if(a == EEPROM_TAMANO - 1) break;
+    }
+    for(uint16_t i = 0; i < 20000 && prueba_fallas - fallas < 10; i++) {
+        uint8_t r, a;
+
+        azar = azar * 1103515245UL + 12345;
+        r = (azar >> 16) & 0xFF;
+        a = (azar >> 24) & 0x3F;   // Pocas direcciones: muchas repetidas en la cola
+        if(r < 120) {
+            EEPROM_Write(a, r ^ (uint8_t)i);
+            copia[a] = r ^ (uint8_t)i;
+        } else if(r < 240) {
+            PRUEBA_IGUAL(EEPROM_Read(a), copia[a]);
+        } else {
+            esperar_us(500 * (r - 239));
+        }
+    }
+    EEPROM_Flush();
+    for(uint8_t a = 0; ; a++) {
+        PRUEBA_IGUAL(EEPROM_Read(a), copia[a]);
+        if(a == EEPROM_TAMANO - 1) break;
+    }
+    PRUEBA_IGUAL(prueba_fallas, fallas);
+}
+
+int main(void)
+{
+    HAL_INIT();
+    INTCONbits.PEIE = 1;   // Lo hacen los *_Init en main.c; EEPROM_Write no lo toca
+    INTCONbits.GIE = 1;
+
+    prueba_sin_espera();
+    prueba_misma_direccion();
+    prueba_llena();
+    prueba_sin_gie();
+    prueba_azar();
+    return PRUEBA_FIN();
+}
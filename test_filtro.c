@@ -0,0 +1,163 @@
+/*
+ * File: test_filtro.c
+ * Adquisicion con fallas inyectadas: sensor y filtro de picos (make test)
+ *
+ * Cada paso es una lectura entera del sensor simulado (sensor_* como en
+ * tarea_sensor()) con la trama forzada: bien, con un pico de checksum
+ * correcto, sin respuesta, cortada a mitad de trama o con un bit
+ * invertido. Las fallas tienen que dar su DHT11_ERR_* y no entrar en la
+ * ventana del filtro, como en lectura_fallida(); la lectura siguiente se
+ * arranca a SENSOR_RECUPERACION_MS. Las validas pasan por filtro_paso() y
+ * se compara lo que sale con el valor esperado: los picos salen
+ * reemplazados por la mediana, el ruido y los escalones confirmados
+ * pasan. Se corre una vez por sensor (test_filtro y test_filtro_dht22).
+ */
+#include "hal.h"
+#include "sensor.h"
+#include "filtro.h"
+#include "sched.h"
+#include "test.h"
+
+#define BIEN       0
+#define NADA       1   // El sensor no responde
+#define CORTADA    2   // Suelta la linea a mitad de trama
+#define CHECKSUM   3   // Un bit de datos invertido
+
+static Tarea ninguna[1];
+
+void __interrupt() isr(void)
+{
+    if(INTCONbits.INTE && INTCONbits.INTF) {
+        sensor_isr();
+    }
+    if(SCHED_TICK_PENDIENTE()) {
+        sched_tick_isr();
+    }
+    if(INTCONbits.T0IE && INTCONbits.T0IF) {
+        sensor_desborde();
+    }
+}
+
+typedef struct {
+    uint8_t falla;
+    uint8_t hum, tem;           // Lo que mide el sensor (% y C enteros)
+    uint8_t hum_sal, tem_sal;   // Lo que tiene que salir del filtro
+} Paso;
+
+// Trama con checksum de hum % y tem C en el formato del sensor compilado
+static void armar(uint8_t *d, uint8_t hum, uint8_t tem)
+{
+#ifdef SENSOR_DHT22
+    uint16_t h = hum * 10, t = tem * 10;
+
+    d[0] = h >> 8;
+    d[1] = h & 0xFF;
+    d[2] = t >> 8;
+    d[3] = t & 0xFF;
+#else
+    d[0] = hum;
+    d[1] = 0;
+    d[2] = tem;
+    d[3] = 0;
+#endif
+    d[4] = d[0] + d[1] + d[2] + d[3];
+}
+
+static void esperar_ms(uint16_t ms)
+{
+    uint16_t t0 = sched_ticks();
+
+    while((uint16_t)(sched_ticks() - t0) < ms) HAL_ESPERA();
+}
+
+static void leer(const Paso *p)
+{
+    static const uint8_t res_falla[] = {
+        DHT11_OK, DHT11_ERR_RESPUESTA, DHT11_ERR_TIMEOUT, DHT11_ERR_CHECKSUM
+    };
+    uint8_t d[5], res;
+    q8_t h, t, h_sal, t_sal;
+
+    armar(d, p->hum, p->tem);
+    if(p->falla == CHECKSUM) d[2] ^= 0x01;
+    hal_host_dht_trama(0, p->falla == NADA ? NULL : d, p->falla == CORTADA ? 25 : 40, 2);
+    sensor_start();
+    esperar_ms(SENSOR_ARRANQUE_MS);
+    sensor_capture();
+    esperar_ms(10);
+    res = sensor_finish(&h, &t);
+    PRUEBA_IGUAL(res, res_falla[p->falla]);
+    if(res != DHT11_OK) {
+        esperar_ms(SENSOR_RECUPERACION_MS);   // Reintento
+        return;
+    }
+
+    filtro_paso(&h, &t);
+    armar(d, p->hum_sal, p->tem_sal);
+    sensor_convertir(d, &h_sal, &t_sal);
+    PRUEBA_IGUAL(h, h_sal);
+    PRUEBA_IGUAL(t, t_sal);
+    esperar_ms(2 * SENSOR_RECUPERACION_MS);
+}
+
+static void correr(const Paso *pasos, uint8_t n)
+{
+    filtro_init();
+    for(uint8_t i = 0; i < n; i++) {
+        leer(&pasos[i]);
+    }
+}
+
+// Umbrales de filtro.h: 2 C y 5 %
+static void prueba_picos(void)
+{
+    static const Paso pasos[] = {
+        { BIEN, 60, 23, 60, 23 },       // Las dos primeras pasan sin filtrar
+        { BIEN, 60, 23, 60, 23 },
+        { BIEN, 60, 35, 60, 23 },       // Pico de temperatura
+        { BIEN, 60, 23, 60, 23 },
+        { BIEN, 85, 23, 60, 23 },       // Pico de humedad
+        { BIEN, 61, 24, 61, 24 },       // Ruido dentro del umbral
+        { NADA, 0, 0 },
+        { BIEN, 61, 36, 61, 24 },       // Pico despues de una falla
+        { CORTADA, 61, 24 },
+        { CHECKSUM, 61, 24 },
+        { BIEN, 61, 24, 61, 24 },
+        { BIEN, 61, 24, 61, 24 },
+        { BIEN, 61, 30, 61, 24 },       // Escalon: llega una lectura tarde
+        { BIEN, 61, 30, 61, 30 },
+        { CHECKSUM, 61, 30 },
+        { BIEN, 70, 30, 61, 30 },       // Escalon de humedad
+        { NADA, 0, 0 },
+        { BIEN, 70, 31, 70, 31 },
+    };
+
+    correr(pasos, sizeof(pasos) / sizeof(pasos[0]));
+}
+
+// filtro_init() vacia la ventana: tras reiniciar no queda nada de antes
+static void prueba_init(void)
+{
+    static const Paso pasos[] = {
+        { NADA, 0, 0 },
+        { BIEN, 60, 40, 60, 40 },
+        { CORTADA, 60, 40 },
+        { BIEN, 60, 23, 60, 23 },
+        { BIEN, 60, 40, 60, 40 },       // Mediana de 40, 23 y 40
+    };
+
+    correr(pasos, sizeof(pasos) / sizeof(pasos[0]));
+}
+
+int main(void)
+{
+    HAL_INIT();
+    sensor_config();
+    sched_init(ninguna, 0);
+    INTCONbits.PEIE = 1;
+    INTCONbits.GIE = 1;
+
+    prueba_picos();
+    prueba_init();
+    return PRUEBA_FIN();
+}
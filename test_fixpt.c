@@ -0,0 +1,162 @@
+/*
+ * File: test_fixpt.c
+ * Punto fijo Q8.8 contra las formulas en float de USE_FLOAT (make test)
+ *
+ * Recorre todas las tramas posibles del sensor elegido (sensor.h) y las
+ * sumas de la tendencia: la conversion, el redondeo a muestra_t y la parte
+ * entera de los LEDs dan lo mismo que con float; los umbrales de tendencia
+ * tambien, salvo justo en el umbral, donde float redondea. Se compila una
+ * vez por sensor (test_fixpt y test_fixpt_dht22).
+ */
+#include "hal.h"
+#include "sensor.h"
+#include "stats.h"
+#include "test.h"
+
+void __interrupt() isr(void)
+{
+}
+
+// Las formulas de USE_FLOAT en fixpt.h y el dht11_finish() de float
+static muestra_t muestra_float(float v)
+{
+    return (muestra_t)(v * MUESTRA_ESCALA + (v < 0 ? -0.5f : 0.5f));
+}
+
+static float leido_float(const uint8_t *d)
+{
+#ifdef SENSOR_DHT22
+    float v = (float)(((uint16_t)(d[0] & 0x7F) << 8) | d[1]) / 10.0;
+
+    return (d[0] & 0x80) ? -v : v;
+#else
+    return ((float)d[0]) + ((float)d[1]) / 10.0;
+#endif
+}
+
+// Una lectura en los dos caminos: misma muestra, misma parte entera y a
+// menos de 1/256 del valor exacto
+static void comparar(const uint8_t *d, q8_t q)
+{
+    float f = leido_float(d);
+    float dif = (float)q / Q8_UNO - f;
+
+    PRUEBA_IGUAL(MUESTRA_DE_VALOR(q), muestra_float(f));
+    PRUEBA_IGUAL(VALOR_ENTERO(q), (int16_t)f);
+    PRUEBA(dif > -1.0f / Q8_UNO && dif < 1.0f / Q8_UNO);
+}
+
+static void prueba_conversion(void)
+{
+    uint8_t d[5] = { 0 };
+    q8_t h, t;
+    unsigned fallas = prueba_fallas;
+
+#ifdef SENSOR_DHT22
+    // Decimas de 0 a 100.0 % y de -40.0 a 80.0 C
+    for(uint16_t x = 0; x <= DHT22_HUM_MAX; x++) {
+        d[0] = x >> 8;
+        d[1] = x & 0xFF;
+        d[2] = 0x80 | (x > 400 ? 0 : x) >> 8;
+        d[3] = (x > 400 ? 0 : x) & 0xFF;
+        PRUEBA_IGUAL(sensor_convertir(d, &h, &t), DHT11_OK);
+        comparar(&d[0], h);
+        comparar(&d[2], t);
+        d[2] = (x > DHT22_TEMP_MAX ? 0 : x) >> 8;
+        d[3] = (x > DHT22_TEMP_MAX ? 0 : x) & 0xFF;
+        PRUEBA_IGUAL(sensor_convertir(d, &h, &t), DHT11_OK);
+        comparar(&d[2], t);
+    }
+#else
+    // Todas las humedades y temperaturas posibles con todas las decimas
+    for(uint8_t e = 0; e <= DHT11_HUM_MAX; e++) {
+        for(uint8_t dec = 0; dec <= DHT11_DECIMAS_MAX; dec++) {
+            d[0] = e;
+            d[1] = d[3] = dec;
+            d[2] = e > DHT11_TEMP_MAX ? 0 : e;
+            PRUEBA_IGUAL(sensor_convertir(d, &h, &t), DHT11_OK);
+            comparar(&d[0], h);
+            comparar(&d[2], t);
+        }
+    }
+#endif
+    PRUEBA_IGUAL(prueba_fallas, fallas);
+}
+
+// La tendencia es la diferencia de dos promedios de STATS_TENDENCIA
+// muestras; main.c y muestreo.c la comparan con 1 y 2 grados
+static int umbrales(valor_t v)
+{
+    return (v > VALOR_DE_ENTERO(2)) * 4 + (v > VALOR_DE_ENTERO(1)) * 2 +
+           (v < -VALOR_DE_ENTERO(1)) - (v < -VALOR_DE_ENTERO(2)) * 8;
+}
+
+static int umbrales_float(float v)
+{
+    return (v > 2.0f) * 4 + (v > 1.0f) * 2 + (v < -1.0f) - (v < -2.0f) * 8;
+}
+
+// Con la diferencia exacta de las sumas: (rec - ant) / n > k
+static int umbrales_exactos(int32_t dif, int32_t n)
+{
+    return (dif > 2 * n) * 4 + (dif > n) * 2 + (dif < -n) - (dif < -2 * n) * 8;
+}
+
+// Q8.8 decide como la aritmetica exacta. float decide igual salvo cuando
+// la diferencia es justo 1 o 2 grados: ahi el redondeo de las dos
+// divisiones la deja de cualquier lado del umbral
+static void prueba_tendencia(void)
+{
+    const int32_t n = STATS_TENDENCIA * MUESTRA_ESCALA;
+    const int32_t tope = STATS_TENDENCIA * 60 * MUESTRA_ESCALA;   // 0..60 grados
+    const int32_t paso = MUESTRA_ESCALA == 10 ? 7 : 1;
+    unsigned fallas = prueba_fallas;
+
+    for(int32_t rec = 0; rec <= tope; rec += paso) {
+        for(int32_t ant = 0; ant <= tope; ant += paso) {
+            valor_t q = VALOR_PROMEDIO(rec, n) - VALOR_PROMEDIO(ant, n);
+            float f = (float)rec / n - (float)ant / n;
+            int32_t dif = rec - ant;
+            int exacto = umbrales_exactos(dif, n);
+
+            PRUEBA_IGUAL(umbrales(q), exacto);
+            if(dif != n && dif != -n && dif != 2 * n && dif != -2 * n) {
+                PRUEBA_IGUAL(umbrales_float(f), exacto);
+            }
+        }
+    }
+    PRUEBA_IGUAL(prueba_fallas, fallas);
+
+    // stats_tendencia() sobre muestras empujadas de a una
+    static const muestra_t serie[] = { 20, 20, 21, 23, 24, 24, 22, 19, 18, 18 };
+    float suma[2] = { 0, 0 };
+
+    stats_init();
+    for(uint8_t i = 0; i < sizeof(serie) / sizeof(serie[0]); i++) {
+        muestra_t m = serie[i] * MUESTRA_ESCALA + (i & 1) * (MUESTRA_ESCALA - 1);
+
+        stats_push(m, 50);
+        if(i >= 2 * STATS_TENDENCIA - 1) {
+            suma[0] = suma[1] = 0;
+            for(uint8_t j = 0; j < STATS_TENDENCIA; j++) {
+                uint8_t a = i - 2 * STATS_TENDENCIA + 1 + j;
+                uint8_t r = a + STATS_TENDENCIA;
+
+                suma[0] += serie[a] * MUESTRA_ESCALA + (a & 1) * (MUESTRA_ESCALA - 1);
+                suma[1] += serie[r] * MUESTRA_ESCALA + (r & 1) * (MUESTRA_ESCALA - 1);
+            }
+            float f = (suma[1] - suma[0]) / n;
+            float dif = (float)stats_tendencia() / Q8_UNO - f;
+
+            PRUEBA(dif > -2.0f / Q8_UNO && dif < 2.0f / Q8_UNO);
+            PRUEBA_IGUAL(umbrales(stats_tendencia()), umbrales_float(f));
+        }
+    }
+}
+
+int main(void)
+{
+    prueba_conversion();
+    prueba_tendencia();
+    return PRUEBA_FIN();
+}
@@ -0,0 +1,118 @@
+/*
+ * File: test_fmt.c
+ * Campos de fmt.c contra snprintf (make test)
+ *
+ * La referencia es lo que daba el sprintf de antes, alineado a la derecha
+ * en el ancho del campo: "%*u" / "%*d", las decimas como "%d.%d" con el
+ * signo adelante, y si no entra, sin el decimal y despues asteriscos.
+ * Se recorren todos los uint16_t (fmt_natural) y todos los int16_t
+ * (fmt_entero, fmt_decimas) con anchos de 1 a 8, y fmt_dos de 0 a 255.
+ * Cada campo se escribe entre bytes de guarda: fmt no escribe fuera de
+ * sus `ancho` caracteres y retorna p + ancho.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "fmt.h"
+#include "test.h"
+
+#define ANCHO_MAX  8
+#define GUARDA     0x5A
+
+// El campo de referencia en ref (con terminador)
+static void referencia(char *ref, const char *s, const char *sin_decimal, uint8_t ancho)
+{
+    if(strlen(s) > ancho && sin_decimal) s = sin_decimal;
+    if(strlen(s) > ancho) {
+        memset(ref, '*', ancho);
+        ref[ancho] = 0;
+    } else {
+        sprintf(ref, "%*s", ancho, s);
+    }
+}
+
+typedef char *(*Campo)(char *p, int32_t v, uint8_t ancho);
+
+static char *campo_natural(char *p, int32_t v, uint8_t ancho)
+{
+    return fmt_natural(p, (uint16_t)v, ancho);
+}
+
+static char *campo_entero(char *p, int32_t v, uint8_t ancho)
+{
+    return fmt_entero(p, (int16_t)v, ancho);
+}
+
+static char *campo_decimas(char *p, int32_t v, uint8_t ancho)
+{
+    return fmt_decimas(p, (int16_t)v, ancho);
+}
+
+// Escribe con f entre guardas y compara con ref; retorna 1 si coincide
+static int coincide(Campo f, int32_t v, uint8_t ancho, const char *ref)
+{
+    char buf[ANCHO_MAX + 2];
+    char *fin;
+
+    memset(buf, GUARDA, sizeof(buf));
+    fin = f(&buf[1], v, ancho);
+    return fin == &buf[1 + ancho] && buf[0] == GUARDA && buf[1 + ancho] == GUARDA &&
+           memcmp(&buf[1], ref, ancho) == 0;
+}
+
+static void prueba(const char *nombre, Campo f, int32_t desde, int32_t hasta, uint8_t decimas)
+{
+    char s[16], sin[16], ref[ANCHO_MAX + 1];
+    unsigned long casos = 0, distintos = 0;
+
+    for(int32_t v = desde; v <= hasta; v++) {
+        uint32_t a = v < 0 ? -v : v;
+        const char *signo = v < 0 ? "-" : "";
+
+        if(decimas) {
+            sprintf(s, "%s%lu.%lu", signo, (unsigned long)(a / 10), (unsigned long)(a % 10));
+            sprintf(sin, "%s%lu", signo, (unsigned long)(a / 10));
+        } else {
+            sprintf(s, "%ld", (long)v);
+        }
+        for(uint8_t ancho = 1; ancho <= ANCHO_MAX; ancho++) {
+            referencia(ref, s, decimas ? sin : NULL, ancho);
+            casos++;
+            if(!coincide(f, v, ancho, ref)) {
+                if(distintos++ < 5) printf("%s(%ld, %u): distinto de \"%s\"\n", nombre, (long)v, ancho, ref);
+            }
+        }
+    }
+    PRUEBA_IGUAL(distintos, 0);
+    printf("%s: %lu casos\n", nombre, casos);
+}
+
+static void prueba_dos(void)
+{
+    char buf[4], ref[4];
+
+    for(uint16_t v = 0; v < 256; v++) {
+        memset(buf, GUARDA, sizeof(buf));
+        if(v > 99) {
+            strcpy(ref, "**");
+        } else {
+            sprintf(ref, "%02u", v);
+        }
+        PRUEBA(fmt_dos(&buf[1], (uint8_t)v) == &buf[3]);
+        PRUEBA(memcmp(&buf[1], ref, 2) == 0 && buf[0] == GUARDA && buf[3] == GUARDA);
+    }
+}
+
+int main(void)
+{
+    char buf[8];
+
+    prueba("fmt_natural", campo_natural, 0, 65535, 0);
+    prueba("fmt_entero", campo_entero, -32768, 32767, 0);
+    prueba("fmt_decimas", campo_decimas, -32768, 32767, 1);
+    prueba_dos();
+
+    // fmt_txt copia sin el terminador
+    memset(buf, GUARDA, sizeof(buf));
+    PRUEBA(fmt_txt(buf, "T:") == &buf[2] && memcmp(buf, "T:", 2) == 0 && buf[2] == GUARDA);
+    return PRUEBA_FIN();
+}
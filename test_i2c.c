@@ -0,0 +1,180 @@
+/*
+ * File: test_i2c.c
+ * Pruebas de la cola I2C de i2c.c sobre el MSSP del simulador (make test)
+ *
+ * El DS1307 simulado hace de esclavo: sus 56 bytes de RAM se escriben por
+ * la cola y se releen con la API bloqueante. 0x40 no esta en el bus (NACK).
+ */
+#include <string.h>
+#include "hal.h"
+#include "i2c.h"
+#include "test.h"
+
+#define DS1307    0xD0
+#define DS_RAM    0x08
+#define AUSENTE   0x40
+
+static uint8_t orden[8];
+static uint8_t n_orden;
+
+void __interrupt() isr(void)
+{
+    if(PIE1bits.SSPIE && PIR1bits.SSPIF) {
+        I2C_Isr();
+    }
+}
+
+static void cb_anotar(uint8_t estado)
+{
+    orden[n_orden++] = estado;
+}
+
+static void leer_ram(uint8_t reg, uint8_t *datos, uint8_t n)
+{
+    I2C_Start();
+    I2C_Write(DS1307);
+    I2C_Write(reg);
+    I2C_Restart();
+    I2C_Write(DS1307 | 1);
+    while(n--) {
+        *datos++ = I2C_Read();
+        if(n) I2C_Ack(); else I2C_Nack();
+    }
+    I2C_Stop();
+}
+
+// Encolar no espera al bus; la ISR completa la rafaga y marca done
+static void prueba_sin_espera(void)
+{
+    const uint8_t datos[] = { DS_RAM, 0x11, 0x22, 0x33 };
+    volatile uint8_t done = 0xFF;
+    uint8_t leido[3];
+    uint64_t t0 = hal_host_ahora();
+    unsigned long b0 = hal_host_i2c_bytes();
+
+    PRUEBA(I2C_Queue_Write(DS1307, datos, sizeof(datos), &done, 0));
+    PRUEBA_IGUAL(hal_host_ahora(), t0);
+    PRUEBA_IGUAL(done, I2C_PENDIENTE);
+    PRUEBA(I2C_Busy());
+
+    I2C_Flush();
+    PRUEBA_IGUAL(done, I2C_OK);
+    PRUEBA(!I2C_Busy());
+    PRUEBA_IGUAL(hal_host_i2c_bytes() - b0, 1 + sizeof(datos));   // Direccion + rafaga
+
+    leer_ram(DS_RAM, leido, 3);
+    PRUEBA(memcmp(leido, &datos[1], 3) == 0);
+}
+
+// Varias transacciones salen en orden, un START/STOP cada una
+static void prueba_orden(void)
+{
+    volatile uint8_t done[3];
+    uint8_t leido[3];
+
+    n_orden = 0;
+    for(uint8_t i = 0; i < 3; i++) {
+        uint8_t d[2] = { DS_RAM + 8 + i, 0xA0 + i };
+        PRUEBA(I2C_Queue_Write(DS1307, d, 2, &done[i], cb_anotar));
+    }
+    I2C_Flush();
+    PRUEBA_IGUAL(n_orden, 3);
+    for(uint8_t i = 0; i < 3; i++) {
+        PRUEBA_IGUAL(done[i], I2C_OK);
+        PRUEBA_IGUAL(orden[i], I2C_OK);
+    }
+    leer_ram(DS_RAM + 8, leido, 3);
+    PRUEBA(leido[0] == 0xA0 && leido[1] == 0xA1 && leido[2] == 0xA2);
+}
+
+// NACK de la direccion: la rafaga se descarta y la siguiente sale entera
+static void prueba_nack(void)
+{
+    const uint8_t basura[] = { 1, 2, 3, 4, 5 };
+    const uint8_t datos[] = { DS_RAM + 16, 0x5A };
+    volatile uint8_t d1, d2;
+    uint8_t leido;
+    unsigned long b0 = hal_host_i2c_bytes();
+
+    PRUEBA(I2C_Queue_Write(AUSENTE, basura, sizeof(basura), &d1, 0));
+    PRUEBA(I2C_Queue_Write(DS1307, datos, sizeof(datos), &d2, 0));
+    I2C_Flush();
+    PRUEBA_IGUAL(d1, I2C_NACK);
+    PRUEBA_IGUAL(d2, I2C_OK);
+    PRUEBA_IGUAL(hal_host_i2c_bytes() - b0, 1 + 1 + sizeof(datos));
+    leer_ram(DS_RAM + 16, &leido, 1);
+    PRUEBA_IGUAL(leido, 0x5A);
+}
+
+// Una rafaga mas larga que el anillo se rechaza sin trabar la cola
+static void prueba_no_cabe(void)
+{
+    uint8_t grande[I2C_BUF_LEN];
+    const uint8_t datos[] = { DS_RAM + 20, 0x77 };
+    volatile uint8_t done;
+    uint8_t leido;
+
+    memset(grande, 0, sizeof(grande));
+    PRUEBA(!I2C_Queue_Write(DS1307, grande, sizeof(grande), &done, 0));
+    PRUEBA(!I2C_Busy());
+    PRUEBA(I2C_Queue_Write(DS1307, datos, sizeof(datos), &done, 0));
+    I2C_Flush();
+    PRUEBA_IGUAL(done, I2C_OK);
+    leer_ram(DS_RAM + 20, &leido, 1);
+    PRUEBA_IGUAL(leido, 0x77);
+}
+
+// Cola llena: Begin espera a que la ISR libere un descriptor; la API
+// bloqueante espera a que la cola se vacie antes de tomar el bus
+static void prueba_llena(void)
+{
+    volatile uint8_t done[I2C_COLA_LEN];
+    uint8_t d[2] = { DS_RAM + 24, 0 };
+    uint8_t leido;
+
+    for(uint8_t i = 0; i < I2C_COLA_LEN - 1; i++) {
+        d[1] = i;
+        PRUEBA(I2C_Queue_Write(DS1307, d, 2, &done[i], 0));
+    }
+    PRUEBA_IGUAL(done[0], I2C_PENDIENTE);
+    d[1] = 0xEE;
+    PRUEBA(I2C_Queue_Write(DS1307, d, 2, &done[I2C_COLA_LEN - 1], 0));
+    PRUEBA_IGUAL(done[0], I2C_OK);
+
+    leer_ram(DS_RAM + 24, &leido, 1);
+    for(uint8_t i = 0; i < I2C_COLA_LEN; i++) {
+        PRUEBA_IGUAL(done[i], I2C_OK);
+    }
+    PRUEBA_IGUAL(leido, 0xEE);
+}
+
+// Con GIE apagado Flush atiende el MSSP a mano
+static void prueba_sin_gie(void)
+{
+    const uint8_t datos[] = { DS_RAM + 30, 0x42 };
+    volatile uint8_t done;
+    uint8_t leido;
+
+    INTCONbits.GIE = 0;
+    PRUEBA(I2C_Queue_Write(DS1307, datos, sizeof(datos), &done, 0));
+    I2C_Flush();
+    PRUEBA_IGUAL(done, I2C_OK);
+    INTCONbits.GIE = 1;
+    leer_ram(DS_RAM + 30, &leido, 1);
+    PRUEBA_IGUAL(leido, 0x42);
+}
+
+int main(void)
+{
+    HAL_INIT();
+    I2C_Init_Master(I2C_100KHZ);
+    INTCONbits.GIE = 1;
+
+    prueba_sin_espera();
+    prueba_orden();
+    prueba_nack();
+    prueba_no_cabe();
+    prueba_llena();
+    prueba_sin_gie();
+    return PRUEBA_FIN();
+}
@@ -0,0 +1,260 @@
+/*
+ * File: test_ingesta.c
+ * Decodificacion y almacen de ingesta.c (make test)
+ *
+ * Las tramas se arman con cobs_codificar() y crc8(), como las manda el
+ * firmware, y se entregan a nodo_procesar() cortadas en pedazos como los
+ * de read(). Se prueba el COBS en los dos sentidos (todos los patrones de
+ * ceros de un registro, el anillo de uart.c dando la vuelta), el descarte
+ * de tramas corruptas, el desenrollado del tick de 16 bits y del seq, las
+ * columnas de cada zona con DHT11 y DHT22, y que el almacen crezca y que
+ * al reabrirlo los registros nuevos se agreguen detras de los viejos.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ingesta.h"
+#include "cobs.h"
+#include "crc8.h"
+#include "test.h"
+
+static char dir[] = "/tmp/test_ingesta_XXXXXX";
+
+static void armar(uint8_t *r, uint8_t seq, uint16_t tick, uint8_t zona, uint8_t estado,
+                  uint8_t d0, uint8_t d1, uint8_t d2, uint8_t d3)
+{
+    r[0] = seq;
+    r[1] = tick & 0xFF;
+    r[2] = tick >> 8;
+    r[3] = d0;
+    r[4] = d1;
+    r[5] = d2;
+    r[6] = d3;
+    r[7] = d0 + d1 + d2 + d3;
+    r[8] = zona << 4 | estado;
+    r[9] = 0;
+    r[10] = crc8(r, TELEM_LEN - 1);
+}
+
+// Entrega bytes al nodo de a `pedazo` como read()
+static void entregar(Nodo *nd, const uint8_t *b, size_t n, size_t pedazo)
+{
+    while(n) {
+        size_t k = n < pedazo ? n : pedazo;
+        if(k > BUF_LEN - nd->n) k = BUF_LEN - nd->n;
+        memcpy(nd->buf + nd->n, b, k);
+        nd->n += k;
+        nodo_procesar(nd);
+        b += k;
+        n -= k;
+    }
+}
+
+static void enviar(Nodo *nd, const uint8_t *r)
+{
+    uint8_t t[COBS_LEN(TELEM_LEN)];
+
+    cobs_codificar(r, TELEM_LEN, t, 0, sizeof(t));
+    entregar(nd, t, sizeof(t), sizeof(t));
+}
+
+static Nodo *nodo_nuevo(const char *nombre)
+{
+    Nodo *nd = calloc(1, sizeof(Nodo));
+
+    snprintf(nd->nombre, sizeof(nd->nombre), "%s", nombre);
+    nodo_zona(nd, 0);
+    return nd;
+}
+
+static void nodo_fin(Nodo *nd)
+{
+    for(int z = 0; z < ZONAS_MAX; z++) {
+        if(nd->zona[z]) {
+            almacen_cerrar(nd->zona[z]);
+            free(nd->zona[z]);
+        }
+    }
+    free(nd);
+}
+
+#define COL(a, c, tipo)  ((tipo *)(a)->col[c])
+
+// Todos los patrones de ceros en un registro, ida y vuelta; el anillo de
+// uart.c en todas las posiciones
+static void prueba_cobs(void)
+{
+    uint8_t r[TELEM_LEN], t[COBS_LEN(TELEM_LEN)], anillo[32], lineal[COBS_LEN(TELEM_LEN)];
+    unsigned mal = 0;
+
+    for(unsigned m = 0; m < 1u << TELEM_LEN; m++) {
+        for(int i = 0; i < TELEM_LEN; i++) r[i] = (m >> i & 1) ? 0 : i + 1;
+        cobs_codificar(r, TELEM_LEN, t, 0, sizeof(t));
+        if(memchr(t, 0, sizeof(t) - 1) || t[sizeof(t) - 1] != 0) mal++;
+        if(!cobs_decodificar(t, sizeof(t) - 1) || memcmp(t + 1, r, TELEM_LEN)) mal++;
+    }
+    PRUEBA_IGUAL(mal, 0);
+
+    armar(r, 1, 0, 0, 0, 0, 0, 20, 0);
+    cobs_codificar(r, TELEM_LEN, lineal, 0, sizeof(lineal));
+    for(unsigned pos = 0; pos < sizeof(anillo); pos++) {
+        cobs_codificar(r, TELEM_LEN, anillo, pos, sizeof(anillo));
+        for(unsigned i = 0; i < sizeof(lineal); i++) {
+            if(anillo[(pos + i) % sizeof(anillo)] != lineal[i]) mal++;
+        }
+    }
+    PRUEBA_IGUAL(mal, 0);
+
+    // Codigo 0, codigo que se pasa del final y trama vacia
+    memcpy(t, lineal, sizeof(t));
+    t[0] = 0;
+    PRUEBA(!cobs_decodificar(t, sizeof(t) - 1));
+    memcpy(t, lineal, sizeof(t));
+    t[0] = sizeof(t);
+    PRUEBA(!cobs_decodificar(t, sizeof(t) - 1));
+    PRUEBA(!cobs_decodificar(t, 0));
+}
+
+// Tramas buenas cortadas en todos los puntos, mezcladas con corruptas
+static void prueba_tramas(void)
+{
+    Nodo *nd = nodo_nuevo("tramas");
+    Almacen *a = nd->zona[0];
+    uint8_t flujo[8 * COBS_LEN(TELEM_LEN)], r[TELEM_LEN], basura[BUF_LEN];
+    size_t n = 0;
+
+    armar(r, 0, 0, 0, DHT11_OK, 60, 0, 23, 5);
+    cobs_codificar(r, TELEM_LEN, flujo + n, 0, COBS_LEN(TELEM_LEN));
+    n += COBS_LEN(TELEM_LEN);
+    armar(r, 1, 2000, 0, DHT11_OK, 61, 0, 0, 0);      // Ceros en los datos
+    cobs_codificar(r, TELEM_LEN, flujo + n, 0, COBS_LEN(TELEM_LEN));
+    n += COBS_LEN(TELEM_LEN);
+    armar(r, 2, 4000, 0, DHT11_OK, 61, 0, 24, 0);     // CRC mal
+    r[10] ^= 0x01;
+    cobs_codificar(r, TELEM_LEN, flujo + n, 0, COBS_LEN(TELEM_LEN));
+    n += COBS_LEN(TELEM_LEN);
+    flujo[n++] = 0x05;                                 // Trama corta
+    flujo[n++] = 0x00;
+    flujo[n++] = 0x00;                                 // Delimitadores seguidos
+    armar(r, 3, 6000, 0, 1, 0, 0, 0, 0);               // Sin respuesta
+    cobs_codificar(r, TELEM_LEN, flujo + n, 0, COBS_LEN(TELEM_LEN));
+    n += COBS_LEN(TELEM_LEN);
+
+    for(size_t pedazo = 1; pedazo <= n; pedazo++) {
+        uint64_t f0 = *a->filas, c0 = nd->corruptas;
+
+        entregar(nd, flujo, n, pedazo);
+        PRUEBA_IGUAL(*a->filas - f0, 3);
+        PRUEBA_IGUAL(nd->corruptas - c0, 2);
+        PRUEBA_IGUAL(nd->n, 0);
+        PRUEBA_IGUAL(COL(a, COL_TEMP, int16_t)[f0], 235);
+        PRUEBA_IGUAL(COL(a, COL_HUM, int16_t)[f0], 600);
+        PRUEBA_IGUAL(COL(a, COL_TEMP, int16_t)[f0 + 1], 0);
+        PRUEBA_IGUAL(COL(a, COL_HUM, int16_t)[f0 + 1], 610);
+        PRUEBA_IGUAL(COL(a, COL_TEMP, int16_t)[f0 + 2], SIN_DATO);
+        PRUEBA_IGUAL(COL(a, COL_ESTADO, uint8_t)[f0 + 2], 1);
+        PRUEBA_IGUAL(COL(a, COL_SEQ, uint8_t)[f0 + 2], 3);
+    }
+
+    // Un buffer entero sin delimitador es basura: se descarta
+    memset(basura, 0x55, sizeof(basura));
+    {
+        uint64_t c0 = nd->corruptas;
+        entregar(nd, basura, sizeof(basura), 1000);
+        PRUEBA_IGUAL(nd->corruptas - c0, 1);
+        PRUEBA_IGUAL(nd->n, 0);
+    }
+    nodo_fin(nd);
+}
+
+// Tick de 16 bits dando la vuelta, seq con registros perdidos, zonas y DHT22
+static void prueba_tick(void)
+{
+    static const uint16_t ticks[] = { 60000, 62000, 64000, 464, 2464, 65000, 1000 };
+    static const uint8_t seqs[] = { 250, 251, 252, 253, 1, 2, 3 };   // 254, 255 y 0 perdidos
+    Nodo *nd = nodo_nuevo("tick");
+    Almacen *a = nd->zona[0], *z3;
+    uint8_t r[TELEM_LEN];
+    int64_t esperado = 0;
+
+    for(unsigned i = 0; i < sizeof(ticks) / sizeof(ticks[0]); i++) {
+        armar(r, seqs[i], ticks[i], 0, DHT11_OK, 50, 0, 20, 0);
+        enviar(nd, r);
+        if(i) esperado += (uint16_t)(ticks[i] - ticks[i - 1]);
+        PRUEBA_IGUAL(COL(a, COL_TIEMPO, int64_t)[i] - COL(a, COL_TIEMPO, int64_t)[0], esperado);
+    }
+    PRUEBA_IGUAL(nd->perdidas, 3);
+
+    // Zona 3 con un DHT22 a -12.5 C y 45.6 %: su propio almacen, el mismo reloj
+    armar(r, 4, 3000, 3, DHT11_OK | TELEM_DHT22, 456 >> 8, 456 & 0xFF, 0x80, 125);
+    enviar(nd, r);
+    z3 = nd->zona[3];
+    PRUEBA(z3 != NULL);
+    if(z3) {
+        PRUEBA(strcmp(z3->nombre, "tick_z3") == 0);
+        PRUEBA_IGUAL(*z3->filas, 1);
+        PRUEBA_IGUAL(COL(z3, COL_TEMP, int16_t)[0], -125);
+        PRUEBA_IGUAL(COL(z3, COL_HUM, int16_t)[0], 456);
+        PRUEBA_IGUAL(COL(z3, COL_TIEMPO, int64_t)[0] - COL(a, COL_TIEMPO, int64_t)[0], esperado + 2000);
+    }
+    PRUEBA_IGUAL(*a->filas, sizeof(ticks) / sizeof(ticks[0]));
+    PRUEBA_IGUAL(nd->perdidas, 3);
+    nodo_fin(nd);
+}
+
+// Mas filas que la capacidad inicial, y otra corrida sobre el mismo directorio
+static void prueba_almacen(void)
+{
+    const unsigned n1 = FILAS_INI + 500, n2 = 100;
+    Nodo *nd = nodo_nuevo("almacen");
+    Almacen *a;
+    uint8_t r[TELEM_LEN];
+    unsigned mal = 0;
+
+    for(unsigned i = 0; i < n1; i++) {
+        armar(r, i, i * 2000, 0, DHT11_OK, 40 + i % 50, 0, 10 + i % 30, i % 10);
+        enviar(nd, r);
+    }
+    a = nd->zona[0];
+    PRUEBA_IGUAL(*a->filas, n1);
+    PRUEBA(a->capacidad >= n1);
+    nodo_fin(nd);
+
+    nd = nodo_nuevo("almacen");
+    for(unsigned i = n1; i < n1 + n2; i++) {
+        armar(r, i, i * 2000, 0, DHT11_OK, 40 + i % 50, 0, 10 + i % 30, i % 10);
+        enviar(nd, r);
+    }
+    a = nd->zona[0];
+    PRUEBA_IGUAL(*a->filas, n1 + n2);
+    for(unsigned i = 0; i < n1 + n2; i++) {
+        if(COL(a, COL_TEMP, int16_t)[i] != (int16_t)((10 + i % 30) * 10 + i % 10) ||
+           COL(a, COL_HUM, int16_t)[i] != (int16_t)((40 + i % 50) * 10) ||
+           COL(a, COL_SEQ, uint8_t)[i] != (uint8_t)i) {
+            mal++;
+        }
+    }
+    PRUEBA_IGUAL(mal, 0);
+    nodo_fin(nd);
+}
+
+int main(void)
+{
+    char orden[64];
+
+    if(!mkdtemp(dir)) {
+        perror(dir);
+        return 1;
+    }
+    dir_base = dir;
+
+    prueba_cobs();
+    prueba_tramas();
+    prueba_tick();
+    prueba_almacen();
+
+    snprintf(orden, sizeof(orden), "rm -rf %s", dir);
+    if(system(orden) != 0) printf("no se pudo borrar %s\n", dir);
+    return PRUEBA_FIN();
+}
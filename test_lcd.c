@@ -0,0 +1,159 @@
+/*
+ * File: test_lcd.c
+ * Pruebas de lcd_i2c.c sobre el PCF8574 + HD44780 del simulador (make test)
+ *
+ * Cuenta los bytes que pasan por el bus: cada byte del LCD son 4 del
+ * PCF8574 (dos nibbles con pulso en E) y cada transaccion suma la
+ * direccion. Lo que queda en la DDRAM simulada se compara con lo escrito.
+ * El borrado espera con el busy flag, o con el retardo fijo si el modulo
+ * tiene RW a GND, sin instrucciones con el HD44780 ocupado ni RW
+ * cambiando al subir E.
+ */
+#include <string.h>
+#include "hal.h"
+#include "i2c.h"
+#include "lcd_i2c.h"
+#include "test.h"
+
+#define BYTES(lcd, trans)  (4 * (lcd) + (trans))
+
+static unsigned long b0;
+
+void __interrupt() isr(void)
+{
+    if(PIE1bits.SSPIE && PIR1bits.SSPIF) {
+        I2C_Isr();
+    }
+}
+
+static unsigned long bytes(void)
+{
+    unsigned long n;
+
+    I2C_Flush();
+    n = hal_host_i2c_bytes() - b0;
+    b0 = hal_host_i2c_bytes();
+    return n;
+}
+
+static int fila_es(uint8_t fila, const char *txt)
+{
+    return memcmp(hal_host_lcd(fila), txt, strlen(txt)) == 0;
+}
+
+// Cadenas, posicion y glifos de CGRAM: una sola transaccion cada uno
+static void prueba_rafagas(void)
+{
+    static const char glifo[8] = { 0x0E, 0x11, 0x11, 0x11, 0x1F, 0x1B, 0x1F, 0x00 };
+
+    bytes();
+    Lcd_Write_String_At(1, 1, "Hola");
+    PRUEBA_IGUAL(bytes(), BYTES(1 + 4, 1));
+    PRUEBA(fila_es(1, "Hola"));
+
+    Lcd_Write_String_At(1, 2, "0123456789ABCDEF");
+    PRUEBA_IGUAL(bytes(), BYTES(1 + 16, 1));
+    PRUEBA(fila_es(2, "0123456789ABCDEF"));
+
+    Lcd_Set_Cursor(5, 1);
+    Lcd_Write_String("!!");
+    PRUEBA_IGUAL(bytes(), BYTES(1, 1) + BYTES(2, 1));
+    PRUEBA(fila_es(1, "Hola!!"));
+
+    Lcd_CGRAM_CreateChar(0, glifo);
+    PRUEBA_IGUAL(bytes(), BYTES(1 + 8, 1));
+}
+
+// Lcd_Flush manda solo las celdas distintas de la sombra, en una
+// transaccion por llamada
+static void prueba_framebuffer(void)
+{
+    Lcd_Clear();
+    bytes();
+
+    Lcd_Fb_Write_String(1, 1, "T: 21C");
+    Lcd_Flush();
+    PRUEBA_IGUAL(bytes(), BYTES(1 + 6, 1));
+    PRUEBA(fila_es(1, "T: 21C          "));
+
+    Lcd_Flush();   // Nada cambio: nada al bus
+    PRUEBA_IGUAL(bytes(), 0);
+
+    Lcd_Fb_Write_Char(5, 1, '2');
+    Lcd_Flush();
+    PRUEBA_IGUAL(bytes(), BYTES(1 + 1, 1));
+    PRUEBA(fila_es(1, "T: 22C"));
+
+    // Un hueco de una celda se reescribe en lugar de mover el cursor
+    Lcd_Fb_Write_Char(4, 1, '3');
+    Lcd_Fb_Write_Char(6, 1, 'F');
+    Lcd_Flush();
+    PRUEBA_IGUAL(bytes(), BYTES(1 + 3, 1));
+    PRUEBA(fila_es(1, "T: 32F"));
+
+    // Tramos separados y en las dos filas: un cursor por tramo, una
+    // sola transaccion
+    *Lcd_Fb_At(12, 1) = 'x';
+    *Lcd_Fb_At(16, 2) = 'y';
+    Lcd_Flush();
+    PRUEBA_IGUAL(bytes(), BYTES(2 + 2, 1));
+    PRUEBA(fila_es(1, "T: 32F     x    "));
+    PRUEBA(fila_es(2, "               y"));
+
+    // Borrar el framebuffer solo manda los espacios que hacen falta
+    Lcd_Fb_Clear();
+    Lcd_Fb_Write_String(1, 1, "T: 32F");
+    Lcd_Flush();
+    PRUEBA_IGUAL(bytes(), BYTES(2 + 2, 1));
+    PRUEBA(fila_es(1, "T: 32F          "));
+    PRUEBA(fila_es(2, "                "));
+}
+
+// Con RW conectado el borrado sondea el busy flag: mas bytes que el
+// comando y lo siguiente no encuentra al HD44780 ocupado
+static void prueba_busy_flag(void)
+{
+    bytes();
+    Lcd_Clear();
+    PRUEBA(bytes() > BYTES(1, 1));
+    Lcd_Write_String_At(1, 1, "Listo");
+    PRUEBA_IGUAL(bytes(), BYTES(1 + 5, 1));
+    PRUEBA(fila_es(1, "Listo           "));
+}
+
+// Con RW a GND Lcd_Init() lo detecta y el borrado no sondea: cada sondeo
+// escribiria 0xFF como instruccion
+static void prueba_sin_rw(void)
+{
+    hal_host_lcd_rw(0);
+    Lcd_Init();
+    Lcd_Write_String_At(1, 1, "Sin RW");
+    bytes();
+    Lcd_Clear();
+    PRUEBA_IGUAL(bytes(), BYTES(1, 1));
+    Lcd_Write_String_At(1, 2, "Sin RW");
+    PRUEBA_IGUAL(bytes(), BYTES(1 + 6, 1));
+    PRUEBA(fila_es(1, "                "));
+    PRUEBA(fila_es(2, "Sin RW          "));
+
+    // Y al conectarlo se vuelve a detectar
+    hal_host_lcd_rw(1);
+    Lcd_Init();
+    prueba_busy_flag();
+}
+
+int main(void)
+{
+    HAL_INIT();
+    I2C_Init_Master(I2C_100KHZ);
+    INTCONbits.GIE = 1;
+    Lcd_Init();
+
+    prueba_rafagas();
+    prueba_framebuffer();
+    prueba_busy_flag();
+    prueba_sin_rw();
+    PRUEBA_IGUAL(hal_host_lcd_ocupado(), 0);
+    PRUEBA_IGUAL(hal_host_lcd_tas(), 0);
+    return PRUEBA_FIN();
+}
@@ -0,0 +1,158 @@
+/*
+ * File: test_logpack.c
+ * Codificacion de logpack.c: ida y vuelta y escrituras cortadas (make test)
+ *
+ * Series al azar (repeticiones, deltas chicos y medianos, saltos, huecos)
+ * se codifican bloque a bloque y se decodifican de nuevo. Despues de cada
+ * pack_add() los bytes modificados se aplican de a uno sobre una copia de
+ * lo grabado, del ultimo al primero como eelog.c: hasta que llega el
+ * ultimo, la copia tiene que seguir decodificando exactamente lo de antes.
+ */
+#include <string.h>
+#include "logpack.h"
+#include "test.h"
+
+#define MAX_LECTURAS  (PACK_NIBBLES * (PACK_HUECO_MAX + 2))
+
+typedef struct {
+    muestra_t t, h;
+} Lectura;
+
+static Lectura esperado[MAX_LECTURAS];
+static uint16_t n_esperado;
+static uint32_t azar = 7;
+
+static uint8_t sorteo(void)
+{
+    azar = azar * 1103515245UL + 12345;
+    return (azar >> 16) & 0xFF;
+}
+
+static uint16_t decodificar(const uint8_t *datos, muestra_t t0, muestra_t h0, Lectura *l)
+{
+    Unpack u;
+    muestra_t t, h;
+    uint16_t n = 0;
+
+    unpack_init(&u, datos, t0, h0);
+    while(unpack_next(&u, &t, &h)) {
+        l[n].t = t;
+        l[n].h = h;
+        n++;
+    }
+    return n;
+}
+
+// La decodificacion de datos es la serie esperada, o su prefijo de n
+static int es_prefijo(const uint8_t *datos, muestra_t t0, muestra_t h0, uint16_t n)
+{
+    Lectura l[MAX_LECTURAS];
+
+    return decodificar(datos, t0, h0, l) == n &&
+           memcmp(l, esperado, n * sizeof(Lectura)) == 0;
+}
+
+// Lo del informe: (20,50) y tres veces (21,50). El tercero volvia el 4 del
+// nibble bajo en 9 con el contador en el byte siguiente, grabado antes
+static void prueba_corrida_cortada(void)
+{
+    uint8_t datos[PACK_BYTES], grabado[PACK_BYTES];
+    Pack p;
+
+    pack_init(&p, datos, 20, 50);
+    memcpy(grabado, datos, PACK_BYTES);
+    esperado[0].t = 20; esperado[0].h = 50;
+    n_esperado = 1;
+    for(uint8_t i = 0; i < 5; i++) {
+        PRUEBA(pack_add(&p, datos, 21, 50));
+        for(uint8_t b = p.mod_fin; ; b--) {
+            grabado[b] = datos[b];
+            if(b == p.mod_ini) break;
+            PRUEBA(es_prefijo(grabado, 20, 50, n_esperado));
+        }
+        esperado[n_esperado].t = 21; esperado[n_esperado].h = 50;
+        n_esperado++;
+        PRUEBA(es_prefijo(grabado, 20, 50, n_esperado));
+        PRUEBA_IGUAL(p.mod_ini, p.mod_fin);   // Un solo byte por lectura
+    }
+}
+
+// Un bloque al azar hasta que se llena; lo grabado se va actualizando byte
+// a byte y se decodifica despues de cada uno
+static void bloque(uint8_t huecos)
+{
+    uint8_t datos[PACK_BYTES], grabado[PACK_BYTES];
+    Lectura l[MAX_LECTURAS];
+    Pack p;
+    muestra_t t0 = 25 * MUESTRA_ESCALA, h0 = 55 * MUESTRA_ESCALA;
+    int16_t t = t0, h = h0;
+    unsigned fallas = prueba_fallas;
+
+    pack_init(&p, datos, t0, h0);
+    memcpy(grabado, datos, PACK_BYTES);
+    esperado[0].t = t0; esperado[0].h = h0;
+    n_esperado = 1;
+
+    for(;;) {
+        uint8_t r = sorteo(), hueco = 0, ok;
+        int16_t nt = t, nh = h;
+
+        if(r < 110) {
+            // Sin cambio: corridas
+        } else if(r < 190) {
+            nt += (int8_t)(r % 3) - 1;
+            nh += (int8_t)((r / 3) % 3) - 1;
+        } else if(r < 235) {
+            nt += (int8_t)(r % 16) - 8;
+            nh += (int8_t)((r / 16) % 16) - 8;
+        } else {
+            nt += (r & 1) ? 40 : -40;
+            nh -= 20;
+        }
+        if(nt < 0 || nt > 60 * MUESTRA_ESCALA) nt = t;   // Dentro de muestra_t
+        if(nh < 10 * MUESTRA_ESCALA || nh > 95 * MUESTRA_ESCALA) nh = h;
+        if(huecos && sorteo() < 30) hueco = 1 + sorteo() % PACK_HUECO_MAX;
+
+        ok = pack_add_hueco(&p, datos, hueco, (muestra_t)nt, (muestra_t)nh);
+        if(!ok) break;
+        t = nt;
+        h = nh;
+
+        for(uint8_t b = p.mod_fin; ; b--) {
+            grabado[b] = datos[b];
+            if(b == p.mod_ini) break;
+            PRUEBA(es_prefijo(grabado, t0, h0, n_esperado));
+        }
+
+        // Las del hueco salen sobre la recta: se toman de la decodificacion
+        // y solo se pide que esten entre el origen y el final
+        PRUEBA_IGUAL(decodificar(grabado, t0, h0, l), n_esperado + hueco + 1);
+        for(uint8_t i = 1; i <= hueco; i++) {
+            Lectura a = esperado[n_esperado - 1], x = l[n_esperado - 1 + i];
+
+            PRUEBA((x.t - a.t) * (t - x.t) >= 0 && (x.h - a.h) * (h - x.h) >= 0);
+            esperado[n_esperado - 1 + i] = x;
+        }
+        n_esperado += hueco;
+        esperado[n_esperado].t = t;
+        esperado[n_esperado].h = h;
+        n_esperado++;
+        PRUEBA(es_prefijo(grabado, t0, h0, n_esperado));
+        PRUEBA(memcmp(grabado, datos, PACK_BYTES) == 0);
+        if(prueba_fallas - fallas > 10) return;
+    }
+
+    // Retomar el bloque (eelog_init) da las mismas lecturas y sigue igual
+    Pack q;
+    PRUEBA_IGUAL(pack_resume(&q, grabado, t0, h0), n_esperado);
+    PRUEBA(q.t == p.t && q.h == p.h && q.pos == p.pos);
+}
+
+int main(void)
+{
+    prueba_corrida_cortada();
+    for(uint16_t i = 0; i < 2000; i++) {
+        bloque(i & 1);
+    }
+    return PRUEBA_FIN();
+}
@@ -0,0 +1,220 @@
+/*
+ * File: test_sched.c
+ * Pruebas del planificador sobre el tick de Timer2 simulado (make test)
+ *
+ * Cada tarea anota el tick en que corrio; el reloj virtual del simulador
+ * da la referencia (1 tick = 1 ms = 5000 ciclos). Despues, las
+ * condiciones con las que sched_run() duerme con SCHED_T1OSC: UART sin
+ * nada por salir y captura del sensor desarmada. Al final, el arranque de
+ * main() con los drivers reales (I2C, LCD, sensor y planificador): el
+ * mensaje inicial y la primera lectura valida tienen que llegar dentro
+ * de su cota, y se informan los tiempos.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "hal.h"
+#include "sched.h"
+#include "uart.h"
+#include "i2c.h"
+#include "lcd_i2c.h"
+#include "sensor.h"
+#include "test.h"
+
+#define CICLOS_TICK  5000
+
+// Cotas del arranque: Lcd_Init() (20 ms de encendido del HD44780, el
+// sondeo de RW y los borrados con busy flag) y el mensaje por la cola I2C;
+// la lectura, SENSOR_ENCENDIDO_MS despues, con su arranque y captura
+#define ARRANQUE_MENSAJE_MS  50
+#define ARRANQUE_LECTURA_MS  (ARRANQUE_MENSAJE_MS + SENSOR_ENCENDIDO_MS + SENSOR_ARRANQUE_MS + 15)
+
+static uint16_t corridas_a[8], corridas_b[8];
+static uint8_t n_a, n_b, n_c;
+
+void __interrupt() isr(void)
+{
+    if(INTCONbits.INTE && INTCONbits.INTF) {
+        dht11_isr();
+    }
+    if(SCHED_TICK_PENDIENTE()) {
+        sched_tick_isr();
+    }
+    if(INTCONbits.T0IE && INTCONbits.T0IF) {
+        dht11_desborde();
+    }
+    if(!INTCONbits.PEIE) {   // Captura del sensor (dht11.c)
+        return;
+    }
+    if(PIE1bits.SSPIE && PIR1bits.SSPIF) {
+        I2C_Isr();
+    }
+    if(PIE1bits.TXIE && PIR1bits.TXIF) {
+        UART_Isr();
+    }
+}
+
+static void tarea_a(void)
+{
+    if(n_a < 8) corridas_a[n_a++] = sched_ticks();
+}
+
+// Se adelanta a si misma: la segunda corrida va 3 ms despues de la primera
+static void tarea_b(void)
+{
+    if(n_b < 8) corridas_b[n_b++] = sched_ticks();
+    if(n_b == 1) sched_delay(1, 3);
+}
+
+// Tarda mas que su plazo una vez
+static void tarea_c(void)
+{
+    if(++n_c == 2) __delay_ms(15);
+}
+
+static Tarea tabla[] = {
+    SCHED_TAREA(tarea_a, 100, 0, 10),
+    SCHED_TAREA(tarea_b,  50, 0, 25),
+    SCHED_TAREA(tarea_c, 200, 10, 5),
+};
+
+// El cuerpo de sched_run() hasta el tick t
+static void correr_hasta(uint16_t t)
+{
+    uint16_t visto;
+
+    while((int16_t)(sched_ticks() - t) < 0) {
+        visto = sched_ticks();
+        sched_dispatch();
+        while(sched_ticks() == visto) HAL_ESPERA();
+    }
+}
+
+static void prueba_tiempos(void)
+{
+    uint64_t t0;
+
+    sched_init(tabla, 3);
+    INTCONbits.GIE = 1;
+    t0 = hal_host_ahora();
+    correr_hasta(1000);
+
+    // El tick sigue al reloj: 1000 ticks son 1000 ms virtuales
+    PRUEBA((hal_host_ahora() - t0) / CICLOS_TICK >= 999 && (hal_host_ahora() - t0) / CICLOS_TICK <= 1001);
+
+    // Fase y periodo
+    PRUEBA_IGUAL(corridas_a[0], 10);
+    PRUEBA_IGUAL(corridas_a[1], 110);
+    PRUEBA_IGUAL(corridas_a[7], 710);
+
+    // sched_delay() desde la tarea y despues el periodo normal
+    PRUEBA_IGUAL(corridas_b[0], 25);
+    PRUEBA_IGUAL(corridas_b[1], 28);
+    PRUEBA_IGUAL(corridas_b[2], 78);
+
+    // La segunda corrida de tarea_c (tick 205) incumple el plazo y mide
+    // ~15 ms de WCET (unidades de 1.6 us); tarea_a sale atrasada en el
+    // 220 pero su periodo no se corre
+    PRUEBA_IGUAL(tabla[2].perdidos, 1);
+    PRUEBA(tabla[2].wcet >= 15000 * 10 / SCHED_WCET_DUS);
+    PRUEBA_IGUAL(corridas_a[2], 220);
+    PRUEBA_IGUAL(corridas_a[3], 310);
+}
+
+// Lo que sched_run() mira antes de SLEEP con SCHED_T1OSC
+static void prueba_reposo(void)
+{
+    const uint8_t trama[4] = { 1, 2, 3, 4 };
+    uint16_t t;
+
+    PRUEBA(!UART_Busy());
+    PRUEBA(UART_Frame(trama, sizeof(trama)));
+    PRUEBA(UART_Busy());
+    t = sched_ticks();
+    while(UART_Busy()) HAL_ESPERA();
+    // 6 bytes (COBS + 0x00) a 115200: ~0.5 ms; TRMT sube con el ultimo bit
+    PRUEBA((uint16_t)(sched_ticks() - t) <= 1);
+    PRUEBA(!PIE1bits.TXIE);
+
+    dht11_config();
+    PRUEBA(!dht11_capturando());
+    dht11_start();
+    __delay_ms(20);
+    dht11_capture();
+    PRUEBA(dht11_capturando());
+    __delay_ms(10);
+    PRUEBA(dht11_done());
+    PRUEBA(!dht11_capturando());
+}
+
+// tarea_sensor() de main.c con un sensor: arranque, captura y resultado
+static uint8_t arranque_fase;
+static uint64_t arranque_lectura;
+
+static void tarea_sensor(void)
+{
+    q8_t h, t;
+
+    switch(arranque_fase) {
+    case 0:
+        sensor_start();
+        sched_delay(0, SENSOR_ARRANQUE_MS);
+        arranque_fase = 1;
+        break;
+    case 1:
+        sensor_capture();
+        sched_delay(0, 10);
+        arranque_fase = 2;
+        break;
+    default:
+        if(sensor_finish(&h, &t) == DHT11_OK) {
+            if(!arranque_lectura) arranque_lectura = hal_host_ahora();
+        } else {
+            sched_delay(0, SENSOR_RECUPERACION_MS);
+        }
+        arranque_fase = 0;
+        break;
+    }
+}
+
+static Tarea tabla_arranque[] = {
+    SCHED_TAREA(tarea_sensor, 2000, 0, SENSOR_ENCENDIDO_MS),
+};
+
+// Lo que hace main() desde el encendido hasta sched_run(), sin esperas fijas
+static void prueba_arranque(void)
+{
+    uint64_t t0 = hal_host_ahora();
+    uint32_t mensaje_ms, lectura_ms;
+
+    I2C_Init_Master(I2C_100KHZ);
+    INTCONbits.GIE = 1;
+    Lcd_Init();
+    Lcd_Fb_Write_String(1, 1, "Sistema " SENSOR_NOMBRE);
+    Lcd_Fb_Write_String(1, 2, "Iniciando...");
+    Lcd_Flush();
+    I2C_Flush();
+    mensaje_ms = (hal_host_ahora() - t0) / CICLOS_TICK;
+    PRUEBA(memcmp(hal_host_lcd(2), "Iniciando...", 12) == 0);
+    PRUEBA(mensaje_ms <= ARRANQUE_MENSAJE_MS);
+
+    sensor_config();
+    // En el PIC el tick empieza en 0 en sched_init(); aca ya corrio
+    tabla_arranque[0].proxima += sched_ticks();
+    sched_init(tabla_arranque, 1);
+    correr_hasta(sched_ticks() + ARRANQUE_LECTURA_MS);
+    PRUEBA(arranque_lectura != 0);
+    lectura_ms = (arranque_lectura - t0) / CICLOS_TICK;
+    PRUEBA(lectura_ms <= ARRANQUE_LECTURA_MS);
+    printf("arranque: mensaje a los %lu ms, primera lectura a los %lu ms (cota %d)\n",
+           (unsigned long)mensaje_ms, (unsigned long)lectura_ms, ARRANQUE_LECTURA_MS);
+}
+
+int main(void)
+{
+    HAL_INIT();
+    UART_Init();
+    prueba_tiempos();
+    prueba_reposo();
+    prueba_arranque();
+    return PRUEBA_FIN();
+}
@@ -0,0 +1,167 @@
+/*
+ * File: test_sensor.c
+ * Conversion de las tramas del DHT11 y del DHT22 (make test)
+ *
+ * dht11_convertir() y dht22_convertir() con tramas armadas a mano: valores
+ * de la hoja de datos, los extremos del rango, temperaturas negativas del
+ * DHT22 (signo y magnitud, -0.0 incluido) y los valores imposibles que dan
+ * DHT11_ERR_RANGO. Despues la lectura entera con sensor_* (sensor.h)
+ * contra el sensor simulado, con el formato del que se compilo: se corre
+ * una vez por sensor (test_sensor y test_sensor_dht22).
+ */
+#include <string.h>
+#include "hal.h"
+#include "dht11.h"
+#include "dht22.h"
+#include "sensor.h"
+#include "sched.h"
+#include "test.h"
+
+static Tarea ninguna[1];
+
+void __interrupt() isr(void)
+{
+    if(INTCONbits.INTE && INTCONbits.INTF) {
+        sensor_isr();
+    }
+    if(SCHED_TICK_PENDIENTE()) {
+        sched_tick_isr();
+    }
+    if(INTCONbits.T0IE && INTCONbits.T0IF) {
+        sensor_desborde();
+    }
+}
+
+typedef struct {
+    uint8_t d[4];
+    uint8_t res;
+    int16_t hum, tem;   // Decimas esperadas, si res es DHT11_OK
+} Caso;
+
+// Decimas a Q8.8, truncando la magnitud como dht22.c
+static q8_t q8_decimas(int16_t d)
+{
+    q8_t q = (q8_t)(((uint32_t)(d < 0 ? -d : d) << 8) / 10);
+
+    return d < 0 ? -q : q;
+}
+
+// El DHT11 pasa las decimas con Q8_DECIMAS(), que puede quedar 1/256 abajo
+static void comparar(const Caso *c, uint8_t res, q8_t h, q8_t t)
+{
+    PRUEBA_IGUAL(res, c->res);
+    if(res != DHT11_OK || c->res != DHT11_OK) return;
+    PRUEBA(h <= q8_decimas(c->hum) && h >= q8_decimas(c->hum) - 1);
+    PRUEBA(t <= q8_decimas(c->tem) && t >= q8_decimas(c->tem) - 1);
+    PRUEBA((t < 0) == (c->tem < 0));
+}
+
+static void prueba_dht11(void)
+{
+    static const Caso casos[] = {
+        { { 55, 0, 23, 0 }, DHT11_OK, 550, 230 },
+        { { 45, 3, 22, 7 }, DHT11_OK, 453, 227 },
+        { { 0, 0, 0, 0 }, DHT11_OK, 0, 0 },
+        { { 100, 0, 60, 9 }, DHT11_OK, 1000, 609 },
+        { { 101, 0, 23, 0 }, DHT11_ERR_RANGO },
+        { { 55, 0, 61, 0 }, DHT11_ERR_RANGO },
+        { { 55, 10, 23, 0 }, DHT11_ERR_RANGO },
+        { { 55, 0, 5, 0x83 }, DHT11_ERR_RANGO },   // -5.3 C de un DHT11 nuevo
+        { { 0xFF, 0xFF, 0xFF, 0xFF }, DHT11_ERR_RANGO },
+        { { 0x02, 0x8C, 0x01, 0x5F }, DHT11_ERR_RANGO },   // Trama de un DHT22
+    };
+    q8_t h, t;
+    uint8_t res;
+
+    for(uint8_t i = 0; i < sizeof(casos) / sizeof(casos[0]); i++) {
+        res = dht11_convertir(casos[i].d, &h, &t);
+        comparar(&casos[i], res, h, t);
+    }
+}
+
+static void prueba_dht22(void)
+{
+    static const Caso casos[] = {
+        { { 0x02, 0x8C, 0x01, 0x5F }, DHT11_OK, 652, 351 },   // Hoja de datos
+        { { 0x02, 0x8C, 0x80, 0x65 }, DHT11_OK, 652, -101 },  // Idem, -10.1 C
+        { { 0x00, 0x00, 0x80, 0x01 }, DHT11_OK, 0, -1 },
+        { { 0x00, 0x00, 0x80, 0x00 }, DHT11_OK, 0, 0 },       // -0.0
+        { { 0x03, 0xE8, 0x03, 0x20 }, DHT11_OK, 1000, 800 },  // 100.0 %, 80.0 C
+        { { 0x03, 0xE8, 0x81, 0x90 }, DHT11_OK, 1000, -400 }, // -40.0 C
+        { { 0x03, 0xE9, 0x00, 0xFA }, DHT11_ERR_RANGO },      // 100.1 %
+        { { 0x02, 0x8C, 0x03, 0x21 }, DHT11_ERR_RANGO },      // 80.1 C
+        { { 0x02, 0x8C, 0x81, 0x91 }, DHT11_ERR_RANGO },      // -40.1 C
+        { { 0x02, 0x8C, 0xFF, 0xFF }, DHT11_ERR_RANGO },
+        { { 55, 0, 23, 0 }, DHT11_ERR_RANGO },                // Trama de un DHT11
+    };
+    q8_t h, t;
+    uint8_t res;
+
+    for(uint8_t i = 0; i < sizeof(casos) / sizeof(casos[0]); i++) {
+        res = dht22_convertir(casos[i].d, &h, &t);
+        comparar(&casos[i], res, h, t);
+    }
+}
+
+// ========== LECTURA ==========
+static void esperar_ms(uint16_t ms)
+{
+    uint16_t t0 = sched_ticks();
+
+    while((uint16_t)(sched_ticks() - t0) < ms) HAL_ESPERA();
+}
+
+// Lectura no bloqueante como en tarea_sensor()
+static void leer(const Caso *c)
+{
+    uint8_t d[5];
+    uint8_t res;
+    q8_t h, t;
+
+    memcpy(d, c->d, 4);
+    d[4] = d[0] + d[1] + d[2] + d[3];
+    hal_host_dht_trama(0, d, 40, 2);
+    sensor_start();
+    esperar_ms(SENSOR_ARRANQUE_MS);
+    sensor_capture();
+    esperar_ms(10);
+    res = sensor_finish(&h, &t);
+    comparar(c, res, h, t);
+    esperar_ms(SENSOR_RECUPERACION_MS);
+}
+
+static void prueba_lectura(void)
+{
+    static const Caso casos[] = {
+#ifdef SENSOR_DHT22
+        { { 0x02, 0x8C, 0x80, 0x65 }, DHT11_OK, 652, -101 },
+        { { 0x00, 0x00, 0x80, 0x00 }, DHT11_OK, 0, 0 },
+        { { 0x03, 0xE8, 0x81, 0x90 }, DHT11_OK, 1000, -400 },
+        { { 0x02, 0x8C, 0x81, 0x91 }, DHT11_ERR_RANGO },
+        { { 0x03, 0xE9, 0x01, 0x5F }, DHT11_ERR_RANGO },
+#else
+        { { 45, 3, 22, 7 }, DHT11_OK, 453, 227 },
+        { { 100, 0, 60, 9 }, DHT11_OK, 1000, 609 },
+        { { 55, 0, 5, 0x83 }, DHT11_ERR_RANGO },
+        { { 101, 0, 23, 0 }, DHT11_ERR_RANGO },
+#endif
+    };
+
+    for(uint8_t i = 0; i < sizeof(casos) / sizeof(casos[0]); i++) {
+        leer(&casos[i]);
+    }
+}
+
+int main(void)
+{
+    HAL_INIT();
+    sensor_config();
+    sched_init(ninguna, 0);
+    INTCONbits.PEIE = 1;
+    INTCONbits.GIE = 1;
+
+    prueba_dht11();
+    prueba_dht22();
+    prueba_lectura();
+    return PRUEBA_FIN();
+}
@@ -0,0 +1,102 @@
+/*
+ * File: test_stats.c
+ * Minimo y maximo de la ventana de stats.c contra fuerza bruta (make test)
+ *
+ * Series al azar por tramos (paseo al azar, valores repetidos, rampas que
+ * suben y bajan, saltos a los extremos de muestra_t) se empujan una
+ * muestra a la vez; despues de cada una stats_min() y stats_max() de los
+ * dos canales tienen que dar lo mismo que recorrer las ultimas
+ * STATS_VENTANA muestras. Cada tanto se vuelve a stats_init(), como al
+ * reconstruir desde la EEPROM. Se compila una vez por sensor (la ventana
+ * y muestra_t cambian).
+ */
+#include <stdio.h>
+#include "stats.h"
+#include "test.h"
+
+#define MUESTRAS  1000000L
+
+#if MUESTRA_BYTES == 2
+#define MUESTRA_MIN  (-32767 - 1)
+#define MUESTRA_MAX  32767
+#else
+#define MUESTRA_MIN  0
+#define MUESTRA_MAX  255
+#endif
+
+static uint32_t azar = 1;
+
+static uint16_t siguiente(void)
+{
+    azar = azar * 1103515245UL + 12345;
+    return azar >> 16;
+}
+
+static muestra_t acotar(int32_t v)
+{
+    return (muestra_t)(v < MUESTRA_MIN ? MUESTRA_MIN : v > MUESTRA_MAX ? MUESTRA_MAX : v);
+}
+
+// Un valor nuevo de la serie del canal segun el tramo en curso
+static muestra_t generar(uint8_t tramo, muestra_t previo)
+{
+    switch(tramo) {
+    case 0:  return acotar(previo + (int16_t)(siguiente() % 7) - 3);    // Paseo al azar
+    case 1:  return previo;                                             // Repetido
+    case 2:  return acotar(previo + 1 + siguiente() % 3);               // Rampa arriba
+    case 3:  return acotar(previo - 1 - (int16_t)(siguiente() % 3));    // Rampa abajo
+    case 4:  return (siguiente() & 1) ? MUESTRA_MIN : MUESTRA_MAX;      // Extremos
+    default: return acotar(MUESTRA_MIN + (int32_t)(siguiente() % (MUESTRA_MAX - MUESTRA_MIN + 1)));
+    }
+}
+
+int main(void)
+{
+    static muestra_t hist[STATS_CANALES][STATS_VENTANA];
+    muestra_t previo[STATS_CANALES] = { 0 };
+    uint8_t tramo = 0, n = 0, pos = 0;
+    uint16_t largo = 0;
+    unsigned long reinicios = 0;
+
+    stats_init();
+    PRUEBA_IGUAL(stats_total(), 0);
+    PRUEBA_IGUAL(stats_min(STATS_TEMP), 0);
+    PRUEBA_IGUAL(stats_max(STATS_HUM), 0);
+
+    for(long i = 0; i < MUESTRAS && prueba_fallas < 10; i++) {
+        if(largo == 0) {
+            tramo = siguiente() % 6;
+            largo = 1 + siguiente() % (3 * STATS_VENTANA);
+            // Como al reconstruir el historial al arrancar
+            if(siguiente() % 64 == 0) {
+                stats_init();
+                n = pos = 0;
+                reinicios++;
+            }
+        }
+        largo--;
+
+        for(uint8_t c = 0; c < STATS_CANALES; c++) {
+            previo[c] = generar(c ? (tramo + 1) % 6 : tramo, previo[c]);
+            hist[c][pos] = previo[c];
+        }
+        stats_push(previo[STATS_TEMP], previo[STATS_HUM]);
+        pos = (pos + 1) % STATS_VENTANA;
+        if(n < STATS_VENTANA) n++;
+
+        PRUEBA_IGUAL(stats_total(), n);
+        for(uint8_t c = 0; c < STATS_CANALES; c++) {
+            muestra_t mn = hist[c][0], mx = hist[c][0];
+
+            for(uint8_t k = 1; k < n; k++) {
+                if(hist[c][k] < mn) mn = hist[c][k];
+                if(hist[c][k] > mx) mx = hist[c][k];
+            }
+            PRUEBA_IGUAL(stats_min(c), mn);
+            PRUEBA_IGUAL(stats_max(c), mx);
+        }
+    }
+    PRUEBA(reinicios > 0);
+    printf("%ld muestras, ventana %d, %lu reinicios\n", MUESTRAS, STATS_VENTANA, reinicios);
+    return PRUEBA_FIN();
+}
@@ -0,0 +1,86 @@
+"""
+Pruebas de telemetria.py (make test)
+
+El decodificador contra un codificador COBS de libro (el mismo algoritmo
+que cobs.c, con grupos de hasta 254 bytes), registros al azar entregados
+en pedazos de todos los tamaños como los de read(), tramas corruptas
+mezcladas, y el valor de control del CRC-8.
+"""
+
+import io
+import random
+import unittest
+
+import telemetria as tm
+
+
+def cobs(datos):
+    salida, grupo = bytearray(), bytearray()
+    for b in datos:
+        if b == 0:
+            salida += bytes([len(grupo) + 1]) + grupo
+            grupo = bytearray()
+        else:
+            grupo.append(b)
+            if len(grupo) == 254:
+                salida += b'\xff' + grupo
+                grupo = bytearray()
+    return bytes(salida + bytes([len(grupo) + 1]) + grupo)
+
+
+def registro(rng):
+    r = bytes(rng.choice((0, rng.randrange(256))) for _ in range(tm.TELEM_LEN - 1))
+    return r + bytes([tm.crc8(r)])
+
+
+class Pedazos(io.RawIOBase):
+    """Flujo que entrega de a `n` bytes"""
+    def __init__(self, datos, n):
+        self.datos, self.n = datos, n
+
+    def read(self, _):
+        b, self.datos = self.datos[:self.n], self.datos[self.n:]
+        return b
+
+
+class PruebaTelemetria(unittest.TestCase):
+
+    def test_crc8(self):
+        self.assertEqual(tm.crc8(b'123456789'), 0xF4)     # CRC-8 (0x07) de control
+
+    def test_cobs(self):
+        rng = random.Random(1)
+        for largo in (0, 1, 11, 253, 254, 255, 600):
+            for _ in range(20):
+                d = bytes(rng.choice((0, rng.randrange(1, 256))) for _ in range(largo))
+                t = cobs(d)
+                self.assertNotIn(0, t)
+                self.assertEqual(tm.cobs_decodificar(t), d)
+        self.assertEqual(tm.cobs_decodificar(b'\xff' + bytes(254 * [1])), bytes(254 * [1]))
+        self.assertIsNone(tm.cobs_decodificar(b'\x05\x01\x02'))      # Se pasa del final
+        self.assertIsNone(tm.cobs_decodificar(b'\x02\x01\x00\x01'))  # Código 0
+
+    def test_tramas(self):
+        rng = random.Random(2)
+        regs = [registro(rng) for _ in range(200)]
+        flujo = bytearray()
+        for i, r in enumerate(regs):
+            flujo += cobs(r) + b'\x00'
+            if i % 7 == 0:
+                mal = bytearray(r)
+                mal[-1] ^= 0x40
+                flujo += cobs(mal) + b'\x00'               # CRC mal
+            if i % 11 == 0:
+                flujo += b'\x03\x01\x00\x00'               # Corta y delimitadores seguidos
+        for n in (1, 5, 12, 13, 100, len(flujo)):
+            leidos = list(tm.leer_tramas(Pedazos(bytes(flujo), n)))
+            self.assertEqual(len(leidos), len(regs), n)
+            for r, l in zip(regs, leidos):
+                self.assertEqual((l['seq'], l['tick'], l['dht'], l['zona'], l['estado'],
+                                  l['dht22'], l['descartadas']),
+                                 (r[0], r[1] | r[2] << 8, r[3:8], r[8] >> 4, r[8] & 7,
+                                  bool(r[8] & tm.TELEM_DHT22), r[9]))
+
+
+if __name__ == '__main__':
+    unittest.main()
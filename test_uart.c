@@ -0,0 +1,184 @@
+/*
+ * File: test_uart.c
+ * Tramas COBS de uart.c sobre el EUSART del simulador (make test)
+ *
+ * Lo que sale por TX se captura en el simulador y se separa por los 0x00.
+ * Se comprueba la codificacion contra tramas escritas a mano, que
+ * UART_Frame() no espera y los bytes salen al ritmo de 115200 baudios, el
+ * anillo dando la vuelta con tramas al azar mientras la ISR transmite, el
+ * descarte de tramas enteras con el contador UART_Overflows() (que da la
+ * vuelta en 256) y el valor de control del CRC-8.
+ */
+#include <string.h>
+#include "hal.h"
+#include "uart.h"
+#include "cobs.h"
+#include "crc8.h"
+#include "test.h"
+
+#define CICLOS_US    5
+// SPBRG de uart.c con BRG16 y BRGH: un bit son SPBRG + 1 ciclos
+#define BAUD_SPBRG   ((20000000 / 4 + UART_BAUDIOS / 2) / UART_BAUDIOS - 1)
+#define CICLOS_BYTE  (10 * (BAUD_SPBRG + 1))   // Start + 8 + stop
+
+static uint8_t salida[16384];
+
+void __interrupt() isr(void)
+{
+    if(PIE1bits.TXIE && PIR1bits.TXIF) {
+        UART_Isr();
+    }
+}
+
+static void esperar_us(uint32_t us)
+{
+    __delay_us(us);
+}
+
+static void vaciar(void)
+{
+    while(UART_Busy()) esperar_us(10);
+}
+
+// Las tramas de referencia, del ejemplo de COBS
+static void prueba_codificacion(void)
+{
+    static const struct {
+        uint8_t n, d[4], t[6];
+    } casos[] = {
+        { 0, { 0 },                      { 0x01, 0x00 } },
+        { 1, { 0x00 },                   { 0x01, 0x01, 0x00 } },
+        { 2, { 0x00, 0x00 },             { 0x01, 0x01, 0x01, 0x00 } },
+        { 3, { 0x11, 0x22, 0x00 },       { 0x03, 0x11, 0x22, 0x01, 0x00 } },
+        { 4, { 0x11, 0x00, 0x00, 0x22 }, { 0x02, 0x11, 0x01, 0x02, 0x22, 0x00 } },
+    };
+
+    for(uint8_t c = 0; c < sizeof(casos) / sizeof(casos[0]); c++) {
+        hal_host_uart_captura(salida, sizeof(salida));
+        PRUEBA(UART_Frame(casos[c].d, casos[c].n));
+        vaciar();
+        PRUEBA_IGUAL(hal_host_uart_bytes(), COBS_LEN(casos[c].n));
+        PRUEBA(memcmp(salida, casos[c].t, COBS_LEN(casos[c].n)) == 0);
+    }
+}
+
+// Encolar no espera; los bytes salen uno cada 10 bits
+static void prueba_ritmo(void)
+{
+    uint8_t d[11] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+    uint64_t t0 = hal_host_ahora(), dt;
+
+    hal_host_uart_captura(salida, sizeof(salida));
+    PRUEBA(UART_Frame(d, sizeof(d)));
+    PRUEBA_IGUAL(hal_host_ahora(), t0);
+    PRUEBA(UART_Busy());
+    vaciar();
+    dt = hal_host_ahora() - t0;
+    PRUEBA(dt >= COBS_LEN(sizeof(d)) * CICLOS_BYTE);
+    PRUEBA(dt <= COBS_LEN(sizeof(d)) * CICLOS_BYTE + CICLOS_BYTE + 10 * CICLOS_US);
+    PRUEBA(!PIE1bits.TXIE);
+}
+
+// Sin tiempo para la ISR entran dos tramas de telemetria; la tercera se
+// descarta entera y se cuenta. El contador da la vuelta en 256
+static void prueba_desborde(void)
+{
+    uint8_t d[11], o0 = UART_Overflows();
+    unsigned long n;
+
+    memset(d, 0x55, sizeof(d));
+    hal_host_uart_captura(salida, sizeof(salida));
+    PRUEBA(UART_Cabe(sizeof(d)));
+    PRUEBA(UART_Frame(d, sizeof(d)));
+    PRUEBA(UART_Frame(d, sizeof(d)));
+    PRUEBA(!UART_Cabe(sizeof(d)));
+    PRUEBA(!UART_Frame(d, sizeof(d)));
+    PRUEBA_IGUAL((uint8_t)(UART_Overflows() - o0), 1);
+    PRUEBA(!UART_Frame(d, UART_FRAME_MAX + 1));   // Nunca entra
+    PRUEBA_IGUAL((uint8_t)(UART_Overflows() - o0), 2);
+    vaciar();
+    n = hal_host_uart_bytes();
+    PRUEBA_IGUAL(n, 2 * COBS_LEN(sizeof(d)));
+
+    for(uint16_t i = 0; i < 256; i++) {
+        UART_Frame(d, UART_FRAME_MAX + 1);
+    }
+    PRUEBA_IGUAL((uint8_t)(UART_Overflows() - o0), 2);
+    PRUEBA_IGUAL(hal_host_uart_bytes(), n);
+}
+
+// Tramas al azar (con ceros, de 0 a UART_FRAME_MAX bytes) mientras la ISR
+// transmite: salen en orden las aceptadas, y las rechazadas se cuentan
+static void prueba_azar(void)
+{
+    static uint8_t enviadas[8192];
+    uint32_t azar = 7;
+    unsigned long n_env = 0, tramas = 0, rechazadas = 0, fin;
+    uint8_t d[UART_FRAME_MAX + 1], o0 = UART_Overflows();
+    unsigned fallas = prueba_fallas;
+
+    hal_host_uart_captura(salida, sizeof(salida));
+    while(n_env + COBS_LEN(UART_FRAME_MAX) < sizeof(enviadas)) {
+        uint8_t n;
+
+        azar = azar * 1103515245UL + 12345;
+        n = (azar >> 16) % (UART_FRAME_MAX + 1);
+        for(uint8_t i = 0; i < n; i++) {
+            azar = azar * 1103515245UL + 12345;
+            d[i] = ((azar >> 16) & 3) ? (azar >> 24) : 0;
+        }
+        if(UART_Cabe(n)) {
+            PRUEBA(UART_Frame(d, n));
+            enviadas[n_env++] = n;
+            memcpy(&enviadas[n_env], d, n);
+            n_env += n;
+            tramas++;
+        } else {
+            PRUEBA(!UART_Frame(d, n));
+            rechazadas++;
+        }
+        esperar_us((azar >> 24) * 4);
+    }
+    vaciar();
+    PRUEBA(rechazadas > 0);
+    PRUEBA_IGUAL((uint8_t)(UART_Overflows() - o0), (uint8_t)rechazadas);
+
+    // Cada trama, separada por su 0x00 y decodificada, es la enviada
+    fin = hal_host_uart_bytes();
+    for(unsigned long p = 0, e = 0, t = 0; t < tramas && prueba_fallas - fallas < 10; t++) {
+        uint8_t *z = memchr(&salida[p], 0x00, fin - p);
+        uint8_t n = enviadas[e];
+
+        PRUEBA(z != NULL);
+        if(!z) break;
+        PRUEBA_IGUAL(z - &salida[p], COBS_LEN(n) - 1);
+        PRUEBA(cobs_decodificar(&salida[p], z - &salida[p]));
+        PRUEBA(memcmp(&salida[p + 1], &enviadas[e + 1], n) == 0);
+        p = z - salida + 1;
+        e += n + 1;
+        if(t == tramas - 1) PRUEBA_IGUAL(p, fin);
+    }
+}
+
+static void prueba_crc8(void)
+{
+    const uint8_t control[] = "123456789";
+
+    PRUEBA_IGUAL(crc8(control, 9), 0xF4);   // CRC-8 (polinomio 0x07) de control
+    PRUEBA_IGUAL(crc8(control, 0), 0x00);
+}
+
+int main(void)
+{
+    HAL_INIT();
+    UART_Init();
+    INTCONbits.GIE = 1;
+
+    prueba_codificacion();
+    prueba_ritmo();
+    prueba_desborde();
+    prueba_azar();
+    prueba_crc8();
+    hal_host_uart_captura(NULL, 0);
+    return PRUEBA_FIN();
+}
@@ -0,0 +1,121 @@
+/*
+ * File: uart.c
+ * Transmision por EUSART (RC6/TX) con tramas COBS para PIC16F887
+ */
+#include "uart.h"
+#include "cobs.h"
+
+#define _XTAL_FREQ 20000000
+
+#define UART_TRMT  0x02   // TXSTA: registro de desplazamiento vacio
+
+// BRG16 = 1, BRGH = 1: baudios = Fosc / (4 * (SPBRG + 1))
+#define UART_SPBRG  ((_XTAL_FREQ / 4 + UART_BAUDIOS / 2) / UART_BAUDIOS - 1)
+
+static uint8_t uart_buf[UART_TX_LEN];
+
+// uart_wr solo lo mueve el programa principal, uart_rd solo la ISR
+static volatile uint8_t uart_wr = 0;
+static volatile uint8_t uart_rd = 0;
+static uint8_t uart_desbordes = 0;
+#ifdef UART_RX
+static volatile uint8_t uart_rx = 0;   // 0 = nada recibido
+#endif
+
+static uint8_t uart_sig(uint8_t i)
+{
+    return (i + 1 >= UART_TX_LEN) ? 0 : i + 1;
+}
+
+void UART_Init(void)
+{
+    TRISCbits.TRISC6 = 1;     // El EUSART toma los pines
+    TRISCbits.TRISC7 = 1;
+    SPBRGH = UART_SPBRG >> 8;
+    SPBRG = UART_SPBRG & 0xFF;
+    BAUDCTLbits.BRG16 = 1;
+    TXSTA = 0x24;             // TXEN, asincrono, BRGH
+#ifdef UART_RX
+    RCSTA = 0x90;             // SPEN, CREN
+    PIE1bits.RCIE = 1;
+#else
+    RCSTA = 0x80;             // SPEN (recepcion apagada)
+#endif
+    PIE1bits.TXIE = 0;
+    INTCONbits.PEIE = 1;
+}
+
+static uint8_t uart_libres(void)
+{
+    uint8_t rd = uart_rd;
+    return (rd > uart_wr) ? rd - uart_wr - 1 : UART_TX_LEN - 1 - uart_wr + rd;
+}
+
+uint8_t UART_Cabe(uint8_t n)
+{
+    return n <= UART_FRAME_MAX && uart_libres() >= n + 2;
+}
+
+uint8_t UART_Frame(const uint8_t *datos, uint8_t n)
+{
+    uint8_t w;
+
+    if(!UART_Cabe(n)) {
+        uart_desbordes++;
+        return 0;
+    }
+
+    cobs_codificar(datos, n, uart_buf, uart_wr, UART_TX_LEN);
+
+    // Publicar la trama completa de una vez
+    w = uart_wr + COBS_LEN(n);
+    uart_wr = (w >= UART_TX_LEN) ? w - UART_TX_LEN : w;
+    PIE1bits.TXIE = 1;
+    return 1;
+}
+
+uint8_t UART_Overflows(void)
+{
+    return uart_desbordes;
+}
+
+// TRMT sube cuando TXREG y el registro de desplazamiento quedaron vacios
+uint8_t UART_Busy(void)
+{
+    return uart_rd != uart_wr || !(TXSTA & UART_TRMT);
+}
+
+void UART_Isr(void)
+{
+    // TXIF se borra solo al cargar TXREG
+    if(uart_rd != uart_wr) {
+        TXREG = uart_buf[uart_rd];
+        uart_rd = uart_sig(uart_rd);
+    }
+    if(uart_rd == uart_wr) {
+        PIE1bits.TXIE = 0;
+    }
+}
+
+#ifdef UART_RX
+uint8_t UART_Recibido(void)
+{
+    uint8_t c;
+
+    PIE1bits.RCIE = 0;
+    c = uart_rx;
+    uart_rx = 0;
+    PIE1bits.RCIE = 1;
+    return c;
+}
+
+void UART_Isr_Rx(void)
+{
+    // Con desborde (OERR) el EUSART deja de recibir hasta bajar CREN
+    if(RCSTAbits.OERR) {
+        RCSTAbits.CREN = 0;
+        RCSTAbits.CREN = 1;
+    }
+    uart_rx = RCREG;   // Leer RCREG borra RCIF
+}
+#endif
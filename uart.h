@@ -0,0 +1,44 @@
+/*
+ * File: uart.h
+ * Transmision por EUSART (RC6/TX) con tramas COBS para PIC16F887
+ *
+ * UART_Frame() codifica la trama con COBS (ningun byte 0x00 adentro) y la
+ * deja en un anillo seguida del delimitador 0x00; la ISR de TXIF la saca
+ * byte a byte. Nunca espera: si la trama no entra se descarta entera y
+ * se cuenta en UART_Overflows().
+ *
+ * Con UART_RX (lo activa PROF, ver prof.h) tambien recibe por RC7/RX: la
+ * ISR de RCIF guarda el ultimo byte y UART_Recibido() lo entrega una vez.
+ * Son pedidos de un byte, no un flujo: un byte que llega antes de leer
+ * el anterior lo reemplaza.
+ */
+#ifndef UART_H
+#define UART_H
+
+#include "hal.h"
+#include <stdint.h>
+
+#define UART_BAUDIOS  115200
+
+#ifndef UART_TX_LEN
+#define UART_TX_LEN   32   // Dos tramas de telemetria
+#endif
+
+#define UART_FRAME_MAX  (UART_TX_LEN - 3)  // Datos por trama (COBS + 0x00)
+
+#if defined(PROF) && !defined(UART_RX)
+#define UART_RX
+#endif
+
+void UART_Init(void);
+uint8_t UART_Frame(const uint8_t *datos, uint8_t n);  // 0 = descartada
+uint8_t UART_Cabe(uint8_t n);  // Una trama de n bytes entra ahora
+uint8_t UART_Overflows(void);  // Tramas descartadas (da la vuelta en 256)
+uint8_t UART_Busy(void);       // Queda algo por salir (anillo, TXREG o TSR)
+void UART_Isr(void);           // Llamar desde la ISR cuando TXIF y TXIE
+#ifdef UART_RX
+uint8_t UART_Recibido(void);   // Ultimo byte recibido, 0 si no hay
+void UART_Isr_Rx(void);        // Llamar desde la ISR cuando RCIF y RCIE
+#endif
+
+#endif /* UART_H */